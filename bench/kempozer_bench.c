@@ -0,0 +1,671 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+/**
+ * @par Measures the throughput of the hot paths of kempozer over several image sizes.
+ *
+ * @par Usage: kempozer_bench [-s WIDTHxHEIGHT]... [-t MILLISECONDS] [-f FILTER] [-o FILE]
+ * * `-s` adds an image size to measure, replacing the default sizes
+ * * `-t` sets the minimum time spent measuring each case, 250ms by default
+ * * `-f` only measures the cases whose name starts with FILTER
+ * * `-o` writes the results as JSON to FILE, or to standard output if FILE is `-`.
+ *
+ * @par Every case is repeated until the minimum time has elapsed and the fastest repetition is reported, which keeps the results stable enough
+ * to diff across releases. Build with optimizations (e.g. `-DCMAKE_BUILD_TYPE=Release`) when comparing results.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libkempozer.h>
+#include <libkempozer/color.h>
+#include <libkempozer/image.h>
+#include <libkempozer/io.h>
+#include <libkempozer/gdfile.h>
+#include <libkempozer/geometries.h>
+
+#define _BENCH_MAX_SIZES 16
+#define _BENCH_MAX_RESULTS 512
+
+struct _bench_result_t {
+    char name[64];
+    KmzSize dimen;
+    size_t iterations;
+    double ns_per_pixel;
+    double mpix_per_s;
+};
+
+struct _bench_t {
+    double min_time;
+    const char * filter;
+    struct _bench_result_t results[_BENCH_MAX_RESULTS];
+    size_t count;
+};
+
+/**
+ * The state shared by every case measured for a single image size.
+ */
+struct _bench_fixture_t {
+    KmzSize dimen;
+    size_t pixels;
+    kmz_color_32 * argb;
+    KmzAhslColor * ahsl;
+    kmz_color_32 * scratch;
+    KmzImage * image;
+    KmzImage * output;
+    KmzImage * thumbnail;
+    KmzImage * rotated;
+    KmzImage * palette_image;
+    KmzColorLut3D * lut;
+    KmzColorTransform * curves;
+    KmzColorTransform * grade;
+    KmzKernel * kernel;
+    KmzPipeline * pipeline;
+    KmzImageFile * file;
+    KmzImageFile * truecolor_file;
+    KmzImageFile * palette_file;
+    FILE * truecolor_gd;
+    FILE * palette_gd;
+    size_t m_size;
+};
+
+typedef void (* _BenchCase)(struct _bench_fixture_t * const fixture);
+
+static double _bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void _bench_fail(const char * const what) {
+    fprintf(stderr, "kempozer_bench: %s\n", what);
+    exit(EXIT_FAILURE);
+}
+
+static void _bench_run(struct _bench_t * const bench, const char * const name, struct _bench_fixture_t * const fixture, const _BenchCase run) {
+    if (NULL != bench->filter && 0 != strncmp(name, bench->filter, strlen(bench->filter))) {
+        return;
+    } else if (_BENCH_MAX_RESULTS == bench->count) {
+        _bench_fail("too many results");
+    }
+
+    // One untimed run warms the caches and any lazily initialized state.
+    run(fixture);
+
+    double best = -1., elapsed = 0.;
+    size_t iterations = 0;
+    while (elapsed < bench->min_time * 1e6 || iterations < 3) {
+        const double start = _bench_now();
+        run(fixture);
+        const double time = _bench_now() - start;
+        best = best < 0. || time < best ? time : best;
+        elapsed += time;
+        ++iterations;
+    }
+
+    struct _bench_result_t * const result = &bench->results[bench->count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->dimen = fixture->dimen;
+    result->iterations = iterations;
+    result->ns_per_pixel = best / (double)fixture->pixels;
+    result->mpix_per_s = (double)fixture->pixels / best * 1e3;
+    printf("%-32s %5ux%-5u %10.3f ns/px %10.2f MPix/s %8zu runs\n", result->name, result->dimen.w, result->dimen.h,
+            result->ns_per_pixel, result->mpix_per_s, result->iterations);
+    fflush(stdout);
+}
+
+// region Fixtures:
+
+/**
+ * A minimal in-memory AHSL image file, since none of the image files of kempozer store AHSL pixels.
+ */
+struct _bench_ahsl_file_t {
+    KmzSize dimen;
+    const KmzAhslColor * pixels;
+};
+
+static void * const _bench_ahsl_file__new(void) {
+    return calloc(1, sizeof(struct _bench_ahsl_file_t));
+}
+
+static void _bench_ahsl_file__ctor(struct _bench_ahsl_file_t * const me, const struct _bench_ahsl_file_t * const argv) {
+    *me = *argv;
+}
+
+static const KmzSize _bench_ahsl_file__dimen(const struct _bench_ahsl_file_t * const me) {
+    return me->dimen;
+}
+
+static const KmzImageFileColorType _bench_ahsl_file__color_type(const struct _bench_ahsl_file_t * const me) {
+    (void)me;
+    return KMZ_IMAGE_FILE_AHSL;
+}
+
+static const KmzImageFileStatus _bench_ahsl_file__status(const struct _bench_ahsl_file_t * const me) {
+    (void)me;
+    return KMZ_IMAGE_FILE_OK;
+}
+
+static const KmzImageFileStatus _bench_ahsl_file__read_ahsl_pixels(struct _bench_ahsl_file_t * const me, KmzAhslColor * const buffer) {
+    memcpy(buffer, me->pixels, sizeof(KmzAhslColor) * me->dimen.w * me->dimen.h);
+    return KMZ_IMAGE_FILE_OK;
+}
+
+static const KmzImageFileType _bench_ahsl_file = {
+    ._new=(void * const (*)(void))&_bench_ahsl_file__new,
+    ._ctor=(void (*)(void * const, const void * const))&_bench_ahsl_file__ctor,
+    .dimen=(const KmzSize (*)(const void * const))&_bench_ahsl_file__dimen,
+    .color_type=(const KmzImageFileColorType (*)(const void * const))&_bench_ahsl_file__color_type,
+    .status=(const KmzImageFileStatus (*)(const void * const))&_bench_ahsl_file__status,
+    .read_ahsl_pixels=(const KmzImageFileStatus (*)(void * const, KmzAhslColor * const))&_bench_ahsl_file__read_ahsl_pixels,
+};
+
+static void _bench_load(KmzImageFile * const file, FILE * const f) {
+    rewind(f);
+    if (KMZ_IMAGE_FILE_OK != KmzImageFile__load_from(file, f)) {
+        _bench_fail("unable to load a GD 2x image");
+    }
+}
+
+static FILE * _bench_save(KmzImageFile * const file) {
+    FILE * const f = tmpfile();
+    if (NULL == f) {
+        _bench_fail("unable to create a temporary file");
+    } else if (KMZ_IMAGE_FILE_OK != KmzImageFile__save_to(file, f)) {
+        _bench_fail("unable to save a GD 2x image");
+    }
+    fflush(f);
+    return f;
+}
+
+static void _bench_fixture_init(struct _bench_fixture_t * const fixture, const KmzSize dimen) {
+    memset(fixture, 0, sizeof(*fixture));
+    fixture->dimen = dimen;
+    fixture->pixels = (size_t)dimen.w * dimen.h;
+    fixture->argb = malloc(sizeof(kmz_color_32) * fixture->pixels);
+    fixture->ahsl = malloc(sizeof(KmzAhslColor) * fixture->pixels);
+    fixture->scratch = malloc(sizeof(kmz_color_32) * fixture->pixels);
+    if (NULL == fixture->argb || NULL == fixture->ahsl || NULL == fixture->scratch) {
+        _bench_fail("out of memory");
+    }
+
+    uint32_t state = 0x12345678u;
+    for (size_t i = 0; i < fixture->pixels; ++i) {
+        state = state * 1664525u + 1013904223u;
+        fixture->argb[i] = (state >> 8) & 0x7FFFFFFFu;
+    }
+    kmz_color_32__to_ahsl_span(fixture->argb, fixture->ahsl, fixture->pixels);
+
+    fixture->image = KmzImage__new_from_buffer(dimen, fixture->argb, KMZ_TRUE);
+    fixture->output = KmzImage__new_from_buffer(dimen, fixture->argb, KMZ_TRUE);
+    fixture->thumbnail = KmzImage__new_from_buffer(kmz_size((uint16_t)(dimen.w / 4 + 1), (uint16_t)(dimen.h / 4 + 1)), fixture->argb, KMZ_TRUE);
+    fixture->rotated = KmzImage__new_from_buffer(kmz_size(dimen.h, dimen.w), fixture->argb, KMZ_TRUE);
+    fixture->file = KmzGd2xImageFile__new();
+    fixture->truecolor_file = KmzGd2xImageFile__new();
+    fixture->palette_file = KmzGd2xImageFile__new();
+    if (NULL == fixture->image || NULL == fixture->output || NULL == fixture->thumbnail || NULL == fixture->rotated || NULL == fixture->file || NULL == fixture->truecolor_file || NULL == fixture->palette_file) {
+        _bench_fail("unable to create the fixtures");
+    }
+    if (KMZ_IMAGE_FILE_OK != KmzImageFile__set_truecolor_image(fixture->truecolor_file, dimen, fixture->argb, KMZ_TRUE)) {
+        _bench_fail("unable to create a truecolor GD 2x image");
+    }
+    fixture->truecolor_gd = _bench_save(fixture->truecolor_file);
+
+    kmz_color_32 palette[256];
+    fixture->palette_image = KmzImage__new_palette_from_image(fixture->image, KMZ_QUANTIZE_MEDIAN_CUT, 256, 0);
+    if (NULL == fixture->palette_image || KMZ_PIXEL_OP_OK != KmzImage__read_palette(fixture->palette_image, palette)
+            || KMZ_IMAGE_FILE_OK != KmzImageFile__set_palette_image(fixture->palette_file, KmzImage__palette_color_count(fixture->palette_image), palette,
+                dimen, KmzImage__palette_indices(fixture->palette_image), KMZ_TRUE)) {
+        _bench_fail("unable to create a palette GD 2x image");
+    }
+    fixture->palette_gd = _bench_save(fixture->palette_file);
+
+    // A warm grade with a little contrast, so no lookup lands on an identity entry.
+    fixture->lut = KmzColorLut3D__new(33);
+    if (NULL == fixture->lut) {
+        _bench_fail("unable to create a 3D LUT");
+    }
+    for (size_t b = 0; b < 33; ++b) {
+        for (size_t g = 0; g < 33; ++g) {
+            for (size_t r = 0; r < 33; ++r) {
+                KmzColorLut3D__set(fixture->lut, r, g, b, powf((float)r / 32.f, .9f), powf((float)g / 32.f, 1.1f), powf((float)b / 32.f, 1.2f));
+            }
+        }
+    }
+
+    // A chain of curves, and a grade that rotates through HSL between two curves.
+    fixture->curves = KmzColorTransform__new();
+    fixture->grade = KmzColorTransform__new();
+    if (NULL == fixture->curves || NULL == fixture->grade
+            || !KmzColorTransform__levels(fixture->curves, .05f, .95f, 1.2f, 0.f, 1.f) || !KmzColorTransform__gamma(fixture->curves, 1.1f)
+            || !KmzColorTransform__gamma(fixture->grade, 1.1f) || !KmzColorTransform__rotate_hue(fixture->grade, .05f)
+            || !KmzColorTransform__saturate(fixture->grade, 1.2f) || !KmzColorTransform__lighten(fixture->grade, .02f)
+            || !KmzColorTransform__levels(fixture->grade, 0.f, 1.f, 1.f, .02f, .98f)
+            || !KmzColorTransform__compile(fixture->curves) || !KmzColorTransform__compile(fixture->grade)) {
+        _bench_fail("unable to create the color transforms");
+    }
+
+    // A blur, curves and a composite of the image over the result, run as a fused pipeline and as three separate passes.
+    fixture->kernel = KmzKernel__new_gaussian(5, 0.f);
+    fixture->pipeline = KmzPipeline__new();
+    if (NULL == fixture->kernel || NULL == fixture->pipeline || !KmzPipeline__add_kernel(fixture->pipeline, fixture->kernel)
+            || !KmzPipeline__add_color_transform(fixture->pipeline, fixture->curves)
+            || !KmzPipeline__add_composite(fixture->pipeline, fixture->image, kmz_rectangle(KmzPoint__ZERO, dimen), KmzPoint__ZERO, KMZ_COMPOSITE_SRC_OVER, .5f)) {
+        _bench_fail("unable to create the pipeline");
+    }
+}
+
+static void _bench_fixture_release(struct _bench_fixture_t * const fixture) {
+    KmzImage__free(fixture->image);
+    KmzImage__free(fixture->output);
+    KmzImage__free(fixture->thumbnail);
+    KmzImage__free(fixture->rotated);
+    KmzImage__free(fixture->palette_image);
+    KmzColorLut3D__free(fixture->lut);
+    KmzColorTransform__free(fixture->curves);
+    KmzColorTransform__free(fixture->grade);
+    KmzKernel__free(fixture->kernel);
+    KmzPipeline__free(fixture->pipeline);
+    KmzImageFile__free(fixture->file);
+    KmzImageFile__free(fixture->truecolor_file);
+    KmzImageFile__free(fixture->palette_file);
+    fclose(fixture->truecolor_gd);
+    fclose(fixture->palette_gd);
+    free(fixture->argb);
+    free(fixture->ahsl);
+    free(fixture->scratch);
+}
+
+// endregion;
+
+// region Cases:
+
+static void _bench_gd_2x_save(KmzImageFile * const file, FILE * const f) {
+    rewind(f);
+    if (KMZ_IMAGE_FILE_OK != KmzImageFile__save_to(file, f)) {
+        _bench_fail("unable to save a GD 2x image");
+    }
+    fflush(f);
+}
+
+static void _bench_gd_2x_save_truecolor(struct _bench_fixture_t * const fixture) {
+    _bench_gd_2x_save(fixture->truecolor_file, fixture->truecolor_gd);
+}
+
+static void _bench_gd_2x_save_palette(struct _bench_fixture_t * const fixture) {
+    _bench_gd_2x_save(fixture->palette_file, fixture->palette_gd);
+}
+
+static void _bench_gd_2x_load_truecolor(struct _bench_fixture_t * const fixture) {
+    _bench_load(fixture->file, fixture->truecolor_gd);
+}
+
+static void _bench_gd_2x_load_palette(struct _bench_fixture_t * const fixture) {
+    _bench_load(fixture->file, fixture->palette_gd);
+}
+
+static void _bench_from_file(KmzImageFile * const file) {
+    KmzImage * const image = KmzImage__new_from_file(file);
+    if (NULL == image) {
+        _bench_fail("unable to create an image from a file");
+    }
+    KmzImage__free(image);
+}
+
+static void _bench_from_file_truecolor(struct _bench_fixture_t * const fixture) {
+    _bench_from_file(fixture->truecolor_file);
+}
+
+static void _bench_from_file_palette(struct _bench_fixture_t * const fixture) {
+    _bench_from_file(fixture->palette_file);
+}
+
+static void _bench_from_file_ahsl(struct _bench_fixture_t * const fixture) {
+    const struct _bench_ahsl_file_t argv = {fixture->dimen, fixture->ahsl};
+    KmzImageFile * const file = KmzImageFile__new(&_bench_ahsl_file, &argv);
+    if (NULL == file) {
+        _bench_fail("out of memory");
+    }
+    _bench_from_file(file);
+    KmzImageFile__free(file);
+}
+
+static void _bench_palette_from_file(struct _bench_fixture_t * const fixture) {
+    KmzImage * const image = KmzImage__new_palette_from_file(fixture->palette_file);
+    if (NULL == image) {
+        _bench_fail("unable to create a palette image from a file");
+    }
+    KmzImage__free(image);
+}
+
+static void _bench_quantize(struct _bench_fixture_t * const fixture, const KmzQuantizeMode mode) {
+    kmz_color_32 palette[256];
+    if (0 == KmzImage__quantize(fixture->image, mode, 256, palette, 0)) {
+        _bench_fail("unable to quantize an image");
+    }
+}
+
+static void _bench_quantize_median_cut(struct _bench_fixture_t * const fixture) {
+    _bench_quantize(fixture, KMZ_QUANTIZE_MEDIAN_CUT);
+}
+
+static void _bench_quantize_octree(struct _bench_fixture_t * const fixture) {
+    _bench_quantize(fixture, KMZ_QUANTIZE_OCTREE);
+}
+
+static void _bench_palette_from_image(struct _bench_fixture_t * const fixture) {
+    KmzImage * const image = KmzImage__new_palette_from_image(fixture->image, KMZ_QUANTIZE_MEDIAN_CUT, 256, 0);
+    if (NULL == image) {
+        _bench_fail("unable to create a palette image from an image");
+    }
+    KmzImage__free(image);
+}
+
+static void _bench_read_argb_block(struct _bench_fixture_t * const fixture) {
+    KmzImage__read_argb_block(fixture->image, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), fixture->scratch);
+}
+
+static void _bench_read_palette_argb_block(struct _bench_fixture_t * const fixture) {
+    KmzImage__read_argb_block(fixture->palette_image, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), fixture->scratch);
+}
+
+static void _bench_write_argb_block(struct _bench_fixture_t * const fixture) {
+    KmzImage__write_argb_block(fixture->output, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), fixture->argb);
+}
+
+/**
+ * Averages every channel over the whole matrix, which touches every pixel of the matrix like a typical convolution.
+ */
+static const kmz_color_32 _bench_box_filter(const void * const argv, KmzMatrix * const matrix) {
+    const ssize_t hsize = (ssize_t)KmzMatrix__hsize(matrix);
+    const uint32_t count = (uint32_t)(KmzMatrix__size(matrix) * KmzMatrix__size(matrix));
+    uint32_t a = 0, r = 0, g = 0, b = 0;
+    (void)argv;
+
+    for (ssize_t y = -hsize; y <= hsize; ++y) {
+        for (ssize_t x = -hsize; x <= hsize; ++x) {
+            const kmz_color_32 color = KmzMatrix__argb_at(matrix, kmz_point(x, y));
+            a += (color >> 24) & 0xFFu;
+            r += (color >> 16) & 0xFFu;
+            g += (color >> 8) & 0xFFu;
+            b += color & 0xFFu;
+        }
+    }
+    return (a / count) << 24 | (r / count) << 16 | (g / count) << 8 | b / count;
+}
+
+static void _bench_apply_buffered_filter(struct _bench_fixture_t * const fixture) {
+    KmzImage__apply_buffered_filter(fixture->image, NULL, &_bench_box_filter, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), fixture->m_size, fixture->output);
+}
+
+static void _bench_composite(struct _bench_fixture_t * const fixture, const KmzCompositeOp op) {
+    KmzImage__composite(fixture->output, fixture->image, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), KmzPoint__ZERO, op, 1.f);
+}
+
+static void _bench_composite_src_over(struct _bench_fixture_t * const fixture) {
+    _bench_composite(fixture, KMZ_COMPOSITE_SRC_OVER);
+}
+
+static void _bench_composite_multiply(struct _bench_fixture_t * const fixture) {
+    _bench_composite(fixture, KMZ_COMPOSITE_MULTIPLY);
+}
+
+static void _bench_resample(struct _bench_fixture_t * const fixture, const KmzResampleFilter filter) {
+    KmzImage__resample(fixture->image, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), filter, fixture->thumbnail, 0);
+}
+
+static void _bench_resample_quarter_bilinear(struct _bench_fixture_t * const fixture) {
+    _bench_resample(fixture, KMZ_RESAMPLE_BILINEAR);
+}
+
+static void _bench_resample_quarter_lanczos_3(struct _bench_fixture_t * const fixture) {
+    _bench_resample(fixture, KMZ_RESAMPLE_LANCZOS_3);
+}
+
+static void _bench_build_pyramid(struct _bench_fixture_t * const fixture, const KmzPyramidFilter filter) {
+    KmzPyramid * const pyramid = KmzImage__build_pyramid(fixture->image, filter, 0);
+    if (NULL != pyramid) {
+        KmzPyramid__free(pyramid);
+    }
+}
+
+static void _bench_build_pyramid_box(struct _bench_fixture_t * const fixture) {
+    _bench_build_pyramid(fixture, KMZ_PYRAMID_BOX);
+}
+
+static void _bench_build_pyramid_gaussian(struct _bench_fixture_t * const fixture) {
+    _bench_build_pyramid(fixture, KMZ_PYRAMID_GAUSSIAN);
+}
+
+static void _bench_rotate90(struct _bench_fixture_t * const fixture) {
+    KmzImage__rotate90(fixture->image, fixture->rotated);
+}
+
+static void _bench_flip_h(struct _bench_fixture_t * const fixture) {
+    KmzImage__flip_h(fixture->image, fixture->output);
+}
+
+static void _bench_rotate180_in_place(struct _bench_fixture_t * const fixture) {
+    KmzImage__rotate180(fixture->output, fixture->output);
+}
+
+static void _bench_histogram(struct _bench_fixture_t * const fixture) {
+    KmzHistogram histogram;
+    KmzImage__histogram(fixture->image, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), KMZ_FALSE, &histogram, 0);
+}
+
+static void _bench_histogram_hsl(struct _bench_fixture_t * const fixture) {
+    KmzHistogram histogram;
+    KmzImage__histogram(fixture->image, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), KMZ_TRUE, &histogram, 0);
+}
+
+static void _bench_box_blur_radius_1(struct _bench_fixture_t * const fixture) {
+    KmzImage__box_blur(fixture->image, 1, fixture->output, 0);
+}
+
+static void _bench_box_blur_radius_50(struct _bench_fixture_t * const fixture) {
+    KmzImage__box_blur(fixture->image, 50, fixture->output, 0);
+}
+
+static void _bench_erode_3x3(struct _bench_fixture_t * const fixture) {
+    KmzImage__morphology(fixture->image, KMZ_MORPHOLOGY_ERODE, kmz_size(3, 3), KMZ_FALSE, fixture->output, 0);
+}
+
+static void _bench_erode_21x21(struct _bench_fixture_t * const fixture) {
+    KmzImage__morphology(fixture->image, KMZ_MORPHOLOGY_ERODE, kmz_size(21, 21), KMZ_FALSE, fixture->output, 0);
+}
+
+static void _bench_median_7x7(struct _bench_fixture_t * const fixture) {
+    KmzImage__median(fixture->image, 3, fixture->output, 0);
+}
+
+static void _bench_median_25x25(struct _bench_fixture_t * const fixture) {
+    KmzImage__median(fixture->image, 12, fixture->output, 0);
+}
+
+static void _bench_gaussian_blur_sigma_2(struct _bench_fixture_t * const fixture) {
+    KmzImage__gaussian_blur(fixture->image, 2.f, fixture->output, 0);
+}
+
+static void _bench_gaussian_blur_sigma_20(struct _bench_fixture_t * const fixture) {
+    KmzImage__gaussian_blur(fixture->image, 20.f, fixture->output, 0);
+}
+
+static void _bench_lut3d_trilinear(struct _bench_fixture_t * const fixture) {
+    KmzImage__apply_lut3d(fixture->image, fixture->lut, KMZ_LUT_TRILINEAR, fixture->output, 0);
+}
+
+static void _bench_lut3d_tetrahedral(struct _bench_fixture_t * const fixture) {
+    KmzImage__apply_lut3d(fixture->image, fixture->lut, KMZ_LUT_TETRAHEDRAL, fixture->output, 0);
+}
+
+static void _bench_color_transform_curves(struct _bench_fixture_t * const fixture) {
+    KmzImage__apply_color_transform(fixture->image, fixture->curves, fixture->output, 0);
+}
+
+static void _bench_color_transform_grade(struct _bench_fixture_t * const fixture) {
+    KmzImage__apply_color_transform(fixture->image, fixture->grade, fixture->output, 0);
+}
+
+static void _bench_pipeline_separate(struct _bench_fixture_t * const fixture) {
+    const KmzRectangle area = kmz_rectangle(KmzPoint__ZERO, fixture->dimen);
+    KmzImage__apply_kernel(fixture->image, fixture->kernel, area, fixture->output);
+    KmzImage__apply_color_transform(fixture->output, fixture->curves, fixture->output, 0);
+    KmzImage__composite(fixture->output, fixture->image, area, KmzPoint__ZERO, KMZ_COMPOSITE_SRC_OVER, .5f);
+}
+
+static void _bench_pipeline_fused(struct _bench_fixture_t * const fixture) {
+    KmzImage__apply_pipeline(fixture->image, fixture->pipeline, kmz_rectangle(KmzPoint__ZERO, fixture->dimen), fixture->output, 0);
+}
+
+static void _bench_argb_to_ahsl(struct _bench_fixture_t * const fixture) {
+    kmz_color_32__to_ahsl_span(fixture->argb, fixture->ahsl, fixture->pixels);
+}
+
+static void _bench_ahsl_to_argb(struct _bench_fixture_t * const fixture) {
+    kmz_color_32__from_ahsl_span(fixture->ahsl, fixture->scratch, fixture->pixels);
+}
+
+// endregion;
+
+static void _bench_measure(struct _bench_t * const bench, const KmzSize dimen) {
+    struct _bench_fixture_t fixture;
+    _bench_fixture_init(&fixture, dimen);
+
+    _bench_run(bench, "gd_2x_save_truecolor", &fixture, &_bench_gd_2x_save_truecolor);
+    _bench_run(bench, "gd_2x_save_palette", &fixture, &_bench_gd_2x_save_palette);
+    _bench_run(bench, "gd_2x_load_truecolor", &fixture, &_bench_gd_2x_load_truecolor);
+    _bench_run(bench, "gd_2x_load_palette", &fixture, &_bench_gd_2x_load_palette);
+    _bench_run(bench, "image_from_file_truecolor", &fixture, &_bench_from_file_truecolor);
+    _bench_run(bench, "image_from_file_palette", &fixture, &_bench_from_file_palette);
+    _bench_run(bench, "image_from_file_ahsl", &fixture, &_bench_from_file_ahsl);
+    _bench_run(bench, "palette_image_from_file", &fixture, &_bench_palette_from_file);
+    _bench_run(bench, "quantize_median_cut", &fixture, &_bench_quantize_median_cut);
+    _bench_run(bench, "quantize_octree", &fixture, &_bench_quantize_octree);
+    _bench_run(bench, "palette_image_from_image", &fixture, &_bench_palette_from_image);
+    _bench_run(bench, "read_argb_block", &fixture, &_bench_read_argb_block);
+    _bench_run(bench, "read_argb_block_palette", &fixture, &_bench_read_palette_argb_block);
+    _bench_run(bench, "write_argb_block", &fixture, &_bench_write_argb_block);
+    for (fixture.m_size = 3; fixture.m_size <= 15; fixture.m_size += 2) {
+        char name[64];
+        snprintf(name, sizeof(name), "apply_buffered_filter_%zux%zu", fixture.m_size, fixture.m_size);
+        _bench_run(bench, name, &fixture, &_bench_apply_buffered_filter);
+    }
+    _bench_run(bench, "composite_src_over", &fixture, &_bench_composite_src_over);
+    _bench_run(bench, "composite_multiply", &fixture, &_bench_composite_multiply);
+    _bench_run(bench, "resample_quarter_bilinear", &fixture, &_bench_resample_quarter_bilinear);
+    _bench_run(bench, "resample_quarter_lanczos_3", &fixture, &_bench_resample_quarter_lanczos_3);
+    _bench_run(bench, "build_pyramid_box", &fixture, &_bench_build_pyramid_box);
+    _bench_run(bench, "build_pyramid_gaussian", &fixture, &_bench_build_pyramid_gaussian);
+    _bench_run(bench, "rotate90", &fixture, &_bench_rotate90);
+    _bench_run(bench, "flip_h", &fixture, &_bench_flip_h);
+    _bench_run(bench, "rotate180_in_place", &fixture, &_bench_rotate180_in_place);
+    _bench_run(bench, "histogram", &fixture, &_bench_histogram);
+    _bench_run(bench, "histogram_hsl", &fixture, &_bench_histogram_hsl);
+    _bench_run(bench, "box_blur_radius_1", &fixture, &_bench_box_blur_radius_1);
+    _bench_run(bench, "box_blur_radius_50", &fixture, &_bench_box_blur_radius_50);
+    _bench_run(bench, "erode_3x3", &fixture, &_bench_erode_3x3);
+    _bench_run(bench, "erode_21x21", &fixture, &_bench_erode_21x21);
+    _bench_run(bench, "median_7x7", &fixture, &_bench_median_7x7);
+    _bench_run(bench, "median_25x25", &fixture, &_bench_median_25x25);
+    _bench_run(bench, "gaussian_blur_sigma_2", &fixture, &_bench_gaussian_blur_sigma_2);
+    _bench_run(bench, "gaussian_blur_sigma_20", &fixture, &_bench_gaussian_blur_sigma_20);
+    _bench_run(bench, "lut3d_trilinear", &fixture, &_bench_lut3d_trilinear);
+    _bench_run(bench, "lut3d_tetrahedral", &fixture, &_bench_lut3d_tetrahedral);
+    _bench_run(bench, "color_transform_curves", &fixture, &_bench_color_transform_curves);
+    _bench_run(bench, "color_transform_grade", &fixture, &_bench_color_transform_grade);
+    _bench_run(bench, "pipeline_separate", &fixture, &_bench_pipeline_separate);
+    _bench_run(bench, "pipeline_fused", &fixture, &_bench_pipeline_fused);
+    _bench_run(bench, "argb_to_ahsl", &fixture, &_bench_argb_to_ahsl);
+    _bench_run(bench, "ahsl_to_argb", &fixture, &_bench_ahsl_to_argb);
+
+    _bench_fixture_release(&fixture);
+}
+
+static void _bench_write_json(const struct _bench_t * const bench, FILE * const f) {
+    static const char * const simd[] = {"none", "sse2", "ssse3", "avx2"};
+    fprintf(f, "{\n  \"version\": \"%s\",\n  \"simd\": \"%s\",\n  \"threads\": %zu,\n  \"results\": [", kmz_version_string(),
+            simd[kmz_simd_level()], kmz_thread_count());
+    for (size_t i = 0; i < bench->count; ++i) {
+        const struct _bench_result_t * const result = &bench->results[i];
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"width\": %u, \"height\": %u, \"iterations\": %zu, \"ns_per_pixel\": %.4f, \"mpix_per_s\": %.3f}",
+                i ? "," : "", result->name, result->dimen.w, result->dimen.h, result->iterations, result->ns_per_pixel, result->mpix_per_s);
+    }
+    fprintf(f, "\n  ]\n}\n");
+}
+
+int main(int argc, char ** argv) {
+    static struct _bench_t bench = {.min_time=250.};
+    KmzSize sizes[_BENCH_MAX_SIZES] = {{256, 256}, {640, 480}, {1920, 1080}};
+    size_t size_count = 3, custom_sizes = 0;
+    const char * output = NULL;
+
+    for (int i = 1; i < argc; ++i) {
+        unsigned w, h;
+        if (0 == strcmp(argv[i], "-s") && i + 1 < argc && 2 == sscanf(argv[i + 1], "%ux%u", &w, &h) && w && h && w <= UINT16_MAX && h <= UINT16_MAX) {
+            if (_BENCH_MAX_SIZES == custom_sizes) {
+                _bench_fail("too many sizes");
+            }
+            sizes[custom_sizes++] = kmz_size((uint16_t)w, (uint16_t)h);
+            size_count = custom_sizes;
+            ++i;
+        } else if (0 == strcmp(argv[i], "-t") && i + 1 < argc && (bench.min_time = atof(argv[i + 1])) > 0.) {
+            ++i;
+        } else if (0 == strcmp(argv[i], "-f") && i + 1 < argc) {
+            bench.filter = argv[++i];
+        } else if (0 == strcmp(argv[i], "-o") && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [-s WIDTHxHEIGHT]... [-t MILLISECONDS] [-f FILTER] [-o FILE]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (size_t i = 0; i < size_count; ++i) {
+        _bench_measure(&bench, sizes[i]);
+    }
+
+    if (NULL != output && 0 == strcmp(output, "-")) {
+        _bench_write_json(&bench, stdout);
+    } else if (NULL != output) {
+        FILE * const f = fopen(output, "w");
+        if (NULL == f) {
+            _bench_fail("unable to open the JSON output");
+        }
+        _bench_write_json(&bench, f);
+        fclose(f);
+    }
+    return EXIT_SUCCESS;
+}
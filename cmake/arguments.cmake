@@ -2,3 +2,6 @@
 
 set(GD_IMAGE_FILE_SUPPORTED ON CACHE BOOL
     "If the gdfile.h header should be included and kmz_gd_2x_image_file should be compiled. On by default.")
+
+set(BENCHMARKS_SUPPORTED ON CACHE BOOL
+    "If the kempozer_bench executable should be compiled. Requires GD_IMAGE_FILE_SUPPORTED. On by default.")
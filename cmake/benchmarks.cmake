@@ -0,0 +1,3 @@
+# Provides the kempozer_bench executable, which measures the throughput of the hot paths of kempozer. It is never installed.
+add_executable(kempozer_bench ${BENCH_DIR}/kempozer_bench.c)
+target_link_libraries(kempozer_bench PRIVATE kempozer)
@@ -1,21 +1,60 @@
 # Provides an initial configuration for the cmake system such as source and header directories, API path, and source and header files.
 set(SOURCE_DIR ${PROJECT_SOURCE_DIR}/src)
 set(API_DIR ${PROJECT_SOURCE_DIR}/include)
+set(BENCH_DIR ${PROJECT_SOURCE_DIR}/bench)
 
-set(SOURCES ${SOURCE_DIR}/kmz_color.c
+set(SOURCES ${SOURCE_DIR}/kmz_ahsl_image.c
+    ${SOURCE_DIR}/kmz_color.c
+    ${SOURCE_DIR}/kmz_color_transform.c
+    ${SOURCE_DIR}/kmz_composite.c
     ${SOURCE_DIR}/kmz_core.c
     ${SOURCE_DIR}/kmz_draw.c
+    ${SOURCE_DIR}/kmz_gaussian.c
     ${SOURCE_DIR}/kmz_geometry.c
+    ${SOURCE_DIR}/kmz_histogram.c
     ${SOURCE_DIR}/kmz_image.c
     ${SOURCE_DIR}/kmz_image_file.c
+    ${SOURCE_DIR}/kmz_image_painter.c
+    ${SOURCE_DIR}/kmz_integral.c
+    ${SOURCE_DIR}/kmz_kernel.c
+    ${SOURCE_DIR}/kmz_lut.c
+    ${SOURCE_DIR}/kmz_median.c
+    ${SOURCE_DIR}/kmz_morphology.c
+    ${SOURCE_DIR}/kmz_orient.c
+    ${SOURCE_DIR}/kmz_palette_image.c
+    ${SOURCE_DIR}/kmz_parallel.c
+    ${SOURCE_DIR}/kmz_pipeline.c
+    ${SOURCE_DIR}/kmz_pyramid.c
+    ${SOURCE_DIR}/kmz_quantizer.c
+    ${SOURCE_DIR}/kmz_resample.c
+    ${SOURCE_DIR}/kmz_tile_painter.c
     ${SOURCE_DIR}/kmz_utilities.c)
-set(HEADERS ${SOURCE_DIR}/kmz_color.h
+set(HEADERS ${SOURCE_DIR}/kmz_ahsl_image.h
+    ${SOURCE_DIR}/kmz_color.h
+    ${SOURCE_DIR}/kmz_color_transform.h
+    ${SOURCE_DIR}/kmz_composite.h
     ${SOURCE_DIR}/kmz_core.h
     ${SOURCE_DIR}/kmz_draw.h
+    ${SOURCE_DIR}/kmz_gaussian.h
     ${SOURCE_DIR}/kmz_geometry.h
+    ${SOURCE_DIR}/kmz_histogram.h
     ${SOURCE_DIR}/kmz_image.h
     ${SOURCE_DIR}/kmz_image_file.h
+    ${SOURCE_DIR}/kmz_image_painter.h
+    ${SOURCE_DIR}/kmz_integral.h
+    ${SOURCE_DIR}/kmz_kernel.h
+    ${SOURCE_DIR}/kmz_lut.h
+    ${SOURCE_DIR}/kmz_median.h
+    ${SOURCE_DIR}/kmz_morphology.h
+    ${SOURCE_DIR}/kmz_orient.h
+    ${SOURCE_DIR}/kmz_palette_image.h
+    ${SOURCE_DIR}/kmz_parallel.h
+    ${SOURCE_DIR}/kmz_pipeline.h
+    ${SOURCE_DIR}/kmz_pyramid.h
+    ${SOURCE_DIR}/kmz_quantizer.h
+    ${SOURCE_DIR}/kmz_resample.h
     ${SOURCE_DIR}/kmz_shared.h
+    ${SOURCE_DIR}/kmz_tile_painter.h
     ${SOURCE_DIR}/kmz_utilities.h)
 set(STD_API ${API_DIR}/libkempozer/color.h
     ${API_DIR}/libkempozer/colors.h
@@ -33,6 +33,7 @@
 #ifndef libkempozer_h
 #define libkempozer_h
 
+#include <stddef.h>
 #include <stdint.h>
 
 // region Numeric:
@@ -51,6 +52,7 @@ typedef enum kmz_bool_e KmzBool;
  */
 enum kmz_draw_status_e {
     KMZ_DRAW_OK = 0,
+    KMZ_DRAW_ERR_INVALID_GEOMETRY = -32,
     KMZ_DRAW_ERR_OUT_OF_MEMORY = -64,
     KMZ_DRAW_ERR_UNKNOWN = -1000,
     KMZ_DRAW_ERR_USER = -1024,
@@ -143,11 +145,227 @@ enum kmz_pixel_operation_status_e {
 };
 typedef enum kmz_pixel_operation_status_e KmzPixelOperationStatus;
 
+/**
+ * Defines the SIMD instruction sets that kempozer is able to dispatch its batch kernels to at runtime.
+ */
+enum kmz_simd_level_e {
+    KMZ_SIMD_NONE = 0,
+    KMZ_SIMD_SSE2 = 1,
+    KMZ_SIMD_SSSE3 = 2,
+    KMZ_SIMD_AVX2 = 3,
+};
+typedef enum kmz_simd_level_e KmzSimdLevel;
+
+/**
+ * Defines the algorithms that kempozer is able to use to choose the colors of a palette.
+ */
+enum kmz_quantize_mode_e {
+    /**
+     * Repeatedly splits the box of colors holding the most pixels over the widest range at its median, which preserves large areas of similar colors.
+     */
+    KMZ_QUANTIZE_MEDIAN_CUT = 0,
+    /**
+     * Merges the least significant branches of an octree of colors, which is faster and needs less memory.
+     */
+    KMZ_QUANTIZE_OCTREE = 1,
+};
+typedef enum kmz_quantize_mode_e KmzQuantizeMode;
+
+/**
+ * Defines the operators that kempozer is able to use to composite one image onto another.
+ */
+enum kmz_composite_op_e {
+    /**
+     * Clears the destination.
+     */
+    KMZ_COMPOSITE_CLEAR = 0,
+    /**
+     * Replaces the destination with the source.
+     */
+    KMZ_COMPOSITE_SRC = 1,
+    /**
+     * Keeps the destination.
+     */
+    KMZ_COMPOSITE_DST = 2,
+    /**
+     * Draws the source over the destination.
+     */
+    KMZ_COMPOSITE_SRC_OVER = 3,
+    /**
+     * Draws the destination over the source.
+     */
+    KMZ_COMPOSITE_DST_OVER = 4,
+    /**
+     * Keeps the source where the destination is opaque.
+     */
+    KMZ_COMPOSITE_SRC_IN = 5,
+    /**
+     * Keeps the destination where the source is opaque.
+     */
+    KMZ_COMPOSITE_DST_IN = 6,
+    /**
+     * Keeps the source where the destination is transparent.
+     */
+    KMZ_COMPOSITE_SRC_OUT = 7,
+    /**
+     * Keeps the destination where the source is transparent.
+     */
+    KMZ_COMPOSITE_DST_OUT = 8,
+    /**
+     * Draws the source over the destination where the destination is opaque.
+     */
+    KMZ_COMPOSITE_SRC_ATOP = 9,
+    /**
+     * Draws the destination over the source where the source is opaque.
+     */
+    KMZ_COMPOSITE_DST_ATOP = 10,
+    /**
+     * Keeps the source and the destination where the other is transparent.
+     */
+    KMZ_COMPOSITE_XOR = 11,
+    /**
+     * Adds the source to the destination.
+     */
+    KMZ_COMPOSITE_PLUS = 12,
+    /**
+     * Draws the source over the destination, multiplying the colors where both are opaque.
+     */
+    KMZ_COMPOSITE_MULTIPLY = 13,
+    /**
+     * Draws the source over the destination, screening the colors where both are opaque.
+     */
+    KMZ_COMPOSITE_SCREEN = 14,
+    /**
+     * Draws the source over the destination, multiplying dark and screening light destination colors where both are opaque.
+     */
+    KMZ_COMPOSITE_OVERLAY = 15,
+    /**
+     * Draws the source over the destination, keeping the darker colors where both are opaque.
+     */
+    KMZ_COMPOSITE_DARKEN = 16,
+    /**
+     * Draws the source over the destination, keeping the lighter colors where both are opaque.
+     */
+    KMZ_COMPOSITE_LIGHTEN = 17,
+};
+typedef enum kmz_composite_op_e KmzCompositeOp;
+
+/**
+ * Defines the filters that kempozer is able to use to resample an image.
+ */
+enum kmz_resample_filter_e {
+    /**
+     * Averages every source pixel covered by an output pixel, or repeats the nearest source pixel when enlarging.
+     */
+    KMZ_RESAMPLE_BOX = 0,
+    /**
+     * Interpolates linearly between the nearest source pixels, widened to cover every source pixel when reducing.
+     */
+    KMZ_RESAMPLE_BILINEAR = 1,
+    /**
+     * Interpolates using the Catmull-Rom cubic, which is sharper than {@link KMZ_RESAMPLE_BILINEAR}.
+     */
+    KMZ_RESAMPLE_BICUBIC = 2,
+    /**
+     * Interpolates using a windowed sinc of 3 lobes, which keeps the most detail at the cost of some ringing near sharp edges.
+     */
+    KMZ_RESAMPLE_LANCZOS_3 = 3,
+};
+typedef enum kmz_resample_filter_e KmzResampleFilter;
+
+/**
+ * Defines the filters that kempozer is able to use to halve each level of an image pyramid.
+ */
+enum kmz_pyramid_filter_e {
+    /**
+     * Averages every 2x2 block of pixels.
+     */
+    KMZ_PYRAMID_BOX = 0,
+    /**
+     * Weighs a 4x4 block of pixels by the binomial 1, 3, 3, 1 in both directions, which aliases less than {@link KMZ_PYRAMID_BOX}.
+     */
+    KMZ_PYRAMID_GAUSSIAN = 1,
+};
+typedef enum kmz_pyramid_filter_e KmzPyramidFilter;
+
+/**
+ * Defines the morphological operations that kempozer is able to apply to an image.
+ */
+enum kmz_morphology_op_e {
+    /**
+     * Replaces every channel with its minimum within the structuring element, which shrinks bright and opaque shapes.
+     */
+    KMZ_MORPHOLOGY_ERODE = 0,
+    /**
+     * Replaces every channel with its maximum within the structuring element, which grows bright and opaque shapes.
+     */
+    KMZ_MORPHOLOGY_DILATE = 1,
+    /**
+     * Erodes then dilates, which removes bright specks smaller than the structuring element.
+     */
+    KMZ_MORPHOLOGY_OPEN = 2,
+    /**
+     * Dilates then erodes, which fills dark holes smaller than the structuring element.
+     */
+    KMZ_MORPHOLOGY_CLOSE = 3,
+};
+typedef enum kmz_morphology_op_e KmzMorphologyOp;
+
+/**
+ * Defines the interpolations that kempozer is able to use between the entries of a 3D color lookup table.
+ */
+enum kmz_lut_interpolation_e {
+    /**
+     * Weighs all 8 corners of the cell that holds a color.
+     */
+    KMZ_LUT_TRILINEAR = 0,
+    /**
+     * Weighs the 4 corners of the tetrahedron within the cell that holds a color, which is cheaper than {@link KMZ_LUT_TRILINEAR} and keeps neutral colors neutral.
+     */
+    KMZ_LUT_TETRAHEDRAL = 1,
+};
+typedef enum kmz_lut_interpolation_e KmzLutInterpolation;
+
 /**
  * @return A string containing the version information for kempozer.
  */
 const char * const kmz_version_string(void);
 
+/**
+ * @par Returns the SIMD instruction set currently used by the batch kernels of kempozer.
+ *
+ * @par The level is detected from the running processor the first time it is requested and may be lowered using {@link kmz_set_simd_level}.
+ *
+ * @return The active {@link KmzSimdLevel}.
+ */
+const KmzSimdLevel kmz_simd_level(void);
+
+/**
+ * @par Limits the SIMD instruction set used by the batch kernels of kempozer.
+ *
+ * @par The requested level is clamped to the highest level supported by the running processor, so this may only be used to lower the active level. Every level produces identical results.
+ *
+ * @param level The highest {@link KmzSimdLevel} that may be used.
+ * @return The {@link KmzSimdLevel} that is active after the change.
+ */
+const KmzSimdLevel kmz_set_simd_level(const KmzSimdLevel level);
+
+/**
+ * @par Returns the number of threads used by the parallel operations of kempozer when no explicit thread count is given.
+ *
+ * @par Unless changed using {@link kmz_set_thread_count}, this is the number of processors currently online.
+ *
+ * @return The default thread count, which is always at least 1.
+ */
+const size_t kmz_thread_count(void);
+
+/**
+ * Changes the number of threads used by the parallel operations of kempozer when no explicit thread count is given.
+ *
+ * @param threads The new default thread count, or 0 to use the number of processors currently online.
+ */
+void kmz_set_thread_count(const size_t threads);
+
 // endregion;
 
 #endif /* libkempozer_h */
@@ -179,4 +179,28 @@ const kmz_color_32 kmz_color_32__from_ahsl_color(const KmzAhslColor color);
  */
 const kmz_color_32 kmz_color_32__from_hex(kmz_hex_string color);
 
+
+
+/**
+ * @par Converts a span of single value ARGB colors into AHSL structures.
+ *
+ * @par The conversion is dispatched at runtime to the widest SIMD kernel supported by the processor, see {@link kmz_simd_level}. Every kernel produces results identical to {@link KmzAhslColor__from_color_32}.
+ *
+ * @param colors The span of {@link kmz_color_32} values to convert.
+ * @param buffer The span of {@link KmzAhslColor} structures to write the converted colors to. It MUST NOT overlap `colors`.
+ * @param count The total number of colors within both spans.
+ */
+void kmz_color_32__to_ahsl_span(const kmz_color_32 * const colors, KmzAhslColor * const buffer, const size_t count);
+
+/**
+ * @par Converts a span of AHSL structures into single value ARGB colors.
+ *
+ * @par The conversion is dispatched at runtime to the widest SIMD kernel supported by the processor, see {@link kmz_simd_level}. Every kernel produces results identical to {@link kmz_color_32__from_ahsl_color} for all finite channels.
+ *
+ * @param colors The span of {@link KmzAhslColor} structures to convert.
+ * @param buffer The span of {@link kmz_color_32} values to write the converted colors to. It MUST NOT overlap `colors`.
+ * @param count The total number of colors within both spans.
+ */
+void kmz_color_32__from_ahsl_span(const KmzAhslColor * const colors, kmz_color_32 * const buffer, const size_t count);
+
 #endif /* libkempozer_color_h */
@@ -122,6 +122,24 @@ struct kmz_pattern_type_t {
     void (* const _dtor)(void * const me);
 
     // endregion;
+
+    // region Version 2:
+
+    /**
+     * @par Returns the color of the pattern represented by this {@link KmzPatternType} at the given position of the image being painted.
+     *
+     * @par This method MUST:
+     * * be defined for the pattern to be painted by {@link kmz_image_painter}
+     * * return a fully transparent color if `me` is {@link NULL}
+     * * accept the appropriate pointer type for the pattern being accessed instead of `void * const`.
+     *
+     * @param me A pointer to an initialized pattern represented by this {@link KmzPatternType}.
+     * @param point The position within the image being painted.
+     * @return The color of the pattern at `point`.
+     */
+    const kmz_color_32 (* const color_at)(const void * const me, const KmzPoint point);
+
+    // endregion;
 };
 typedef struct kmz_pattern_type_t KmzPatternType;
 
@@ -129,6 +147,15 @@ KmzPattern * const KmzPattern__new(const KmzPatternType * const type, const void
 
 void KmzPattern__free(KmzPattern * const me);
 
+/**
+ * Returns the color of the targeted {@link KmzPattern} at the given position.
+ *
+ * @param me The target of this invocation.
+ * @param point The position within the image being painted.
+ * @return The color of the pattern at `point`, or transparent black if its type doesn't define `color_at`.
+ */
+const kmz_color_32 KmzPattern__color_at(const KmzPattern * const me, const KmzPoint point);
+
 /**
  * Defines the methods available to an abstract painter within kempozer.
  */
@@ -502,6 +529,18 @@ const KmzDrawStatus KmzPainter__draw_rectanglef(KmzPainter * const me, const Kmz
 
 const KmzDrawStatus KmzPainter__paint(KmzPainter * const me, KmzImage * const image);
 
+/**
+ * Saves the contents of the targeted {@link KmzPainter} at the provided position within the provided image.
+ *
+ * @param me The target of this invocation.
+ * @param pos The position within `image` to draw the contents to.
+ * @param image The image to draw the contents to.
+ * @return {@link KMZ_DRAW_OK} if the drawing operation is successful, otherwise an appropriate value from {@link KmzDrawStatus}.
+ *
+ * @see KmzPainterType#paint
+ */
+const KmzDrawStatus KmzPainter__paint_at(KmzPainter * const me, const KmzPoint pos, KmzImage * const image);
+
 const KmzBool KmzPainter__redo(KmzPainter * const me);
 
 const KmzBool KmzPainter__undo(KmzPainter * const me);
@@ -510,4 +549,40 @@ extern const KmzBrush KmzBrush__TRANSPARENT;
 
 extern const KmzPen KmzPen__TRANSPARENT;
 
+/**
+ * @par Creates a new painter of the type {@link kmz_image_painter} that draws directly onto the provided image.
+ *
+ * @par The painter starts with {@link KmzBrush__TRANSPARENT} and {@link KmzPen__TRANSPARENT}, so a brush or pen MUST be set before anything is drawn. `image` MUST outlive the painter.
+ *
+ * @param image The image to draw onto.
+ * @param history The number of changes that may be undone, or 0 to disable {@link KmzPainter__undo} and {@link KmzPainter__redo}.
+ * @return A pointer to a new {@link KmzPainter}, or {@link NULL} if there isn't enough memory.
+ */
+KmzPainter * const KmzPainter__new_for_image(KmzImage * const image, const size_t history);
+
+/**
+ * @par A scanline {@link KmzPainterType} that draws onto a {@link KmzImage} as implemented by kempozer.
+ *
+ * @par Solid shapes are filled one span at a time with an active edge table and written to the image a whole row span at a time. Lines are drawn using Bresenham's algorithm, or Wu's algorithm if the pen is antialiased, and circles are drawn using the midpoint algorithm. Pens wider than a pixel are drawn as filled shapes. Lines are clipped to the image before they're rasterized and circles only compute the rows that cross the image, so shapes reaching far beyond the image cost no more than the part of them that's visible, while shapes with a coordinate that isn't finite are rejected with {@link KMZ_DRAW_ERR_INVALID_GEOMETRY}. Translucent colors are blended with the image, where an alpha of 0 is opaque and 127 is transparent. Painting a painter onto another image blends the whole image of the painter at the given position. It should only be allocated using {@link KmzPainter__new_for_image}.
+ */
+extern const KmzPainterType kmz_image_painter;
+
+/**
+ * @par Creates a new painter of the type {@link kmz_tile_painter} that records shapes for a canvas of the provided size.
+ *
+ * @par The painter starts with {@link KmzBrush__TRANSPARENT} and {@link KmzPen__TRANSPARENT}, so a brush or pen MUST be set before anything is drawn. Any pattern used by a brush MUST outlive the painter.
+ *
+ * @param dimen The size of the canvas, where shapes outside of it are discarded when painted.
+ * @param threads The number of threads used by {@link KmzPainter__paint}, or 0 to use {@link kmz_thread_count}.
+ * @return A pointer to a new {@link KmzPainter}, or {@link NULL} if there isn't enough memory.
+ */
+KmzPainter * const KmzPainter__new_binned(const KmzSize dimen, const size_t threads);
+
+/**
+ * @par A binned {@link KmzPainterType} that records shapes and rasterizes them into an image with antialiasing when painted as implemented by kempozer.
+ *
+ * @par Every shape is recorded as a list of edges and binned into each 64x64 tile of the canvas it touches. Painting rasterizes the tiles in parallel, computing the exact area of each pixel covered by a shape using the nonzero winding rule, so every tile of the image is read and written once regardless of how many shapes cover it. Solid shapes are always antialiased, while lines are only antialiased if the pen is. Coordinates of lines, points and circles are the centers of pixels, while coordinates of filled polygons and rectangles are the edges of pixels, matching {@link kmz_image_painter}. Undoing and redoing only changes which of the recorded shapes are painted. It should only be allocated using {@link KmzPainter__new_binned}.
+ */
+extern const KmzPainterType kmz_tile_painter;
+
 #endif /* libkempozer_draw_h */
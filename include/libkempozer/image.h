@@ -177,6 +177,81 @@ struct kmz_image_type_t {
      */
     const KmzPixelOperationStatus (* const write_argb_block)(void * const me, const KmzRectangle area, const kmz_color_32 * const buffer);
     // endregion;
+
+    // region Version 2 methods:
+
+    /**
+     * @par Reads a horizontal span of ARGB values starting at the given coordinates in the image represented by this {@link KmzImageType}.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * return the appropriate {@link KmzPixelOperationStatus} if the span doesn't fit within a single row of the image or `buffer` is invalid
+     * * accept the appropriate pointer type for the image being accessed through `me` instead of `void * const`.
+     *
+     * @param me A pointer to an initialized image represented by this {@link KmzImageType}.
+     * @param start The first point of the span.
+     * @param count The number of pixels in the span.
+     * @param buffer A pointer to an initialized block of memory to read `count` ARGB values into.
+     * @return {@link KMZ_PIXEL_OP_OK} if the span was successfully read, otherwise an appropriate value from {@link KmzPixelOperationStatus}.
+     */
+    const KmzPixelOperationStatus (* const read_row_span)(const void * const me, const KmzPoint start, const size_t count, kmz_color_32 * const buffer);
+
+    /**
+     * @par Writes a horizontal span of ARGB values starting at the given coordinates to the image represented by this {@link KmzImageType}.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * return the appropriate {@link KmzPixelOperationStatus} if the span doesn't fit within a single row of the image or `buffer` is invalid
+     * * accept the appropriate pointer type for the image being accessed through `me` instead of `void * const`.
+     *
+     * @param me A pointer to an initialized image represented by this {@link KmzImageType}.
+     * @param start The first point of the span.
+     * @param count The number of pixels in the span.
+     * @param buffer A pointer to an initialized block of `count` ARGB values to write into `me`.
+     * @return {@link KMZ_PIXEL_OP_OK} if the span was successfully written, otherwise an appropriate value from {@link KmzPixelOperationStatus}.
+     */
+    const KmzPixelOperationStatus (* const write_row_span)(void * const me, const KmzPoint start, const size_t count, const kmz_color_32 * const buffer);
+
+    /**
+     * @par Reads the ARGB values at every point of a list from the image represented by this {@link KmzImageType}.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * read {@link kmz_color_32__ZERO} for every invalid point
+     * * return {@link KMZ_PIXEL_OP_ERR_READ_INVALID_PTR} if `points` or `buffer` is {@link NULL}
+     * * accept the appropriate pointer type for the image being accessed through `me` instead of `void * const`.
+     *
+     * @param me A pointer to an initialized image represented by this {@link KmzImageType}.
+     * @param points The points to read.
+     * @param count The number of points to read.
+     * @param buffer A pointer to an initialized block of memory to read `count` ARGB values into.
+     * @return {@link KMZ_PIXEL_OP_OK} if the points were successfully read, otherwise an appropriate value from {@link KmzPixelOperationStatus}.
+     */
+    const KmzPixelOperationStatus (* const gather)(const void * const me, const KmzPoint * const points, const size_t count, kmz_color_32 * const buffer);
+
+    /**
+     * @par Writes an ARGB value to every point of a list in the image represented by this {@link KmzImageType}.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * skip every invalid point
+     * * write the points in order, so that the last value written to a point repeated within `points` is kept
+     * * return {@link KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR} if `points` or `buffer` is {@link NULL}
+     * * accept the appropriate pointer type for the image being accessed through `me` instead of `void * const`.
+     *
+     * @param me A pointer to an initialized image represented by this {@link KmzImageType}.
+     * @param points The points to write.
+     * @param count The number of points to write.
+     * @param buffer A pointer to an initialized block of `count` ARGB values to write into `me`.
+     * @return {@link KMZ_PIXEL_OP_OK} if the points were successfully written, otherwise an appropriate value from {@link KmzPixelOperationStatus}.
+     */
+    const KmzPixelOperationStatus (* const scatter)(void * const me, const KmzPoint * const points, const size_t count, const kmz_color_32 * const buffer);
+
+    // endregion;
 };
 typedef struct kmz_image_type_t KmzImageType;
 
@@ -192,6 +267,98 @@ typedef struct kmz_image_t KmzImage;
 struct kmz_matrix_t;
 typedef struct kmz_matrix_t KmzMatrix;
 
+/**
+ * Defines an opaque convolution kernel within kempozer.
+ */
+struct kmz_kernel_t;
+typedef struct kmz_kernel_t KmzKernel;
+
+/**
+ * Defines an opaque image pyramid within kempozer.
+ */
+struct kmz_pyramid_t;
+typedef struct kmz_pyramid_t KmzPyramid;
+
+/**
+ * Defines an opaque summed-area table of an image within kempozer.
+ */
+struct kmz_integral_image_t;
+typedef struct kmz_integral_image_t KmzIntegralImage;
+
+/**
+ * Defines an opaque 3D color lookup table within kempozer.
+ */
+struct kmz_color_lut_3d_t;
+typedef struct kmz_color_lut_3d_t KmzColorLut3D;
+
+/**
+ * Defines an opaque chain of color adjustments within kempozer, which is compiled once into lookup tables.
+ */
+struct kmz_color_transform_t;
+typedef struct kmz_color_transform_t KmzColorTransform;
+
+/**
+ * Defines an opaque chain of filters, kernels, color transforms and composites within kempozer, which is run over an image tile by tile.
+ */
+struct kmz_pipeline_t;
+typedef struct kmz_pipeline_t KmzPipeline;
+
+/**
+ * The number of bins of every channel of a {@link KmzHistogram}.
+ */
+#define KMZ_HISTOGRAM_BINS 256
+
+/**
+ * Defines the number of pixels of an area of an image that fall into each bin of every channel.
+ */
+struct kmz_histogram_t {
+    /**
+     * The number of pixels within the area.
+     */
+    uint64_t count;
+    /**
+     * The number of pixels of every 7-bit alpha value, where 0 is opaque and 127 is transparent. The bins past 127 are always 0.
+     */
+    uint64_t a[KMZ_HISTOGRAM_BINS];
+    uint64_t r[KMZ_HISTOGRAM_BINS];
+    uint64_t g[KMZ_HISTOGRAM_BINS];
+    uint64_t b[KMZ_HISTOGRAM_BINS];
+    /**
+     * The number of pixels within every equal range of hue, saturation and lightness, which are only filled when requested.
+     */
+    uint64_t h[KMZ_HISTOGRAM_BINS];
+    uint64_t s[KMZ_HISTOGRAM_BINS];
+    uint64_t l[KMZ_HISTOGRAM_BINS];
+};
+typedef struct kmz_histogram_t KmzHistogram;
+
+/**
+ * Defines the statistics of a single channel of an area of an image.
+ */
+struct kmz_channel_stats_t {
+    kmz_channel min;
+    kmz_channel max;
+    double mean;
+    double variance;
+    /**
+     * The lowest value that at least the given percent of the pixels are lower than or equal to, for every whole percent from 0 to 100.
+     */
+    kmz_channel percentiles[101];
+};
+typedef struct kmz_channel_stats_t KmzChannelStats;
+
+/**
+ * Defines the statistics of every ARGB channel of an area of an image.
+ */
+struct kmz_image_stats_t {
+    uint64_t count;
+    KmzChannelStats a;
+    KmzChannelStats r;
+    KmzChannelStats g;
+    KmzChannelStats b;
+};
+typedef struct kmz_image_stats_t KmzImageStats;
+
 /**
  * Defines a function that is capable of applying a filter to an image using the given {@link KmzMatrix}.
  *
@@ -340,7 +507,7 @@ void KmzImage__set_argb_at(KmzImage * const me, const KmzPoint point, const kmz_
 /**
  * @par Reads a block of ARGB colors within the target {@link KmzImage} into the provided buffer.
  *
- * @par If the target {@link KmzImage} does not provide an implementation for this method, then a fallback implementation will be used. This fallback implementation will require individual reads to {@link KmzImage__argb_at} and will be substantially slower than a native implementation, so its encouraged that all inheritors implement this method.
+ * @par If the target {@link KmzImage} does not provide an implementation for this method, then a fallback implementation will be used. This fallback implementation reads one row at a time using {@link KmzImage__read_row_span} when the image provides `read_row_span`, otherwise it requires individual reads to {@link KmzImage__argb_at} and will be substantially slower than a native implementation, so its encouraged that all inheritors implement this method.
  *
  * @param me The target of this invocation.
  * @param area The area of this image to read into the buffer.
@@ -354,7 +521,7 @@ const KmzPixelOperationStatus KmzImage__read_argb_block(const KmzImage * const m
 /**
  * @par Writes a block of ARGB colors to the target {@link KmzImage} from the provided buffer.
  *
- * @par If the target {@link KmzImage} does not provide an implementation for this method, then a fallback implementation will be used. This fallback implementation will require individual writes to {@link KmzImage__set_argb_at} and will be substantially slower than a native implementation, so its encouraged that all inheritors implement this method.
+ * @par If the target {@link KmzImage} does not provide an implementation for this method, then a fallback implementation will be used. This fallback implementation writes one row at a time using {@link KmzImage__write_row_span} when the image provides `write_row_span`, otherwise it requires individual writes to {@link KmzImage__set_argb_at} and will be substantially slower than a native implementation, so its encouraged that all inheritors implement this method.
  *
  * @param me The target of this invocation.
  * @param area The area of this image to write the buffer to.
@@ -365,6 +532,66 @@ const KmzPixelOperationStatus KmzImage__read_argb_block(const KmzImage * const m
  */
 const KmzPixelOperationStatus KmzImage__write_argb_block(KmzImage * const me, const KmzRectangle area, const kmz_color_32 * const buffer);
 
+/**
+ * @par Reads a horizontal span of ARGB colors within the target {@link KmzImage} into the provided buffer.
+ *
+ * @par If the target {@link KmzImage} does not provide an implementation for this method, then its `read_argb_block` implementation is used for a single row, falling back to individual reads to {@link KmzImage__argb_at}.
+ *
+ * @param me The target of this invocation.
+ * @param start The first point of the span.
+ * @param count The number of pixels in the span.
+ * @param buffer The buffer to read into.
+ * @return {@link KMZ_PIXEL_OP_OK} if the read operation is successful, otherwise the appropriate {@link KmzPixelOperationStatus}.
+ *
+ * @see KmzImageType#read_row_span
+ */
+const KmzPixelOperationStatus KmzImage__read_row_span(const KmzImage * const me, const KmzPoint start, const size_t count, kmz_color_32 * const buffer);
+
+/**
+ * @par Writes a horizontal span of ARGB colors to the target {@link KmzImage} from the provided buffer.
+ *
+ * @par If the target {@link KmzImage} does not provide an implementation for this method, then its `write_argb_block` implementation is used for a single row, falling back to individual writes to {@link KmzImage__set_argb_at}.
+ *
+ * @param me The target of this invocation.
+ * @param start The first point of the span.
+ * @param count The number of pixels in the span.
+ * @param buffer The buffer to read from.
+ * @return {@link KMZ_PIXEL_OP_OK} if the write operation is successful, otherwise the appropriate {@link KmzPixelOperationStatus}.
+ *
+ * @see KmzImageType#write_row_span
+ */
+const KmzPixelOperationStatus KmzImage__write_row_span(KmzImage * const me, const KmzPoint start, const size_t count, const kmz_color_32 * const buffer);
+
+/**
+ * @par Reads the ARGB color at every point of a list within the target {@link KmzImage}, reading {@link kmz_color_32__ZERO} for every invalid point.
+ *
+ * @par If the target {@link KmzImage} does not provide an implementation for this method, then a fallback implementation using {@link KmzImage__argb_at} is used.
+ *
+ * @param me The target of this invocation.
+ * @param points The points to read.
+ * @param count The number of points to read.
+ * @param buffer The buffer to read into.
+ * @return {@link KMZ_PIXEL_OP_OK} if the read operation is successful, otherwise the appropriate {@link KmzPixelOperationStatus}.
+ *
+ * @see KmzImageType#gather
+ */
+const KmzPixelOperationStatus KmzImage__gather(const KmzImage * const me, const KmzPoint * const points, const size_t count, kmz_color_32 * const buffer);
+
+/**
+ * @par Writes an ARGB color to every point of a list within the target {@link KmzImage}, skipping every invalid point.
+ *
+ * @par If the target {@link KmzImage} does not provide an implementation for this method, then a fallback implementation using {@link KmzImage__set_argb_at} is used.
+ *
+ * @param me The target of this invocation.
+ * @param points The points to write.
+ * @param count The number of points to write.
+ * @param buffer The buffer to read from.
+ * @return {@link KMZ_PIXEL_OP_OK} if the write operation is successful, otherwise the appropriate {@link KmzPixelOperationStatus}.
+ *
+ * @see KmzImageType#scatter
+ */
+const KmzPixelOperationStatus KmzImage__scatter(KmzImage * const me, const KmzPoint * const points, const size_t count, const kmz_color_32 * const buffer);
+
 /**
  * Determines if the provided {@link KmzPoint} is within the target {@link KmzImage}.
  *
@@ -414,6 +641,28 @@ const KmzPixelOperationStatus KmzImage__apply_buffered_filter(const KmzImage * c
         const size_t m_size,
         KmzImage * const buffer);
 
+/**
+ * @par Applies a filter operation to the target {@link KmzImage} like {@link KmzImage__apply_buffered_filter}, but splits `area` into tiles that are filtered by a pool of worker threads.
+ *
+ * @par Every worker uses its own {@link KmzMatrix} over a tile buffer with a halo of `m_size / 2` pixels, and every tile is written to `buffer` using {@link KmzImage__write_argb_block}, so the result is identical to that of {@link KmzImage__apply_buffered_filter}. `filter` MUST be safe to invoke from multiple threads at once with the same `argv`.
+ *
+ * @param me The target of this invocation.
+ * @param argv The argument to pass to `filter`.
+ * @param filter The filter to apply to the region of the target {@link KmzImage}.
+ * @param area The area within the target {@link KmzImage} to apply the filter to.
+ * @param m_size The size of matrix to use.
+ * @param buffer The buffer to write all changes to, which MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if `filter` is applied to the image, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__apply_parallel_filter(const KmzImage * const me,
+        const void * const argv,
+        const KmzFilter filter,
+        const KmzRectangle area,
+        const size_t m_size,
+        KmzImage * const buffer,
+        const size_t threads);
+
 /**
  * Creates a new image using the provided file.
  *
@@ -421,6 +670,17 @@ const KmzPixelOperationStatus KmzImage__apply_buffered_filter(const KmzImage * c
  */
 KmzImage * const KmzImage__new_from_file(KmzImageFile * const file);
 
+/**
+ * @par Creates a new image that borrows the truecolor pixels held in memory by the provided file instead of copying them.
+ *
+ * @par If the file doesn't expose its truecolor pixels, this behaves like {@link KmzImage__new_from_file}. Otherwise the image MUST be freed before `file` is freed or another image is loaded into it, and changes made to the image are visible through `file`.
+ *
+ * @param file The file of the image, usually mapped using {@link KmzImageFile__map}.
+ *
+ * @see KmzImageFile__truecolor_pixels()
+ */
+KmzImage * const KmzImage__new_borrowed_from_file(KmzImageFile * const file);
+
 /**
  * Creates a new image using the provided buffer.
  *
@@ -437,4 +697,805 @@ KmzImage * const KmzImage__new_from_buffer(const KmzSize dimen, kmz_color_32 * c
  */
 extern const KmzImageType kmz_image;
 
+/**
+ * Creates a new planar AHSL image that contains the colors of the provided image.
+ *
+ * @param image The image to convert.
+ * @return A pointer to a {@link KmzImage} of the type {@link kmz_ahsl_image}, or {@link NULL} if there isn't enough memory or `image` can't be read.
+ */
+KmzImage * const KmzImage__new_ahsl_from_image(const KmzImage * const image);
+
+/**
+ * @par Creates a new planar AHSL image using the provided file.
+ *
+ * @par AHSL files are split directly into planes without being converted to ARGB first.
+ *
+ * @param file The file of the image.
+ * @return A pointer to a {@link KmzImage} of the type {@link kmz_ahsl_image}, or {@link NULL} if there isn't enough memory.
+ */
+KmzImage * const KmzImage__new_ahsl_from_file(KmzImageFile * const file);
+
+/**
+ * @par Rotates the hue of every pixel within the given area of the target {@link KmzImage}.
+ *
+ * @par Images of the type {@link kmz_ahsl_image} only have their hue plane updated. Images of the type {@link kmz_palette_image} only have their palette updated when `area` covers the entire image. Every other image is converted to AHSL one row at a time.
+ *
+ * @param me The target of this invocation.
+ * @param area The area within the target {@link KmzImage} to adjust.
+ * @param amount The fraction of a full turn to rotate the hue by, where 0.5 is 180 degrees. Negative values rotate backwards.
+ * @return {@link KMZ_PIXEL_OP_OK} if the adjustment is applied, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__rotate_hue(KmzImage * const me, const KmzRectangle area, const kmz_percent amount);
+
+/**
+ * @par Multiplies the saturation of every pixel within the given area of the target {@link KmzImage}, clamping the result between 0 and 1.
+ *
+ * @par Images of the type {@link kmz_ahsl_image} only have their saturation plane updated. Images of the type {@link kmz_palette_image} only have their palette updated when `area` covers the entire image. Every other image is converted to AHSL one row at a time.
+ *
+ * @param me The target of this invocation.
+ * @param area The area within the target {@link KmzImage} to adjust.
+ * @param factor The factor to multiply the saturation by, where 0 produces grays and 1 leaves the image unchanged.
+ * @return {@link KMZ_PIXEL_OP_OK} if the adjustment is applied, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__saturate(KmzImage * const me, const KmzRectangle area, const kmz_percent factor);
+
+/**
+ * @par Adds to the luminosity of every pixel within the given area of the target {@link KmzImage}, clamping the result between 0 and 1.
+ *
+ * @par Images of the type {@link kmz_ahsl_image} only have their luminosity plane updated. Images of the type {@link kmz_palette_image} only have their palette updated when `area` covers the entire image. Every other image is converted to AHSL one row at a time.
+ *
+ * @param me The target of this invocation.
+ * @param area The area within the target {@link KmzImage} to adjust.
+ * @param amount The amount to add to the luminosity. Negative values darken the image.
+ * @return {@link KMZ_PIXEL_OP_OK} if the adjustment is applied, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__lighten(KmzImage * const me, const KmzRectangle area, const kmz_percent amount);
+
+/**
+ * @par A planar AHSL {@link KmzImageType} as implemented by kempozer.
+ *
+ * @par This implementation stores the hue, saturation, luminosity and alpha channels of the image as separate planes that each begin on a cache line. The hue, saturation and luminosity are kept as 16-bit fixed point values, which takes 7 bytes per pixel instead of the 16 bytes of a {@link KmzAhslColor} while every ARGB color still survives being stored and loaded unchanged. Hue rotations wrap around exactly, and every adjustment is rounded to the nearest 1/65535. ARGB access converts through {@link kmz_color_32__to_ahsl_span} and {@link kmz_color_32__from_ahsl_span}. It should only be allocated using {@link KmzImage__new_ahsl_from_image} and {@link KmzImage__new_ahsl_from_file}.
+ */
+extern const KmzImageType kmz_ahsl_image;
+
+/**
+ * @par Creates a new palette image using the provided palette file.
+ *
+ * @par The palette and the 8-bit index of every pixel are kept as they are stored in the file instead of being converted to ARGB.
+ *
+ * @param file The file of the image.
+ * @return A pointer to a {@link KmzImage} of the type {@link kmz_palette_image}, or {@link NULL} if there isn't enough memory or `file` doesn't contain a palette image.
+ */
+KmzImage * const KmzImage__new_palette_from_file(KmzImageFile * const file);
+
+/**
+ * @par Creates a new palette image using the provided palette and buffer of indices.
+ *
+ * @par Indices beyond `color_count` are kept and read as {@link kmz_color_32} 0 until the palette is extended using {@link KmzImage__write_palette}.
+ *
+ * @param dimen The dimensions of the image.
+ * @param palette The colors of the palette, or {@link NULL} to start with a palette of `color_count` colors that are all 0.
+ * @param color_count The number of colors within `palette`, which is limited to 256.
+ * @param indices The palette index of every pixel of the image, or {@link NULL} to start with every pixel using the first color.
+ * @param copy_source {@link KMZ_TRUE} if `indices` should be copied, otherwise {@link KMZ_FALSE}.
+ * @return A pointer to a {@link KmzImage} of the type {@link kmz_palette_image}, or {@link NULL} if there isn't enough memory.
+ */
+KmzImage * const KmzImage__new_palette_from_buffer(const KmzSize dimen, const kmz_color_32 * const palette, const size_t color_count,
+        uint8_t * const indices, const KmzBool copy_source);
+
+/**
+ * Returns the number of colors within the palette of the target {@link KmzImage}.
+ *
+ * @param me The target of this invocation.
+ * @return The number of colors within the palette, or 0 if the target isn't of the type {@link kmz_palette_image}.
+ */
+const size_t KmzImage__palette_color_count(const KmzImage * const me);
+
+/**
+ * @par Returns the palette index of every pixel of the target {@link KmzImage}, stored row by row.
+ *
+ * @par Indices written through the returned pointer MUST be lower than {@link KmzImage__palette_color_count}.
+ *
+ * @param me The target of this invocation.
+ * @return A pointer to the indices held by the target, or {@link NULL} if the target isn't of the type {@link kmz_palette_image}.
+ */
+uint8_t * const KmzImage__palette_indices(KmzImage * const me);
+
+/**
+ * Reads the palette of the target {@link KmzImage}.
+ *
+ * @param me The target of this invocation.
+ * @param colors A pointer to an initialized block of memory to read {@link KmzImage__palette_color_count} colors into.
+ * @return {@link KMZ_PIXEL_OP_OK} if the palette was read, or {@link KMZ_PIXEL_OP_ERR_READ_INVALID_PTR} if `colors` is {@link NULL} or the target isn't of the type {@link kmz_palette_image}.
+ */
+const KmzPixelOperationStatus KmzImage__read_palette(const KmzImage * const me, kmz_color_32 * const colors);
+
+/**
+ * @par Replaces the first `count` colors of the palette of the target {@link KmzImage}, which recolors every pixel using those colors at once.
+ *
+ * @par The palette grows to `count` colors if it is smaller, but never shrinks.
+ *
+ * @param me The target of this invocation.
+ * @param colors The new colors of the palette.
+ * @param count The number of colors to replace, which is limited to 256.
+ * @return {@link KMZ_PIXEL_OP_OK} if the palette was written, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__write_palette(KmzImage * const me, const kmz_color_32 * const colors, const size_t count);
+
+/**
+ * @par Chooses a palette of up to `color_count` colors that represents the colors of the provided image.
+ *
+ * @par Colors are counted in parallel within a histogram of 5 bits per color channel that keeps opaque, translucent and fully transparent pixels apart. Images of more than 4194304 pixels are sampled on a regular grid instead of being counted in full.
+ *
+ * @param me The target of this invocation.
+ * @param mode The {@link KmzQuantizeMode} used to choose the colors.
+ * @param color_count The maximum number of colors to choose, which is clamped between 1 and 256.
+ * @param palette A pointer to an initialized block of memory to write the chosen colors into, which MUST hold `color_count` colors.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return The number of colors written to `palette`, or 0 if the image is empty, can't be read or there isn't enough memory.
+ */
+const size_t KmzImage__quantize(const KmzImage * const me, const KmzQuantizeMode mode, const size_t color_count, kmz_color_32 * const palette,
+        const size_t threads);
+
+/**
+ * @par Creates a new palette image that represents the provided image using a palette chosen by {@link KmzImage__quantize}.
+ *
+ * @par Every pixel is remapped in parallel through an inverse colormap that holds the palette color nearest to every histogram bin. Bins are only resolved once one of their colors is found, so remapping costs a single table lookup per pixel.
+ *
+ * @param image The image to convert.
+ * @param mode The {@link KmzQuantizeMode} used to choose the colors.
+ * @param color_count The maximum number of colors of the palette, which is clamped between 1 and 256.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return A pointer to a {@link KmzImage} of the type {@link kmz_palette_image}, or {@link NULL} if there isn't enough memory or `image` can't be read.
+ */
+KmzImage * const KmzImage__new_palette_from_image(const KmzImage * const image, const KmzQuantizeMode mode, const size_t color_count,
+        const size_t threads);
+
+/**
+ * @par A palette {@link KmzImageType} as implemented by kempozer.
+ *
+ * @par This implementation stores a palette of up to 256 colors and a single 8-bit index per pixel, which takes a quarter of the memory of {@link kmz_image}. ARGB reads look every index up within the palette. ARGB writes reuse the palette color of the exact same value, append new colors while the palette has fewer than 256 colors and use the nearest palette color otherwise. {@link KmzImage__rotate_hue}, {@link KmzImage__saturate} and {@link KmzImage__lighten} only adjust the palette when they cover the entire image. It should only be allocated using {@link KmzImage__new_palette_from_file}, {@link KmzImage__new_palette_from_buffer} and {@link KmzImage__new_palette_from_image}.
+ */
+extern const KmzImageType kmz_palette_image;
+
+/**
+ * @par Creates a new convolution kernel from a `size` by `size` matrix of weights stored row by row.
+ *
+ * @par Weights are converted to fixed point with as many fractional bits as the kernel allows without overflowing, up to 14, and the center weight absorbs the rounding error so that the sum of the weights is preserved.
+ *
+ * @param size The number of weights across the kernel, which MUST be odd.
+ * @param weights The `size * size` weights of the kernel.
+ * @return A pointer to a new {@link KmzKernel}, or {@link NULL} if `size` is even, a weight can't be represented or there isn't enough memory.
+ */
+KmzKernel * const KmzKernel__new(const size_t size, const float * const weights);
+
+/**
+ * Creates a new convolution kernel from a `size` by `size` matrix of integer weights stored row by row, where every weight is divided by `divisor`.
+ *
+ * @param size The number of weights across the kernel, which MUST be odd.
+ * @param weights The `size * size` weights of the kernel.
+ * @param divisor The divisor of every weight, which MUST NOT be 0.
+ * @return A pointer to a new {@link KmzKernel}, or {@link NULL} if the kernel can't be created.
+ *
+ * @see KmzKernel__new()
+ */
+KmzKernel * const KmzKernel__new_from_integers(const size_t size, const int32_t * const weights, const int32_t divisor);
+
+/**
+ * @par Creates a new separable convolution kernel, which is equivalent to the kernel whose weight at `x, y` is `h_weights[x] * v_weights[y]`.
+ *
+ * @par Separable kernels are applied as a horizontal pass followed by a vertical pass, which takes `2 * size` multiplications per channel instead of `size * size`.
+ *
+ * @param size The number of weights in each pass, which MUST be odd.
+ * @param h_weights The `size` weights of the horizontal pass.
+ * @param v_weights The `size` weights of the vertical pass.
+ * @return A pointer to a new {@link KmzKernel}, or {@link NULL} if the kernel can't be created.
+ */
+KmzKernel * const KmzKernel__new_separable(const size_t size, const float * const h_weights, const float * const v_weights);
+
+/**
+ * Creates a new separable kernel that replaces every pixel with the mean of the `size` by `size` pixels around it.
+ *
+ * @param size The number of pixels across the kernel, which MUST be odd.
+ * @return A pointer to a new {@link KmzKernel}, or {@link NULL} if the kernel can't be created.
+ */
+KmzKernel * const KmzKernel__new_box(const size_t size);
+
+/**
+ * Creates a new separable Gaussian blur kernel.
+ *
+ * @param size The number of pixels across the kernel, which MUST be odd.
+ * @param sigma The standard deviation of the Gaussian, or a value of 0 or lower to derive one from `size`.
+ * @return A pointer to a new {@link KmzKernel}, or {@link NULL} if the kernel can't be created.
+ */
+KmzKernel * const KmzKernel__new_gaussian(const size_t size, const float sigma);
+
+/**
+ * Frees the targeted {@link KmzKernel}.
+ *
+ * @param me The target of this invocation.
+ */
+void KmzKernel__free(KmzKernel * const me);
+
+/**
+ * @param me The target of this invocation.
+ * @return The number of pixels across the targeted {@link KmzKernel}.
+ */
+const size_t KmzKernel__size(const KmzKernel * const me);
+
+/**
+ * @param me The target of this invocation.
+ * @return {@link KMZ_TRUE} if the targeted {@link KmzKernel} is applied as separate horizontal and vertical passes, otherwise {@link KMZ_FALSE}.
+ */
+const KmzBool KmzKernel__is_separable(const KmzKernel * const me);
+
+/**
+ * @par Convolves the given area of the target {@link KmzImage} with the provided {@link KmzKernel}.
+ *
+ * @par The area is read into the same zero padded buffer used by {@link KmzImage__apply_buffered_filter}, so pixels outside of `area` count as transparent black. Each of the alpha, red, green and blue channels is convolved separately using fixed point arithmetic, then rounded and clamped between 0 and 255. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param kernel The kernel to convolve the image with.
+ * @param area The area within the target {@link KmzImage} to convolve.
+ * @param buffer The image to write the result to, which MAY be the target {@link KmzImage}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the kernel is applied to the image, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__apply_kernel(const KmzImage * const me, const KmzKernel * const kernel, const KmzRectangle area, KmzImage * const buffer);
+
+/**
+ * @par Composites an area of the source {@link KmzImage} onto the target {@link KmzImage} using the provided {@link KmzCompositeOp}.
+ *
+ * @par The source area is clipped to both images, and only the destination pixels it covers are changed. Both images are converted to premultiplied 8-bit channels and composited using fixed point arithmetic over whole row spans. Rows and runs of fully transparent source pixels are skipped for every operator that keeps the destination under them, and runs of opaque source pixels are copied for {@link KMZ_COMPOSITE_SRC_OVER} at full opacity. {@link KMZ_COMPOSITE_SRC} at full opacity copies the source unchanged. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation, which the source is composited onto.
+ * @param src The image to composite onto the target, which MAY be the target {@link KmzImage}.
+ * @param src_rect The area within the source image to composite.
+ * @param dst_pos The position within the target {@link KmzImage} of the top left corner of `src_rect`.
+ * @param op The {@link KmzCompositeOp} to composite with.
+ * @param opacity The opacity that the source is scaled by, between 0 and 1.
+ * @return {@link KMZ_PIXEL_OP_OK} if the source is composited onto the image, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__composite(KmzImage * const me, const KmzImage * const src, const KmzRectangle src_rect, const KmzPoint dst_pos,
+        const KmzCompositeOp op, const kmz_percent opacity);
+
+/**
+ * @par Resamples an area of the target {@link KmzImage} to the dimensions of the output image, replacing every pixel of the output image.
+ *
+ * @par The area is resampled as a horizontal pass followed by a vertical pass over premultiplied channels using 14-bit fixed point weights. The weights of every pair of source and output lengths are computed once and kept in a cache of the 16 most recently used pairs, so resampling many images of the same size only computes them once. The output is split into bands of 16 rows that are resampled in parallel. An area with the dimensions of the output image is copied unchanged, as every filter passes it through exactly. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param area The area within the target {@link KmzImage} to resample.
+ * @param filter The {@link KmzResampleFilter} to resample with.
+ * @param output The image to write the result to, which MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the area is resampled, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__resample(const KmzImage * const me, const KmzRectangle area, const KmzResampleFilter filter,
+        KmzImage * const output, const size_t threads);
+
+/**
+ * @par Builds a pyramid from the target {@link KmzImage}, where level 0 is a copy of the image and every following level halves the one above it, rounding odd dimensions up, until the given number of levels or a single pixel is reached.
+ *
+ * @par Every level is built in a single pass over the rows of the image. Each reduced row is pushed down to the following levels while the rows it is reduced from are still within the cache, and only the last 4 premultiplied rows of every level are kept for the level below it. Every level is kept within a single allocation. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param filter The {@link KmzPyramidFilter} to halve each level with.
+ * @param levels The maximum number of levels including level 0, or 0 to build every level down to a single pixel.
+ * @return A new {@link KmzPyramid} if the pyramid is built, otherwise {@link NULL}.
+ */
+KmzPyramid * const KmzImage__build_pyramid(const KmzImage * const me, const KmzPyramidFilter filter, const size_t levels);
+
+/**
+ * @par Frees the target {@link KmzPyramid} and every one of its levels.
+ *
+ * @param me The target of this invocation.
+ */
+void KmzPyramid__free(KmzPyramid * const me);
+
+/**
+ * @par Returns the number of levels within the target {@link KmzPyramid}.
+ *
+ * @param me The target of this invocation.
+ * @return The number of levels within the target {@link KmzPyramid}.
+ */
+const size_t KmzPyramid__level_count(const KmzPyramid * const me);
+
+/**
+ * @par Returns a level of the target {@link KmzPyramid} as an image that borrows the pixels of the pyramid. The image is owned by the pyramid and MUST NOT be freed, nor used after the pyramid is freed.
+ *
+ * @param me The target of this invocation.
+ * @param level The level to return, where 0 is the full size image.
+ * @return The {@link KmzImage} of the level, otherwise {@link NULL} if the level is outside of the pyramid.
+ */
+KmzImage * const KmzPyramid__level(const KmzPyramid * const me, const size_t level);
+
+/**
+ * @par Mirrors the target {@link KmzImage} along its main diagonal, so that the pixel at (x, y) is written to (y, x) of the output image.
+ *
+ * @par The image is reoriented in tiles of 64x64 pixels, each transposed in blocks of 8x8 pixels, so that neither image is walked a column at a time. The output image MUST be as wide as the target {@link KmzImage} is tall and as tall as it is wide. When reoriented in place the image MUST be square, and the tiles are swapped in place without a copy of the image. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param output The image to write the result to, which MAY be the target {@link KmzImage} if it is square.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is reoriented, otherwise {@link KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE} if the dimensions of the output image do not match, or another appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__transpose(const KmzImage * const me, KmzImage * const output);
+
+/**
+ * @par Rotates the target {@link KmzImage} clockwise by 90 degrees.
+ *
+ * @par The image is reoriented in tiles of 64x64 pixels, each transposed in blocks of 8x8 pixels, so that neither image is walked a column at a time. The output image MUST be as wide as the target {@link KmzImage} is tall and as tall as it is wide. When reoriented in place the image MUST be square, and the tiles are swapped in place without a copy of the image. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param output The image to write the result to, which MAY be the target {@link KmzImage} if it is square.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is reoriented, otherwise {@link KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE} if the dimensions of the output image do not match, or another appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__rotate90(const KmzImage * const me, KmzImage * const output);
+
+/**
+ * @par Rotates the target {@link KmzImage} by 180 degrees.
+ *
+ * @par The image is reoriented in tiles of 64x64 pixels. The output image MUST have the same dimensions as the target {@link KmzImage}. When reoriented in place the tiles are swapped in place without a copy of the image. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param output The image to write the result to, which MAY be the target {@link KmzImage}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is reoriented, otherwise {@link KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE} if the dimensions of the output image do not match, or another appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__rotate180(const KmzImage * const me, KmzImage * const output);
+
+/**
+ * @par Rotates the target {@link KmzImage} clockwise by 270 degrees.
+ *
+ * @par The image is reoriented in tiles of 64x64 pixels, each transposed in blocks of 8x8 pixels, so that neither image is walked a column at a time. The output image MUST be as wide as the target {@link KmzImage} is tall and as tall as it is wide. When reoriented in place the image MUST be square, and the tiles are swapped in place without a copy of the image. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param output The image to write the result to, which MAY be the target {@link KmzImage} if it is square.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is reoriented, otherwise {@link KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE} if the dimensions of the output image do not match, or another appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__rotate270(const KmzImage * const me, KmzImage * const output);
+
+/**
+ * @par Mirrors the target {@link KmzImage} horizontally, so that its left edge becomes its right edge.
+ *
+ * @par The image is reoriented in tiles of 64x64 pixels. The output image MUST have the same dimensions as the target {@link KmzImage}. When reoriented in place the tiles are swapped in place without a copy of the image. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param output The image to write the result to, which MAY be the target {@link KmzImage}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is reoriented, otherwise {@link KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE} if the dimensions of the output image do not match, or another appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__flip_h(const KmzImage * const me, KmzImage * const output);
+
+/**
+ * @par Mirrors the target {@link KmzImage} vertically, so that its top edge becomes its bottom edge.
+ *
+ * @par The image is reoriented in tiles of 64x64 pixels. The output image MUST have the same dimensions as the target {@link KmzImage}. When reoriented in place the tiles are swapped in place without a copy of the image. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param output The image to write the result to, which MAY be the target {@link KmzImage}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is reoriented, otherwise {@link KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE} if the dimensions of the output image do not match, or another appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__flip_v(const KmzImage * const me, KmzImage * const output);
+
+/**
+ * @par Counts the pixels within an area of the target {@link KmzImage} that fall into each bin of every ARGB channel, and optionally of the hue, saturation and lightness of every pixel.
+ *
+ * @par The area is split into bands of 16 rows that are counted in parallel. Every worker counts into its own histograms, which begin on their own cache lines and are merged once every band is counted. Every worker keeps 4 copies of each histogram so that runs of equal pixels don't wait on the counter they last incremented.
+ *
+ * @param me The target of this invocation.
+ * @param area The area within the target {@link KmzImage} to count.
+ * @param hsl {@link KMZ_TRUE} to also fill the hue, saturation and lightness histograms, which converts every pixel to AHSL.
+ * @param histogram The {@link KmzHistogram} to write the result to.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the area is counted, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__histogram(const KmzImage * const me, const KmzRectangle area, const KmzBool hsl, KmzHistogram * const histogram,
+        const size_t threads);
+
+/**
+ * @par Computes the minimum, maximum, mean, variance and every whole percentile of each ARGB channel within an area of the target {@link KmzImage}.
+ *
+ * @par The statistics are computed exactly from the histograms of {@link KmzImage__histogram}.
+ *
+ * @param me The target of this invocation.
+ * @param area The area within the target {@link KmzImage} to measure.
+ * @param stats The {@link KmzImageStats} to write the result to.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the area is measured, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__stats(const KmzImage * const me, const KmzRectangle area, KmzImageStats * const stats, const size_t threads);
+
+/**
+ * @par Creates a summed-area table of the alpha, red, green and blue channels of the given {@link KmzImage}, and optionally of their squares, from which the sum of any area is 4 lookups.
+ *
+ * @par Every row is summed from left to right in parallel bands of 16 rows, then every strip of 256 columns is accumulated from top to bottom in parallel. The sums are kept in 32 bits for images of up to 16843009 pixels, where no area can sum past 32 bits, and in 64 bits otherwise. The squares are always kept in 64 bits, which adds 32 bytes per pixel.
+ *
+ * @param image The image to sum.
+ * @param squares {@link KMZ_TRUE} to also sum the squares of every channel, which {@link KmzIntegralImage__sum_squares} and {@link KmzIntegralImage__local_variance} require.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return A new {@link KmzIntegralImage} if the image is summed, otherwise {@link NULL}.
+ */
+KmzIntegralImage * const KmzIntegralImage__new(const KmzImage * const image, const KmzBool squares, const size_t threads);
+
+/**
+ * Frees the targeted {@link KmzIntegralImage}.
+ *
+ * @param me The target of this invocation.
+ */
+void KmzIntegralImage__free(KmzIntegralImage * const me);
+
+/**
+ * @param me The target of this invocation.
+ * @return The dimensions of the image summed by the targeted {@link KmzIntegralImage}.
+ */
+const KmzSize KmzIntegralImage__dimen(const KmzIntegralImage * const me);
+
+/**
+ * @par Sums every channel within an area of the targeted {@link KmzIntegralImage} in constant time.
+ *
+ * @param me The target of this invocation.
+ * @param area The area to sum.
+ * @param sums A pointer to 4 values to write the sums of the alpha, red, green and blue channels to, where alpha is the 7-bit value from 0 to 127.
+ * @return {@link KMZ_PIXEL_OP_OK} if the area is summed, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzIntegralImage__sum(const KmzIntegralImage * const me, const KmzRectangle area, uint64_t * const sums);
+
+/**
+ * @par Sums the squares of every channel within an area of the targeted {@link KmzIntegralImage} in constant time.
+ *
+ * @param me The target of this invocation.
+ * @param area The area to sum.
+ * @param sums A pointer to 4 values to write the sums of the squares of the alpha, red, green and blue channels to.
+ * @return {@link KMZ_PIXEL_OP_OK} if the area is summed, otherwise {@link KMZ_PIXEL_OP_ERR_READ_INVALID_PTR} if the table was created without squares.
+ */
+const KmzPixelOperationStatus KmzIntegralImage__sum_squares(const KmzIntegralImage * const me, const KmzRectangle area, uint64_t * const sums);
+
+/**
+ * @par Writes the mean of every channel within `radius` pixels of every pixel to the output image, which is a box blur whose cost does not depend on its radius.
+ *
+ * @par The window is clipped to the image, so pixels near the edges are the mean of the pixels within both the window and the image. Each mean is rounded to nearest exactly. The output is split into bands of 16 rows that are filtered in parallel.
+ *
+ * @param me The target of this invocation.
+ * @param radius The number of pixels on each side of every pixel to average.
+ * @param output The image to write the result to, which MUST have the dimensions of the summed image and MAY be the summed image.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is blurred, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzIntegralImage__box_blur(const KmzIntegralImage * const me, const size_t radius, KmzImage * const output,
+        const size_t threads);
+
+/**
+ * @par Writes the variance of every channel within `radius` pixels of every pixel, using the same clipped windows as {@link KmzIntegralImage__box_blur}.
+ *
+ * @param me The target of this invocation.
+ * @param radius The number of pixels on each side of every pixel to measure.
+ * @param variances A pointer to 4 values for every pixel of the summed image, in rows from top to bottom, to write the variances of the alpha, red, green and blue channels to.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the variances are written, otherwise {@link KMZ_PIXEL_OP_ERR_READ_INVALID_PTR} if the table was created without squares, or another appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzIntegralImage__local_variance(const KmzIntegralImage * const me, const size_t radius, float * const variances,
+        const size_t threads);
+
+/**
+ * @par Box blurs the target {@link KmzImage} through a temporary {@link KmzIntegralImage}, so the cost of every pixel does not depend on the radius.
+ *
+ * @param me The target of this invocation.
+ * @param radius The number of pixels on each side of every pixel to average.
+ * @param output The image to write the result to, which MUST have the dimensions of the target {@link KmzImage} and MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is blurred, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ *
+ * @see KmzIntegralImage__box_blur
+ */
+const KmzPixelOperationStatus KmzImage__box_blur(const KmzImage * const me, const size_t radius, KmzImage * const output, const size_t threads);
+
+/**
+ * @par Applies a morphological operation with a rectangular structuring element centred on every pixel of the target {@link KmzImage}, where even sizes extend one pixel further right and down. The element is clipped to the image.
+ *
+ * @par Every channel is filtered separately, where the alpha channel is filtered as its opacity so that eroding shrinks opaque shapes. When `grayscale` is {@link KMZ_TRUE} every pixel is first replaced by its Rec. 601 luma, keeping its alpha.
+ *
+ * @par The element is applied as a horizontal pass followed by a vertical pass using the van Herk/Gil-Werman algorithm, which takes about 3 comparisons per pixel and pass whatever the size of the element. The horizontal pass interleaves bands of 16 rows and the vertical pass filters strips of 64 columns, both in parallel, so every comparison is a SIMD minimum or maximum over many pixels. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param op The {@link KmzMorphologyOp} to apply.
+ * @param element The width and height of the structuring element, neither of which may be 0.
+ * @param grayscale {@link KMZ_TRUE} to filter the luma of every pixel, otherwise {@link KMZ_FALSE} to filter every channel.
+ * @param output The image to write the result to, which MUST have the dimensions of the target {@link KmzImage} and MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the operation is applied, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__morphology(const KmzImage * const me, const KmzMorphologyOp op, const KmzSize element, const KmzBool grayscale,
+        KmzImage * const output, const size_t threads);
+
+/**
+ * @par Writes the given percentile of every channel within `radius` pixels of every pixel of the target {@link KmzImage} to the output image, so 0 is a minimum filter, 0.5 a median filter and 1 a maximum filter. The window is clipped to the image.
+ *
+ * @par The percentile of a window is the lowest value that at least the given fraction of its pixels are lower than or equal to, as in {@link KmzImage__stats}, so even windows take their lower median. Every channel is filtered separately, where the alpha channel is filtered as its opacity.
+ *
+ * @par The filter uses the Perreault-Hébert algorithm, which keeps a histogram of every column of the window and slides them down the image one row at a time, so the cost of every pixel does not depend on the radius. The image is split into strips of 128 columns that are filtered in parallel. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param radius The number of pixels on each side of every pixel to filter, which may not be greater than 127.
+ * @param percentile The percentile to write, from 0 to 1.
+ * @param output The image to write the result to, which MUST have the dimensions of the target {@link KmzImage} and MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is filtered, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__percentile_filter(const KmzImage * const me, const size_t radius, const kmz_percent percentile,
+        KmzImage * const output, const size_t threads);
+
+/**
+ * @par Median filters the target {@link KmzImage}, which removes speckles smaller than the window while keeping edges sharp.
+ *
+ * @param me The target of this invocation.
+ * @param radius The number of pixels on each side of every pixel to filter, which may not be greater than 127.
+ * @param output The image to write the result to, which MUST have the dimensions of the target {@link KmzImage} and MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is filtered, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ *
+ * @see KmzImage__percentile_filter
+ */
+const KmzPixelOperationStatus KmzImage__median(const KmzImage * const me, const size_t radius, KmzImage * const output, const size_t threads);
+
+/**
+ * @par Gaussian blurs the target {@link KmzImage} with the given standard deviation, whose cost does not depend on the sigma once it reaches 2.5.
+ *
+ * @par The blur is the recursive filter of Young and van Vliet, which runs a 3rd order recursion forwards and then backwards down every column and then along every row, taking the edges of the image as repeated forever. The recursion strays from a Gaussian as the sigma shrinks, so sigmas below 2.5 are instead convolved down every column and along every row with a Gaussian sampled out to 4 sigmas, which costs at most 21 taps per pass. Colors are blurred premultiplied by their alpha, so transparent pixels do not darken their neighbours. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @par The columns are filtered in strips of 64 pixels, where every step of the recursion is a SIMD operation across the strip, and the rows are filtered in bands of 16 rows, where every step is a SIMD operation across the channels of a pixel, or of a pixel of 2 rows with {@link KMZ_SIMD_AVX2}. The filtered columns are kept in 16-bit fixed point between the passes, within 1/128 of their exact values. Both passes are filtered in parallel, unless the image is too small for threads to pay off.
+ *
+ * @param me The target of this invocation.
+ * @param sigma The standard deviation of the Gaussian in pixels, which may not be lower than 0.5.
+ * @param output The image to write the result to, which MUST have the dimensions of the target {@link KmzImage} and MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is blurred, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__gaussian_blur(const KmzImage * const me, const float sigma, KmzImage * const output, const size_t threads);
+
+/**
+ * @par Creates an identity {@link KmzColorLut3D}, which maps every color to itself until its entries are set.
+ *
+ * @par Tables of 17, 33 or 65 entries along every side are the usual sizes, but any size from 2 to 256 may be used.
+ *
+ * @param size The number of entries along every side of the table.
+ * @return A new {@link KmzColorLut3D}, or {@link NULL} if the size is invalid or there isn't enough memory.
+ */
+KmzColorLut3D * const KmzColorLut3D__new(const size_t size);
+
+/**
+ * @par Reads a {@link KmzColorLut3D} from an Adobe or Resolve `.cube` file.
+ *
+ * @par The `LUT_3D_SIZE`, `DOMAIN_MIN`, `DOMAIN_MAX` and `LUT_3D_INPUT_RANGE` keywords are read and `TITLE` and any other keyword is ignored. Every output is clamped to the range of 0 to 1.
+ *
+ * @param file The file to read from its current position.
+ * @return A new {@link KmzColorLut3D}, or {@link NULL} if the file is not a valid 3D `.cube` file, could not be read, or there isn't enough memory.
+ */
+KmzColorLut3D * const KmzColorLut3D__new_from_cube(FILE * const file);
+
+/**
+ * Frees the targeted {@link KmzColorLut3D}.
+ *
+ * @param me The target of this invocation.
+ */
+void KmzColorLut3D__free(KmzColorLut3D * const me);
+
+/**
+ * @param me The target of this invocation.
+ * @return The number of entries along every side of the targeted {@link KmzColorLut3D}.
+ */
+const size_t KmzColorLut3D__size(const KmzColorLut3D * const me);
+
+/**
+ * @par Sets the color that the entry at the given grid position of the targeted {@link KmzColorLut3D} maps to.
+ *
+ * @par Entries are kept in fixed point to within 1/256 of a step of an 8-bit channel, so a grading preset that is sampled at every grid position keeps its precision.
+ *
+ * @param me The target of this invocation.
+ * @param r The position of the entry along red, from 0 to one less than the size.
+ * @param g The position of the entry along green.
+ * @param b The position of the entry along blue.
+ * @param red The red channel of the output color, from 0 to 1.
+ * @param green The green channel of the output color, from 0 to 1.
+ * @param blue The blue channel of the output color, from 0 to 1.
+ * @return {@link KMZ_PIXEL_OP_OK} if the entry is set, otherwise {@link KMZ_PIXEL_OP_ERR_WRITE_INVALID_POS}.
+ */
+const KmzPixelOperationStatus KmzColorLut3D__set(KmzColorLut3D * const me, const size_t r, const size_t g, const size_t b, const float red,
+        const float green, const float blue);
+
+/**
+ * @par Maps the color of every pixel of the target {@link KmzImage} through a {@link KmzColorLut3D} to the output image. The alpha of every pixel is kept.
+ *
+ * @par A single lookup stands for any chain of color adjustments baked into the table, such as a round trip through {@link KmzAhslColor}. The grid position of every channel is looked up per 8-bit value and the corners are weighed in 16-bit fixed point, where every pair of corners is a single SIMD multiply-add across the channels, and with {@link KMZ_SIMD_AVX2} the cells of 8 pixels are found and their corners gathered at once. The image is mapped in bands of 16 rows in parallel, unless it is too small for threads to pay off. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param lut The table to map every color through.
+ * @param interpolation The {@link KmzLutInterpolation} to use between the entries of the table.
+ * @param output The image to write the result to, which MUST have the dimensions of the target {@link KmzImage} and MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is mapped, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__apply_lut3d(const KmzImage * const me, const KmzColorLut3D * const lut, const KmzLutInterpolation interpolation,
+        KmzImage * const output, const size_t threads);
+
+/**
+ * @par Creates an empty {@link KmzColorTransform}, which leaves every color unchanged until steps are added to it.
+ *
+ * @par Every step is applied in the order it is added, to every channel from 0 to 1 in floating point, and the result of every step is clamped between 0 and 1. The chain is only evaluated when it is compiled, never per pixel.
+ *
+ * @return A new {@link KmzColorTransform}, or {@link NULL} if there isn't enough memory.
+ */
+KmzColorTransform * const KmzColorTransform__new(void);
+
+/**
+ * Frees the targeted {@link KmzColorTransform}.
+ *
+ * @param me The target of this invocation.
+ */
+void KmzColorTransform__free(KmzColorTransform * const me);
+
+/**
+ * @par Adds a step that rotates the hue of every color, as {@link KmzImage__rotate_hue} does.
+ *
+ * @param me The target of this invocation.
+ * @param amount The fraction of a full turn to rotate the hue by, where 0.5 is 180 degrees. Negative values rotate backwards.
+ * @return {@link KMZ_TRUE} if the step is added, otherwise {@link KMZ_FALSE} if `amount` is not finite or there isn't enough memory.
+ */
+const KmzBool KmzColorTransform__rotate_hue(KmzColorTransform * const me, const kmz_percent amount);
+
+/**
+ * @par Adds a step that multiplies the saturation of every color, as {@link KmzImage__saturate} does.
+ *
+ * @param me The target of this invocation.
+ * @param factor The factor to multiply the saturation by, where 0 produces grays and 1 leaves the color unchanged.
+ * @return {@link KMZ_TRUE} if the step is added, otherwise {@link KMZ_FALSE} if `factor` is not finite or there isn't enough memory.
+ */
+const KmzBool KmzColorTransform__saturate(KmzColorTransform * const me, const kmz_percent factor);
+
+/**
+ * @par Adds a step that adds to the luminosity of every color, as {@link KmzImage__lighten} does.
+ *
+ * @param me The target of this invocation.
+ * @param amount The amount to add to the luminosity. Negative values darken the color.
+ * @return {@link KMZ_TRUE} if the step is added, otherwise {@link KMZ_FALSE} if `amount` is not finite or there isn't enough memory.
+ */
+const KmzBool KmzColorTransform__lighten(KmzColorTransform * const me, const kmz_percent amount);
+
+/**
+ * @par Adds a step that raises every channel to the power of `1 / gamma`, so a gamma above 1 brightens the midtones and a gamma below 1 darkens them.
+ *
+ * @param me The target of this invocation.
+ * @param gamma The gamma, which must be greater than 0.
+ * @return {@link KMZ_TRUE} if the step is added, otherwise {@link KMZ_FALSE} if `gamma` is invalid or there isn't enough memory.
+ */
+const KmzBool KmzColorTransform__gamma(KmzColorTransform * const me, const float gamma);
+
+/**
+ * @par Adds a step that maps every channel from the input black and white to 0 and 1, applies a gamma as {@link KmzColorTransform__gamma} does and maps the result from 0 and 1 to the output black and white.
+ *
+ * @param me The target of this invocation.
+ * @param in_black The input value that becomes the output black.
+ * @param in_white The input value that becomes the output white, which must be greater than `in_black`.
+ * @param gamma The gamma, which must be greater than 0.
+ * @param out_black The output value of the input black.
+ * @param out_white The output value of the input white, which may be lower than `out_black` to invert the channels.
+ * @return {@link KMZ_TRUE} if the step is added, otherwise {@link KMZ_FALSE} if any value is invalid or there isn't enough memory.
+ */
+const KmzBool KmzColorTransform__levels(KmzColorTransform * const me, const kmz_percent in_black, const kmz_percent in_white, const float gamma,
+        const kmz_percent out_black, const kmz_percent out_white);
+
+/**
+ * @par Adds a step that mixes the channels of every color through a matrix, where every output channel is the sum of every input channel weighed by a coefficient plus an offset.
+ *
+ * @param me The target of this invocation.
+ * @param matrix The rows of red, green and blue, each as the coefficients of red, green and blue followed by the offset, for 12 values between -16 and 16.
+ * @return {@link KMZ_TRUE} if the step is added, otherwise {@link KMZ_FALSE} if any value is invalid or there isn't enough memory.
+ */
+const KmzBool KmzColorTransform__mix_channels(KmzColorTransform * const me, const float * const matrix);
+
+/**
+ * @param me The target of this invocation.
+ * @return {@link KMZ_TRUE} if every step of the targeted {@link KmzColorTransform} maps every channel on its own, so the chain compiles to a curve of every channel, otherwise {@link KMZ_FALSE}.
+ */
+const KmzBool KmzColorTransform__is_per_channel(const KmzColorTransform * const me);
+
+/**
+ * @par Compiles the chain of the targeted {@link KmzColorTransform}, which is done once when the transform is first applied and again after a step is added.
+ *
+ * @par A chain whose steps are all per channel compiles to a curve of every channel, which costs 3 lookups per pixel. A chain with a single {@link KmzColorTransform__mix_channels} and otherwise per-channel steps compiles to a curve of every channel, the matrix in fixed point and another curve of every channel. Any other chain compiles to a {@link KmzColorLut3D} of 33 entries along every side, applied with {@link KMZ_LUT_TETRAHEDRAL}, where the per-channel steps before the first step that mixes the channels are folded into the grid position of every channel at no cost per pixel.
+ *
+ * @param me The target of this invocation.
+ * @return {@link KMZ_TRUE} if the chain is compiled, otherwise {@link KMZ_FALSE} if there isn't enough memory.
+ */
+const KmzBool KmzColorTransform__compile(KmzColorTransform * const me);
+
+/**
+ * @par Maps the color of every pixel of the target {@link KmzImage} through a {@link KmzColorTransform} to the output image, compiling the transform first if needed. The alpha of every pixel is kept.
+ *
+ * @par Every form of the compiled transform costs a fixed number of lookups per pixel whatever the length of the chain, and the image is mapped in bands of 16 rows in parallel, unless it is too small for threads to pay off. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param transform The transform to map every color through.
+ * @param output The image to write the result to, which MUST have the dimensions of the target {@link KmzImage} and MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is mapped, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__apply_color_transform(const KmzImage * const me, KmzColorTransform * const transform, KmzImage * const output,
+        const size_t threads);
+
+/**
+ * @par Creates an empty {@link KmzPipeline}, which copies the area it is run over unchanged until stages are added to it.
+ *
+ * @return A new {@link KmzPipeline}, or {@link NULL} if there isn't enough memory.
+ */
+KmzPipeline * const KmzPipeline__new(void);
+
+/**
+ * Frees the targeted {@link KmzPipeline}, leaving the filters, kernels, transforms and images of its stages untouched.
+ *
+ * @param me The target of this invocation.
+ */
+void KmzPipeline__free(KmzPipeline * const me);
+
+/**
+ * @param me The target of this invocation.
+ * @return The number of pixels around every tile that the stages of the targeted {@link KmzPipeline} read together, which is the sum of half the size of every filter and kernel.
+ */
+const size_t KmzPipeline__halo(const KmzPipeline * const me);
+
+/**
+ * @par Adds a stage that applies a {@link KmzFilter} as {@link KmzImage__apply_buffered_filter} does, where every pixel outside of the area the pipeline is run over is 0.
+ *
+ * @param me The target of this invocation.
+ * @param argv The argument passed to every call of `filter`, which MUST be safe to share between threads.
+ * @param filter The filter to apply.
+ * @param m_size The size of the matrix of the filter.
+ * @return {@link KMZ_TRUE} if the stage is added, otherwise {@link KMZ_FALSE} if `filter` is {@link NULL}, the halo of the pipeline would grow too large or there isn't enough memory.
+ */
+const KmzBool KmzPipeline__add_filter(KmzPipeline * const me, const void * const argv, const KmzFilter filter, const size_t m_size);
+
+/**
+ * @par Adds a stage that convolves with a {@link KmzKernel} as {@link KmzImage__apply_kernel} does. The kernel MUST outlive the pipeline.
+ *
+ * @param me The target of this invocation.
+ * @param kernel The kernel to convolve with.
+ * @return {@link KMZ_TRUE} if the stage is added, otherwise {@link KMZ_FALSE} if `kernel` is {@link NULL}, the halo of the pipeline would grow too large or there isn't enough memory.
+ */
+const KmzBool KmzPipeline__add_kernel(KmzPipeline * const me, const KmzKernel * const kernel);
+
+/**
+ * @par Adds a stage that maps every color through a {@link KmzColorTransform} as {@link KmzImage__apply_color_transform} does. The transform is compiled when the pipeline is run, so steps MAY still be added to it, and it MUST outlive the pipeline.
+ *
+ * @param me The target of this invocation.
+ * @param transform The transform to map every color through.
+ * @return {@link KMZ_TRUE} if the stage is added, otherwise {@link KMZ_FALSE} if `transform` is {@link NULL} or there isn't enough memory.
+ */
+const KmzBool KmzPipeline__add_color_transform(KmzPipeline * const me, KmzColorTransform * const transform);
+
+/**
+ * @par Adds a stage that composites an area of a source {@link KmzImage} onto the pixels of the pipeline as {@link KmzImage__composite} does, where `dst_pos` is within the image the pipeline is run over. Only the pixels within the area the pipeline is run over are changed. The source MUST outlive the pipeline.
+ *
+ * @param me The target of this invocation.
+ * @param src The image to composite, which MAY be the image or the output the pipeline is run with.
+ * @param src_rect The area within the source image to composite.
+ * @param dst_pos The position within the image the pipeline is run over of the top left corner of `src_rect`.
+ * @param op The {@link KmzCompositeOp} to composite with.
+ * @param opacity The opacity that the source is scaled by, between 0 and 1.
+ * @return {@link KMZ_TRUE} if the stage is added, otherwise {@link KMZ_FALSE} if `src` is {@link NULL}, `op` is unknown or there isn't enough memory.
+ */
+const KmzBool KmzPipeline__add_composite(KmzPipeline * const me, const KmzImage * const src, const KmzRectangle src_rect, const KmzPoint dst_pos,
+        const KmzCompositeOp op, const kmz_percent opacity);
+
+/**
+ * @par Runs every stage of a {@link KmzPipeline} in order over an area of the target {@link KmzImage}, writing the result to the same area of the output image. The result is that of applying every stage in turn to the area, where every filter and kernel reads the pixels outside of the area as 0.
+ *
+ * @par The area is split into tiles of 256 by 64 pixels that are run in parallel. Every tile is read once together with the halo of the pipeline and passes through every stage while it is still in the cache, where every filter and kernel shrinks the halo by half its size, so a chain of stages streams the image through memory once instead of once for every stage. Every {@link KmzSimdLevel} produces identical results.
+ *
+ * @param me The target of this invocation.
+ * @param pipeline The pipeline to run.
+ * @param area The area to run the pipeline over.
+ * @param output The image to write the result to, which MAY be the target {@link KmzImage}.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the pipeline is run, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus KmzImage__apply_pipeline(const KmzImage * const me, const KmzPipeline * const pipeline, const KmzRectangle area,
+        KmzImage * const output, const size_t threads);
+
 #endif /* libkempozer_image_h */
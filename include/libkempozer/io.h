@@ -340,6 +340,103 @@ struct kmz_image_file_type_t {
     const KmzImageFileStatus (* const remove_metadata)(void * const me, const char * const name);
 
     // endregion;
+
+    // region Version 2 methods:
+
+    /**
+     * @par Attempts to map the image file at the given path into memory instead of reading it into a buffer.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * validate the header of the file before exposing any pixels
+     * * leave every pixel accessor returning colors in host byte order
+     * * release the mapping when `me` is deallocated or another image is loaded into it.
+     *
+     * @param me The target of this invocation.
+     * @param path The path of the file to map into `me`.
+     * @return {@link KMZ_IMAGE_FILE_OK} if the image was mapped sucessfully, otherwise an appropriate {@link KmzImageFileStatus} specifying the error.
+     */
+    const KmzImageFileStatus (* const map)(void * const me, const char * const path);
+
+    /**
+     * @par Returns the truecolor pixels held in memory by the image file represented by this {@link KmzImageFileType} without copying them.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * return {@link NULL} if `me` is {@link NULL}, the image file isn't a truecolor image or it hasn't been loaded yet
+     * * return pixels in host byte order that remain valid until `me` is deallocated or another image is loaded into it.
+     *
+     * @param me The target of this invocation.
+     * @return A pointer to the truecolor pixels of the target, or {@link NULL} if they aren't available.
+     */
+    kmz_color_32 * const (* const truecolor_pixels)(void * const me);
+
+    /**
+     * @par Reads only the header of an image file from the given file, leaving the file positioned at the first row of pixels.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * release any pixels held by `me`
+     * * make the dimensions, color type and palette of the image available through `me` without loading any pixels.
+     *
+     * @param me The target of this invocation.
+     * @param file The file to read the header from.
+     * @return {@link KMZ_IMAGE_FILE_OK} if the header was read sucessfully, otherwise an appropriate {@link KmzImageFileStatus} specifying the error.
+     */
+    const KmzImageFileStatus (* const read_header)(void * const me, FILE * const file);
+
+    /**
+     * @par Reads the next rows of pixels from the given file as ARGB colors, after the header has been read using `read_header`.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * convert palette pixels to their palette colors
+     * * use no more memory than is needed for a single row of pixels beyond `buffer`.
+     *
+     * @param me The target of this invocation.
+     * @param file The file to read the rows from.
+     * @param count The number of rows to read.
+     * @param buffer A pointer to an initialized block of memory to read `count` rows of ARGB values into.
+     * @return {@link KMZ_IMAGE_FILE_OK} if the rows were read sucessfully, otherwise an appropriate {@link KmzImageFileStatus} specifying the error.
+     */
+    const KmzImageFileStatus (* const read_rows)(void * const me, FILE * const file, const size_t count, kmz_color_32 * const buffer);
+
+    /**
+     * @par Writes the header of a truecolor image file of the given dimensions to the given file, so that its pixels may follow using `write_rows`.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * release any pixels held by `me`.
+     *
+     * @param me The target of this invocation.
+     * @param file The file to write the header to.
+     * @param dimen The dimensions of the image being written.
+     * @return {@link KMZ_IMAGE_FILE_OK} if the header was written sucessfully, otherwise an appropriate {@link KmzImageFileStatus} specifying the error.
+     */
+    const KmzImageFileStatus (* const write_header)(void * const me, FILE * const file, const KmzSize dimen);
+
+    /**
+     * @par Writes the next rows of pixels to the given file, after the header has been written using `write_header`.
+     *
+     * @par This method MUST:
+     * * be {@link NULL} if not implemented
+     * * do nothing if `me` is {@link NULL}
+     * * leave `buffer` unchanged
+     * * use a bounded amount of memory regardless of `count`.
+     *
+     * @param me The target of this invocation.
+     * @param file The file to write the rows to.
+     * @param count The number of rows to write.
+     * @param buffer A pointer to `count` rows of ARGB values to write.
+     * @return {@link KMZ_IMAGE_FILE_OK} if the rows were written sucessfully, otherwise an appropriate {@link KmzImageFileStatus} specifying the error.
+     */
+    const KmzImageFileStatus (* const write_rows)(void * const me, FILE * const file, const size_t count, const kmz_color_32 * const buffer);
+
+    // endregion;
 };
 typedef struct kmz_image_file_type_t KmzImageFileType;
 
@@ -370,6 +467,107 @@ const KmzImageFileStatus KmzImageFile__load(KmzImageFile * const me, const char
 
 const KmzImageFileStatus KmzImageFile__load_from(KmzImageFile * const me, FILE * const path);
 
+/**
+ * @par Maps the image file at the given path into the target {@link KmzImageFile} instead of reading it.
+ *
+ * @par Mapped pixels are paged in by the operating system on demand and may be borrowed by {@link KmzImage__new_borrowed_from_file} without being copied.
+ *
+ * @param me The target of this invocation.
+ * @param path The path of the file to map.
+ * @return {@link KMZ_IMAGE_FILE_OK} if the file was mapped, {@link KMZ_IMAGE_FILE_ERR_UNSUPPORTED_OPERATION} if the type of the target can't map files, otherwise an appropriate {@link KmzImageFileStatus}.
+ *
+ * @see KmzImageFileType#map
+ */
+const KmzImageFileStatus KmzImageFile__map(KmzImageFile * const me, const char * const path);
+
+/**
+ * Returns the truecolor pixels held in memory by the target {@link KmzImageFile} without copying them.
+ *
+ * @param me The target of this invocation.
+ * @return A pointer to the truecolor pixels of the target in host byte order, or {@link NULL} if they aren't available.
+ *
+ * @see KmzImageFileType#truecolor_pixels
+ */
+kmz_color_32 * const KmzImageFile__truecolor_pixels(const KmzImageFile * const me);
+
+/**
+ * Defines an opaque stream of rows being read from or written to a file through a {@link KmzImageFile}.
+ */
+struct kmz_image_stream_t;
+typedef struct kmz_image_stream_t KmzImageStream;
+
+/**
+ * @par Reads the header of the image in the given file into the target {@link KmzImageFile} and opens a stream that decodes its rows on demand.
+ *
+ * @par The dimensions, color type and palette of the image are available through the target while the stream is open, but its pixels are never held in memory as a whole. The stream MUST be freed before the target is freed, and `file` MUST stay open until then.
+ *
+ * @param me The target of this invocation.
+ * @param file The file to read from, positioned at the start of the image.
+ * @return A pointer to a new {@link KmzImageStream}, or {@link NULL} if the type of the target can't stream files, the header can't be read or there isn't enough memory.
+ *
+ * @see KmzImageFileType#read_header
+ */
+KmzImageStream * const KmzImageFile__open_stream(KmzImageFile * const me, FILE * const file);
+
+/**
+ * @par Writes the header of a truecolor image of the given dimensions to the given file using the format of the target {@link KmzImageFile}, and opens a stream that its rows may be written to.
+ *
+ * @par The stream MUST be freed before the target is freed, and `file` MUST stay open until then.
+ *
+ * @param me The target of this invocation.
+ * @param file The file to write to.
+ * @param dimen The dimensions of the image being written.
+ * @return A pointer to a new {@link KmzImageStream}, or {@link NULL} if the type of the target can't stream files, the header can't be written or there isn't enough memory.
+ *
+ * @see KmzImageFileType#write_header
+ */
+KmzImageStream * const KmzImageFile__create_stream(KmzImageFile * const me, FILE * const file, const KmzSize dimen);
+
+/**
+ * Frees the targeted {@link KmzImageStream} without closing its file.
+ *
+ * @param me The target of this invocation.
+ */
+void KmzImageStream__free(KmzImageStream * const me);
+
+/**
+ * @param me The target of this invocation.
+ * @return The dimensions of the image being streamed.
+ */
+const KmzSize KmzImageStream__dimen(const KmzImageStream * const me);
+
+/**
+ * @param me The target of this invocation.
+ * @return The index of the next row to be read or written.
+ */
+const size_t KmzImageStream__row(const KmzImageStream * const me);
+
+/**
+ * @param me The target of this invocation.
+ * @return {@link KMZ_IMAGE_FILE_OK} if every row so far has been streamed successfully, otherwise the {@link KmzImageFileStatus} of the first failure.
+ */
+const KmzImageFileStatus KmzImageStream__status(const KmzImageStream * const me);
+
+/**
+ * Decodes the next rows of the image being read into the provided buffer as ARGB colors.
+ *
+ * @param me The target of this invocation.
+ * @param count The maximum number of rows to read.
+ * @param buffer The buffer to read into, which MUST hold `count` rows.
+ * @return The number of rows read, which is lower than `count` only once the end of the image is reached or an error occurs.
+ */
+const size_t KmzImageStream__next_rows(KmzImageStream * const me, const size_t count, kmz_color_32 * const buffer);
+
+/**
+ * Encodes the next rows of the image being written from the provided buffer, leaving the buffer unchanged.
+ *
+ * @param me The target of this invocation.
+ * @param count The maximum number of rows to write.
+ * @param buffer The buffer to write from, which MUST hold `count` rows.
+ * @return The number of rows written, which is lower than `count` only once the end of the image is reached or an error occurs.
+ */
+const size_t KmzImageStream__write_rows(KmzImageStream * const me, const size_t count, const kmz_color_32 * const buffer);
+
 const size_t KmzImageFile__palette_color_count(const KmzImageFile * const me);
 
 const KmzImageFileStatus KmzImageFile__read_palette_colors(KmzImageFile * const me, kmz_color_32 * const buffer);
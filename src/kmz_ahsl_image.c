@@ -0,0 +1,541 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_ahsl_image.h"
+
+#define _KMZ_AHSL_IMAGE_CACHE_LINE 64
+#define _KMZ_AHSL_IMAGE_CHUNK 256
+#define _KmzAhslImage__plane_size(len, s) ((((len) * (s)) + (_KMZ_AHSL_IMAGE_CACHE_LINE - 1)) & ~((size_t)_KMZ_AHSL_IMAGE_CACHE_LINE - 1))
+/**
+ * The fixed point scale of the hue plane, where a whole turn wraps around to 0 so that rotations are exact modular additions.
+ */
+#define _KMZ_AHSL_HUE_ONE 65536.f
+/**
+ * The fixed point scale of the saturation and luminosity planes, where 1 is the largest value.
+ */
+#define _KMZ_AHSL_ONE 65535.f
+
+/**
+ * Defines the adjustments that may be applied to a single plane of an AHSL image.
+ */
+enum _kmz_ahsl_adjustment_e {
+    _KMZ_AHSL_ROTATE = 0,
+    _KMZ_AHSL_SCALE = 1,
+    _KMZ_AHSL_OFFSET = 2,
+};
+typedef enum _kmz_ahsl_adjustment_e _KmzAhslAdjustment;
+
+/**
+ * Every plane holds 16-bit fixed point values, which is precise enough for every 8-bit ARGB color to survive being stored and loaded unchanged.
+ */
+struct _kmz_ahsl_image_t {
+    KmzSize dimen;
+    size_t len;
+    void * block;
+    uint16_t * h;
+    uint16_t * s;
+    uint16_t * l;
+    kmz_channel * a;
+};
+
+struct _kmz_ahsl_image_argv_t {
+    KmzSize dimen;
+    const KmzAhslColor * pixels;
+};
+
+static inline const uint16_t _kmz_ahsl_to_hue(const kmz_percent hue) {
+    // NaN compares false and is taken as 0, and a hue that rounds up to a whole turn wraps around to 0.
+    const kmz_percent turn = hue == hue ? hue - floorf(hue) : 0.f;
+    return (uint16_t)(uint32_t)(turn * _KMZ_AHSL_HUE_ONE + .5f);
+}
+
+static inline const uint16_t _kmz_ahsl_to_fixed(const kmz_percent value) {
+    const kmz_percent clamped = value > 0.f ? (value < 1.f ? value : 1.f) : 0.f;
+    return (uint16_t)(clamped * _KMZ_AHSL_ONE + .5f);
+}
+
+static inline const KmzAhslColor _kmz_ahsl_color_at(const struct _kmz_ahsl_image_t * const restrict me, const size_t i) {
+    return KmzAhslColor__from_channels(me->a[i], me->h[i] / _KMZ_AHSL_HUE_ONE, me->s[i] / _KMZ_AHSL_ONE, me->l[i] / _KMZ_AHSL_ONE);
+}
+
+static inline void _kmz_ahsl_set_color_at(struct _kmz_ahsl_image_t * const restrict me, const size_t i, const KmzAhslColor color) {
+    me->a[i] = color.a;
+    me->h[i] = _kmz_ahsl_to_hue(color.h);
+    me->s[i] = _kmz_ahsl_to_fixed(color.s);
+    me->l[i] = _kmz_ahsl_to_fixed(color.l);
+}
+
+static inline const kmz_percent _kmz_adjust_channel(const _KmzAhslAdjustment adjustment, const kmz_percent value, const kmz_percent amount) {
+    switch (adjustment) {
+        case _KMZ_AHSL_ROTATE: {
+            const kmz_percent rotated = value + amount;
+            return rotated - floorf(rotated);
+        }
+        case _KMZ_AHSL_SCALE:
+            return fminf(fmaxf(value * amount, 0.f), 1.f);
+        case _KMZ_AHSL_OFFSET:
+        default:
+            return fminf(fmaxf(value + amount, 0.f), 1.f);
+    }
+}
+
+/**
+ * Returns the fixed point step of a rotation or an offset, which is a modular step of the hue for a rotation and a signed step clamped to a whole plane for an offset.
+ */
+static inline const int32_t _kmz_adjust_step(const _KmzAhslAdjustment adjustment, const kmz_percent amount) {
+    if (_KMZ_AHSL_ROTATE == adjustment) {
+        return _kmz_ahsl_to_hue(amount);
+    }
+
+    const kmz_percent clamped = amount > -1.f ? (amount < 1.f ? amount : 1.f) : (amount == amount ? -1.f : 0.f);
+    return (int32_t)(clamped * _KMZ_AHSL_ONE + (clamped < 0.f ? -.5f : .5f));
+}
+
+static inline const uint16_t _kmz_adjust_fixed(const _KmzAhslAdjustment adjustment, const uint16_t value, const int32_t step, const float amount) {
+    switch (adjustment) {
+        case _KMZ_AHSL_ROTATE:
+            return (uint16_t)(value + step);
+        case _KMZ_AHSL_SCALE: {
+            // NaN compares false and is taken as 0, as the SIMD maximum does.
+            const float scaled = (float)value * amount, clamped = scaled > 0.f ? (scaled < _KMZ_AHSL_ONE ? scaled : _KMZ_AHSL_ONE) : 0.f;
+            return (uint16_t)(int32_t)(clamped + .5f);
+        }
+        case _KMZ_AHSL_OFFSET:
+        default: {
+            const int32_t offset = (int32_t)value + step;
+            return (uint16_t)kmz_clamp(offset, 0, UINT16_MAX);
+        }
+    }
+}
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static inline __m128i _kmz_sse2_scale_fixed(const __m128i values, const __m128 amount) {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(_KMZ_AHSL_ONE), half = _mm_set1_ps(.5f);
+    const __m128i bias = _mm_set1_epi32(32768), sign = _mm_set1_epi16((short)0x8000);
+    __m128 lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(values, _mm_setzero_si128())),
+           hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(values, _mm_setzero_si128()));
+    lo = _mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(lo, amount), zero), one), half);
+    hi = _mm_add_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(hi, amount), zero), one), half);
+
+    // SSE2 only packs with signed saturation, so the values are moved into the signed range and back.
+    return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(_mm_cvttps_epi32(lo), bias), _mm_sub_epi32(_mm_cvttps_epi32(hi), bias)), sign);
+}
+
+kmz__target("sse2") static size_t _kmz_sse2_adjust_plane(uint16_t * const restrict plane, const size_t count, const _KmzAhslAdjustment adjustment,
+        const int32_t step, const float amount) {
+    const __m128i up = _mm_set1_epi16((short)(uint16_t)(step > 0 ? step : 0)), down = _mm_set1_epi16((short)(uint16_t)(step < 0 ? -step : 0));
+    const __m128 factor = _mm_set1_ps(amount);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m128i * const restrict p = (__m128i *)(plane + i);
+        const __m128i values = _mm_loadu_si128(p);
+        switch (adjustment) {
+            case _KMZ_AHSL_ROTATE:
+                _mm_storeu_si128(p, _mm_add_epi16(values, up));
+                break;
+            case _KMZ_AHSL_SCALE:
+                _mm_storeu_si128(p, _kmz_sse2_scale_fixed(values, factor));
+                break;
+            case _KMZ_AHSL_OFFSET:
+            default:
+                _mm_storeu_si128(p, _mm_subs_epu16(_mm_adds_epu16(values, up), down));
+                break;
+        }
+    }
+    return i;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_adjust_plane(uint16_t * const restrict plane, const size_t count, const _KmzAhslAdjustment adjustment,
+        const int32_t step, const float amount) {
+    const __m256i up = _mm256_set1_epi16((short)(uint16_t)(step > 0 ? step : 0)), down = _mm256_set1_epi16((short)(uint16_t)(step < 0 ? -step : 0));
+    const __m256 factor = _mm256_set1_ps(amount), zero = _mm256_setzero_ps(), one = _mm256_set1_ps(_KMZ_AHSL_ONE), half = _mm256_set1_ps(.5f);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        __m256i * const restrict p = (__m256i *)(plane + i);
+        const __m256i values = _mm256_loadu_si256(p);
+        switch (adjustment) {
+            case _KMZ_AHSL_ROTATE:
+                _mm256_storeu_si256(p, _mm256_add_epi16(values, up));
+                break;
+            case _KMZ_AHSL_SCALE: {
+                __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(values))),
+                       hi = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(values, 1)));
+                lo = _mm256_add_ps(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(lo, factor), zero), one), half);
+                hi = _mm256_add_ps(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(hi, factor), zero), one), half);
+                // The pack works within each 128 bit lane, so the quarters are put back in order afterwards.
+                _mm256_storeu_si256(p, _mm256_permute4x64_epi64(_mm256_packus_epi32(_mm256_cvttps_epi32(lo), _mm256_cvttps_epi32(hi)), 0xD8));
+                break;
+            }
+            case _KMZ_AHSL_OFFSET:
+            default:
+                _mm256_storeu_si256(p, _mm256_subs_epu16(_mm256_adds_epu16(values, up), down));
+                break;
+        }
+    }
+    return i;
+}
+#endif
+
+static void _kmz_adjust_plane(uint16_t * const restrict plane, const size_t count, const _KmzAhslAdjustment adjustment, const kmz_percent amount) {
+    const int32_t step = _KMZ_AHSL_SCALE == adjustment ? 0 : _kmz_adjust_step(adjustment, amount);
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_adjust_plane(plane, count, adjustment, step, amount);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        i += _kmz_sse2_adjust_plane(plane + i, count - i, adjustment, step, amount);
+    }
+#endif
+    for (; i < count; ++i) {
+        plane[i] = _kmz_adjust_fixed(adjustment, plane[i], step, amount);
+    }
+}
+
+static void _KmzAhslImage__store(struct _kmz_ahsl_image_t * const restrict me, const size_t offset, const kmz_color_32 * const restrict src,
+        const size_t count) {
+    KmzAhslColor chunk[_KMZ_AHSL_IMAGE_CHUNK];
+    for (size_t done = 0; done < count; done += _KMZ_AHSL_IMAGE_CHUNK) {
+        const size_t n = (count - done) < _KMZ_AHSL_IMAGE_CHUNK ? (count - done) : _KMZ_AHSL_IMAGE_CHUNK;
+        kmz_color_32__to_ahsl_span(src + done, chunk, n);
+        for (size_t i = 0, o = offset + done; i < n; ++i, ++o) {
+            _kmz_ahsl_set_color_at(me, o, chunk[i]);
+        }
+    }
+}
+
+static void _KmzAhslImage__load(const struct _kmz_ahsl_image_t * const restrict me, const size_t offset, kmz_color_32 * const restrict dst,
+        const size_t count) {
+    KmzAhslColor chunk[_KMZ_AHSL_IMAGE_CHUNK];
+    for (size_t done = 0; done < count; done += _KMZ_AHSL_IMAGE_CHUNK) {
+        const size_t n = (count - done) < _KMZ_AHSL_IMAGE_CHUNK ? (count - done) : _KMZ_AHSL_IMAGE_CHUNK;
+        for (size_t i = 0, o = offset + done; i < n; ++i, ++o) {
+            chunk[i] = _kmz_ahsl_color_at(me, o);
+        }
+        kmz_color_32__from_ahsl_span(chunk, dst + done, n);
+    }
+}
+
+static struct _kmz_ahsl_image_t * const _KmzAhslImage__new(void) {
+    struct _kmz_ahsl_image_t * const restrict me = malloc(sizeof(struct _kmz_ahsl_image_t));
+
+    if (NULL != me) {
+        me->dimen = KmzSize__ZERO;
+        me->len = 0;
+        me->block = NULL;
+        me->h = me->s = me->l = NULL;
+        me->a = NULL;
+    }
+
+    return me;
+}
+
+static void _KmzAhslImage__ctor(struct _kmz_ahsl_image_t * const restrict me, const struct _kmz_ahsl_image_argv_t * const restrict args) {
+    const size_t len = (size_t)args->dimen.w * args->dimen.h;
+    const size_t plane_size = _KmzAhslImage__plane_size(len, sizeof(uint16_t)),
+          block_size = (3 * plane_size) + _KmzAhslImage__plane_size(len, sizeof(kmz_channel));
+    void * block = NULL;
+
+    // Every plane begins on its own cache line so adjustments can stream a single plane without touching the others.
+    if (0 != posix_memalign(&block, _KMZ_AHSL_IMAGE_CACHE_LINE, block_size ? block_size : _KMZ_AHSL_IMAGE_CACHE_LINE)) {
+        // The missing block is detected by _KmzAhslImage__new_image, which frees the image.
+        return;
+    }
+
+    me->dimen = args->dimen;
+    me->len = len;
+    me->block = block;
+    me->h = (uint16_t *)block;
+    me->s = (uint16_t *)((uint8_t *)block + plane_size);
+    me->l = (uint16_t *)((uint8_t *)block + (2 * plane_size));
+    me->a = (kmz_channel *)((uint8_t *)block + (3 * plane_size));
+
+    if (NULL == args->pixels) {
+        memset(block, 0, block_size);
+    } else {
+        for (size_t i = 0; i < len; ++i) {
+            _kmz_ahsl_set_color_at(me, i, args->pixels[i]);
+        }
+    }
+}
+
+static void _KmzAhslImage__dtor(struct _kmz_ahsl_image_t * const restrict me) {
+    free(me->block);
+    free(me);
+}
+
+static const KmzSize _KmzAhslImage__dimen(const struct _kmz_ahsl_image_t * const restrict me) {
+    return me->dimen;
+}
+
+static const KmzBool _KmzAhslImage__is_valid(const struct _kmz_ahsl_image_t * const restrict me, const KmzPoint point) {
+    return (me->dimen.w > point.x && point.x > -1 && me->dimen.h > point.y && point.y > -1);
+}
+
+static const kmz_color_32 _KmzAhslImage__argb_at(const struct _kmz_ahsl_image_t * const restrict me, const KmzPoint point) {
+    const size_t i = (size_t)((me->dimen.w * point.y) + point.x);
+    return kmz_color_32__from_ahsl_color(_kmz_ahsl_color_at(me, i));
+}
+
+static void _KmzAhslImage__set_argb_at(struct _kmz_ahsl_image_t * const restrict me, const KmzPoint point, const kmz_color_32 color) {
+    const size_t i = (size_t)((me->dimen.w * point.y) + point.x);
+    _kmz_ahsl_set_color_at(me, i, KmzAhslColor__from_color_32(color));
+}
+
+static const KmzPixelOperationStatus _KmzAhslImage__read_argb_block(const struct _kmz_ahsl_image_t * const restrict me, const KmzRectangle src_area,
+        kmz_color_32 * const restrict dst) {
+    if (src_area.pos.x < 0 || src_area.pos.x >= me->dimen.w || src_area.pos.y < 0 || src_area.pos.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_POS;
+    } else if ((src_area.size.w + src_area.pos.x) > me->dimen.w || (src_area.size.h + src_area.pos.y) > me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_SIZE;
+    } else if (NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    size_t src_offset = (size_t)((src_area.pos.y * me->dimen.w) + src_area.pos.x), dst_offset = 0;
+    for (uint16_t line = 0; line < src_area.size.h; ++line) {
+        _KmzAhslImage__load(me, src_offset, dst + dst_offset, src_area.size.w);
+        src_offset += me->dimen.w;
+        dst_offset += src_area.size.w;
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzAhslImage__write_argb_block(struct _kmz_ahsl_image_t * const restrict me, const KmzRectangle dst_area,
+        const kmz_color_32 * const restrict src) {
+    if (dst_area.pos.x < 0 || dst_area.pos.x >= me->dimen.w || dst_area.pos.y < 0 || dst_area.pos.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_POS;
+    } else if ((dst_area.size.w + dst_area.pos.x) > me->dimen.w || (dst_area.size.h + dst_area.pos.y) > me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    } else if (NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    size_t dst_offset = (size_t)((dst_area.pos.y * me->dimen.w) + dst_area.pos.x), src_offset = 0;
+    for (uint16_t line = 0; line < dst_area.size.h; ++line) {
+        _KmzAhslImage__store(me, dst_offset, src + src_offset, dst_area.size.w);
+        dst_offset += me->dimen.w;
+        src_offset += dst_area.size.w;
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzAhslImage__read_row_span(const struct _kmz_ahsl_image_t * const restrict me, const KmzPoint start, const size_t count,
+        kmz_color_32 * const restrict dst) {
+    if (start.x < 0 || start.x >= me->dimen.w || start.y < 0 || start.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_POS;
+    } else if (count > (size_t)(me->dimen.w - start.x)) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_SIZE;
+    } else if (NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    _KmzAhslImage__load(me, (size_t)((start.y * me->dimen.w) + start.x), dst, count);
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzAhslImage__write_row_span(struct _kmz_ahsl_image_t * const restrict me, const KmzPoint start, const size_t count,
+        const kmz_color_32 * const restrict src) {
+    if (start.x < 0 || start.x >= me->dimen.w || start.y < 0 || start.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_POS;
+    } else if (count > (size_t)(me->dimen.w - start.x)) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    } else if (NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    _KmzAhslImage__store(me, (size_t)((start.y * me->dimen.w) + start.x), src, count);
+    return KMZ_PIXEL_OP_OK;
+}
+
+const KmzImageType kmz_ahsl_image = {
+    ._new=(void * const (*)(void))&_KmzAhslImage__new,
+    ._ctor=(void (*)(void * const restrict, const void * const restrict))&_KmzAhslImage__ctor,
+    ._dtor=(void (*)(void * const restrict))&_KmzAhslImage__dtor,
+    .dimen=(const KmzSize (*)(const void * const restrict))&_KmzAhslImage__dimen,
+    .argb_at=(const kmz_color_32 (*)(const void * const restrict, const KmzPoint))&_KmzAhslImage__argb_at,
+    .set_argb_at=(void (*)(void * const restrict, const KmzPoint, const kmz_color_32))&_KmzAhslImage__set_argb_at,
+    .is_valid=(const KmzBool (*)(const void * const restrict, const KmzPoint))&_KmzAhslImage__is_valid,
+    .read_argb_block=(const KmzPixelOperationStatus (*)(const void * const restrict, const KmzRectangle, kmz_color_32 * const restrict))&_KmzAhslImage__read_argb_block,
+    .write_argb_block=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzRectangle, const kmz_color_32 * const restrict))&_KmzAhslImage__write_argb_block,
+    .read_row_span=(const KmzPixelOperationStatus (*)(const void * const restrict, const KmzPoint, const size_t, kmz_color_32 * const restrict))&_KmzAhslImage__read_row_span,
+    .write_row_span=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzPoint, const size_t, const kmz_color_32 * const restrict))&_KmzAhslImage__write_row_span
+};
+
+static KmzImage * const _KmzAhslImage__new_image(const KmzSize dimen, const KmzAhslColor * const restrict pixels) {
+    const struct _kmz_ahsl_image_argv_t argv = {dimen, pixels};
+    KmzImage * const restrict me = KmzImage__new(&kmz_ahsl_image, &argv);
+
+    if (NULL != me && NULL == ((struct _kmz_ahsl_image_t *)_KmzImage__impl(me))->block) {
+        KmzImage__free(me);
+        return NULL;
+    }
+    return me;
+}
+
+KmzImage * const KmzImage__new_ahsl_from_image(const KmzImage * const restrict image) {
+    const KmzSize dimen = KmzImage__dimen(image);
+    KmzImage * const restrict me = _KmzAhslImage__new_image(dimen, NULL);
+    if (NULL == me) {
+        return NULL;
+    }
+
+    kmz_color_32 * const restrict line = calloc(dimen.w ? dimen.w : 1, sizeof(kmz_color_32));
+    if (NULL == line) {
+        KmzImage__free(me);
+        return NULL;
+    }
+
+    struct _kmz_ahsl_image_t * const restrict planes = _KmzImage__impl(me);
+    for (uint16_t y = 0; y < dimen.h; ++y) {
+        if (KMZ_PIXEL_OP_OK != KmzImage__read_argb_block(image, kmz_rectangle(kmz_point(0, y), kmz_size(dimen.w, 1)), line)) {
+            free(line);
+            KmzImage__free(me);
+            return NULL;
+        }
+        _KmzAhslImage__store(planes, (size_t)y * dimen.w, line, dimen.w);
+    }
+
+    free(line);
+    return me;
+}
+
+KmzImage * const KmzImage__new_ahsl_from_file(KmzImageFile * const restrict file) {
+    if (KMZ_IMAGE_FILE_AHSL == KmzImageFile__color_type(file)) {
+        const KmzSize dimen = KmzImageFile__dimen(file);
+        KmzAhslColor * const restrict buffer = calloc((size_t)dimen.w * dimen.h, sizeof(KmzAhslColor));
+        if (NULL == buffer) {
+            return NULL;
+        }
+        KmzImageFile__read_ahsl_pixels(file, buffer);
+        KmzImage * const restrict me = _KmzAhslImage__new_image(dimen, buffer);
+        free(buffer);
+        return me;
+    }
+
+    KmzImage * const restrict argb = KmzImage__new_from_file(file);
+    if (NULL == argb) {
+        return NULL;
+    }
+    KmzImage * const restrict me = KmzImage__new_ahsl_from_image(argb);
+    KmzImage__free(argb);
+    return me;
+}
+
+static const KmzPixelOperationStatus _KmzImage__adjust_ahsl(KmzImage * const restrict me, const KmzRectangle area,
+        const _KmzAhslAdjustment adjustment, const size_t channel, const kmz_percent amount) {
+    const KmzSize dimen = KmzImage__dimen(me);
+    const ssize_t x = kmz_clamp(area.pos.x, 0, dimen.w),
+          y = kmz_clamp(area.pos.y, 0, dimen.h),
+          max_x = kmz_clamp(area.size.w + x, x, dimen.w),
+          max_y = kmz_clamp(area.size.h + y, y, dimen.h);
+    const size_t w = (size_t)(max_x - x);
+
+    if (0 == w || max_y == y) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    if (&kmz_ahsl_image == KmzImage__type(me)) {
+        struct _kmz_ahsl_image_t * const restrict planes = _KmzImage__impl(me);
+        uint16_t * const restrict plane = 0 == channel ? planes->h : (1 == channel ? planes->s : planes->l);
+
+        if (0 == x && w == dimen.w) {
+            _kmz_adjust_plane(plane + (size_t)y * dimen.w, (size_t)(max_y - y) * w, adjustment, amount);
+        } else {
+            for (ssize_t line = y; line < max_y; ++line) {
+                _kmz_adjust_plane(plane + (size_t)line * dimen.w + (size_t)x, w, adjustment, amount);
+            }
+        }
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    // Every pixel of a palette image that is adjusted as a whole uses a palette color, so only the palette needs to be adjusted.
+    const size_t color_count = KmzImage__palette_color_count(me);
+    if (0 != color_count && 0 == x && 0 == y && w == dimen.w && max_y == dimen.h) {
+        kmz_color_32 palette[256];
+        KmzAhslColor colors[256];
+        KmzImage__read_palette(me, palette);
+        kmz_color_32__to_ahsl_span(palette, colors, color_count);
+        for (size_t i = 0; i < color_count; ++i) {
+            kmz_percent * const restrict value = 0 == channel ? &colors[i].h : (1 == channel ? &colors[i].s : &colors[i].l);
+            *value = _kmz_adjust_channel(adjustment, *value, amount);
+        }
+        kmz_color_32__from_ahsl_span(colors, palette, color_count);
+        return KmzImage__write_palette(me, palette, color_count);
+    }
+
+    kmz_color_32 * const restrict line = calloc(w, sizeof(kmz_color_32));
+    KmzAhslColor * const restrict colors = calloc(w, sizeof(KmzAhslColor));
+    KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+
+    if (NULL == line || NULL == colors) {
+        free(line);
+        free(colors);
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    for (ssize_t l = y; l < max_y && KMZ_PIXEL_OP_OK == status; ++l) {
+        const KmzRectangle row = kmz_rectangle(kmz_point(x, l), kmz_size((uint16_t)w, 1));
+        status = KmzImage__read_argb_block(me, row, line);
+        if (KMZ_PIXEL_OP_OK != status) {
+            break;
+        }
+        kmz_color_32__to_ahsl_span(line, colors, w);
+        for (size_t i = 0; i < w; ++i) {
+            kmz_percent * const restrict value = 0 == channel ? &colors[i].h : (1 == channel ? &colors[i].s : &colors[i].l);
+            *value = _kmz_adjust_channel(adjustment, *value, amount);
+        }
+        kmz_color_32__from_ahsl_span(colors, line, w);
+        status = KmzImage__write_argb_block(me, row, line);
+    }
+
+    free(line);
+    free(colors);
+    return status;
+}
+
+const KmzPixelOperationStatus KmzImage__rotate_hue(KmzImage * const restrict me, const KmzRectangle area, const kmz_percent amount) {
+    return _KmzImage__adjust_ahsl(me, area, _KMZ_AHSL_ROTATE, 0, amount);
+}
+
+const KmzPixelOperationStatus KmzImage__saturate(KmzImage * const restrict me, const KmzRectangle area, const kmz_percent factor) {
+    return _KmzImage__adjust_ahsl(me, area, _KMZ_AHSL_SCALE, 1, factor);
+}
+
+const KmzPixelOperationStatus KmzImage__lighten(KmzImage * const restrict me, const KmzRectangle area, const kmz_percent amount) {
+    return _KmzImage__adjust_ahsl(me, area, _KMZ_AHSL_OFFSET, 2, amount);
+}
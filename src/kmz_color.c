@@ -58,21 +58,7 @@ static inline const kmz_percent _kmz_rgb2delta(const kmz_percent max, const kmz_
     return ((((max - channel) / 6.f) + half_max_delta) / max_delta);
 }
 
-KmzArgbColor KmzArgbColor__from_hex(kmz_hex_string color) {
-    return KmzArgbColor__from_color_32(kmz_color_32__from_hex(color));
-}
-
-KmzArgbColor KmzArgbColor__from_color_32(const kmz_color_32 color) {
-    const kmz_channel * c = (kmz_channel*)&color;
-    return KmzArgbColor__from_channels(c[3], c[2], c[1], c[0]);
-}
-
-KmzArgbColor KmzArgbColor__from_channels(const kmz_channel a, const kmz_channel r, const kmz_channel g, const kmz_channel b) {
-    const KmzArgbColor c = {.a=a, .r=r, .g=g, .b=b};
-    return c;
-}
-
-KmzArgbColor KmzArgbColor__from_ahsl_color(const KmzAhslColor color) {
+static inline const KmzArgbColor _kmz_ahsl2argb(const KmzAhslColor color) {
     const kmz_channel a = color.a;
     kmz_channel r, g, b;
 
@@ -96,23 +82,11 @@ KmzArgbColor KmzArgbColor__from_ahsl_color(const KmzAhslColor color) {
         b = ((kmz_channel)round(255.f * _kmz_hue2rgb(part_1, part_2, color.h - _KMZ_ONE_THIRD)));
     }
 
-    return KmzArgbColor__from_channels(a, r, g, b);
-}
-
-KmzAhslColor KmzAhslColor__from_hex(kmz_hex_string color) {
-    return KmzAhslColor__from_argb_color(KmzArgbColor__from_hex(color));
-}
-
-KmzAhslColor KmzAhslColor__from_color_32(const kmz_color_32 color) {
-    return KmzAhslColor__from_argb_color(KmzArgbColor__from_color_32(color));
-}
-
-KmzAhslColor KmzAhslColor__from_channels(const kmz_channel a, const kmz_percent h, const kmz_percent s, const kmz_percent l) {
-    const KmzAhslColor c = {.a=a, .h=h, .s=s, .l=l};
+    const KmzArgbColor c = {.a=a, .r=r, .g=g, .b=b};
     return c;
 }
 
-KmzAhslColor KmzAhslColor__from_argb_color(KmzArgbColor color) {
+static inline const KmzAhslColor _kmz_argb2ahsl(const KmzArgbColor color) {
     const kmz_channel a = color.a;
     kmz_percent h, s, l;
 
@@ -163,7 +137,309 @@ KmzAhslColor KmzAhslColor__from_argb_color(KmzArgbColor color) {
         }
     }
 
-    return KmzAhslColor__from_channels(a, h, s, l);
+    const KmzAhslColor c = {.a=a, .h=h, .s=s, .l=l};
+    return c;
+}
+
+static inline const KmzArgbColor _kmz_color_32_to_argb(const kmz_color_32 color) {
+    const KmzArgbColor c = {.a=(kmz_channel)(color >> 24u), .r=(kmz_channel)(color >> 16u), .g=(kmz_channel)(color >> 8u), .b=(kmz_channel)color};
+    return c;
+}
+
+static inline const kmz_color_32 _kmz_argb_to_color_32(const KmzArgbColor color) {
+    return (kmz_color_32)(((kmz_color_32)color.a << 24u) | (color.r << 16u) | (color.g << 8u) | color.b);
+}
+
+/*
+ * The batch kernels below evaluate the exact same sequence of IEEE single precision operations as _kmz_argb2ahsl and
+ * _kmz_ahsl2argb, replacing every branch with a lane mask, so every SIMD level produces results identical to the
+ * scalar conversion for all finite channels. fmodf(x, 1) is computed as x - trunc(x), which is exact, and round() of
+ * a float is computed as a truncation followed by a comparison of the exact fractional part against one half.
+ */
+#define _kmz_ahsl_span_is_packed (16 == sizeof(KmzAhslColor) && 4 == offsetof(KmzAhslColor, h) && \
+        8 == offsetof(KmzAhslColor, s) && 12 == offsetof(KmzAhslColor, l))
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static inline __m128 _kmz_sse2_fmod_1(const __m128 x) {
+    return _mm_sub_ps(x, _kmz_sse2_trunc(x));
+}
+
+kmz__target("sse2") static inline __m128i _kmz_sse2_round_channel(const __m128 x) {
+    const __m128i t = _mm_cvttps_epi32(x);
+    const __m128 fraction = _mm_sub_ps(x, _mm_cvtepi32_ps(t));
+    const __m128i up = _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f))),
+          down = _mm_castps_si128(_mm_cmple_ps(fraction, _mm_set1_ps(-0.5f)));
+    return _mm_and_si128(_mm_add_epi32(_mm_sub_epi32(t, up), down), _mm_set1_epi32(0xFF));
+}
+
+kmz__target("sse2") static inline __m128 _kmz_sse2_hue2rgb(const __m128 part_1, const __m128 part_2, __m128 hue) {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+    const __m128 is_negative = _mm_cmplt_ps(hue, zero), is_over = _mm_cmpgt_ps(hue, one);
+    hue = _kmz_sse2_select(is_negative, _mm_sub_ps(one, _kmz_sse2_fmod_1(_mm_sub_ps(zero, hue))),
+            _kmz_sse2_select(is_over, _kmz_sse2_fmod_1(hue), hue));
+
+    const __m128 diff = _mm_sub_ps(part_2, part_1);
+    const __m128 rise = _mm_add_ps(part_1, _mm_mul_ps(_mm_mul_ps(diff, _mm_set1_ps(6.f)), hue)),
+          fall = _mm_add_ps(part_1, _mm_mul_ps(diff, _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(_KMZ_TWO_THIRDS), hue), _mm_set1_ps(6.f))));
+    const __m128 in_rise = _mm_cmpgt_ps(one, _mm_mul_ps(_mm_set1_ps(6.f), hue)),
+          in_peak = _mm_cmpgt_ps(one, _mm_mul_ps(_mm_set1_ps(2.f), hue)),
+          in_fall = _mm_cmpgt_ps(_mm_set1_ps(2.f), _mm_mul_ps(_mm_set1_ps(3.f), hue));
+
+    return _kmz_sse2_select(in_rise, rise, _kmz_sse2_select(in_peak, part_2, _kmz_sse2_select(in_fall, fall, part_1)));
+}
+
+kmz__target("sse2") static void _kmz_sse2_to_ahsl_span(const kmz_color_32 * const restrict src, KmzAhslColor * const restrict dst,
+        const size_t count) {
+    const __m128i byte = _mm_set1_epi32(0xFF);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), half = _mm_set1_ps(0.5f), two = _mm_set1_ps(2.f),
+          six = _mm_set1_ps(6.f), max_channel = _mm_set1_ps(255.f);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        const __m128i c = _mm_loadu_si128((const __m128i *)(src + i));
+        const __m128i a = _mm_srli_epi32(c, 24),
+              r = _mm_and_si128(_mm_srli_epi32(c, 16), byte),
+              g = _mm_and_si128(_mm_srli_epi32(c, 8), byte),
+              b = _mm_and_si128(c, byte);
+
+        const __m128 red = _mm_div_ps(_mm_cvtepi32_ps(r), max_channel),
+              green = _mm_div_ps(_mm_cvtepi32_ps(g), max_channel),
+              blue = _mm_div_ps(_mm_cvtepi32_ps(b), max_channel);
+        const __m128 min = _mm_min_ps(_mm_min_ps(red, green), blue),
+              max = _mm_max_ps(_mm_max_ps(red, green), blue);
+        const __m128 max_delta = _mm_sub_ps(max, min), min_max_sum = _mm_add_ps(min, max);
+        const __m128 half_max_delta = _mm_div_ps(max_delta, two);
+
+        __m128 l = _mm_div_ps(min_max_sum, two);
+        __m128 s = _kmz_sse2_select(_mm_cmpgt_ps(half, l), _mm_div_ps(max_delta, min_max_sum),
+                _mm_div_ps(max_delta, _mm_sub_ps(_mm_sub_ps(two, max), min)));
+
+        const __m128 red_delta = _mm_div_ps(_mm_add_ps(_mm_div_ps(_mm_sub_ps(max, red), six), half_max_delta), max_delta),
+              green_delta = _mm_div_ps(_mm_add_ps(_mm_div_ps(_mm_sub_ps(max, green), six), half_max_delta), max_delta),
+              blue_delta = _mm_div_ps(_mm_add_ps(_mm_div_ps(_mm_sub_ps(max, blue), six), half_max_delta), max_delta);
+
+        __m128 h = _kmz_sse2_select(_mm_cmpeq_ps(max, red), _mm_sub_ps(blue_delta, green_delta),
+                _kmz_sse2_select(_mm_cmpeq_ps(max, green), _mm_sub_ps(_mm_add_ps(_mm_set1_ps(_KMZ_ONE_THIRD), red_delta), blue_delta),
+                    _mm_sub_ps(_mm_add_ps(_mm_set1_ps(_KMZ_TWO_THIRDS), green_delta), red_delta)));
+        h = _kmz_sse2_select(_mm_cmplt_ps(h, zero), _mm_sub_ps(one, _kmz_sse2_fmod_1(_mm_sub_ps(zero, h))),
+                _kmz_sse2_select(_mm_cmpgt_ps(h, one), _kmz_sse2_fmod_1(h), h));
+
+        const __m128 is_gray = _mm_castsi128_ps(_mm_and_si128(_mm_cmpeq_epi32(r, g), _mm_cmpeq_epi32(g, b)));
+        const __m128 gray = _mm_div_ps(_mm_div_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(r, g), b)), _mm_set1_ps(3.f)), max_channel);
+        h = _mm_andnot_ps(is_gray, h);
+        s = _mm_andnot_ps(is_gray, s);
+        l = _kmz_sse2_select(is_gray, gray, l);
+
+        __m128 o0 = _mm_castsi128_ps(a), o1 = h, o2 = s, o3 = l;
+        _MM_TRANSPOSE4_PS(o0, o1, o2, o3);
+        _mm_storeu_ps((float *)(dst + i), o0);
+        _mm_storeu_ps((float *)(dst + i + 1), o1);
+        _mm_storeu_ps((float *)(dst + i + 2), o2);
+        _mm_storeu_ps((float *)(dst + i + 3), o3);
+    }
+
+    for (; i < count; ++i) {
+        dst[i] = _kmz_argb2ahsl(_kmz_color_32_to_argb(src[i]));
+    }
+}
+
+kmz__target("sse2") static void _kmz_sse2_from_ahsl_span(const KmzAhslColor * const restrict src, kmz_color_32 * const restrict dst,
+        const size_t count) {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), half = _mm_set1_ps(0.5f), max_channel = _mm_set1_ps(255.f);
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps((const float *)(src + i)), h = _mm_loadu_ps((const float *)(src + i + 1)),
+               s = _mm_loadu_ps((const float *)(src + i + 2)), l = _mm_loadu_ps((const float *)(src + i + 3));
+        _MM_TRANSPOSE4_PS(a, h, s, l);
+
+        const __m128 part_2 = _kmz_sse2_select(_mm_cmpgt_ps(half, l), _mm_mul_ps(l, _mm_add_ps(one, s)),
+                _mm_sub_ps(_mm_add_ps(l, s), _mm_mul_ps(s, l)));
+        const __m128 part_1 = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(2.f), l), part_2);
+
+        __m128i r = _kmz_sse2_round_channel(_mm_mul_ps(max_channel, _kmz_sse2_hue2rgb(part_1, part_2, _mm_add_ps(h, _mm_set1_ps(_KMZ_ONE_THIRD))))),
+                g = _kmz_sse2_round_channel(_mm_mul_ps(max_channel, _kmz_sse2_hue2rgb(part_1, part_2, h))),
+                b = _kmz_sse2_round_channel(_mm_mul_ps(max_channel, _kmz_sse2_hue2rgb(part_1, part_2, _mm_sub_ps(h, _mm_set1_ps(_KMZ_ONE_THIRD)))));
+
+        const __m128i is_black = _mm_castps_si128(_mm_cmpeq_ps(l, zero)),
+              is_gray = _mm_castps_si128(_mm_cmpeq_ps(s, zero));
+        const __m128i gray = _kmz_sse2_round_channel(_mm_mul_ps(l, max_channel));
+        r = _mm_andnot_si128(is_black, _kmz_sse2_select_si(is_gray, gray, r));
+        g = _mm_andnot_si128(is_black, _kmz_sse2_select_si(is_gray, gray, g));
+        b = _mm_andnot_si128(is_black, _kmz_sse2_select_si(is_gray, gray, b));
+
+        const __m128i alpha = _mm_and_si128(_mm_castps_si128(a), _mm_set1_epi32(0xFF));
+        const __m128i c = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(alpha, 24), _mm_slli_epi32(r, 16)),
+                _mm_or_si128(_mm_slli_epi32(g, 8), b));
+        _mm_storeu_si128((__m128i *)(dst + i), c);
+    }
+
+    for (; i < count; ++i) {
+        dst[i] = _kmz_argb_to_color_32(_kmz_ahsl2argb(src[i]));
+    }
+}
+
+kmz__target("avx2") static inline __m256i _kmz_avx2_round_channel(const __m256 x) {
+    const __m256 t = _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    const __m256 fraction = _mm256_sub_ps(x, t);
+    const __m256i up = _mm256_castps_si256(_mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ)),
+          down = _mm256_castps_si256(_mm256_cmp_ps(fraction, _mm256_set1_ps(-0.5f), _CMP_LE_OQ));
+    return _mm256_and_si256(_mm256_add_epi32(_mm256_sub_epi32(_mm256_cvttps_epi32(t), up), down), _mm256_set1_epi32(0xFF));
+}
+
+kmz__target("avx2") static inline __m256 _kmz_avx2_fmod_1(const __m256 x) {
+    return _mm256_sub_ps(x, _mm256_round_ps(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+}
+
+kmz__target("avx2") static inline __m256 _kmz_avx2_hue2rgb(const __m256 part_1, const __m256 part_2, __m256 hue) {
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f), six = _mm256_set1_ps(6.f);
+    hue = _mm256_blendv_ps(_mm256_blendv_ps(hue, _kmz_avx2_fmod_1(hue), _mm256_cmp_ps(hue, one, _CMP_GT_OQ)),
+            _mm256_sub_ps(one, _kmz_avx2_fmod_1(_mm256_sub_ps(zero, hue))), _mm256_cmp_ps(hue, zero, _CMP_LT_OQ));
+
+    const __m256 diff = _mm256_sub_ps(part_2, part_1);
+    const __m256 rise = _mm256_add_ps(part_1, _mm256_mul_ps(_mm256_mul_ps(diff, six), hue)),
+          fall = _mm256_add_ps(part_1, _mm256_mul_ps(diff, _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(_KMZ_TWO_THIRDS), hue), six)));
+    const __m256 in_rise = _mm256_cmp_ps(one, _mm256_mul_ps(six, hue), _CMP_GT_OQ),
+          in_peak = _mm256_cmp_ps(one, _mm256_mul_ps(_mm256_set1_ps(2.f), hue), _CMP_GT_OQ),
+          in_fall = _mm256_cmp_ps(_mm256_set1_ps(2.f), _mm256_mul_ps(_mm256_set1_ps(3.f), hue), _CMP_GT_OQ);
+
+    return _mm256_blendv_ps(_mm256_blendv_ps(_mm256_blendv_ps(part_1, fall, in_fall), part_2, in_peak), rise, in_rise);
+}
+
+kmz__target("avx2") static void _kmz_avx2_to_ahsl_span(const kmz_color_32 * const restrict src, KmzAhslColor * const restrict dst,
+        const size_t count) {
+    const __m256i byte = _mm256_set1_epi32(0xFF), deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f), half = _mm256_set1_ps(0.5f), two = _mm256_set1_ps(2.f),
+          six = _mm256_set1_ps(6.f), max_channel = _mm256_set1_ps(255.f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        // Lanes are processed in the order 0, 2, 4, 6, 1, 3, 5, 7 so the in-lane transpose below emits whole structures.
+        const __m256i c = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(src + i)), deinterleave);
+        const __m256i a = _mm256_srli_epi32(c, 24),
+              r = _mm256_and_si256(_mm256_srli_epi32(c, 16), byte),
+              g = _mm256_and_si256(_mm256_srli_epi32(c, 8), byte),
+              b = _mm256_and_si256(c, byte);
+
+        const __m256 red = _mm256_div_ps(_mm256_cvtepi32_ps(r), max_channel),
+              green = _mm256_div_ps(_mm256_cvtepi32_ps(g), max_channel),
+              blue = _mm256_div_ps(_mm256_cvtepi32_ps(b), max_channel);
+        const __m256 min = _mm256_min_ps(_mm256_min_ps(red, green), blue),
+              max = _mm256_max_ps(_mm256_max_ps(red, green), blue);
+        const __m256 max_delta = _mm256_sub_ps(max, min), min_max_sum = _mm256_add_ps(min, max);
+        const __m256 half_max_delta = _mm256_div_ps(max_delta, two);
+
+        __m256 l = _mm256_div_ps(min_max_sum, two);
+        __m256 s = _mm256_blendv_ps(_mm256_div_ps(max_delta, _mm256_sub_ps(_mm256_sub_ps(two, max), min)),
+                _mm256_div_ps(max_delta, min_max_sum), _mm256_cmp_ps(half, l, _CMP_GT_OQ));
+
+        const __m256 red_delta = _mm256_div_ps(_mm256_add_ps(_mm256_div_ps(_mm256_sub_ps(max, red), six), half_max_delta), max_delta),
+              green_delta = _mm256_div_ps(_mm256_add_ps(_mm256_div_ps(_mm256_sub_ps(max, green), six), half_max_delta), max_delta),
+              blue_delta = _mm256_div_ps(_mm256_add_ps(_mm256_div_ps(_mm256_sub_ps(max, blue), six), half_max_delta), max_delta);
+
+        __m256 h = _mm256_blendv_ps(
+                _mm256_blendv_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_set1_ps(_KMZ_TWO_THIRDS), green_delta), red_delta),
+                    _mm256_sub_ps(_mm256_add_ps(_mm256_set1_ps(_KMZ_ONE_THIRD), red_delta), blue_delta),
+                    _mm256_cmp_ps(max, green, _CMP_EQ_OQ)),
+                _mm256_sub_ps(blue_delta, green_delta), _mm256_cmp_ps(max, red, _CMP_EQ_OQ));
+        h = _mm256_blendv_ps(_mm256_blendv_ps(h, _kmz_avx2_fmod_1(h), _mm256_cmp_ps(h, one, _CMP_GT_OQ)),
+                _mm256_sub_ps(one, _kmz_avx2_fmod_1(_mm256_sub_ps(zero, h))), _mm256_cmp_ps(h, zero, _CMP_LT_OQ));
+
+        const __m256 is_gray = _mm256_castsi256_ps(_mm256_and_si256(_mm256_cmpeq_epi32(r, g), _mm256_cmpeq_epi32(g, b)));
+        const __m256 gray = _mm256_div_ps(_mm256_div_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_add_epi32(r, g), b)),
+                    _mm256_set1_ps(3.f)), max_channel);
+        h = _mm256_andnot_ps(is_gray, h);
+        s = _mm256_andnot_ps(is_gray, s);
+        l = _mm256_blendv_ps(l, gray, is_gray);
+
+        const __m256 alpha = _mm256_castsi256_ps(a);
+        const __m256 t0 = _mm256_unpacklo_ps(alpha, h), t1 = _mm256_unpackhi_ps(alpha, h),
+              t2 = _mm256_unpacklo_ps(s, l), t3 = _mm256_unpackhi_ps(s, l);
+        _mm256_storeu_ps((float *)(dst + i), _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)));
+        _mm256_storeu_ps((float *)(dst + i + 2), _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)));
+        _mm256_storeu_ps((float *)(dst + i + 4), _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)));
+        _mm256_storeu_ps((float *)(dst + i + 6), _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)));
+    }
+
+    _kmz_sse2_to_ahsl_span(src + i, dst + i, count - i);
+}
+
+kmz__target("avx2") static void _kmz_avx2_from_ahsl_span(const KmzAhslColor * const restrict src, kmz_color_32 * const restrict dst,
+        const size_t count) {
+    const __m256i interleave = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f), half = _mm256_set1_ps(0.5f), max_channel = _mm256_set1_ps(255.f);
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v0 = _mm256_loadu_ps((const float *)(src + i)), v1 = _mm256_loadu_ps((const float *)(src + i + 2)),
+              v2 = _mm256_loadu_ps((const float *)(src + i + 4)), v3 = _mm256_loadu_ps((const float *)(src + i + 6));
+        const __m256 t0 = _mm256_unpacklo_ps(v0, v1), t1 = _mm256_unpackhi_ps(v0, v1),
+              t2 = _mm256_unpacklo_ps(v2, v3), t3 = _mm256_unpackhi_ps(v2, v3);
+
+        // Lanes now hold the colors 0, 2, 4, 6, 1, 3, 5, 7 and are interleaved back before storing.
+        const __m256 a = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), h = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+              s = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), l = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+        const __m256 part_2 = _mm256_blendv_ps(_mm256_sub_ps(_mm256_add_ps(l, s), _mm256_mul_ps(s, l)),
+                _mm256_mul_ps(l, _mm256_add_ps(one, s)), _mm256_cmp_ps(half, l, _CMP_GT_OQ));
+        const __m256 part_1 = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(2.f), l), part_2);
+
+        __m256i r = _kmz_avx2_round_channel(_mm256_mul_ps(max_channel,
+                    _kmz_avx2_hue2rgb(part_1, part_2, _mm256_add_ps(h, _mm256_set1_ps(_KMZ_ONE_THIRD))))),
+                g = _kmz_avx2_round_channel(_mm256_mul_ps(max_channel, _kmz_avx2_hue2rgb(part_1, part_2, h))),
+                b = _kmz_avx2_round_channel(_mm256_mul_ps(max_channel,
+                    _kmz_avx2_hue2rgb(part_1, part_2, _mm256_sub_ps(h, _mm256_set1_ps(_KMZ_ONE_THIRD)))));
+
+        const __m256i is_black = _mm256_castps_si256(_mm256_cmp_ps(l, zero, _CMP_EQ_OQ)),
+              is_gray = _mm256_castps_si256(_mm256_cmp_ps(s, zero, _CMP_EQ_OQ));
+        const __m256i gray = _kmz_avx2_round_channel(_mm256_mul_ps(l, max_channel));
+        r = _mm256_andnot_si256(is_black, _mm256_blendv_epi8(r, gray, is_gray));
+        g = _mm256_andnot_si256(is_black, _mm256_blendv_epi8(g, gray, is_gray));
+        b = _mm256_andnot_si256(is_black, _mm256_blendv_epi8(b, gray, is_gray));
+
+        const __m256i alpha = _mm256_and_si256(_mm256_castps_si256(a), _mm256_set1_epi32(0xFF));
+        const __m256i c = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(alpha, 24), _mm256_slli_epi32(r, 16)),
+                _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_permutevar8x32_epi32(c, interleave));
+    }
+
+    _kmz_sse2_from_ahsl_span(src + i, dst + i, count - i);
+}
+#endif
+
+KmzArgbColor KmzArgbColor__from_hex(kmz_hex_string color) {
+    return KmzArgbColor__from_color_32(kmz_color_32__from_hex(color));
+}
+
+KmzArgbColor KmzArgbColor__from_color_32(const kmz_color_32 color) {
+    const kmz_channel * c = (kmz_channel*)&color;
+    return KmzArgbColor__from_channels(c[3], c[2], c[1], c[0]);
+}
+
+KmzArgbColor KmzArgbColor__from_channels(const kmz_channel a, const kmz_channel r, const kmz_channel g, const kmz_channel b) {
+    const KmzArgbColor c = {.a=a, .r=r, .g=g, .b=b};
+    return c;
+}
+
+KmzArgbColor KmzArgbColor__from_ahsl_color(const KmzAhslColor color) {
+    return _kmz_ahsl2argb(color);
+}
+
+KmzAhslColor KmzAhslColor__from_hex(kmz_hex_string color) {
+    return KmzAhslColor__from_argb_color(KmzArgbColor__from_hex(color));
+}
+
+KmzAhslColor KmzAhslColor__from_color_32(const kmz_color_32 color) {
+    return KmzAhslColor__from_argb_color(KmzArgbColor__from_color_32(color));
+}
+
+KmzAhslColor KmzAhslColor__from_channels(const kmz_channel a, const kmz_percent h, const kmz_percent s, const kmz_percent l) {
+    const KmzAhslColor c = {.a=a, .h=h, .s=s, .l=l};
+    return c;
+}
+
+KmzAhslColor KmzAhslColor__from_argb_color(KmzArgbColor color) {
+    return _kmz_argb2ahsl(color);
 }
 
 const kmz_color_32 kmz_color_32__from_argb_color(const KmzArgbColor color) {
@@ -192,6 +468,85 @@ const kmz_color_32 kmz_color_32__from_hex(kmz_hex_string color) {
     return 0;
 }
 
+void kmz_color_32__to_ahsl_span(const kmz_color_32 * const restrict colors, KmzAhslColor * const restrict buffer, const size_t count) {
+#ifdef KMZ_SIMD_X86
+    if (_kmz_ahsl_span_is_packed) {
+        const KmzSimdLevel level = kmz_simd_level();
+        if (KMZ_SIMD_AVX2 <= level) {
+            _kmz_avx2_to_ahsl_span(colors, buffer, count);
+            return;
+        } else if (KMZ_SIMD_SSE2 <= level) {
+            _kmz_sse2_to_ahsl_span(colors, buffer, count);
+            return;
+        }
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        buffer[i] = _kmz_argb2ahsl(_kmz_color_32_to_argb(colors[i]));
+    }
+}
+
+void kmz_color_32__from_ahsl_span(const KmzAhslColor * const restrict colors, kmz_color_32 * const restrict buffer, const size_t count) {
+#ifdef KMZ_SIMD_X86
+    if (_kmz_ahsl_span_is_packed) {
+        const KmzSimdLevel level = kmz_simd_level();
+        if (KMZ_SIMD_AVX2 <= level) {
+            _kmz_avx2_from_ahsl_span(colors, buffer, count);
+            return;
+        } else if (KMZ_SIMD_SSE2 <= level) {
+            _kmz_sse2_from_ahsl_span(colors, buffer, count);
+            return;
+        }
+    }
+#endif
+    for (size_t i = 0; i < count; ++i) {
+        buffer[i] = _kmz_argb_to_color_32(_kmz_ahsl2argb(colors[i]));
+    }
+}
+
+#ifdef KMZ_SIMD_X86
+/**
+ * Opaque colors need no multiplication, so every group of 4 opaque colors is only widened.
+ */
+kmz__target("sse2") static void _kmz_sse2_premultiply_span(const kmz_color_32 * const restrict src, int16_t * const restrict dst, const size_t count) {
+    const __m128i zero = _mm_setzero_si128(), alpha_mask = _mm_set1_epi32(0x7F000000), alpha = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    size_t x = 0;
+    for (; x + 4 <= count; x += 4) {
+        const __m128i s = _mm_loadu_si128((const __m128i *)(src + x));
+        if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alpha_mask), zero))) {
+            _mm_storeu_si128((__m128i *)(dst + 4 * x), _mm_or_si128(_mm_unpacklo_epi8(s, zero), alpha));
+            _mm_storeu_si128((__m128i *)(dst + 4 * x + 8), _mm_or_si128(_mm_unpackhi_epi8(s, zero), alpha));
+        } else {
+            for (size_t i = x; i < x + 4; ++i) {
+                _kmz_color_premultiply(src[i], dst + 4 * i);
+            }
+        }
+    }
+    for (; x < count; ++x) {
+        _kmz_color_premultiply(src[x], dst + 4 * x);
+    }
+}
+#endif
+
+void _kmz_color_premultiply_span(const kmz_color_32 * const restrict src, int16_t * const restrict dst, const size_t count) {
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_SSE2 <= kmz_simd_level()) {
+        _kmz_sse2_premultiply_span(src, dst, count);
+        return;
+    }
+#endif
+    for (size_t x = 0; x < count; ++x) {
+        _kmz_color_premultiply(src[x], dst + 4 * x);
+    }
+}
+
+void _kmz_color_unpremultiply_span(const int16_t * const restrict src, kmz_color_32 * const restrict dst, const size_t count) {
+    for (size_t x = 0; x < count; ++x) {
+        const int32_t channels[4] = {src[4 * x], src[4 * x + 1], src[4 * x + 2], src[4 * x + 3]};
+        dst[x] = _kmz_color_unpremultiply(channels);
+    }
+}
+
 const KmzArgbColor KmzArgbColor__ALICE_BLUE = {.a=0, .r=0xF0, .g=0xF8, .b=0xFF},
       KmzArgbColor__ANTIQUE_WHITE = {.a=0, .r=0xFA, .g=0xEB, .b=0xD7},
       KmzArgbColor__AQUA = {.a=0, .r=0x00, .g=0xFF, .b=0xFF},
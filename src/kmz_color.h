@@ -43,11 +43,14 @@
  * |kmz_color_32__from_argb_color() |libkempozer/color.h    |
  * |kmz_color_32__from_ahsl_color() |libkempozer/color.h    |
  * |kmz_color_32__from_ex()         |libkempozer/color.h    |
+ * |kmz_color_32__to_ahsl_span()    |libkempozer/color.h    |
+ * |kmz_color_32__from_ahsl_span()  |libkempozer/color.h    |
  * |*                               |libkempozer/colors.h   |
  */
 #ifndef kmz_color_h
 #define kmz_color_h
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <math.h>
@@ -56,7 +59,67 @@
 
 #include "kmz_config.h"
 #include "kmz_shared.h"
+#include "kmz_utilities.h"
 #include "../include/libkempozer/color.h"
 #include "../include/libkempozer/colors.h"
 
+// region Premultiplied:
+
+/**
+ * Multiplies two 8-bit fixed point values, rounding the result to the nearest 8-bit value exactly.
+ */
+static inline const int32_t _kmz_color_mul(const int32_t a, const int32_t b) {
+    const int32_t t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+/**
+ * Widens the 7-bit inverted alpha of kempozer to an 8-bit opacity exactly, where 0 is transparent and 255 is opaque.
+ */
+static inline const int32_t _kmz_color_opacity(const kmz_color_32 color) {
+    const int32_t o = 127 - (int32_t)((color >> 24) & 0x7Fu);
+    return 2 * o + (o >> 6);
+}
+
+/**
+ * Splits `color` into premultiplied blue, green, red and alpha channels of 0-255.
+ */
+static inline void _kmz_color_premultiply(const kmz_color_32 color, int16_t * const restrict out) {
+    const int32_t alpha = _kmz_color_opacity(color);
+    for (unsigned int c = 0; c < 3; ++c) {
+        out[c] = (int16_t)_kmz_color_mul((int32_t)((color >> 8 * c) & 0xFFu), alpha);
+    }
+    out[3] = (int16_t)alpha;
+}
+
+/**
+ * Joins premultiplied blue, green, red and alpha channels of 0-255 back into a color, rounding every channel to the nearest value. Channels
+ * larger than the alpha are treated as the alpha.
+ */
+static inline const kmz_color_32 _kmz_color_unpremultiply(const int32_t * const restrict channels) {
+    const int32_t alpha = channels[3];
+    kmz_color_32 color = (kmz_color_32)(127 - _kmz_color_mul(alpha, 127)) << 24;
+    if (255 == alpha) {
+        return color | (kmz_color_32)channels[2] << 16 | (kmz_color_32)channels[1] << 8 | (kmz_color_32)channels[0];
+    } else if (0 != alpha) {
+        for (unsigned int c = 0; c < 3; ++c) {
+            const int32_t value = channels[c] < alpha ? channels[c] : alpha;
+            color |= (kmz_color_32)((510 * value + alpha) / (2 * alpha)) << 8 * c;
+        }
+    }
+    return color;
+}
+
+/**
+ * Splits every color of `src` into 4 premultiplied channels of `dst` using {@link _kmz_color_premultiply}.
+ */
+void _kmz_color_premultiply_span(const kmz_color_32 * const src, int16_t * const dst, const size_t count);
+
+/**
+ * Joins every 4 premultiplied channels of `src`, which MUST be between 0 and 255, into a color of `dst` using {@link _kmz_color_unpremultiply}.
+ */
+void _kmz_color_unpremultiply_span(const int16_t * const src, kmz_color_32 * const dst, const size_t count);
+
+// endregion;
+
 #endif /* kmz_color_h */
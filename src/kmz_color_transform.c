@@ -0,0 +1,488 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_color_transform.h"
+
+/**
+ * The number of entries along every side of the table that a chain mixing its channels in more than a single matrix is compiled to.
+ */
+#define _KMZ_TRANSFORM_LUT_SIZE 33
+/**
+ * The fixed point scale of the channels and coefficients of a compiled matrix, where the channels between the matrix and the curves after it keep
+ * 12 bits so the curves do not amplify a rounding to 8 bits.
+ */
+#define _KMZ_TRANSFORM_SHIFT 12
+#define _KMZ_TRANSFORM_ONE (1 << _KMZ_TRANSFORM_SHIFT)
+/**
+ * The largest coefficient or offset of a channel mix, which keeps every compiled sum within 31 bits.
+ */
+#define _KMZ_TRANSFORM_MAX_COEFFICIENT 16.f
+
+/**
+ * Defines the steps that may be recorded into a color transform.
+ */
+enum _kmz_transform_op_e {
+    _KMZ_TRANSFORM_ROTATE_HUE = 0,
+    _KMZ_TRANSFORM_SATURATE = 1,
+    _KMZ_TRANSFORM_LIGHTEN = 2,
+    _KMZ_TRANSFORM_LEVELS = 3,
+    _KMZ_TRANSFORM_MIX = 4,
+};
+typedef enum _kmz_transform_op_e _KmzTransformOp;
+
+/**
+ * Defines the forms that a color transform may be compiled to, from the cheapest to the most general.
+ */
+enum _kmz_transform_form_e {
+    _KMZ_TRANSFORM_UNCOMPILED = 0,
+    /**
+     * A curve of every channel, which is 3 lookups of an 8-bit channel per pixel.
+     */
+    _KMZ_TRANSFORM_CURVES = 1,
+    /**
+     * A curve of every channel, a single channel mix and another curve of every channel.
+     */
+    _KMZ_TRANSFORM_MATRIX = 2,
+    /**
+     * A curve of every channel folded into the grid positions of a 3D LUT that holds the rest of the chain.
+     */
+    _KMZ_TRANSFORM_LUT = 3,
+};
+typedef enum _kmz_transform_form_e _KmzTransformForm;
+
+struct _kmz_transform_step_t {
+    _KmzTransformOp op;
+    /**
+     * The amount of the HSL adjustments, the input black and white, the reciprocal of the gamma and the output black and white of the levels, or
+     * the rows of red, green and blue of the mix, each as 3 coefficients followed by an offset.
+     */
+    float values[12];
+};
+
+struct kmz_color_transform_t {
+    struct _kmz_transform_step_t * steps;
+    size_t count;
+    size_t capacity;
+    _KmzTransformForm form;
+    /**
+     * The output of every 8-bit value of red, green and blue already shifted into its place in a {@link kmz_color_32}.
+     */
+    uint32_t curves[3][256];
+    /**
+     * The inputs of the matrix of every 8-bit value of red, green and blue in `_KMZ_TRANSFORM_SHIFT` fixed point.
+     */
+    int32_t inputs[3][256];
+    /**
+     * The rows of the matrix, where the coefficients are in `_KMZ_TRANSFORM_SHIFT` fixed point and the offsets in twice that.
+     */
+    int32_t matrix[12];
+    /**
+     * The output of every `_KMZ_TRANSFORM_SHIFT` fixed point output of the matrix for red, green and blue, already shifted into place.
+     */
+    uint32_t * outputs;
+    KmzColorLut3D * lut;
+};
+
+// region Steps:
+
+static inline const float _kmz_transform_clamp(const float value) {
+    return value > 0.f ? (value < 1.f ? value : 1.f) : 0.f;
+}
+
+static inline const uint32_t _kmz_transform_channel(const float value) {
+    return (uint32_t)(_kmz_transform_clamp(value) * 255.f + .5f);
+}
+
+static void _kmz_transform_to_hsl(const float * const restrict rgb, float * const restrict hsl) {
+    const float max = fmaxf(fmaxf(rgb[0], rgb[1]), rgb[2]), min = fminf(fminf(rgb[0], rgb[1]), rgb[2]), delta = max - min;
+    hsl[2] = (max + min) / 2.f;
+    if (0.f == delta) {
+        hsl[0] = hsl[1] = 0.f;
+        return;
+    }
+
+    hsl[1] = .5f > hsl[2] ? delta / (max + min) : delta / (2.f - max - min);
+    float hue;
+    if (max == rgb[0]) {
+        hue = (rgb[1] - rgb[2]) / delta;
+    } else if (max == rgb[1]) {
+        hue = 2.f + (rgb[2] - rgb[0]) / delta;
+    } else {
+        hue = 4.f + (rgb[0] - rgb[1]) / delta;
+    }
+    hue /= 6.f;
+    hsl[0] = hue - floorf(hue);
+}
+
+static inline const float _kmz_transform_hue(const float part_1, const float part_2, float hue) {
+    hue -= floorf(hue);
+    if (1.f > 6.f * hue) {
+        return part_1 + (part_2 - part_1) * 6.f * hue;
+    } else if (1.f > 2.f * hue) {
+        return part_2;
+    } else if (2.f > 3.f * hue) {
+        return part_1 + (part_2 - part_1) * (2.f / 3.f - hue) * 6.f;
+    }
+    return part_1;
+}
+
+static void _kmz_transform_to_rgb(const float * const restrict hsl, float * const restrict rgb) {
+    if (0.f == hsl[1]) {
+        rgb[0] = rgb[1] = rgb[2] = hsl[2];
+        return;
+    }
+
+    const float part_2 = .5f > hsl[2] ? hsl[2] * (1.f + hsl[1]) : hsl[2] + hsl[1] - hsl[1] * hsl[2], part_1 = 2.f * hsl[2] - part_2;
+    rgb[0] = _kmz_transform_hue(part_1, part_2, hsl[0] + 1.f / 3.f);
+    rgb[1] = _kmz_transform_hue(part_1, part_2, hsl[0]);
+    rgb[2] = _kmz_transform_hue(part_1, part_2, hsl[0] - 1.f / 3.f);
+}
+
+/**
+ * Applies the steps from `from` to `to` to a color in floating point, where every channel runs from 0 to 1 and is clamped after every step.
+ */
+static void _kmz_transform_eval(const KmzColorTransform * const restrict me, const size_t from, const size_t to, float * const restrict rgb) {
+    for (size_t i = from; i < to; ++i) {
+        const struct _kmz_transform_step_t * const restrict step = me->steps + i;
+        const float * const restrict values = step->values;
+        float hsl[3], mixed[3];
+        switch (step->op) {
+            case _KMZ_TRANSFORM_ROTATE_HUE:
+            case _KMZ_TRANSFORM_SATURATE:
+            case _KMZ_TRANSFORM_LIGHTEN:
+                _kmz_transform_to_hsl(rgb, hsl);
+                if (_KMZ_TRANSFORM_ROTATE_HUE == step->op) {
+                    hsl[0] += values[0];
+                    hsl[0] -= floorf(hsl[0]);
+                } else if (_KMZ_TRANSFORM_SATURATE == step->op) {
+                    hsl[1] = _kmz_transform_clamp(hsl[1] * values[0]);
+                } else {
+                    hsl[2] = _kmz_transform_clamp(hsl[2] + values[0]);
+                }
+                _kmz_transform_to_rgb(hsl, rgb);
+                break;
+            case _KMZ_TRANSFORM_LEVELS:
+                for (size_t c = 0; c < 3; ++c) {
+                    const float level = powf(_kmz_transform_clamp((rgb[c] - values[0]) / (values[1] - values[0])), values[2]);
+                    rgb[c] = values[3] + level * (values[4] - values[3]);
+                }
+                break;
+            case _KMZ_TRANSFORM_MIX:
+            default:
+                for (size_t c = 0; c < 3; ++c) {
+                    mixed[c] = values[4 * c] * rgb[0] + values[4 * c + 1] * rgb[1] + values[4 * c + 2] * rgb[2] + values[4 * c + 3];
+                }
+                memcpy(rgb, mixed, sizeof(mixed));
+                break;
+        }
+        for (size_t c = 0; c < 3; ++c) {
+            rgb[c] = _kmz_transform_clamp(rgb[c]);
+        }
+    }
+}
+
+/**
+ * Drops the compiled form of a transform, so the next application compiles the chain again.
+ */
+static void _kmz_transform_drop(KmzColorTransform * const restrict me) {
+    free(me->outputs);
+    me->outputs = NULL;
+    if (NULL != me->lut) {
+        KmzColorLut3D__free(me->lut);
+        me->lut = NULL;
+    }
+    me->form = _KMZ_TRANSFORM_UNCOMPILED;
+}
+
+static const KmzBool _kmz_transform_record(KmzColorTransform * const restrict me, const _KmzTransformOp op, const float * const restrict values,
+        const size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (!isfinite(values[i])) {
+            return KMZ_FALSE;
+        }
+    }
+    if (me->count == me->capacity) {
+        const size_t capacity = me->capacity ? 2 * me->capacity : 8;
+        struct _kmz_transform_step_t * const restrict steps = realloc(me->steps, capacity * sizeof(struct _kmz_transform_step_t));
+        if (NULL == steps) {
+            return KMZ_FALSE;
+        }
+        me->steps = steps;
+        me->capacity = capacity;
+    }
+
+    struct _kmz_transform_step_t * const restrict step = me->steps + me->count++;
+    memset(step, 0, sizeof(*step));
+    step->op = op;
+    memcpy(step->values, values, count * sizeof(float));
+    _kmz_transform_drop(me);
+    return KMZ_TRUE;
+}
+
+KmzColorTransform * const KmzColorTransform__new(void) {
+    return calloc(1, sizeof(KmzColorTransform));
+}
+
+void KmzColorTransform__free(KmzColorTransform * const restrict me) {
+    _kmz_transform_drop(me);
+    free(me->steps);
+    free(me);
+}
+
+const KmzBool KmzColorTransform__rotate_hue(KmzColorTransform * const restrict me, const kmz_percent amount) {
+    return _kmz_transform_record(me, _KMZ_TRANSFORM_ROTATE_HUE, &amount, 1);
+}
+
+const KmzBool KmzColorTransform__saturate(KmzColorTransform * const restrict me, const kmz_percent factor) {
+    return _kmz_transform_record(me, _KMZ_TRANSFORM_SATURATE, &factor, 1);
+}
+
+const KmzBool KmzColorTransform__lighten(KmzColorTransform * const restrict me, const kmz_percent amount) {
+    return _kmz_transform_record(me, _KMZ_TRANSFORM_LIGHTEN, &amount, 1);
+}
+
+const KmzBool KmzColorTransform__levels(KmzColorTransform * const restrict me, const kmz_percent in_black, const kmz_percent in_white,
+        const float gamma, const kmz_percent out_black, const kmz_percent out_white) {
+    if (!(in_white > in_black) || !(gamma > 0.f)) {
+        return KMZ_FALSE;
+    }
+    const float values[5] = {in_black, in_white, 1.f / gamma, out_black, out_white};
+    return _kmz_transform_record(me, _KMZ_TRANSFORM_LEVELS, values, 5);
+}
+
+const KmzBool KmzColorTransform__gamma(KmzColorTransform * const restrict me, const float gamma) {
+    return KmzColorTransform__levels(me, 0.f, 1.f, gamma, 0.f, 1.f);
+}
+
+const KmzBool KmzColorTransform__mix_channels(KmzColorTransform * const restrict me, const float * const restrict matrix) {
+    for (size_t i = 0; i < 12; ++i) {
+        if (!(fabsf(matrix[i]) <= _KMZ_TRANSFORM_MAX_COEFFICIENT)) {
+            return KMZ_FALSE;
+        }
+    }
+    return _kmz_transform_record(me, _KMZ_TRANSFORM_MIX, matrix, 12);
+}
+
+const KmzBool KmzColorTransform__is_per_channel(const KmzColorTransform * const restrict me) {
+    for (size_t i = 0; i < me->count; ++i) {
+        if (_KMZ_TRANSFORM_LEVELS != me->steps[i].op) {
+            return KMZ_FALSE;
+        }
+    }
+    return KMZ_TRUE;
+}
+
+// endregion;
+
+// region Compilation:
+
+/**
+ * Evaluates the per-channel steps from `from` to `to` for a gray of the given value, which is the value of every channel of any color.
+ */
+static inline void _kmz_transform_curve(const KmzColorTransform * const restrict me, const size_t from, const size_t to, const float value,
+        float * const restrict rgb) {
+    rgb[0] = rgb[1] = rgb[2] = value;
+    _kmz_transform_eval(me, from, to, rgb);
+}
+
+static const KmzBool _kmz_transform_compile_matrix(KmzColorTransform * const restrict me, const size_t mix) {
+    me->outputs = malloc(3 * (_KMZ_TRANSFORM_ONE + 1) * sizeof(uint32_t));
+    if (NULL == me->outputs) {
+        return KMZ_FALSE;
+    }
+
+    float rgb[3];
+    for (size_t v = 0; v < 256; ++v) {
+        _kmz_transform_curve(me, 0, mix, (float)v / 255.f, rgb);
+        for (size_t c = 0; c < 3; ++c) {
+            me->inputs[c][v] = (int32_t)(rgb[c] * _KMZ_TRANSFORM_ONE + .5f);
+        }
+    }
+    const float * const restrict values = me->steps[mix].values;
+    for (size_t i = 0; i < 12; ++i) {
+        const float scale = 3 == i % 4 ? (float)_KMZ_TRANSFORM_ONE * _KMZ_TRANSFORM_ONE : (float)_KMZ_TRANSFORM_ONE;
+        me->matrix[i] = (int32_t)lrintf(values[i] * scale);
+    }
+    for (size_t v = 0; v <= _KMZ_TRANSFORM_ONE; ++v) {
+        _kmz_transform_curve(me, mix + 1, me->count, (float)v / _KMZ_TRANSFORM_ONE, rgb);
+        for (size_t c = 0; c < 3; ++c) {
+            me->outputs[c * (_KMZ_TRANSFORM_ONE + 1) + v] = _kmz_transform_channel(rgb[c]) << (16 - 8 * c);
+        }
+    }
+    return KMZ_TRUE;
+}
+
+static const KmzBool _kmz_transform_compile_lut(KmzColorTransform * const restrict me, const size_t first) {
+    double inputs[3 * 256];
+    float rgb[3];
+    for (size_t v = 0; v < 256; ++v) {
+        _kmz_transform_curve(me, 0, first, (float)v / 255.f, rgb);
+        for (size_t c = 0; c < 3; ++c) {
+            inputs[256 * c + v] = rgb[c];
+        }
+    }
+
+    me->lut = _kmz_lut_new_shaped(_KMZ_TRANSFORM_LUT_SIZE, inputs);
+    if (NULL == me->lut) {
+        return KMZ_FALSE;
+    }
+    const float scale = 1.f / (_KMZ_TRANSFORM_LUT_SIZE - 1);
+    for (size_t b = 0; b < _KMZ_TRANSFORM_LUT_SIZE; ++b) {
+        for (size_t g = 0; g < _KMZ_TRANSFORM_LUT_SIZE; ++g) {
+            for (size_t r = 0; r < _KMZ_TRANSFORM_LUT_SIZE; ++r) {
+                rgb[0] = (float)r * scale;
+                rgb[1] = (float)g * scale;
+                rgb[2] = (float)b * scale;
+                _kmz_transform_eval(me, first, me->count, rgb);
+                KmzColorLut3D__set(me->lut, r, g, b, rgb[0], rgb[1], rgb[2]);
+            }
+        }
+    }
+    return KMZ_TRUE;
+}
+
+const KmzBool KmzColorTransform__compile(KmzColorTransform * const restrict me) {
+    if (_KMZ_TRANSFORM_UNCOMPILED != me->form) {
+        return KMZ_TRUE;
+    }
+
+    // The curves before the first step that mixes the channels are kept apart from the rest of the chain, which they are looked up ahead of.
+    size_t first = me->count, mixes = 0;
+    KmzBool matrix = KMZ_TRUE;
+    for (size_t i = 0; i < me->count; ++i) {
+        if (_KMZ_TRANSFORM_LEVELS != me->steps[i].op) {
+            first = first < i ? first : i;
+            matrix = matrix && _KMZ_TRANSFORM_MIX == me->steps[i].op && !mixes++;
+        }
+    }
+
+    if (first == me->count) {
+        float rgb[3];
+        for (size_t v = 0; v < 256; ++v) {
+            _kmz_transform_curve(me, 0, me->count, (float)v / 255.f, rgb);
+            for (size_t c = 0; c < 3; ++c) {
+                me->curves[c][v] = _kmz_transform_channel(rgb[c]) << (16 - 8 * c);
+            }
+        }
+        me->form = _KMZ_TRANSFORM_CURVES;
+    } else if (matrix) {
+        if (!_kmz_transform_compile_matrix(me, first)) {
+            return KMZ_FALSE;
+        }
+        me->form = _KMZ_TRANSFORM_MATRIX;
+    } else {
+        if (!_kmz_transform_compile_lut(me, first)) {
+            return KMZ_FALSE;
+        }
+        me->form = _KMZ_TRANSFORM_LUT;
+    }
+    return KMZ_TRUE;
+}
+
+// endregion;
+
+// region Application:
+
+#ifdef KMZ_SIMD_X86
+kmz__target("avx2") static size_t _kmz_avx2_transform_curves(const KmzColorTransform * const restrict me, kmz_color_32 * const restrict colors,
+        const size_t count, size_t i) {
+    const __m256i channel = _mm256_set1_epi32(0xFF), alpha_mask = _mm256_set1_epi32(0x7F000000);
+    for (; i + 8 <= count; i += 8) {
+        const __m256i src = _mm256_loadu_si256((const __m256i *)(colors + i)),
+              r = _mm256_i32gather_epi32((const int *)me->curves[0], _mm256_and_si256(_mm256_srli_epi32(src, 16), channel), 4),
+              g = _mm256_i32gather_epi32((const int *)me->curves[1], _mm256_and_si256(_mm256_srli_epi32(src, 8), channel), 4),
+              b = _mm256_i32gather_epi32((const int *)me->curves[2], _mm256_and_si256(src, channel), 4);
+        _mm256_storeu_si256((__m256i *)(colors + i), _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, _mm256_and_si256(src, alpha_mask))));
+    }
+    return i;
+}
+#endif
+
+static void _kmz_transform_curves(const void * const restrict arg, kmz_color_32 * const restrict colors, const size_t count) {
+    const KmzColorTransform * const restrict me = arg;
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_AVX2 <= kmz_simd_level()) {
+        i = _kmz_avx2_transform_curves(me, colors, count, i);
+    }
+#endif
+    for (; i < count; ++i) {
+        const kmz_color_32 color = colors[i];
+        colors[i] = (color & 0x7F000000u) | me->curves[0][color >> 16 & 0xFF] | me->curves[1][color >> 8 & 0xFF] | me->curves[2][color & 0xFF];
+    }
+}
+
+static void _kmz_transform_matrix(const void * const restrict arg, kmz_color_32 * const restrict colors, const size_t count) {
+    const KmzColorTransform * const restrict me = arg;
+    const int32_t * const restrict m = me->matrix;
+    for (size_t i = 0; i < count; ++i) {
+        const kmz_color_32 color = colors[i];
+        const int32_t r = me->inputs[0][color >> 16 & 0xFF], g = me->inputs[1][color >> 8 & 0xFF], b = me->inputs[2][color & 0xFF];
+        kmz_color_32 out = color & 0x7F000000u;
+        for (size_t c = 0; c < 3; ++c) {
+            const int32_t sum = (m[4 * c] * r + m[4 * c + 1] * g + m[4 * c + 2] * b + m[4 * c + 3] + _KMZ_TRANSFORM_ONE / 2) >> _KMZ_TRANSFORM_SHIFT;
+            out |= me->outputs[c * (_KMZ_TRANSFORM_ONE + 1) + kmz_clamp(sum, 0, _KMZ_TRANSFORM_ONE)];
+        }
+        colors[i] = out;
+    }
+}
+
+static void _kmz_transform_lut(const void * const restrict arg, kmz_color_32 * const restrict colors, const size_t count) {
+    const KmzColorTransform * const restrict me = arg;
+    _kmz_lut_span(me->lut, KMZ_LUT_TETRAHEDRAL, colors, count);
+}
+
+const _KmzLutSpan _kmz_transform_span(const KmzColorTransform * const restrict me) {
+    switch (me->form) {
+        case _KMZ_TRANSFORM_CURVES:
+            return &_kmz_transform_curves;
+        case _KMZ_TRANSFORM_MATRIX:
+            return &_kmz_transform_matrix;
+        case _KMZ_TRANSFORM_LUT:
+        default:
+            return &_kmz_transform_lut;
+    }
+}
+
+const KmzPixelOperationStatus KmzImage__apply_color_transform(const KmzImage * const me, KmzColorTransform * const transform, KmzImage * const output,
+        const size_t threads) {
+    if (NULL == transform) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+    if (!KmzColorTransform__compile(transform)) {
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    return _kmz_lut_map(me, output, _kmz_transform_span(transform), transform, threads);
+}
+
+// endregion;
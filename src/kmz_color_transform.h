@@ -0,0 +1,67 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+/**
+ * |Definition                              |Header                 |
+ * |KmzColorTransform__new()                |libkempozer/image.h    |
+ * |KmzColorTransform__free()               |libkempozer/image.h    |
+ * |KmzColorTransform__rotate_hue()         |libkempozer/image.h    |
+ * |KmzColorTransform__saturate()           |libkempozer/image.h    |
+ * |KmzColorTransform__lighten()            |libkempozer/image.h    |
+ * |KmzColorTransform__gamma()              |libkempozer/image.h    |
+ * |KmzColorTransform__levels()             |libkempozer/image.h    |
+ * |KmzColorTransform__mix_channels()       |libkempozer/image.h    |
+ * |KmzColorTransform__is_per_channel()     |libkempozer/image.h    |
+ * |KmzColorTransform__compile()            |libkempozer/image.h    |
+ * |KmzImage__apply_color_transform()       |libkempozer/image.h    |
+ */
+#ifndef kmz_color_transform_h
+#define kmz_color_transform_h
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmz_config.h"
+#include "kmz_shared.h"
+#include "kmz_utilities.h"
+#include "kmz_core.h"
+#include "kmz_lut.h"
+
+/**
+ * Returns the span that maps colors through the compiled form of a {@link KmzColorTransform}, which is passed as the argument of every call.
+ *
+ * @param me The target of this invocation, which MUST be compiled.
+ * @return The span of the compiled form of `me`.
+ */
+const _KmzLutSpan _kmz_transform_span(const KmzColorTransform * const me);
+
+#endif /* kmz_color_transform_h */
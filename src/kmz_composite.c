@@ -0,0 +1,481 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_composite.h"
+
+enum _kmz_composite_factor_e {
+    _KMZ_COMPOSITE_ZERO,
+    _KMZ_COMPOSITE_ONE,
+    _KMZ_COMPOSITE_ALPHA,
+    _KMZ_COMPOSITE_INVERSE_ALPHA,
+};
+
+enum _kmz_composite_blend_e {
+    _KMZ_COMPOSITE_BLEND_NONE,
+    _KMZ_COMPOSITE_BLEND_MULTIPLY,
+    _KMZ_COMPOSITE_BLEND_SCREEN,
+    _KMZ_COMPOSITE_BLEND_OVERLAY,
+    _KMZ_COMPOSITE_BLEND_DARKEN,
+    _KMZ_COMPOSITE_BLEND_LIGHTEN,
+};
+
+static const struct _kmz_composite_op_t _kmz_composite_ops[] = {
+    [KMZ_COMPOSITE_CLEAR] = {_KMZ_COMPOSITE_ZERO, _KMZ_COMPOSITE_ZERO, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_SRC] = {_KMZ_COMPOSITE_ONE, _KMZ_COMPOSITE_ZERO, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_DST] = {_KMZ_COMPOSITE_ZERO, _KMZ_COMPOSITE_ONE, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_SRC_OVER] = {_KMZ_COMPOSITE_ONE, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_DST_OVER] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_ONE, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_SRC_IN] = {_KMZ_COMPOSITE_ALPHA, _KMZ_COMPOSITE_ZERO, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_DST_IN] = {_KMZ_COMPOSITE_ZERO, _KMZ_COMPOSITE_ALPHA, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_SRC_OUT] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_ZERO, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_DST_OUT] = {_KMZ_COMPOSITE_ZERO, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_SRC_ATOP] = {_KMZ_COMPOSITE_ALPHA, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_DST_ATOP] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_ALPHA, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_XOR] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_PLUS] = {_KMZ_COMPOSITE_ONE, _KMZ_COMPOSITE_ONE, _KMZ_COMPOSITE_BLEND_NONE},
+    [KMZ_COMPOSITE_MULTIPLY] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_MULTIPLY},
+    [KMZ_COMPOSITE_SCREEN] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_SCREEN},
+    [KMZ_COMPOSITE_OVERLAY] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_OVERLAY},
+    [KMZ_COMPOSITE_DARKEN] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_DARKEN},
+    [KMZ_COMPOSITE_LIGHTEN] = {_KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_INVERSE_ALPHA, _KMZ_COMPOSITE_BLEND_LIGHTEN},
+};
+
+// region Scalar:
+
+static inline const int32_t _kmz_composite_factor(const uint8_t factor, const int32_t alpha) {
+    switch (factor) {
+        case _KMZ_COMPOSITE_ONE:
+            return 255;
+        case _KMZ_COMPOSITE_ALPHA:
+            return alpha;
+        case _KMZ_COMPOSITE_INVERSE_ALPHA:
+            return 255 - alpha;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Splits `color` into premultiplied blue, green, red and alpha channels of 0-255, widening the 7-bit inverted alpha of kempozer exactly.
+ */
+static inline void _kmz_composite_premultiply(const kmz_color_32 color, const int32_t opacity, int32_t * const restrict out) {
+    const int32_t alpha = _kmz_color_opacity(color);
+    for (unsigned int c = 0; c < 3; ++c) {
+        out[c] = _kmz_color_mul(_kmz_color_mul((int32_t)((color >> 8 * c) & 0xFFu), alpha), opacity);
+    }
+    out[3] = _kmz_color_mul(alpha, opacity);
+}
+
+static inline const int32_t _kmz_composite_blend(const uint8_t blend, const int32_t s, const int32_t d, const int32_t s_alpha, const int32_t d_alpha) {
+    switch (blend) {
+        case _KMZ_COMPOSITE_BLEND_MULTIPLY:
+            return _kmz_color_mul(s, d);
+        case _KMZ_COMPOSITE_BLEND_SCREEN:
+            return _kmz_color_mul(s, d_alpha) + _kmz_color_mul(d, s_alpha) - _kmz_color_mul(s, d);
+        case _KMZ_COMPOSITE_BLEND_OVERLAY:
+            return 2 * d <= d_alpha ? 2 * _kmz_color_mul(s, d) : _kmz_color_mul(s_alpha, d_alpha) - 2 * _kmz_color_mul(d_alpha - d, s_alpha - s);
+        case _KMZ_COMPOSITE_BLEND_DARKEN: {
+            const int32_t a = _kmz_color_mul(s, d_alpha), b = _kmz_color_mul(d, s_alpha);
+            return a < b ? a : b;
+        }
+        case _KMZ_COMPOSITE_BLEND_LIGHTEN: {
+            const int32_t a = _kmz_color_mul(s, d_alpha), b = _kmz_color_mul(d, s_alpha);
+            return a > b ? a : b;
+        }
+        default:
+            return 0;
+    }
+}
+
+static const kmz_color_32 _kmz_composite_pixel(const struct _kmz_composite_t * const restrict me, const kmz_color_32 src, const kmz_color_32 dst) {
+    int32_t s[4], d[4], r[4];
+    _kmz_composite_premultiply(src, (int32_t)me->opacity, s);
+    if (me->keeps_dst && 0 == s[3]) {
+        return dst;
+    }
+    _kmz_composite_premultiply(dst, 255, d);
+
+    const int32_t fs = _kmz_composite_factor(me->op.src_factor, d[3]), fd = _kmz_composite_factor(me->op.dst_factor, s[3]);
+    for (unsigned int c = 0; c < 4; ++c) {
+        const int32_t value = _kmz_color_mul(s[c], fs) + _kmz_color_mul(d[c], fd) + _kmz_composite_blend(me->op.blend, s[c], d[c], s[3], d[3]);
+        r[c] = kmz_clamp(value, 0, 255);
+    }
+
+    return _kmz_color_unpremultiply(r);
+}
+
+// endregion;
+
+// region SIMD:
+
+#ifdef KMZ_SIMD_X86
+/**
+ * The SIMD kernels keep two (SSE2) or four (AVX2) pixels per register as 16-bit blue, green, red and alpha lanes and follow
+ * {@link _kmz_composite_pixel} step by step, using a correctly rounded single precision division to unpremultiply, which matches the integer
+ * division exactly for every 8-bit input.
+ */
+#define _KMZ_COMPOSITE_ALPHA_LANES 0xFF
+
+kmz__target("sse2") static inline __m128i _kmz_sse2_composite_mul(const __m128i a, const __m128i b) {
+    const __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+kmz__target("sse2") static inline __m128i _kmz_sse2_composite_alphas(const __m128i x) {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _KMZ_COMPOSITE_ALPHA_LANES), _KMZ_COMPOSITE_ALPHA_LANES);
+}
+
+kmz__target("sse2") static inline __m128i _kmz_sse2_composite_premultiply(const __m128i x, const __m128i opacity) {
+    const __m128i alpha_lane = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0),
+          o = _mm_sub_epi16(_mm_set1_epi16(127), _mm_and_si128(x, _mm_set1_epi16(0x7F))),
+          alpha = _kmz_sse2_composite_alphas(_mm_add_epi16(_mm_add_epi16(o, o), _mm_srli_epi16(o, 6))),
+          channels = _kmz_sse2_select_si(alpha_lane, _mm_set1_epi16(255), x);
+    return _kmz_sse2_composite_mul(_kmz_sse2_composite_mul(channels, alpha), opacity);
+}
+
+kmz__target("sse2") static inline __m128i _kmz_sse2_composite_factor(const __m128i alpha, const __m128i base, const __m128i plus, const __m128i minus) {
+    return _mm_sub_epi16(_mm_add_epi16(base, _mm_and_si128(alpha, plus)), _mm_and_si128(alpha, minus));
+}
+
+kmz__target("sse2") static inline __m128i _kmz_sse2_composite_unpremultiply(const __m128i value, const __m128i alpha, const __m128i zero) {
+    const __m128i den = _mm_max_epi16(alpha, _mm_set1_epi16(1)), scale = _mm_set1_epi32(510 | 1 << 16);
+    const __m128 lo = _mm_div_ps(_mm_cvtepi32_ps(_mm_madd_epi16(_mm_unpacklo_epi16(value, alpha), scale)),
+                _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_add_epi16(den, den), zero))),
+          hi = _mm_div_ps(_mm_cvtepi32_ps(_mm_madd_epi16(_mm_unpackhi_epi16(value, alpha), scale)),
+                _mm_cvtepi32_ps(_mm_unpackhi_epi16(_mm_add_epi16(den, den), zero)));
+    return _mm_packs_epi32(_mm_cvttps_epi32(lo), _mm_cvttps_epi32(hi));
+}
+
+kmz__target("sse2") static inline __m128i _kmz_sse2_composite_half(const struct _kmz_composite_t * const restrict me, const __m128i src,
+        const __m128i dst, const __m128i opacity, const __m128i * const restrict factors) {
+    const __m128i zero = _mm_setzero_si128(), alpha_lane = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0),
+          s = _kmz_sse2_composite_premultiply(src, opacity), d = _kmz_sse2_composite_premultiply(dst, _mm_set1_epi16(255)),
+          s_alpha = _kmz_sse2_composite_alphas(s), d_alpha = _kmz_sse2_composite_alphas(d);
+
+    __m128i r = _mm_add_epi16(_kmz_sse2_composite_mul(s, _kmz_sse2_composite_factor(d_alpha, factors[0], factors[1], factors[2])),
+            _kmz_sse2_composite_mul(d, _kmz_sse2_composite_factor(s_alpha, factors[3], factors[4], factors[5])));
+    switch (me->op.blend) {
+        case _KMZ_COMPOSITE_BLEND_MULTIPLY:
+            r = _mm_add_epi16(r, _kmz_sse2_composite_mul(s, d));
+            break;
+        case _KMZ_COMPOSITE_BLEND_SCREEN:
+            r = _mm_add_epi16(r, _mm_sub_epi16(_mm_add_epi16(_kmz_sse2_composite_mul(s, d_alpha), _kmz_sse2_composite_mul(d, s_alpha)),
+                    _kmz_sse2_composite_mul(s, d)));
+            break;
+        case _KMZ_COMPOSITE_BLEND_OVERLAY: {
+            const __m128i low = _kmz_sse2_composite_mul(s, d),
+                  high = _kmz_sse2_composite_mul(_mm_sub_epi16(d_alpha, d), _mm_sub_epi16(s_alpha, s));
+            r = _mm_add_epi16(r, _kmz_sse2_select_si(_mm_cmpgt_epi16(_mm_add_epi16(d, d), d_alpha),
+                    _mm_sub_epi16(_kmz_sse2_composite_mul(s_alpha, d_alpha), _mm_add_epi16(high, high)), _mm_add_epi16(low, low)));
+            break;
+        }
+        case _KMZ_COMPOSITE_BLEND_DARKEN:
+            r = _mm_add_epi16(r, _mm_min_epi16(_kmz_sse2_composite_mul(s, d_alpha), _kmz_sse2_composite_mul(d, s_alpha)));
+            break;
+        case _KMZ_COMPOSITE_BLEND_LIGHTEN:
+            r = _mm_add_epi16(r, _mm_max_epi16(_kmz_sse2_composite_mul(s, d_alpha), _kmz_sse2_composite_mul(d, s_alpha)));
+            break;
+        default:
+            break;
+    }
+
+    r = _mm_min_epi16(_mm_max_epi16(r, zero), _mm_set1_epi16(255));
+    const __m128i alpha = _kmz_sse2_composite_alphas(r);
+    r = _mm_min_epi16(r, alpha);
+    if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi16(alpha, _mm_set1_epi16(255)))) {
+        // Opaque results are already unpremultiplied, which is the common case of compositing onto an opaque destination.
+        r = _kmz_sse2_composite_unpremultiply(r, alpha, zero);
+    }
+    r = _kmz_sse2_select_si(alpha_lane, _mm_sub_epi16(_mm_set1_epi16(127), _kmz_sse2_composite_mul(alpha, _mm_set1_epi16(127))), r);
+
+    if (me->keeps_dst) {
+        r = _kmz_sse2_select_si(_mm_cmpeq_epi16(s_alpha, zero), dst, r);
+    }
+    return r;
+}
+
+kmz__target("sse2") static size_t _kmz_sse2_composite_span(const struct _kmz_composite_t * const restrict me, const kmz_color_32 * const restrict src,
+        kmz_color_32 * const restrict dst, const size_t count, size_t x) {
+    const __m128i zero = _mm_setzero_si128(), alpha_mask = _mm_set1_epi32(0x7F000000), opacity = _mm_set1_epi16((short)me->opacity);
+    __m128i factors[6];
+    for (size_t f = 0; f < 2; ++f) {
+        const uint8_t factor = f ? me->op.dst_factor : me->op.src_factor;
+        factors[3 * f] = _mm_set1_epi16(_KMZ_COMPOSITE_ONE == factor || _KMZ_COMPOSITE_INVERSE_ALPHA == factor ? 255 : 0);
+        factors[3 * f + 1] = _mm_set1_epi16(_KMZ_COMPOSITE_ALPHA == factor ? -1 : 0);
+        factors[3 * f + 2] = _mm_set1_epi16(_KMZ_COMPOSITE_INVERSE_ALPHA == factor ? -1 : 0);
+    }
+
+    for (; x + 4 <= count; x += 4) {
+        const __m128i s = _mm_loadu_si128((const __m128i *)(src + x)), alpha = _mm_and_si128(s, alpha_mask);
+        if (me->keeps_dst && 0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alpha_mask))) {
+            continue;
+        } else if (me->copies_opaque && 0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero))) {
+            _mm_storeu_si128((__m128i *)(dst + x), _mm_andnot_si128(_mm_set1_epi32((int)0x80000000u), s));
+            continue;
+        }
+        const __m128i d = _mm_loadu_si128((const __m128i *)(dst + x)),
+              lo = _kmz_sse2_composite_half(me, _mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), opacity, factors),
+              hi = _kmz_sse2_composite_half(me, _mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), opacity, factors);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    return x;
+}
+
+kmz__target("avx2") static inline __m256i _kmz_avx2_composite_mul(const __m256i a, const __m256i b) {
+    const __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+kmz__target("avx2") static inline __m256i _kmz_avx2_composite_alphas(const __m256i x) {
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, _KMZ_COMPOSITE_ALPHA_LANES), _KMZ_COMPOSITE_ALPHA_LANES);
+}
+
+kmz__target("avx2") static inline __m256i _kmz_avx2_composite_premultiply(const __m256i x, const __m256i opacity, const __m256i alpha_lane) {
+    const __m256i o = _mm256_sub_epi16(_mm256_set1_epi16(127), _mm256_and_si256(x, _mm256_set1_epi16(0x7F))),
+          alpha = _kmz_avx2_composite_alphas(_mm256_add_epi16(_mm256_add_epi16(o, o), _mm256_srli_epi16(o, 6))),
+          channels = _mm256_blendv_epi8(x, _mm256_set1_epi16(255), alpha_lane);
+    return _kmz_avx2_composite_mul(_kmz_avx2_composite_mul(channels, alpha), opacity);
+}
+
+kmz__target("avx2") static inline __m256i _kmz_avx2_composite_factor(const __m256i alpha, const __m256i base, const __m256i plus, const __m256i minus) {
+    return _mm256_sub_epi16(_mm256_add_epi16(base, _mm256_and_si256(alpha, plus)), _mm256_and_si256(alpha, minus));
+}
+
+kmz__target("avx2") static inline __m256i _kmz_avx2_composite_unpremultiply(const __m256i value, const __m256i alpha, const __m256i zero) {
+    const __m256i den = _mm256_max_epi16(alpha, _mm256_set1_epi16(1)), scale = _mm256_set1_epi32(510 | 1 << 16);
+    const __m256 lo = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(_mm256_unpacklo_epi16(value, alpha), scale)),
+                _mm256_cvtepi32_ps(_mm256_unpacklo_epi16(_mm256_add_epi16(den, den), zero))),
+          hi = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(_mm256_unpackhi_epi16(value, alpha), scale)),
+                _mm256_cvtepi32_ps(_mm256_unpackhi_epi16(_mm256_add_epi16(den, den), zero)));
+    return _mm256_packs_epi32(_mm256_cvttps_epi32(lo), _mm256_cvttps_epi32(hi));
+}
+
+kmz__target("avx2") static inline __m256i _kmz_avx2_composite_half(const struct _kmz_composite_t * const restrict me, const __m256i src,
+        const __m256i dst, const __m256i opacity, const __m256i * const restrict factors) {
+    const __m256i zero = _mm256_setzero_si256(), alpha_lane = _mm256_set1_epi64x((long long)0xFFFF000000000000ull),
+          s = _kmz_avx2_composite_premultiply(src, opacity, alpha_lane), d = _kmz_avx2_composite_premultiply(dst, _mm256_set1_epi16(255), alpha_lane),
+          s_alpha = _kmz_avx2_composite_alphas(s), d_alpha = _kmz_avx2_composite_alphas(d);
+
+    __m256i r = _mm256_add_epi16(_kmz_avx2_composite_mul(s, _kmz_avx2_composite_factor(d_alpha, factors[0], factors[1], factors[2])),
+            _kmz_avx2_composite_mul(d, _kmz_avx2_composite_factor(s_alpha, factors[3], factors[4], factors[5])));
+    switch (me->op.blend) {
+        case _KMZ_COMPOSITE_BLEND_MULTIPLY:
+            r = _mm256_add_epi16(r, _kmz_avx2_composite_mul(s, d));
+            break;
+        case _KMZ_COMPOSITE_BLEND_SCREEN:
+            r = _mm256_add_epi16(r, _mm256_sub_epi16(_mm256_add_epi16(_kmz_avx2_composite_mul(s, d_alpha), _kmz_avx2_composite_mul(d, s_alpha)),
+                    _kmz_avx2_composite_mul(s, d)));
+            break;
+        case _KMZ_COMPOSITE_BLEND_OVERLAY: {
+            const __m256i low = _kmz_avx2_composite_mul(s, d),
+                  high = _kmz_avx2_composite_mul(_mm256_sub_epi16(d_alpha, d), _mm256_sub_epi16(s_alpha, s));
+            r = _mm256_add_epi16(r, _mm256_blendv_epi8(_mm256_add_epi16(low, low),
+                    _mm256_sub_epi16(_kmz_avx2_composite_mul(s_alpha, d_alpha), _mm256_add_epi16(high, high)),
+                    _mm256_cmpgt_epi16(_mm256_add_epi16(d, d), d_alpha)));
+            break;
+        }
+        case _KMZ_COMPOSITE_BLEND_DARKEN:
+            r = _mm256_add_epi16(r, _mm256_min_epi16(_kmz_avx2_composite_mul(s, d_alpha), _kmz_avx2_composite_mul(d, s_alpha)));
+            break;
+        case _KMZ_COMPOSITE_BLEND_LIGHTEN:
+            r = _mm256_add_epi16(r, _mm256_max_epi16(_kmz_avx2_composite_mul(s, d_alpha), _kmz_avx2_composite_mul(d, s_alpha)));
+            break;
+        default:
+            break;
+    }
+
+    r = _mm256_min_epi16(_mm256_max_epi16(r, zero), _mm256_set1_epi16(255));
+    const __m256i alpha = _kmz_avx2_composite_alphas(r);
+    r = _mm256_min_epi16(r, alpha);
+    if (-1 != _mm256_movemask_epi8(_mm256_cmpeq_epi16(alpha, _mm256_set1_epi16(255)))) {
+        r = _kmz_avx2_composite_unpremultiply(r, alpha, zero);
+    }
+    r = _mm256_blendv_epi8(r, _mm256_sub_epi16(_mm256_set1_epi16(127), _kmz_avx2_composite_mul(alpha, _mm256_set1_epi16(127))), alpha_lane);
+
+    if (me->keeps_dst) {
+        r = _mm256_blendv_epi8(r, dst, _mm256_cmpeq_epi16(s_alpha, zero));
+    }
+    return r;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_composite_span(const struct _kmz_composite_t * const restrict me, const kmz_color_32 * const restrict src,
+        kmz_color_32 * const restrict dst, const size_t count, size_t x) {
+    const __m256i zero = _mm256_setzero_si256(), alpha_mask = _mm256_set1_epi32(0x7F000000), opacity = _mm256_set1_epi16((short)me->opacity);
+    __m256i factors[6];
+    for (size_t f = 0; f < 2; ++f) {
+        const uint8_t factor = f ? me->op.dst_factor : me->op.src_factor;
+        factors[3 * f] = _mm256_set1_epi16(_KMZ_COMPOSITE_ONE == factor || _KMZ_COMPOSITE_INVERSE_ALPHA == factor ? 255 : 0);
+        factors[3 * f + 1] = _mm256_set1_epi16(_KMZ_COMPOSITE_ALPHA == factor ? -1 : 0);
+        factors[3 * f + 2] = _mm256_set1_epi16(_KMZ_COMPOSITE_INVERSE_ALPHA == factor ? -1 : 0);
+    }
+
+    for (; x + 8 <= count; x += 8) {
+        const __m256i s = _mm256_loadu_si256((const __m256i *)(src + x)), alpha = _mm256_and_si256(s, alpha_mask);
+        if (me->keeps_dst && -1 == _mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alpha_mask))) {
+            continue;
+        } else if (me->copies_opaque && -1 == _mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, zero))) {
+            _mm256_storeu_si256((__m256i *)(dst + x), _mm256_andnot_si256(_mm256_set1_epi32((int)0x80000000u), s));
+            continue;
+        }
+        // The unpacks and the pack work within each 128 bit lane, so every pixel is packed back into the position it was unpacked from.
+        const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + x)),
+              lo = _kmz_avx2_composite_half(me, _mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), opacity, factors),
+              hi = _kmz_avx2_composite_half(me, _mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), opacity, factors);
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_packus_epi16(lo, hi));
+    }
+    return x;
+}
+#endif
+
+// endregion;
+
+void _kmz_composite_span(const struct _kmz_composite_t * const restrict me, const kmz_color_32 * const restrict src,
+        kmz_color_32 * const restrict dst, const size_t count) {
+    size_t x = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        x = _kmz_avx2_composite_span(me, src, dst, count, x);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        x = _kmz_sse2_composite_span(me, src, dst, count, x);
+    }
+#endif
+    for (; x < count; ++x) {
+        const kmz_color_32 alpha = src[x] & 0x7F000000u;
+        if (me->keeps_dst && 0x7F000000u == alpha) {
+            continue;
+        } else if (me->copies_opaque && 0 == alpha) {
+            dst[x] = src[x] & 0x7FFFFFFFu;
+        } else {
+            dst[x] = _kmz_composite_pixel(me, src[x], dst[x]);
+        }
+    }
+}
+
+const KmzBool _kmz_composite_init(struct _kmz_composite_t * const restrict me, const KmzCompositeOp op, const kmz_percent opacity) {
+    if ((unsigned int)op >= sizeof(_kmz_composite_ops) / sizeof(_kmz_composite_ops[0])) {
+        return KMZ_FALSE;
+    }
+
+    const float scale = opacity * 255.f + .5f;
+    me->op = _kmz_composite_ops[op];
+    me->opacity = (uint32_t)kmz_clamp(scale, 0.f, 255.f);
+    me->keeps_dst = _KMZ_COMPOSITE_ONE == me->op.dst_factor || _KMZ_COMPOSITE_INVERSE_ALPHA == me->op.dst_factor;
+    me->copies_opaque = KMZ_COMPOSITE_SRC_OVER == op && 255 == me->opacity;
+    return KMZ_TRUE;
+}
+
+const KmzBool _kmz_composite_clip(const KmzSize s_dimen, const KmzSize d_dimen, const KmzRectangle src_rect, const KmzPoint dst_pos,
+        KmzRectangle * const restrict s_area, KmzPoint * const restrict d_pos) {
+    // Clip the source area to the source, then move the destination by the same amount and clip both to the destination.
+    ssize_t s_x = kmz_clamp(src_rect.pos.x, 0, s_dimen.w),
+            s_y = kmz_clamp(src_rect.pos.y, 0, s_dimen.h),
+            d_x = dst_pos.x + s_x - src_rect.pos.x,
+            d_y = dst_pos.y + s_y - src_rect.pos.y;
+    ssize_t w = kmz_clamp(src_rect.pos.x + (ssize_t)src_rect.size.w, s_x, s_dimen.w) - s_x,
+            h = kmz_clamp(src_rect.pos.y + (ssize_t)src_rect.size.h, s_y, s_dimen.h) - s_y;
+    if (d_x < 0) {
+        s_x -= d_x;
+        w += d_x;
+        d_x = 0;
+    }
+    if (d_y < 0) {
+        s_y -= d_y;
+        h += d_y;
+        d_y = 0;
+    }
+    w = w < d_dimen.w - d_x ? w : d_dimen.w - d_x;
+    h = h < d_dimen.h - d_y ? h : d_dimen.h - d_y;
+
+    if (w <= 0 || h <= 0) {
+        return KMZ_FALSE;
+    }
+
+    *s_area = kmz_rectangle(kmz_point(s_x, s_y), kmz_size((uint16_t)w, (uint16_t)h));
+    *d_pos = kmz_point(d_x, d_y);
+    return KMZ_TRUE;
+}
+
+const KmzPixelOperationStatus KmzImage__composite(KmzImage * const me, const KmzImage * const src, const KmzRectangle src_rect,
+        const KmzPoint dst_pos, const KmzCompositeOp op, const kmz_percent opacity) {
+    struct _kmz_composite_t state;
+    KmzRectangle s_area;
+    KmzPoint d_pos;
+    if (!_kmz_composite_init(&state, op, opacity)) {
+        return KMZ_PIXEL_OP_ERR_UNKNOWN;
+    }
+    if (!_kmz_composite_clip(KmzImage__dimen(src), KmzImage__dimen(me), src_rect, dst_pos, &s_area, &d_pos) || KMZ_COMPOSITE_DST == op
+            || (state.keeps_dst && 0 == state.opacity)) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const ssize_t s_x = s_area.pos.x, s_y = s_area.pos.y, d_x = d_pos.x, d_y = d_pos.y, h = s_area.size.h;
+    const size_t count = s_area.size.w;
+    kmz_color_32 * const restrict s_line = malloc(count * sizeof(kmz_color_32));
+    kmz_color_32 * const restrict d_line = malloc(count * sizeof(kmz_color_32));
+    KmzPixelOperationStatus status = NULL == s_line || NULL == d_line ? KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY : KMZ_PIXEL_OP_OK;
+
+    // Compositing an image onto a lower part of itself walks upwards, so no source row is overwritten before it is read.
+    const KmzBool upwards = src == me && d_y > s_y;
+    for (ssize_t i = 0; KMZ_PIXEL_OP_OK == status && i < h; ++i) {
+        const ssize_t row = upwards ? h - 1 - i : i;
+        status = KmzImage__read_row_span(src, kmz_point(s_x, s_y + row), count, s_line);
+        if (KMZ_PIXEL_OP_OK != status) {
+            break;
+        }
+
+        if (KMZ_COMPOSITE_SRC == op && 255 == state.opacity) {
+            status = KmzImage__write_row_span(me, kmz_point(d_x, d_y + row), count, s_line);
+            continue;
+        } else if (state.keeps_dst) {
+            size_t x = 0;
+            while (x < count && 0x7F000000u == (s_line[x] & 0x7F000000u)) {
+                ++x;
+            }
+            if (x == count) {
+                continue;
+            }
+        }
+
+        status = KmzImage__read_row_span(me, kmz_point(d_x, d_y + row), count, d_line);
+        if (KMZ_PIXEL_OP_OK == status) {
+            _kmz_composite_span(&state, s_line, d_line, count);
+            status = KmzImage__write_row_span(me, kmz_point(d_x, d_y + row), count, d_line);
+        }
+    }
+
+    free(s_line);
+    free(d_line);
+
+    return status;
+}
@@ -0,0 +1,110 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+/**
+ * |Definition                          |Header                 |
+ * |KmzImage__composite()               |libkempozer/image.h    |
+ */
+#ifndef kmz_composite_h
+#define kmz_composite_h
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "kmz_config.h"
+#include "kmz_shared.h"
+#include "kmz_utilities.h"
+#include "kmz_color.h"
+#include "kmz_core.h"
+
+/**
+ * Every operator computes `src * src_factor + dst * dst_factor + blend` over premultiplied channels, where the source factor is taken from the
+ * alpha of the destination and the destination factor from the alpha of the source.
+ */
+struct _kmz_composite_op_t {
+    uint8_t src_factor;
+    uint8_t dst_factor;
+    uint8_t blend;
+};
+
+/**
+ * The state shared by every span of a single composite.
+ */
+struct _kmz_composite_t {
+    struct _kmz_composite_op_t op;
+    uint32_t opacity;
+    /**
+     * Whether a transparent source pixel leaves the destination pixel unchanged, which is true whenever the destination factor is 1 for a source
+     * alpha of 0.
+     */
+    KmzBool keeps_dst;
+    /**
+     * Whether an opaque source pixel replaces the destination pixel, which is only true for {@link KMZ_COMPOSITE_SRC_OVER} at full opacity.
+     */
+    KmzBool copies_opaque;
+};
+
+/**
+ * Fills the state of a composite with `op` at `opacity`.
+ *
+ * @param me The state to fill.
+ * @param op The operator to composite with.
+ * @param opacity The opacity the source is composited at, from 0 to 1.
+ * @return {@link KMZ_TRUE} if `op` is a known {@link KmzCompositeOp}, otherwise {@link KMZ_FALSE}.
+ */
+const KmzBool _kmz_composite_init(struct _kmz_composite_t * const me, const KmzCompositeOp op, const kmz_percent opacity);
+
+/**
+ * Clips the area of a source of `s_dimen` that is composited at `dst_pos` to both the source and a destination of `d_dimen`.
+ *
+ * @param s_dimen The dimensions of the source.
+ * @param d_dimen The dimensions of the destination.
+ * @param src_rect The area of the source to composite.
+ * @param dst_pos The position within the destination of the top left pixel of `src_rect`.
+ * @param s_area Set to the clipped area of the source.
+ * @param d_pos Set to the position within the destination of the top left pixel of `s_area`.
+ * @return {@link KMZ_TRUE} if any pixel is left, otherwise {@link KMZ_FALSE} and neither `s_area` nor `d_pos` is set.
+ */
+const KmzBool _kmz_composite_clip(const KmzSize s_dimen, const KmzSize d_dimen, const KmzRectangle src_rect, const KmzPoint dst_pos,
+        KmzRectangle * const s_area, KmzPoint * const d_pos);
+
+/**
+ * Composites every pixel of `src` onto the matching pixel of `dst` in place, dispatched to the widest SIMD kernel supported by the processor.
+ *
+ * @param me The state of the composite.
+ * @param src The source pixels.
+ * @param dst The destination pixels, which are replaced by the result.
+ * @param count The number of pixels.
+ */
+void _kmz_composite_span(const struct _kmz_composite_t * const me, const kmz_color_32 * const src, kmz_color_32 * const dst, const size_t count);
+
+#endif /* kmz_composite_h */
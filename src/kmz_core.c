@@ -118,6 +118,10 @@ const KmzImageType * const KmzImage__type(const KmzImage * const restrict me) {
     return me->_type;
 }
 
+void * const _KmzImage__impl(const KmzImage * const restrict me) {
+    return me->_me;
+}
+
 const KmzSize KmzImage__dimen(const KmzImage * const restrict me) {
     return me->_type->dimen(me->_me);
 }
@@ -145,6 +149,16 @@ const KmzPixelOperationStatus KmzImage__read_argb_block(const KmzImage * const r
     } else if (NULL == dst) {
         return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
     }
+
+    if (me->_type->read_row_span) {
+        KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+        KmzPoint p = src_area.pos;
+        for (size_t o = 0; p.y < max_y && status == KMZ_PIXEL_OP_OK; ++p.y, o += src_area.size.w) {
+            status = me->_type->read_row_span(me->_me, p, src_area.size.w, dst + o);
+        }
+        return status;
+    }
+
     KmzPoint p = src_area.pos;
     for (size_t o = 0; p.y < max_y; ++p.y) {
         for (p.x = src_area.pos.x; p.x < max_x; ++p.x) {
@@ -170,6 +184,16 @@ const KmzPixelOperationStatus KmzImage__write_argb_block(KmzImage * const restri
     } else if (NULL == src) {
         return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
     }
+
+    if (me->_type->write_row_span) {
+        KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+        KmzPoint p = dst_area.pos;
+        for (size_t o = 0; p.y < max_y && status == KMZ_PIXEL_OP_OK; ++p.y, o += dst_area.size.w) {
+            status = me->_type->write_row_span(me->_me, p, dst_area.size.w, src + o);
+        }
+        return status;
+    }
+
     KmzPoint p = dst_area.pos;
     for (size_t o = 0; p.y < max_y; ++p.y) {
         for (p.x = dst_area.pos.x; p.x < max_x; ++p.x) {
@@ -180,11 +204,101 @@ const KmzPixelOperationStatus KmzImage__write_argb_block(KmzImage * const restri
     return KMZ_PIXEL_OP_OK;
 }
 
+const KmzPixelOperationStatus KmzImage__read_row_span(const KmzImage * const restrict me, const KmzPoint start, const size_t count, kmz_color_32 * const restrict dst) {
+    if (me->_type->read_row_span) {
+        return me->_type->read_row_span(me->_me, start, count, dst);
+    }
+
+    const KmzSize dimen = KmzImage__dimen(me);
+
+    if (start.x < 0 || start.x >= dimen.w || start.y < 0 || start.y >= dimen.h) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_POS;
+    } else if (count > (size_t)(dimen.w - start.x)) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_SIZE;
+    } else if (NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    if (me->_type->read_argb_block) {
+        return me->_type->read_argb_block(me->_me, kmz_rectangle(start, kmz_size((uint16_t)count, 1)), dst);
+    }
+
+    KmzPoint p = start;
+    for (size_t o = 0; o < count; ++o, ++p.x) {
+        dst[o] = KmzImage__argb_at(me, p);
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+const KmzPixelOperationStatus KmzImage__write_row_span(KmzImage * const restrict me, const KmzPoint start, const size_t count, const kmz_color_32 * const restrict src) {
+    if (me->_type->write_row_span) {
+        return me->_type->write_row_span(me->_me, start, count, src);
+    }
+
+    const KmzSize dimen = KmzImage__dimen(me);
+
+    if (start.x < 0 || start.x >= dimen.w || start.y < 0 || start.y >= dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_POS;
+    } else if (count > (size_t)(dimen.w - start.x)) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    } else if (NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    if (me->_type->write_argb_block) {
+        return me->_type->write_argb_block(me->_me, kmz_rectangle(start, kmz_size((uint16_t)count, 1)), src);
+    }
+
+    KmzPoint p = start;
+    for (size_t o = 0; o < count; ++o, ++p.x) {
+        KmzImage__set_argb_at(me, p, src[o]);
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+const KmzPixelOperationStatus KmzImage__gather(const KmzImage * const restrict me, const KmzPoint * const restrict points, const size_t count,
+        kmz_color_32 * const restrict dst) {
+    if (me->_type->gather) {
+        return me->_type->gather(me->_me, points, count, dst);
+    }
+
+    if (NULL == points || NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        dst[i] = KmzImage__is_valid(me, points[i]) ? KmzImage__argb_at(me, points[i]) : 0x00000000;
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+const KmzPixelOperationStatus KmzImage__scatter(KmzImage * const restrict me, const KmzPoint * const restrict points, const size_t count,
+        const kmz_color_32 * const restrict src) {
+    if (me->_type->scatter) {
+        return me->_type->scatter(me->_me, points, count, src);
+    }
+
+    if (NULL == points || NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (KmzImage__is_valid(me, points[i])) {
+            KmzImage__set_argb_at(me, points[i], src[i]);
+        }
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
 const KmzBool KmzImage__is_valid(const KmzImage * const restrict me, const KmzPoint point) {
     return me->_type->is_valid(me->_me, point);
 }
 
-static inline const KmzPixelOperationStatus _KmzImage__populate_buffer(const KmzImage * const restrict me, kmz_color_32 * const restrict buffer, KmzRectangle i_area,
+const KmzPixelOperationStatus _KmzImage__populate_buffer(const KmzImage * const restrict me, kmz_color_32 * const restrict buffer, KmzRectangle i_area,
         const KmzSize buffer_size, const KmzSize h_buffer_size, const size_t hsize,
         const size_t w) {
     const size_t w_m_o = w - 1;
@@ -250,7 +364,8 @@ const KmzPixelOperationStatus KmzImage__apply_buffered_filter(const KmzImage * c
         return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
     }
 
-    KmzPixelOperationStatus status = _KmzImage__populate_buffer(me, buffer, area, kmz_size(b_w, b_h), kmz_size(h_w, h_h), hsize, w);
+    const KmzRectangle c_area = kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)w, (uint16_t)h));
+    KmzPixelOperationStatus status = _KmzImage__populate_buffer(me, buffer, c_area, kmz_size(b_w, b_h), kmz_size(h_w, h_h), hsize, w);
     if (status != KMZ_PIXEL_OP_OK) {
         free(buffer);
         free(o_buffer);
@@ -274,7 +389,7 @@ const KmzPixelOperationStatus KmzImage__apply_buffered_filter(const KmzImage * c
         }
     }
 
-    KmzImage__write_argb_block(output, area, o_buffer);
+    KmzImage__write_argb_block(output, c_area, o_buffer);
 
     free(m);
     free(buffer);
@@ -282,3 +397,209 @@ const KmzPixelOperationStatus KmzImage__apply_buffered_filter(const KmzImage * c
 
     return KMZ_PIXEL_OP_OK;
 }
+
+void _kmz_filter_region(const void * const restrict argv, const KmzFilter filter, const size_t m_size, kmz_color_32 * const restrict buffer,
+        const KmzSize b_dimen, const KmzRectangle region, kmz_color_32 * const restrict o_buffer) {
+    const ssize_t hsize = (ssize_t)(m_size / 2), max_x = region.pos.x + region.size.w, max_y = region.pos.y + region.size.h;
+    struct kmz_matrix_t m = {
+        ._size = m_size,
+        ._hsize = (size_t)hsize,
+        ._pos = KmzPoint__ZERO,
+        ._image_dimen = b_dimen,
+        ._pixels = buffer,
+    };
+
+    for (ssize_t y = region.pos.y; y < max_y; ++y) {
+        kmz_color_32 * const restrict row = o_buffer + (size_t)y * b_dimen.w;
+        for (ssize_t x = region.pos.x; x < max_x; ++x) {
+            m._pos = kmz_point(x - hsize, y - hsize);
+            row[x] = filter(argv, &m);
+        }
+    }
+}
+
+#define _KMZ_FILTER_TILE_SIZE 128
+
+struct _kmz_parallel_filter_t {
+    const KmzImage * me;
+    const void * argv;
+    KmzFilter filter;
+    KmzRectangle area;
+    size_t m_size;
+    size_t hsize;
+    size_t tiles_x;
+    KmzImage * output;
+    KmzBool in_place;
+    kmz_color_32 ** buffers;
+    kmz_color_32 ** o_buffers;
+    KmzMatrix ** matrices;
+    kmz_color_32 * tiles;
+    pthread_mutex_t lock;
+    KmzPixelOperationStatus status;
+};
+
+static inline const KmzRectangle _kmz_parallel_filter_tile(const struct _kmz_parallel_filter_t * const restrict ctx, const size_t index) {
+    const size_t tx = index % ctx->tiles_x, ty = index / ctx->tiles_x;
+    const ssize_t x = ctx->area.pos.x + (ssize_t)(tx * _KMZ_FILTER_TILE_SIZE),
+          y = ctx->area.pos.y + (ssize_t)(ty * _KMZ_FILTER_TILE_SIZE);
+    const ssize_t max_x = ctx->area.pos.x + ctx->area.size.w, max_y = ctx->area.pos.y + ctx->area.size.h;
+
+    return kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)kmz_clamp(max_x - x, 0, _KMZ_FILTER_TILE_SIZE),
+            (uint16_t)kmz_clamp(max_y - y, 0, _KMZ_FILTER_TILE_SIZE)));
+}
+
+const KmzPixelOperationStatus _KmzImage__populate_tile(const KmzImage * const restrict me, kmz_color_32 * const restrict buffer,
+        const KmzRectangle area, const KmzRectangle tile, const size_t hsize) {
+    const size_t b_w = tile.size.w + 2 * hsize, b_h = tile.size.h + 2 * hsize;
+    const ssize_t a_max_x = area.pos.x + area.size.w, a_max_y = area.pos.y + area.size.h;
+    const ssize_t x0 = tile.pos.x - (ssize_t)hsize,
+          r_x = x0 < area.pos.x ? area.pos.x : x0,
+          r_max_x = x0 + (ssize_t)b_w > a_max_x ? a_max_x : x0 + (ssize_t)b_w;
+    const size_t left = (size_t)(r_x - x0), span = r_max_x > r_x ? (size_t)(r_max_x - r_x) : 0;
+    KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+    kmz_color_32 * restrict row = buffer;
+
+    for (size_t b_y = 0; b_y < b_h; ++b_y, row += b_w) {
+        const ssize_t y = tile.pos.y - (ssize_t)hsize + (ssize_t)b_y;
+
+        if (y < area.pos.y || y >= a_max_y || !span) {
+            memset(row, 0, b_w * sizeof(kmz_color_32));
+            continue;
+        }
+
+        memset(row, 0, left * sizeof(kmz_color_32));
+        status = KmzImage__read_argb_block(me, kmz_rectangle(kmz_point(r_x, y), kmz_size((uint16_t)span, 1)), row + left);
+        if (status != KMZ_PIXEL_OP_OK) {
+            return status;
+        }
+        memset(row + left + span, 0, (b_w - left - span) * sizeof(kmz_color_32));
+    }
+
+    return status;
+}
+
+static void _KmzImage__apply_filter_tile(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_parallel_filter_t * const restrict ctx = arg;
+    if (__atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_PIXEL_OP_OK) {
+        return;
+    }
+
+    const KmzRectangle tile = _kmz_parallel_filter_tile(ctx, index);
+    const size_t b_area = (_KMZ_FILTER_TILE_SIZE + 2 * ctx->hsize) * (_KMZ_FILTER_TILE_SIZE + 2 * ctx->hsize),
+          o_area = _KMZ_FILTER_TILE_SIZE * _KMZ_FILTER_TILE_SIZE;
+
+    if (NULL == ctx->buffers[worker]) {
+        ctx->buffers[worker] = malloc(b_area * sizeof(kmz_color_32));
+        ctx->matrices[worker] = KmzMatrix__new_from_buffer(ctx->buffers[worker], KmzSize__ZERO, KmzPoint__ZERO, ctx->m_size);
+        if (!ctx->in_place) {
+            ctx->o_buffers[worker] = malloc(o_area * sizeof(kmz_color_32));
+        }
+    }
+
+    kmz_color_32 * const restrict buffer = ctx->buffers[worker];
+    kmz_color_32 * const restrict o_buffer = ctx->in_place ? ctx->tiles + index * o_area : ctx->o_buffers[worker];
+    KmzMatrix * const restrict m = ctx->matrices[worker];
+    KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+
+    if (NULL == buffer || NULL == o_buffer || NULL == m) {
+        status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        status = _KmzImage__populate_tile(ctx->me, buffer, ctx->area, tile, ctx->hsize);
+    }
+
+    if (status == KMZ_PIXEL_OP_OK) {
+        KmzPoint p = KmzPoint__ZERO;
+        size_t o = 0;
+
+        m->_image_dimen = kmz_size((uint16_t)(tile.size.w + 2 * ctx->hsize), (uint16_t)(tile.size.h + 2 * ctx->hsize));
+        for (; p.y < tile.size.h; ++p.y) {
+            for (p.x = 0; p.x < tile.size.w; ++p.x) {
+                m->_pos = p;
+                o_buffer[o++] = ctx->filter(ctx->argv, m);
+            }
+        }
+
+        if (!ctx->in_place) {
+            pthread_mutex_lock(&ctx->lock);
+            KmzImage__write_argb_block(ctx->output, tile, o_buffer);
+            pthread_mutex_unlock(&ctx->lock);
+        }
+    } else {
+        KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, status, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+const KmzPixelOperationStatus KmzImage__apply_parallel_filter(const KmzImage * const restrict me, const void * const restrict argv, const KmzFilter filter, const KmzRectangle area,
+        const size_t m_size, KmzImage * const restrict output, const size_t threads) {
+    const KmzSize dimen = KmzImage__dimen(me);
+    const ssize_t x = kmz_clamp(area.pos.x, 0, dimen.w),
+          y = kmz_clamp(area.pos.y, 0, dimen.h),
+          max_x = kmz_clamp(area.size.w + x, x, dimen.w),
+          max_y = kmz_clamp(area.size.h + y, y, dimen.h);
+
+    const size_t w = (size_t)(max_x - x),
+          h = (size_t)(max_y - y);
+
+    if (!w || !h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t tiles_x = (w + _KMZ_FILTER_TILE_SIZE - 1) / _KMZ_FILTER_TILE_SIZE,
+          tiles = tiles_x * ((h + _KMZ_FILTER_TILE_SIZE - 1) / _KMZ_FILTER_TILE_SIZE),
+          workers = _kmz_parallel_workers(threads, tiles);
+
+    struct _kmz_parallel_filter_t ctx = {
+        .me = me,
+        .argv = argv,
+        .filter = filter,
+        .area = kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)w, (uint16_t)h)),
+        .m_size = m_size,
+        .hsize = m_size / 2,
+        .tiles_x = tiles_x,
+        .output = output,
+        .in_place = output == me ? KMZ_TRUE : KMZ_FALSE,
+        .buffers = calloc(workers, sizeof(kmz_color_32 *)),
+        .o_buffers = calloc(workers, sizeof(kmz_color_32 *)),
+        .matrices = calloc(workers, sizeof(KmzMatrix *)),
+        .tiles = NULL,
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (ctx.in_place) {
+        ctx.tiles = malloc(tiles * _KMZ_FILTER_TILE_SIZE * _KMZ_FILTER_TILE_SIZE * sizeof(kmz_color_32));
+    }
+
+    if (NULL == ctx.buffers || NULL == ctx.o_buffers || NULL == ctx.matrices || (ctx.in_place && NULL == ctx.tiles)) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        pthread_mutex_init(&ctx.lock, NULL);
+        _kmz_parallel_for(workers, tiles, &_KmzImage__apply_filter_tile, &ctx);
+        pthread_mutex_destroy(&ctx.lock);
+
+        // Every tile reads its halo from `me`, so in-place output is written back only once all tiles are filtered.
+        if (ctx.in_place && ctx.status == KMZ_PIXEL_OP_OK) {
+            for (size_t i = 0; i < tiles; ++i) {
+                KmzImage__write_argb_block(output, _kmz_parallel_filter_tile(&ctx, i), ctx.tiles + i * _KMZ_FILTER_TILE_SIZE * _KMZ_FILTER_TILE_SIZE);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < workers; ++i) {
+        if (NULL != ctx.buffers) {
+            free(ctx.buffers[i]);
+        }
+        if (NULL != ctx.o_buffers) {
+            free(ctx.o_buffers[i]);
+        }
+        if (NULL != ctx.matrices) {
+            free(ctx.matrices[i]);
+        }
+    }
+    free(ctx.buffers);
+    free(ctx.o_buffers);
+    free(ctx.matrices);
+    free(ctx.tiles);
+
+    return ctx.status;
+}
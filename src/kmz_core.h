@@ -47,19 +47,77 @@
  * |KmzImage__set_argb_at()             |libkempozer/image.h    |
  * |KmzImage__read_argb_block()         |libkempozer/image.h    |
  * |KmzImage__write_argb_block()        |libkempozer/image.h    |
+ * |KmzImage__read_row_span()           |libkempozer/image.h    |
+ * |KmzImage__write_row_span()          |libkempozer/image.h    |
+ * |KmzImage__gather()                  |libkempozer/image.h    |
+ * |KmzImage__scatter()                 |libkempozer/image.h    |
  * |KmzImage__is_valid()                |libkempozer/image.h    |
  * |KmzImage__apply_filter()            |libkempozer/image.h    |
  * |KmzImage__apply_buffered_filter()   |libkempozer/image.h    |
+ * |KmzImage__apply_parallel_filter()   |libkempozer/image.h    |
  */
 #ifndef kmz_core_h
 #define kmz_core_h
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "kmz_config.h"
 #include "kmz_shared.h"
 #include "kmz_geometry.h"
 #include "kmz_color.h"
+#include "kmz_parallel.h"
 #include "../include/libkempozer/image.h"
 
+/**
+ * Returns the image implementation wrapped by the targeted {@link KmzImage} so that kempozer's own image types may access their internal state.
+ *
+ * @param me The target of this invocation.
+ * @return The pointer created by the `_new` method of the {@link KmzImageType} of `me`.
+ */
+void * const _KmzImage__impl(const KmzImage * const me);
+
+/**
+ * Reads `area` of the targeted {@link KmzImage} into the middle of `buffer`, surrounded by a border of `hsize` transparent black pixels.
+ *
+ * @param me The target of this invocation.
+ * @param buffer The buffer to populate, which holds `buffer_size.w * buffer_size.h` colors.
+ * @param area The area to read, which MUST be within the targeted {@link KmzImage}.
+ * @param buffer_size The dimensions of the buffer, which are those of `area` plus `2 * hsize`.
+ * @param h_buffer_size The dimensions of `area` plus `hsize`, where the bottom and right borders begin.
+ * @param hsize The width of the border.
+ * @param w The width of `area`.
+ * @return {@link KMZ_PIXEL_OP_OK} if the buffer is populated, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus _KmzImage__populate_buffer(const KmzImage * const me, kmz_color_32 * const buffer, KmzRectangle area,
+        const KmzSize buffer_size, const KmzSize h_buffer_size, const size_t hsize, const size_t w);
+
+/**
+ * Populates a tile buffer with the pixels of `tile` and a halo of `hsize` pixels around it, where every pixel outside of `area` is zero so that the
+ * result matches the buffer built by {@link _KmzImage__populate_buffer} for the whole area.
+ *
+ * @param me The target of this invocation.
+ * @param buffer The buffer to populate, which holds `(tile.size.w + 2 * hsize) * (tile.size.h + 2 * hsize)` colors.
+ * @param area The area to read, which MUST be within the targeted {@link KmzImage}.
+ * @param tile The tile of `area` to read.
+ * @param hsize The width of the halo.
+ * @return {@link KMZ_PIXEL_OP_OK} if the buffer is populated, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus _KmzImage__populate_tile(const KmzImage * const me, kmz_color_32 * const buffer, const KmzRectangle area,
+        const KmzRectangle tile, const size_t hsize);
+
+/**
+ * Applies `filter` to every pixel of `region` of a buffer, where the matrix of every pixel is centered on it and MUST lie within the buffer.
+ *
+ * @param argv The argument passed to every call of `filter`.
+ * @param filter The filter to apply.
+ * @param m_size The size of the matrix.
+ * @param buffer The buffer to read the matrices from.
+ * @param b_dimen The dimensions of `buffer`.
+ * @param region The pixels to filter, in the coordinates of `buffer`.
+ * @param o_buffer The buffer to write the result to, which has the dimensions of `buffer` and MUST NOT be `buffer`.
+ */
+void _kmz_filter_region(const void * const argv, const KmzFilter filter, const size_t m_size, kmz_color_32 * const buffer, const KmzSize b_dimen,
+        const KmzRectangle region, kmz_color_32 * const o_buffer);
+
 #endif /* kmz_core_h */
@@ -31,3 +31,243 @@
   */
 
 #include "kmz_draw.h"
+
+struct kmz_pattern_t {
+    const KmzPatternType * _type;
+    void * _me;
+};
+
+struct kmz_painter_t {
+    const KmzPainterType * _type;
+    void * _me;
+};
+
+const KmzBrush KmzBrush__TRANSPARENT = {.color = 0x7F000000, .pattern = NULL};
+
+const KmzPen KmzPen__TRANSPARENT = {.antialias = KMZ_FALSE, .color = 0x7F000000, .width = 0.f};
+
+// region KmzPattern:
+
+KmzPattern * const KmzPattern__new(const KmzPatternType * const restrict type, const void * const restrict argv) {
+    KmzPattern * ptr = malloc(sizeof(struct kmz_pattern_t));
+    if (NULL == ptr) {
+        return NULL;
+    }
+
+    ptr->_type = type;
+    ptr->_me = ptr->_type->_new();
+    if (NULL == ptr->_me) {
+        free(ptr);
+        return NULL;
+    }
+
+    if (ptr->_type->_ctor) {
+        ptr->_type->_ctor(ptr->_me, argv);
+    }
+
+    return ptr;
+}
+
+void KmzPattern__free(KmzPattern * const restrict me) {
+    if (NULL == me->_type->_dtor) {
+        free(me->_me);
+    } else {
+        me->_type->_dtor(me->_me);
+    }
+    free(me);
+}
+
+const kmz_color_32 KmzPattern__color_at(const KmzPattern * const restrict me, const KmzPoint point) {
+    if (NULL == me->_type->color_at) {
+        return KmzBrush__TRANSPARENT.color;
+    }
+    return me->_type->color_at(me->_me, point);
+}
+
+// endregion;
+
+// region KmzPainter:
+
+static inline const KmzPoint _kmz_round_point(const KmzPointF point) {
+    return kmz_point((ssize_t)lroundf(point.x), (ssize_t)lroundf(point.y));
+}
+
+static inline const KmzPointF _kmz_float_point(const KmzPoint point) {
+    return kmz_pointf((float)point.x, (float)point.y);
+}
+
+KmzPainter * const KmzPainter__new(const KmzPainterType * const restrict type, const void * const restrict argv) {
+    KmzPainter * ptr = malloc(sizeof(struct kmz_painter_t));
+    if (NULL == ptr) {
+        return NULL;
+    }
+
+    ptr->_type = type;
+    ptr->_me = ptr->_type->_new();
+    if (NULL == ptr->_me) {
+        free(ptr);
+        return NULL;
+    }
+
+    if (ptr->_type->_ctor) {
+        ptr->_type->_ctor(ptr->_me, argv);
+    }
+
+    return ptr;
+}
+
+void KmzPainter__free(KmzPainter * const restrict me) {
+    if (NULL == me->_type->_dtor) {
+        free(me->_me);
+    } else {
+        me->_type->_dtor(me->_me);
+    }
+    free(me);
+}
+
+KmzBrush KmzPainter__brush(const KmzPainter * const restrict me) {
+    return me->_type->brush(me->_me);
+}
+
+void KmzPainter__set_brush(KmzPainter * const restrict me, const KmzBrush brush) {
+    me->_type->set_brush(me->_me, brush);
+}
+
+KmzPen KmzPainter__pen(const KmzPainter * const restrict me) {
+    return me->_type->pen(me->_me);
+}
+
+void KmzPainter__set_pen(KmzPainter * const restrict me, const KmzPen pen) {
+    me->_type->set_pen(me->_me, pen);
+}
+
+const KmzDrawStatus KmzPainter__draw_circle(KmzPainter * const restrict me, const KmzCircle circle) {
+    if (me->_type->draw_circle) {
+        return me->_type->draw_circle(me->_me, circle);
+    } else if (me->_type->draw_circlef) {
+        return me->_type->draw_circlef(me->_me, kmz_circlef(_kmz_float_point(circle.center), (float)circle.radius));
+    }
+    return KMZ_DRAW_ERR_UNKNOWN;
+}
+
+const KmzDrawStatus KmzPainter__draw_circlef(KmzPainter * const restrict me, const KmzCircleF circle) {
+    if (me->_type->draw_circlef) {
+        return me->_type->draw_circlef(me->_me, circle);
+    } else if (me->_type->draw_circle) {
+        return me->_type->draw_circle(me->_me, kmz_circle(_kmz_round_point(circle.center), 0.f < circle.radius ? (size_t)lroundf(circle.radius) : 0));
+    }
+    return KMZ_DRAW_ERR_UNKNOWN;
+}
+
+const KmzDrawStatus KmzPainter__draw_line(KmzPainter * const restrict me, const KmzLine line) {
+    if (me->_type->draw_line) {
+        return me->_type->draw_line(me->_me, line);
+    } else if (me->_type->draw_linef) {
+        return me->_type->draw_linef(me->_me, kmz_linef(_kmz_float_point(line.start), _kmz_float_point(line.end)));
+    }
+    return KMZ_DRAW_ERR_UNKNOWN;
+}
+
+const KmzDrawStatus KmzPainter__draw_linef(KmzPainter * const restrict me, const KmzLineF line) {
+    if (me->_type->draw_linef) {
+        return me->_type->draw_linef(me->_me, line);
+    } else if (me->_type->draw_line) {
+        return me->_type->draw_line(me->_me, kmz_line(_kmz_round_point(line.start), _kmz_round_point(line.end)));
+    }
+    return KMZ_DRAW_ERR_UNKNOWN;
+}
+
+const KmzDrawStatus KmzPainter__draw_point(KmzPainter * const restrict me, const KmzPoint point) {
+    if (me->_type->draw_point) {
+        return me->_type->draw_point(me->_me, point);
+    } else if (me->_type->draw_pointf) {
+        return me->_type->draw_pointf(me->_me, _kmz_float_point(point));
+    }
+    return KMZ_DRAW_ERR_UNKNOWN;
+}
+
+const KmzDrawStatus KmzPainter__draw_pointf(KmzPainter * const restrict me, const KmzPointF point) {
+    if (me->_type->draw_pointf) {
+        return me->_type->draw_pointf(me->_me, point);
+    } else if (me->_type->draw_point) {
+        return me->_type->draw_point(me->_me, _kmz_round_point(point));
+    }
+    return KMZ_DRAW_ERR_UNKNOWN;
+}
+
+const KmzDrawStatus KmzPainter__draw_polygon(KmzPainter * const restrict me, const KmzPolygon polygon) {
+    if (me->_type->draw_polygon) {
+        return me->_type->draw_polygon(me->_me, polygon);
+    } else if (NULL == me->_type->draw_polygonf) {
+        return KMZ_DRAW_ERR_UNKNOWN;
+    }
+
+    KmzPointF * const points = malloc(sizeof(KmzPointF) * (polygon.count ? polygon.count : 1));
+    if (NULL == points) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+    for (size_t i = 0; i < polygon.count; ++i) {
+        points[i] = _kmz_float_point(polygon.points[i]);
+    }
+
+    const KmzDrawStatus status = me->_type->draw_polygonf(me->_me, (KmzPolygonF){polygon.closed, polygon.count, points});
+    free(points);
+    return status;
+}
+
+const KmzDrawStatus KmzPainter__draw_polygonf(KmzPainter * const restrict me, const KmzPolygonF polygon) {
+    if (me->_type->draw_polygonf) {
+        return me->_type->draw_polygonf(me->_me, polygon);
+    } else if (NULL == me->_type->draw_polygon) {
+        return KMZ_DRAW_ERR_UNKNOWN;
+    }
+
+    KmzPoint * const points = malloc(sizeof(KmzPoint) * (polygon.count ? polygon.count : 1));
+    if (NULL == points) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+    for (size_t i = 0; i < polygon.count; ++i) {
+        points[i] = _kmz_round_point(polygon.points[i]);
+    }
+
+    const KmzDrawStatus status = me->_type->draw_polygon(me->_me, (KmzPolygon){polygon.closed, polygon.count, points});
+    free(points);
+    return status;
+}
+
+const KmzDrawStatus KmzPainter__draw_rectangle(KmzPainter * const restrict me, const KmzRectangle rectangle) {
+    if (me->_type->draw_rectangle) {
+        return me->_type->draw_rectangle(me->_me, rectangle);
+    } else if (me->_type->draw_rectanglef) {
+        return me->_type->draw_rectanglef(me->_me, kmz_rectanglef(_kmz_float_point(rectangle.pos), kmz_sizef(rectangle.size.w, rectangle.size.h)));
+    }
+    return KMZ_DRAW_ERR_UNKNOWN;
+}
+
+const KmzDrawStatus KmzPainter__draw_rectanglef(KmzPainter * const restrict me, const KmzRectangleF rectangle) {
+    if (me->_type->draw_rectanglef) {
+        return me->_type->draw_rectanglef(me->_me, rectangle);
+    } else if (me->_type->draw_rectangle) {
+        const float w = fminf(fmaxf(rectangle.size.w, 0.f), UINT16_MAX), h = fminf(fmaxf(rectangle.size.h, 0.f), UINT16_MAX);
+        return me->_type->draw_rectangle(me->_me, kmz_rectangle(_kmz_round_point(rectangle.pos), kmz_size((uint16_t)lroundf(w), (uint16_t)lroundf(h))));
+    }
+    return KMZ_DRAW_ERR_UNKNOWN;
+}
+
+const KmzDrawStatus KmzPainter__paint(KmzPainter * const restrict me, KmzImage * const restrict image) {
+    return KmzPainter__paint_at(me, kmz_point(0, 0), image);
+}
+
+const KmzDrawStatus KmzPainter__paint_at(KmzPainter * const restrict me, const KmzPoint pos, KmzImage * const restrict image) {
+    return me->_type->paint(me->_me, pos, image);
+}
+
+const KmzBool KmzPainter__redo(KmzPainter * const restrict me) {
+    return me->_type->redo ? me->_type->redo(me->_me) : KMZ_FALSE;
+}
+
+const KmzBool KmzPainter__undo(KmzPainter * const restrict me) {
+    return me->_type->undo ? me->_type->undo(me->_me) : KMZ_FALSE;
+}
+
+// endregion;
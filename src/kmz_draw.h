@@ -34,6 +34,7 @@
  * |Definition                              |Header             |
  * |KmzPattern__new()                       |libkempozer/draw.h |
  * |KmzPattern__free()                      |libkempozer/draw.h |
+ * |KmzPattern__color_at()                  |libkempozer/draw.h |
  * |KmzPainter__new()                       |libkempozer/draw.h |
  * |KmzPainter__free()                      |libkempozer/draw.h |
  * |KmzPainter__brush()                     |libkempozer/draw.h |
@@ -50,6 +51,8 @@
  * |KmzPainter__draw_polygonf()             |libkempozer/draw.h |
  * |KmzPainter__draw_rectangle()            |libkempozer/draw.h |
  * |KmzPainter__draw_rectanglef()           |libkempozer/draw.h |
+ * |KmzPainter__paint()                     |libkempozer/draw.h |
+ * |KmzPainter__paint_at()                  |libkempozer/draw.h |
  * |KmzPainter__redo()                      |libkempozer/draw.h |
  * |KmzPainter__undo()                      |libkempozer/draw.h |
  * |const KmzBrush KmzBrush__TRANSPARENT    |libkempozer/draw.h |
@@ -58,6 +61,9 @@
 #ifndef kmz_draw_h
 #define kmz_draw_h
 
+#include <stdlib.h>
+#include <math.h>
+
 #include "kmz_config.h"
 #include "kmz_shared.h"
 #include "kmz_geometry.h"
@@ -65,4 +71,39 @@
 #include "kmz_core.h"
 #include "../include/libkempozer/draw.h"
 
+#define _KMZ_DRAW_OPAQUE (127u * 255u)
+
+/**
+ * Returns the opacity of a color from 0 (transparent) to 127 (opaque).
+ */
+static inline const uint32_t _kmz_draw_opacity(const kmz_color_32 color) {
+    return 127u - ((color >> 24) & 0x7Fu);
+}
+
+/**
+ * Blends `src` over `dst` after scaling the opacity of `src` by `coverage` (0-255), where an alpha of 0 is opaque and 127 is transparent.
+ */
+static inline const kmz_color_32 _kmz_draw_blend(const kmz_color_32 dst, const kmz_color_32 src, const uint32_t coverage) {
+    const uint32_t s = _kmz_draw_opacity(src) * coverage;
+    if (0 == s) {
+        return dst;
+    } else if (_KMZ_DRAW_OPAQUE == s) {
+        return src;
+    } else if (127u == _kmz_draw_opacity(dst)) {
+        // An opaque destination stays opaque and the general case below reduces to a division by a constant.
+        const uint32_t d = _KMZ_DRAW_OPAQUE - s;
+        return ((((src >> 16) & 0xFFu) * s + ((dst >> 16) & 0xFFu) * d + _KMZ_DRAW_OPAQUE / 2) / _KMZ_DRAW_OPAQUE) << 16
+                | ((((src >> 8) & 0xFFu) * s + ((dst >> 8) & 0xFFu) * d + _KMZ_DRAW_OPAQUE / 2) / _KMZ_DRAW_OPAQUE) << 8
+                | (((src & 0xFFu) * s + (dst & 0xFFu) * d + _KMZ_DRAW_OPAQUE / 2) / _KMZ_DRAW_OPAQUE);
+    }
+
+    const uint32_t d = (uint32_t)(((uint64_t)_kmz_draw_opacity(dst) * 255u * (_KMZ_DRAW_OPAQUE - s) + _KMZ_DRAW_OPAQUE / 2) / _KMZ_DRAW_OPAQUE);
+    const uint32_t o = s + d;
+    const uint32_t r = (((src >> 16) & 0xFFu) * s + ((dst >> 16) & 0xFFu) * d + o / 2) / o,
+                   g = (((src >> 8) & 0xFFu) * s + ((dst >> 8) & 0xFFu) * d + o / 2) / o,
+                   b = ((src & 0xFFu) * s + (dst & 0xFFu) * d + o / 2) / o,
+                   a = 127u - (o + 127u) / 255u;
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
 #endif /* kmz_draw_h */
@@ -0,0 +1,723 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_gaussian.h"
+
+#define _KMZ_GAUSSIAN_BAND_ROWS 16
+/**
+ * The number of pixels of each strip of columns filtered down the image by a single unit of work.
+ */
+#define _KMZ_GAUSSIAN_STRIP 64
+/**
+ * The number of pixels below which an image is filtered by the calling thread alone, as starting threads would take longer than the filter.
+ */
+#define _KMZ_GAUSSIAN_PARALLEL_PIXELS 65536
+/**
+ * The scale of the fixed point channels that the columns are passed to the rows in, which leaves room for the overshoot of the recursion within 16
+ * bits and rounds every channel to within 1/128 of its exact value.
+ */
+#define _KMZ_GAUSSIAN_FIXED 64.f
+/**
+ * The smallest sigma the coefficients of Young and van Vliet are fitted for.
+ */
+#define _KMZ_GAUSSIAN_MIN_SIGMA .5f
+
+/**
+ * The sigma below which the blur convolves the image with a sampled Gaussian instead, as the recursion strays too far from a Gaussian that narrow.
+ */
+#define _KMZ_GAUSSIAN_FIR_SIGMA 2.5f
+/**
+ * The largest radius of the sampled Gaussian, which reaches 4 sigmas past its center.
+ */
+#define _KMZ_GAUSSIAN_FIR_RADIUS 10
+
+/**
+ * The steady state below which the forward recursion is taken to have decayed away past the end of a line.
+ */
+#define _KMZ_GAUSSIAN_DECAYED 1e-12
+
+/**
+ * The coefficients of the recursion `out[n] = b * in[n] + c1 * out[n - 1] + c2 * out[n - 2] + c3 * out[n - 3]`, which is run forwards and then
+ * backwards along every row and column.
+ */
+struct _kmz_gaussian_coefficients_t {
+    float b;
+    float c1;
+    float c2;
+    float c3;
+    /**
+     * The boundary matrix, where `m[3 * i + j]` is how much output `i` of the backward recursion past the end of a line moves with the `j`th last
+     * output of the forward recursion.
+     */
+    float m[9];
+};
+
+struct _kmz_gaussian_t {
+    KmzSize dimen;
+    struct _kmz_gaussian_coefficients_t co;
+    /**
+     * The radius of the sampled Gaussian, or 0 if the image is filtered by the recursion.
+     */
+    size_t radius;
+    /**
+     * The weights of the sampled Gaussian from its center outwards.
+     */
+    float taps[_KMZ_GAUSSIAN_FIR_RADIUS + 1];
+    kmz_color_32 * pixels;
+    int16_t * plane;
+    size_t line_size;
+    float ** lines;
+    KmzPixelOperationStatus status;
+};
+
+/**
+ * Computes the boundary matrix of Triggs and Sdika, "Boundary conditions for Young-van Vliet recursive filtering" (2006), which starts the backward
+ * recursion as though the last input of a line were repeated forever rather than the last output of the forward recursion. Every column of the matrix
+ * is found by running the forward recursion past the end of the line from a unit state until it has decayed away, and the backward recursion back
+ * over it, which takes a number of steps that grows with the sigma but only happens once per blur.
+ */
+static const KmzBool _kmz_gaussian_boundary(struct _kmz_gaussian_coefficients_t * const restrict co) {
+    const double b = co->b, c1 = co->c1, c2 = co->c2, c3 = co->c3;
+    size_t capacity = 256, count = 0;
+    double * restrict forward = malloc(3 * capacity * sizeof(double));
+    if (NULL == forward) {
+        return KMZ_FALSE;
+    }
+
+    double p[3][3] = {{1., 0., 0.}, {0., 1., 0.}, {0., 0., 1.}};
+    for (double decayed = 1.; decayed > _KMZ_GAUSSIAN_DECAYED; ++count) {
+        if (count == capacity) {
+            double * const restrict grown = realloc(forward, 6 * capacity * sizeof(double));
+            if (NULL == grown) {
+                free(forward);
+                return KMZ_FALSE;
+            }
+            forward = grown;
+            capacity *= 2;
+        }
+        decayed = 0.;
+        for (size_t j = 0; j < 3; ++j) {
+            const double v = c1 * p[j][0] + c2 * p[j][1] + c3 * p[j][2];
+            p[j][2] = p[j][1];
+            p[j][1] = p[j][0];
+            p[j][0] = v;
+            forward[3 * count + j] = v;
+            decayed += fabs(p[j][0]) + fabs(p[j][1]) + fabs(p[j][2]);
+        }
+    }
+
+    memset(p, 0, sizeof(p));
+    for (size_t n = count; n-- > 0;) {
+        for (size_t j = 0; j < 3; ++j) {
+            const double v = b * forward[3 * n + j] + c1 * p[j][0] + c2 * p[j][1] + c3 * p[j][2];
+            p[j][2] = p[j][1];
+            p[j][1] = p[j][0];
+            p[j][0] = v;
+            if (n < 3) {
+                co->m[3 * n + j] = (float)v;
+            }
+        }
+    }
+
+    free(forward);
+    return KMZ_TRUE;
+}
+
+/**
+ * Computes the coefficients of the recursive Gaussian of Young and van Vliet, "Recursive implementation of the Gaussian filter" (1995).
+ */
+static const KmzBool _kmz_gaussian_coefficients(const double sigma, struct _kmz_gaussian_coefficients_t * const restrict co) {
+    const double q = sigma >= 2.5 ? .98711 * sigma - .96330 : 3.97156 - 4.14554 * sqrt(1. - .26891 * sigma), q2 = q * q, q3 = q2 * q,
+          b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + .422205 * q3, b1 = 2.44413 * q + 2.85619 * q2 + 1.26661 * q3,
+          b2 = -(1.4281 * q2 + 1.26661 * q3), b3 = .422205 * q3;
+    co->b = (float)(1. - (b1 + b2 + b3) / b0);
+    co->c1 = (float)(b1 / b0);
+    co->c2 = (float)(b2 / b0);
+    co->c3 = (float)(b3 / b0);
+    return _kmz_gaussian_boundary(co);
+}
+
+/**
+ * Samples a Gaussian out to 4 sigmas past its center, normalized so that its weights sum to 1.
+ */
+static void _kmz_gaussian_taps(const double sigma, struct _kmz_gaussian_t * const restrict ctx) {
+    const size_t radius = (size_t)ceil(4. * sigma);
+    ctx->radius = radius < _KMZ_GAUSSIAN_FIR_RADIUS ? radius : _KMZ_GAUSSIAN_FIR_RADIUS;
+    double taps[_KMZ_GAUSSIAN_FIR_RADIUS + 1], sum = 0.;
+    for (size_t k = 0; k <= ctx->radius; ++k) {
+        taps[k] = exp(-(double)(k * k) / (2. * sigma * sigma));
+        sum += k ? 2. * taps[k] : taps[k];
+    }
+    for (size_t k = 0; k <= ctx->radius; ++k) {
+        ctx->taps[k] = (float)(taps[k] / sum);
+    }
+}
+
+// region Kernels:
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static size_t _kmz_sse2_gaussian_step(const struct _kmz_gaussian_coefficients_t * const restrict co, float * const restrict line,
+        const float * const restrict p1, const float * const restrict p2, const float * const restrict p3, const size_t count, size_t i) {
+    const __m128 b = _mm_set1_ps(co->b), c1 = _mm_set1_ps(co->c1), c2 = _mm_set1_ps(co->c2), c3 = _mm_set1_ps(co->c3);
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_mul_ps(b, _mm_loadu_ps(line + i));
+        v = _mm_add_ps(v, _mm_mul_ps(c3, _mm_loadu_ps(p3 + i)));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_loadu_ps(p2 + i)));
+        v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_loadu_ps(p1 + i)));
+        _mm_storeu_ps(line + i, v);
+    }
+    return i;
+}
+
+kmz__target("sse2") static size_t _kmz_sse2_gaussian_fir(const float * const restrict taps, const size_t radius, const float * const * const restrict lines,
+        float * const restrict out, const size_t count, size_t i) {
+    const __m128 center = _mm_set1_ps(taps[0]);
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_mul_ps(center, _mm_loadu_ps(lines[radius] + i));
+        for (size_t k = 1; k <= radius; ++k) {
+            v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(taps[k]), _mm_add_ps(_mm_loadu_ps(lines[radius - k] + i), _mm_loadu_ps(lines[radius + k] + i))));
+        }
+        _mm_storeu_ps(out + i, v);
+    }
+    return i;
+}
+
+kmz__target("sse2") static inline void _kmz_sse2_gaussian_edge(const struct _kmz_gaussian_coefficients_t * const restrict co, const __m128 u,
+        __m128 * const restrict p1, __m128 * const restrict p2, __m128 * const restrict p3) {
+    const __m128 d[3] = {_mm_sub_ps(*p1, u), _mm_sub_ps(*p2, u), _mm_sub_ps(*p3, u)};
+    __m128 y[3];
+    for (size_t i = 0; i < 3; ++i) {
+        __m128 v = _mm_mul_ps(_mm_set1_ps(co->m[3 * i]), d[0]);
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(co->m[3 * i + 1]), d[1]));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(co->m[3 * i + 2]), d[2]));
+        y[i] = _mm_add_ps(v, u);
+    }
+    *p1 = y[0];
+    *p2 = y[1];
+    *p3 = y[2];
+}
+
+/**
+ * Runs the recursion forwards and then backwards along a row, holding the 4 channels of every pixel in a single vector.
+ */
+kmz__target("sse2") static void _kmz_sse2_gaussian_row(const struct _kmz_gaussian_coefficients_t * const restrict co, float * const restrict row,
+        const size_t w) {
+    const __m128 b = _mm_set1_ps(co->b), c1 = _mm_set1_ps(co->c1), c2 = _mm_set1_ps(co->c2), c3 = _mm_set1_ps(co->c3),
+          last = _mm_loadu_ps(row + 4 * (w - 1));
+    __m128 p1 = _mm_loadu_ps(row), p2 = p1, p3 = p1;
+    for (size_t x = 0; x < w; ++x) {
+        __m128 v = _mm_mul_ps(b, _mm_loadu_ps(row + 4 * x));
+        v = _mm_add_ps(v, _mm_mul_ps(c3, p3));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, p2));
+        v = _mm_add_ps(v, _mm_mul_ps(c1, p1));
+        _mm_storeu_ps(row + 4 * x, v);
+        p3 = p2;
+        p2 = p1;
+        p1 = v;
+    }
+    _kmz_sse2_gaussian_edge(co, last, &p1, &p2, &p3);
+    for (size_t x = w; x-- > 0;) {
+        __m128 v = _mm_mul_ps(b, _mm_loadu_ps(row + 4 * x));
+        v = _mm_add_ps(v, _mm_mul_ps(c3, p3));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, p2));
+        v = _mm_add_ps(v, _mm_mul_ps(c1, p1));
+        _mm_storeu_ps(row + 4 * x, v);
+        p3 = p2;
+        p2 = p1;
+        p1 = v;
+    }
+}
+
+kmz__target("sse2") static size_t _kmz_sse2_gaussian_widen(const int16_t * const restrict src, float * const restrict dst, const float scale,
+        const size_t count, size_t i) {
+    const __m128 s = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(s, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16))));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(s, _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16))));
+    }
+    return i;
+}
+
+kmz__target("sse2") static size_t _kmz_sse2_gaussian_narrow(const float * const restrict src, int16_t * const restrict dst, const float scale,
+        const size_t count, size_t i) {
+    const __m128 s = _mm_set1_ps(scale), half = _mm_set1_ps(.5f);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(src + i)), half)),
+              hi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(s, _mm_loadu_ps(src + i + 4)), half));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi32(lo, hi));
+    }
+    return i;
+}
+
+/**
+ * Rounds 4 premultiplied pixels at a time into bytes, which only need to be joined back into colors one at a time unless all 4 are opaque.
+ */
+kmz__target("sse2") static size_t _kmz_sse2_gaussian_colors(const float * const restrict src, kmz_color_32 * const restrict dst, const size_t w,
+        size_t x) {
+    const __m128 half = _mm_set1_ps(.5f);
+    const __m128i opaque = _mm_set1_epi32((int)0xFF000000u);
+    for (; x + 4 <= w; x += 4) {
+        __m128i v[4];
+        for (size_t k = 0; k < 4; ++k) {
+            v[k] = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(src + 4 * (x + k)), half));
+        }
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+        if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(bytes, opaque), opaque))) {
+            _mm_storeu_si128((__m128i *)(dst + x), _mm_andnot_si128(opaque, bytes));
+        } else {
+            uint8_t channels[16];
+            _mm_storeu_si128((__m128i *)channels, bytes);
+            for (size_t k = 0; k < 4; ++k) {
+                const int32_t c[4] = {channels[4 * k], channels[4 * k + 1], channels[4 * k + 2], channels[4 * k + 3]};
+                dst[x + k] = _kmz_color_unpremultiply(c);
+            }
+        }
+    }
+    return x;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_gaussian_step(const struct _kmz_gaussian_coefficients_t * const restrict co, float * const restrict line,
+        const float * const restrict p1, const float * const restrict p2, const float * const restrict p3, const size_t count, size_t i) {
+    const __m256 b = _mm256_set1_ps(co->b), c1 = _mm256_set1_ps(co->c1), c2 = _mm256_set1_ps(co->c2), c3 = _mm256_set1_ps(co->c3);
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_mul_ps(b, _mm256_loadu_ps(line + i));
+        v = _mm256_add_ps(v, _mm256_mul_ps(c3, _mm256_loadu_ps(p3 + i)));
+        v = _mm256_add_ps(v, _mm256_mul_ps(c2, _mm256_loadu_ps(p2 + i)));
+        v = _mm256_add_ps(v, _mm256_mul_ps(c1, _mm256_loadu_ps(p1 + i)));
+        _mm256_storeu_ps(line + i, v);
+    }
+    return i;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_gaussian_fir(const float * const restrict taps, const size_t radius, const float * const * const restrict lines,
+        float * const restrict out, const size_t count, size_t i) {
+    const __m256 center = _mm256_set1_ps(taps[0]);
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_mul_ps(center, _mm256_loadu_ps(lines[radius] + i));
+        for (size_t k = 1; k <= radius; ++k) {
+            v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(taps[k]), _mm256_add_ps(_mm256_loadu_ps(lines[radius - k] + i), _mm256_loadu_ps(lines[radius + k] + i))));
+        }
+        _mm256_storeu_ps(out + i, v);
+    }
+    return i;
+}
+
+kmz__target("avx2") static inline void _kmz_avx2_gaussian_edge(const struct _kmz_gaussian_coefficients_t * const restrict co, const __m256 u,
+        __m256 * const restrict p1, __m256 * const restrict p2, __m256 * const restrict p3) {
+    const __m256 d[3] = {_mm256_sub_ps(*p1, u), _mm256_sub_ps(*p2, u), _mm256_sub_ps(*p3, u)};
+    __m256 y[3];
+    for (size_t i = 0; i < 3; ++i) {
+        __m256 v = _mm256_mul_ps(_mm256_set1_ps(co->m[3 * i]), d[0]);
+        v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(co->m[3 * i + 1]), d[1]));
+        v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(co->m[3 * i + 2]), d[2]));
+        y[i] = _mm256_add_ps(v, u);
+    }
+    *p1 = y[0];
+    *p2 = y[1];
+    *p3 = y[2];
+}
+
+/**
+ * Runs the recursion along 2 rows at once, holding a pixel of the first row in the low half of every vector and a pixel of the second in the high
+ * half, which halves the length of the chain of dependent operations per row.
+ */
+kmz__target("avx2") static void _kmz_avx2_gaussian_rows(const struct _kmz_gaussian_coefficients_t * const restrict co, float * const restrict a,
+        float * const restrict b_row, const size_t w) {
+    const __m256 b = _mm256_set1_ps(co->b), c1 = _mm256_set1_ps(co->c1), c2 = _mm256_set1_ps(co->c2), c3 = _mm256_set1_ps(co->c3),
+          last = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a + 4 * (w - 1))), _mm_loadu_ps(b_row + 4 * (w - 1)), 1);
+    __m256 p1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a)), _mm_loadu_ps(b_row), 1), p2 = p1, p3 = p1;
+    for (size_t x = 0; x < w; ++x) {
+        __m256 v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a + 4 * x)), _mm_loadu_ps(b_row + 4 * x), 1);
+        v = _mm256_mul_ps(b, v);
+        v = _mm256_add_ps(v, _mm256_mul_ps(c3, p3));
+        v = _mm256_add_ps(v, _mm256_mul_ps(c2, p2));
+        v = _mm256_add_ps(v, _mm256_mul_ps(c1, p1));
+        _mm_storeu_ps(a + 4 * x, _mm256_castps256_ps128(v));
+        _mm_storeu_ps(b_row + 4 * x, _mm256_extractf128_ps(v, 1));
+        p3 = p2;
+        p2 = p1;
+        p1 = v;
+    }
+    _kmz_avx2_gaussian_edge(co, last, &p1, &p2, &p3);
+    for (size_t x = w; x-- > 0;) {
+        __m256 v = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a + 4 * x)), _mm_loadu_ps(b_row + 4 * x), 1);
+        v = _mm256_mul_ps(b, v);
+        v = _mm256_add_ps(v, _mm256_mul_ps(c3, p3));
+        v = _mm256_add_ps(v, _mm256_mul_ps(c2, p2));
+        v = _mm256_add_ps(v, _mm256_mul_ps(c1, p1));
+        _mm_storeu_ps(a + 4 * x, _mm256_castps256_ps128(v));
+        _mm_storeu_ps(b_row + 4 * x, _mm256_extractf128_ps(v, 1));
+        p3 = p2;
+        p2 = p1;
+        p1 = v;
+    }
+}
+#endif
+
+/**
+ * Takes one step of the recursion for `count` channels at once, where `line` holds the input and receives the output and `p1`, `p2` and `p3` hold
+ * the 3 previous outputs. Every {@link KmzSimdLevel} sums the terms in the same order, so they all produce identical results, and the term of the
+ * latest output is added last so that a chain of steps only waits on one multiplication and addition per step.
+ */
+static void _kmz_gaussian_step(const struct _kmz_gaussian_coefficients_t * const restrict co, float * const restrict line,
+        const float * const restrict p1, const float * const restrict p2, const float * const restrict p3, const size_t count) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_gaussian_step(co, line, p1, p2, p3, count, i);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        i = _kmz_sse2_gaussian_step(co, line, p1, p2, p3, count, i);
+    }
+#endif
+    for (; i < count; ++i) {
+        float v = co->b * line[i];
+        v += co->c3 * p3[i];
+        v += co->c2 * p2[i];
+        v += co->c1 * p1[i];
+        line[i] = v;
+    }
+}
+
+/**
+ * Convolves `count` channels with the sampled Gaussian, where `lines` holds the `2 * radius + 1` lines of input it covers and `out` receives the
+ * output. Every {@link KmzSimdLevel} sums the pairs of taps from the center outwards, so they all produce identical results.
+ */
+static void _kmz_gaussian_fir(const float * const restrict taps, const size_t radius, const float * const * const restrict lines, float * const restrict out,
+        const size_t count) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_gaussian_fir(taps, radius, lines, out, count, i);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        i = _kmz_sse2_gaussian_fir(taps, radius, lines, out, count, i);
+    }
+#endif
+    for (; i < count; ++i) {
+        float v = taps[0] * lines[radius][i];
+        for (size_t k = 1; k <= radius; ++k) {
+            v += taps[k] * (lines[radius - k][i] + lines[radius + k][i]);
+        }
+        out[i] = v;
+    }
+}
+
+/**
+ * Converts `count` channels from 16 bits to floats, multiplying them by `scale`.
+ */
+static void _kmz_gaussian_widen(const int16_t * const restrict src, float * const restrict dst, const float scale, const size_t count) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_SSE2 <= kmz_simd_level()) {
+        i = _kmz_sse2_gaussian_widen(src, dst, scale, count, i);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = scale * (float)src[i];
+    }
+}
+
+/**
+ * Converts `count` channels from floats to 16 bits, multiplying them by `scale` and rounding them half up.
+ */
+static void _kmz_gaussian_narrow(const float * const restrict src, int16_t * const restrict dst, const float scale, const size_t count) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_SSE2 <= kmz_simd_level()) {
+        i = _kmz_sse2_gaussian_narrow(src, dst, scale, count, i);
+    }
+#endif
+    for (; i < count; ++i) {
+        const int32_t v = (int32_t)(scale * src[i] + .5f);
+        dst[i] = (int16_t)(v < INT16_MIN ? INT16_MIN : v > INT16_MAX ? INT16_MAX : v);
+    }
+}
+
+/**
+ * Rounds a row of premultiplied pixels to the nearest whole channels and joins them back into colors.
+ */
+static void _kmz_gaussian_colors(const float * const restrict src, kmz_color_32 * const restrict dst, const size_t w) {
+    size_t x = 0;
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_SSE2 <= kmz_simd_level()) {
+        x = _kmz_sse2_gaussian_colors(src, dst, w, x);
+    }
+#endif
+    for (; x < w; ++x) {
+        int32_t channels[4];
+        for (size_t c = 0; c < 4; ++c) {
+            const int32_t v = (int32_t)(src[4 * x + c] + .5f);
+            channels[c] = v < 0 ? 0 : v > 255 ? 255 : v;
+        }
+        dst[x] = _kmz_color_unpremultiply(channels);
+    }
+}
+
+/**
+ * Computes the first 3 outputs of the backward recursion past the end of a line, from the last input `u` and the last 3 outputs `w1`, `w2` and `w3`
+ * of the forward recursion, for `count` channels at once.
+ */
+static void _kmz_gaussian_edge(const struct _kmz_gaussian_coefficients_t * const restrict co, const float * const restrict u,
+        const float * const restrict w1, const float * const restrict w2, const float * const restrict w3, float * const restrict y1,
+        float * const restrict y2, float * const restrict y3, const size_t count) {
+    float * const restrict y[3] = {y1, y2, y3};
+    for (size_t i = 0; i < count; ++i) {
+        const float d[3] = {w1[i] - u[i], w2[i] - u[i], w3[i] - u[i]};
+        for (size_t k = 0; k < 3; ++k) {
+            float v = co->m[3 * k] * d[0];
+            v += co->m[3 * k + 1] * d[1];
+            v += co->m[3 * k + 2] * d[2];
+            y[k][i] = v + u[i];
+        }
+    }
+}
+
+/**
+ * Runs the recursion forwards and then backwards along a row of `w` pixels of 4 channels. Both directions start as though the edge pixels of the
+ * image were repeated forever, the backward one through the boundary matrix.
+ */
+static void _kmz_gaussian_row(const struct _kmz_gaussian_coefficients_t * const restrict co, float * const restrict row, const size_t w) {
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_SSE2 <= kmz_simd_level()) {
+        _kmz_sse2_gaussian_row(co, row, w);
+        return;
+    }
+#endif
+    float p[3][4], last[4];
+    for (size_t c = 0; c < 4; ++c) {
+        p[0][c] = p[1][c] = p[2][c] = row[c];
+        last[c] = row[4 * (w - 1) + c];
+    }
+    for (size_t x = 0; x < w; ++x) {
+        _kmz_gaussian_step(co, row + 4 * x, p[0], p[1], p[2], 4);
+        memcpy(p[2], p[1], sizeof(p[1]));
+        memcpy(p[1], p[0], sizeof(p[0]));
+        memcpy(p[0], row + 4 * x, sizeof(p[0]));
+    }
+    float edge[3][4];
+    _kmz_gaussian_edge(co, last, p[0], p[1], p[2], edge[0], edge[1], edge[2], 4);
+    memcpy(p, edge, sizeof(p));
+    for (size_t x = w; x-- > 0;) {
+        _kmz_gaussian_step(co, row + 4 * x, p[0], p[1], p[2], 4);
+        memcpy(p[2], p[1], sizeof(p[1]));
+        memcpy(p[1], p[0], sizeof(p[0]));
+        memcpy(p[0], row + 4 * x, sizeof(p[0]));
+    }
+}
+
+// endregion;
+
+// region Passes:
+
+/**
+ * Returns the buffer of a worker, which holds either a strip of columns or 2 rows and is kept from one unit of work to the next.
+ */
+static inline float * const _kmz_gaussian_line(struct _kmz_gaussian_t * const restrict ctx, const size_t worker) {
+    if (NULL == ctx->lines[worker]) {
+        ctx->lines[worker] = malloc(ctx->line_size * sizeof(float));
+    }
+    if (NULL == ctx->lines[worker]) {
+        KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+    return ctx->lines[worker];
+}
+
+/**
+ * Premultiplies a strip of columns and filters it down and then up the image within a buffer of the worker, where every step of the recursion is a
+ * single pass over the whole width of the strip, and then stores it in fixed point.
+ */
+static void _KmzImage__gaussian_columns(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_gaussian_t * const restrict ctx = arg;
+    const size_t w = ctx->dimen.w, h = ctx->dimen.h, x0 = index * _KMZ_GAUSSIAN_STRIP,
+          columns = x0 + _KMZ_GAUSSIAN_STRIP < w ? _KMZ_GAUSSIAN_STRIP : w - x0, count = 4 * columns;
+    float * const restrict strip = _kmz_gaussian_line(ctx, worker);
+    if (NULL == strip) {
+        return;
+    }
+    int16_t premultiplied[4 * _KMZ_GAUSSIAN_STRIP];
+    float first[4 * _KMZ_GAUSSIAN_STRIP], last[4 * _KMZ_GAUSSIAN_STRIP], edge[3][4 * _KMZ_GAUSSIAN_STRIP];
+
+    for (size_t y = 0; y < h; ++y) {
+        float * const restrict line = strip + y * count;
+        _kmz_color_premultiply_span(ctx->pixels + y * w + x0, premultiplied, columns);
+        _kmz_gaussian_widen(premultiplied, line, 1.f, count);
+        if (ctx->radius) {
+            continue;
+        } else if (!y) {
+            memcpy(first, line, count * sizeof(float));
+        }
+        if (y + 1 == h) {
+            memcpy(last, line, count * sizeof(float));
+        }
+        _kmz_gaussian_step(&ctx->co, line, y > 0 ? line - count : first, y > 1 ? line - 2 * count : first, y > 2 ? line - 3 * count : first, count);
+    }
+
+    if (ctx->radius) {
+        // The lines past the edges of the image repeat the edge lines, as they do for the recursion.
+        const float * lines[2 * _KMZ_GAUSSIAN_FIR_RADIUS + 1];
+        for (size_t y = 0; y < h; ++y) {
+            for (size_t j = 0; j <= 2 * ctx->radius; ++j) {
+                const ssize_t source = (ssize_t)(y + j) - (ssize_t)ctx->radius;
+                lines[j] = strip + (source < 0 ? 0 : (size_t)source < h ? (size_t)source : h - 1) * count;
+            }
+            _kmz_gaussian_fir(ctx->taps, ctx->radius, lines, first, count);
+            _kmz_gaussian_narrow(first, ctx->plane + 4 * (y * w + x0), _KMZ_GAUSSIAN_FIXED, count);
+        }
+        return;
+    }
+
+    float * const restrict end = strip + (h - 1) * count;
+    _kmz_gaussian_edge(&ctx->co, last, end, h > 1 ? end - count : first, h > 2 ? end - 2 * count : first, edge[0], edge[1], edge[2], count);
+    for (size_t y = h; y-- > 0;) {
+        float * const restrict line = strip + y * count;
+        _kmz_gaussian_step(&ctx->co, line, y + 1 < h ? line + count : edge[y + 1 - h], y + 2 < h ? line + 2 * count : edge[y + 2 - h],
+            y + 3 < h ? line + 3 * count : edge[y + 3 - h], count);
+        _kmz_gaussian_narrow(line, ctx->plane + 4 * (y * w + x0), _KMZ_GAUSSIAN_FIXED, count);
+    }
+}
+
+/**
+ * Filters a band of rows along the image and then rounds and unpremultiplies them back into colors.
+ */
+static void _KmzImage__gaussian_rows(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_gaussian_t * const restrict ctx = arg;
+    const size_t w = ctx->dimen.w, y0 = index * _KMZ_GAUSSIAN_BAND_ROWS,
+          y1 = y0 + _KMZ_GAUSSIAN_BAND_ROWS < ctx->dimen.h ? y0 + _KMZ_GAUSSIAN_BAND_ROWS : ctx->dimen.h;
+    float * const restrict rows = _kmz_gaussian_line(ctx, worker);
+    if (NULL == rows) {
+        return;
+    }
+
+    if (ctx->radius) {
+        // Every row is widened between copies of its edge pixels, so that every pixel of the row sees whole lines of input on either side.
+        const size_t radius = ctx->radius;
+        float * const restrict padded = rows, * const restrict out = rows + 4 * (w + 2 * radius);
+        const float * lines[2 * _KMZ_GAUSSIAN_FIR_RADIUS + 1];
+        for (size_t j = 0; j <= 2 * radius; ++j) {
+            lines[j] = padded + 4 * j;
+        }
+        for (size_t y = y0; y < y1; ++y) {
+            _kmz_gaussian_widen(ctx->plane + 4 * w * y, padded + 4 * radius, 1.f / _KMZ_GAUSSIAN_FIXED, 4 * w);
+            for (size_t k = 0; k < radius; ++k) {
+                memcpy(padded + 4 * k, padded + 4 * radius, 4 * sizeof(float));
+                memcpy(padded + 4 * (radius + w + k), padded + 4 * (radius + w - 1), 4 * sizeof(float));
+            }
+            _kmz_gaussian_fir(ctx->taps, radius, lines, out, 4 * w);
+            _kmz_gaussian_colors(out, ctx->pixels + y * w, w);
+        }
+        return;
+    }
+
+    for (size_t y = y0; y < y1; y += 2) {
+        const size_t pair = y + 2 <= y1 ? 2 : 1;
+        _kmz_gaussian_widen(ctx->plane + 4 * w * y, rows, 1.f / _KMZ_GAUSSIAN_FIXED, 4 * w * pair);
+#ifdef KMZ_SIMD_X86
+        if (2 == pair && KMZ_SIMD_AVX2 <= kmz_simd_level()) {
+            _kmz_avx2_gaussian_rows(&ctx->co, rows, rows + 4 * w, w);
+        } else
+#endif
+        {
+            for (size_t r = 0; r < pair; ++r) {
+                _kmz_gaussian_row(&ctx->co, rows + r * 4 * w, w);
+            }
+        }
+
+        for (size_t r = 0; r < pair; ++r) {
+            _kmz_gaussian_colors(rows + r * 4 * w, ctx->pixels + (y + r) * w, w);
+        }
+    }
+}
+
+// endregion;
+
+const KmzPixelOperationStatus KmzImage__gaussian_blur(const KmzImage * const me, const float sigma, KmzImage * const output, const size_t threads) {
+    if (!isfinite(sigma) || sigma < _KMZ_GAUSSIAN_MIN_SIGMA) {
+        return KMZ_PIXEL_OP_ERR_UNKNOWN;
+    }
+
+    const KmzSize dimen = KmzImage__dimen(me), o_dimen = KmzImage__dimen(output);
+    if (o_dimen.w != dimen.w || o_dimen.h != dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    }
+    if (!dimen.w || !dimen.h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t pixels = (size_t)dimen.w * dimen.h, strips = ((size_t)dimen.w + _KMZ_GAUSSIAN_STRIP - 1) / _KMZ_GAUSSIAN_STRIP,
+          bands = ((size_t)dimen.h + _KMZ_GAUSSIAN_BAND_ROWS - 1) / _KMZ_GAUSSIAN_BAND_ROWS,
+          requested = pixels < _KMZ_GAUSSIAN_PARALLEL_PIXELS ? 1 : threads,
+          workers = _kmz_parallel_workers(requested, strips > bands ? strips : bands);
+    struct _kmz_gaussian_t ctx = {
+        .dimen = dimen,
+        .pixels = malloc(pixels * sizeof(kmz_color_32)),
+        .plane = malloc(4 * pixels * sizeof(int16_t)),
+        .line_size = 4 * _KMZ_GAUSSIAN_STRIP * (size_t)dimen.h > 8 * ((size_t)dimen.w + _KMZ_GAUSSIAN_FIR_RADIUS)
+                ? 4 * _KMZ_GAUSSIAN_STRIP * (size_t)dimen.h : 8 * ((size_t)dimen.w + _KMZ_GAUSSIAN_FIR_RADIUS),
+        .lines = calloc(workers, sizeof(float *)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (sigma < _KMZ_GAUSSIAN_FIR_SIGMA) {
+        _kmz_gaussian_taps(sigma, &ctx);
+    }
+    if (NULL == ctx.pixels || NULL == ctx.plane || NULL == ctx.lines || (!ctx.radius && !_kmz_gaussian_coefficients(sigma, &ctx.co))) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        ctx.status = KmzImage__read_argb_block(me, kmz_rectangle(KmzPoint__ZERO, dimen), ctx.pixels);
+    }
+
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        _kmz_parallel_for(_kmz_parallel_workers(requested, strips), strips, &_KmzImage__gaussian_columns, &ctx);
+    }
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        _kmz_parallel_for(_kmz_parallel_workers(requested, bands), bands, &_KmzImage__gaussian_rows, &ctx);
+    }
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        ctx.status = KmzImage__write_argb_block(output, kmz_rectangle(KmzPoint__ZERO, dimen), ctx.pixels);
+    }
+
+    if (NULL != ctx.lines) {
+        for (size_t i = 0; i < workers; ++i) {
+            free(ctx.lines[i]);
+        }
+    }
+    free(ctx.pixels);
+    free(ctx.plane);
+    free(ctx.lines);
+
+    return ctx.status;
+}
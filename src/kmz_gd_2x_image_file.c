@@ -36,22 +36,14 @@ static const int _kmz_read_byte(FILE * const restrict f, uint8_t * const restric
     if (1 == fread(r, sizeof(uint8_t), 1, f)) {
         return 0;
     }
-    return ferror(f);
+    return ferror(f) ? ferror(f) : EOF;
 }
 
 static const int _kmz_read_byte_buffer(FILE * const restrict f, uint8_t * const restrict r, const size_t s) {
-    size_t total = 0, remainder = s;
-    while (remainder > 8192 && !feof(f)) {
-        total += fread(r + total, sizeof(uint8_t), 8192, f);
-        remainder -= 8192;
-    }
-    if (remainder && !feof(f)) {
-        total += fread(r + total, sizeof(uint8_t), remainder, f);
-    }
-    if (s == total) {
+    if (s == fread(r, sizeof(uint8_t), s, f)) {
         return 0;
     }
-    return ferror(f);
+    return ferror(f) ? ferror(f) : EOF;
 }
 
 static const int _kmz_write_byte(FILE * const restrict f, const uint8_t v) {
@@ -62,15 +54,10 @@ static const int _kmz_write_byte(FILE * const restrict f, const uint8_t v) {
 }
 
 static const int _kmz_write_byte_buffer(FILE * const restrict f, const uint8_t * const restrict r, const size_t s) {
-    size_t total = 0, remainder = s;
-    while (remainder > 8192 && !feof(f)) {
-        total += fwrite(r + total, sizeof(uint8_t), 8192, f);
-        remainder -= 8192;
-    }
-    if (remainder && !feof(f)) {
-        total += fwrite(r + total, sizeof(uint8_t), remainder, f);
+    if (s == fwrite(r, sizeof(uint8_t), s, f)) {
+        return 0;
     }
-    return s == total ? 0 : ferror(f);
+    return ferror(f) ? ferror(f) : EOF;
 }
 
 static const int _kmz_read_short(FILE * const restrict f, uint16_t * const restrict r) {
@@ -78,7 +65,7 @@ static const int _kmz_read_short(FILE * const restrict f, uint16_t * const restr
         *r = ntohs(*r);
         return 0;
     }
-    return ferror(f);
+    return ferror(f) ? ferror(f) : EOF;
 }
 
 static const int _kmz_write_short(FILE * const restrict f, uint16_t v) {
@@ -89,44 +76,88 @@ static const int _kmz_write_short(FILE * const restrict f, uint16_t v) {
     return ferror(f);
 }
 
-static const int _kmz_read_int_buffer(FILE * const restrict f, uint32_t * const restrict r, const size_t s) {
-    size_t total = 0, remainder = s;
-    while (remainder > 8192 && !feof(f)) {
-        total += fread(r + total, sizeof(uint32_t), 8192, f);
-        remainder -= 8192;
+#ifdef KMZ_SIMD_X86
+kmz__target("ssse3") static size_t _kmz_ssse3_swap_int_buffer(uint32_t * const dst, const uint8_t * const src, const size_t count) {
+    const __m128i order = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + (i * 4))), order));
     }
-    if (remainder && !feof(f)) {
-        total += fread(r + total, sizeof(uint32_t), remainder, f);
-    }
-    if (s == total) {
-        for (size_t i = 0; i < s; ++i) {
-            r[i] = ntohl(r[i]);
-        }
-        return 0;
+    return i;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_swap_int_buffer(uint32_t * const dst, const uint8_t * const src, const size_t count) {
+    const __m256i order = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src + (i * 4))), order));
     }
-    return ferror(f);
+    return i;
 }
+#endif
 
-static const int _kmz_write_int_buffer(FILE * const restrict f, uint32_t * const restrict r, const size_t s) {
-    for (size_t i = 0; i < s; ++i) {
-        r[i] = htonl(r[i]);
+/**
+ * Converts `count` big-endian integers starting at `src` into host order integers starting at `dst`. `src` doesn't need to be aligned and
+ * may overlap `dst` as long as it doesn't begin before it, since every block is loaded before the block preceding it in `src` is stored.
+ */
+static void _kmz_swap_int_buffer(uint32_t * const dst, const uint8_t * const src, const size_t count) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_swap_int_buffer(dst, src, count);
+    } else if (KMZ_SIMD_SSSE3 <= level) {
+        i = _kmz_ssse3_swap_int_buffer(dst, src, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        uint32_t v;
+        memcpy(&v, src + (i * 4), sizeof(uint32_t));
+        dst[i] = ntohl(v);
     }
-    size_t total = 0, remainder = s;
-    while (remainder > 8192 && !feof(f)) {
-        total += fwrite(r + total, sizeof(uint32_t), 8192, f);
-        remainder -= 8192;
+}
+
+/**
+ * The number of integers converted between host and big-endian order at a time, which is small enough to stay within the cache and large
+ * enough for every block to be handed to the system in a single read or write instead of passing through the buffer of a default `FILE`.
+ */
+#define _KMZ_BLOCK_INTS 8192
+
+/**
+ * Reads `s` big-endian integers, converting every block to host order in place while it is still in the cache.
+ */
+static const int _kmz_read_int_buffer(FILE * const restrict f, uint32_t * const restrict r, const size_t s) {
+    for (size_t i = 0; i < s; i += _KMZ_BLOCK_INTS) {
+        const size_t count = s - i < _KMZ_BLOCK_INTS ? s - i : _KMZ_BLOCK_INTS;
+        if (count != fread(r + i, sizeof(uint32_t), count, f)) {
+            return ferror(f) ? ferror(f) : EOF;
+        }
+        _kmz_swap_int_buffer(r + i, (const uint8_t *)(r + i), count);
     }
-    if (remainder && !feof(f)) {
-        total += fwrite(r + total, sizeof(uint32_t), remainder, f);
+    return 0;
+}
+
+/**
+ * Writes `s` host order integers as big-endian integers through a fixed size staging buffer, leaving `r` unchanged.
+ */
+static const int _kmz_write_swapped_int_buffer(FILE * const restrict f, const uint32_t * const restrict r, const size_t s) {
+    uint32_t staging[_KMZ_BLOCK_INTS];
+    for (size_t i = 0; i < s; i += _KMZ_BLOCK_INTS) {
+        const size_t count = s - i < _KMZ_BLOCK_INTS ? s - i : _KMZ_BLOCK_INTS;
+        _kmz_swap_int_buffer(staging, (const uint8_t *)(r + i), count);
+        if (count != fwrite(staging, sizeof(uint32_t), count, f)) {
+            return ferror(f) ? ferror(f) : EOF;
+        }
     }
-    return s == total ? 0 : ferror(f);
+    return 0;
 }
 
 static const int _kmz_read_int(FILE * const restrict f, uint32_t * const restrict r) {
     if (1 == fread(r, sizeof(uint32_t), 1, f)) {
         return 0;
     }
-    return ferror(f);
+    return ferror(f) ? ferror(f) : EOF;
 }
 
 static const int _kmz_write_int(FILE * const restrict f, uint32_t v) {
@@ -190,6 +221,8 @@ typedef struct kmz_gd_2x_image_file_header_t KmzGd2xImageFileHeader;
 struct kmz_gd_2x_image_file_t {
     KmzGd2xImageFileStatus status;
     KmzBool owns_pixels;
+    void * mapping;
+    size_t mapping_size;
     KmzGd2xImageFileHeader header;
     union {
         kmz_color_32 * truecolor;
@@ -205,11 +238,14 @@ static KmzGd2xImageFile * const _KmzGd2xImageFile__new(void) {
 static void _KmzGd2xImageFile__ctor(KmzGd2xImageFile * const restrict me, const void * const restrict argv) {
     if (me != NULL) {
         me->status = (KmzGd2xImageFileStatus)KMZ_IMAGE_FILE_ERR_NOT_LOADED;
+        me->owns_pixels = KMZ_FALSE;
+        me->mapping = NULL;
+        me->mapping_size = 0;
         me->pixels.palette = NULL;
     }
 }
 
-static void _KmzGd2xImageFile__dtor(KmzGd2xImageFile * const restrict me) {
+static void _KmzGd2xImageFile__release(KmzGd2xImageFile * const restrict me) {
     if (KMZ_TRUE == me->owns_pixels) {
         switch (me->header.signature.type) {
             case KMZ_GD_2X_IMAGE_FILE_PALETTE:
@@ -224,6 +260,19 @@ static void _KmzGd2xImageFile__dtor(KmzGd2xImageFile * const restrict me) {
                 break;
         }
     }
+#ifdef KMZ_GD_2X_IMAGE_FILE_MAP_SUPPORTED
+    if (NULL != me->mapping) {
+        munmap(me->mapping, me->mapping_size);
+    }
+#endif
+    me->owns_pixels = KMZ_FALSE;
+    me->mapping = NULL;
+    me->mapping_size = 0;
+    me->pixels.palette = NULL;
+}
+
+static void _KmzGd2xImageFile__dtor(KmzGd2xImageFile * const restrict me) {
+    _KmzGd2xImageFile__release(me);
     free(me);
 }
 
@@ -304,12 +353,7 @@ static const char * const _KmzGd2xImageFile__status_msg(const KmzGd2xImageFile *
     }
 }
 
-static const KmzGd2xImageFileStatus _KmzGd2xImageFile__save_to(KmzGd2xImageFile * const restrict me, FILE * const path) {
-    FILE * const f = path;
-    if (NULL == f) {
-        return me->status = KMZ_GD_ERR_INVALID_FILE_PTR;
-    }
-
+static const KmzGd2xImageFileStatus _KmzGd2xImageFile__save_header(KmzGd2xImageFile * const restrict me, FILE * const restrict f) {
     if (0 != _kmz_write_short(f, me->header.signature.type)) {
         return me->status = KMZ_GD_ERR_WRITE_SIGNATURE;
     }
@@ -330,15 +374,38 @@ static const KmzGd2xImageFileStatus _KmzGd2xImageFile__save_to(KmzGd2xImageFile
             }
             break;
         case KMZ_GD_2X_IMAGE_FILE_PALETTE:
-            // TODO: Implement palette image writing
-            return me->status = KMZ_GD_ERR_UNSUPPORTED_OPERATION;
+            if (0 != _kmz_write_short(f, me->header.color.value.palette.count)) {
+                return me->status = KMZ_GD_ERR_WRITE_PALETTE_COUNT;
+            }
+            if (0 != _kmz_write_int(f, me->header.color.value.palette.transparent)) {
+                return me->status = KMZ_GD_ERR_WRITE_PALETTE_TRANSPARENT;
+            }
+            if (0 != _kmz_write_swapped_int_buffer(f, me->header.color.value.palette.colors, 256)) {
+                return me->status = KMZ_GD_ERR_WRITE_PALETTE_COLORS;
+            }
+            break;
     }
+    return KMZ_GD_OK;
+}
 
-    const size_t len = me->header.signature.dimen.w * me->header.signature.dimen.h;
+static const KmzGd2xImageFileStatus _KmzGd2xImageFile__save_to(KmzGd2xImageFile * const restrict me, FILE * const path) {
+    FILE * const f = path;
+    if (NULL == f) {
+        return me->status = KMZ_GD_ERR_INVALID_FILE_PTR;
+    } else if (NULL == me->pixels.palette) {
+        return (KmzGd2xImageFileStatus)KMZ_IMAGE_FILE_ERR_NOT_LOADED;
+    }
+
+    const KmzGd2xImageFileStatus status = _KmzGd2xImageFile__save_header(me, f);
+    if (KMZ_GD_OK != status) {
+        return status;
+    }
+
+    const size_t len = (size_t)me->header.signature.dimen.w * me->header.signature.dimen.h;
     const size_t is_truecolor = me->header.signature.type == KMZ_GD_2X_IMAGE_FILE_TRUECOLOR;
 
     if (is_truecolor) {
-        if (0 != _kmz_write_int_buffer(f, me->pixels.truecolor, len)) {
+        if (0 != _kmz_write_swapped_int_buffer(f, me->pixels.truecolor, len)) {
             return me->status = KMZ_GD_ERR_WRITE_PIXELS;
         }
     } else {
@@ -349,11 +416,12 @@ static const KmzGd2xImageFileStatus _KmzGd2xImageFile__save_to(KmzGd2xImageFile
     return me->status = KMZ_GD_OK;
 }
 
-static const KmzGd2xImageFileStatus _KmzGd2xImageFile__load_from(KmzGd2xImageFile * const restrict me, FILE * const path) {
+static const KmzGd2xImageFileStatus _KmzGd2xImageFile__read_header(KmzGd2xImageFile * const restrict me, FILE * const path) {
     FILE * const f = path;
     if (NULL == f) {
         return me->status = KMZ_GD_ERR_INVALID_FILE_PTR;
     }
+    _KmzGd2xImageFile__release(me);
     if (0 != _kmz_read_short(f, &me->header.signature.type)) {
         return me->status = KMZ_GD_ERR_READ_SIGNATURE;
     }
@@ -383,17 +451,31 @@ static const KmzGd2xImageFileStatus _KmzGd2xImageFile__load_from(KmzGd2xImageFil
             if (0 != _kmz_read_int_buffer(f, me->header.color.value.palette.colors, 256)) {
                 return me->status = KMZ_GD_ERR_READ_PALETTE_COLORS;
             }
+            break;
+        default:
+            return me->status = KMZ_GD_ERR_READ_SIGNATURE;
+    }
+
+    me->header.color.is_truecolor = me->header.signature.type == KMZ_GD_2X_IMAGE_FILE_TRUECOLOR;
+    return me->status = KMZ_GD_OK;
+}
+
+static const KmzGd2xImageFileStatus _KmzGd2xImageFile__load_from(KmzGd2xImageFile * const restrict me, FILE * const path) {
+    const KmzGd2xImageFileStatus status = _KmzGd2xImageFile__read_header(me, path);
+    if (KMZ_GD_OK != status) {
+        return status;
     }
 
-    const size_t len = me->header.signature.dimen.w * me->header.signature.dimen.h;
-    const uint8_t is_truecolor = me->header.signature.type == KMZ_GD_2X_IMAGE_FILE_TRUECOLOR;
-    me->header.color.is_truecolor = is_truecolor;
+    FILE * const f = path;
+    const size_t len = (size_t)me->header.signature.dimen.w * me->header.signature.dimen.h;
+    const uint8_t is_truecolor = me->header.color.is_truecolor;
 
     if (is_truecolor) {
         me->pixels.truecolor = calloc(len, sizeof(kmz_color_32));
         if (NULL == me->pixels.truecolor) {
             return me->status = KMZ_GD_ERR_OUT_OF_MEMORY;
         }
+        me->owns_pixels = KMZ_TRUE;
         if (0 != _kmz_read_int_buffer(f, me->pixels.truecolor, len)) {
             return me->status = KMZ_GD_ERR_READ_PIXELS;
         }
@@ -402,6 +484,7 @@ static const KmzGd2xImageFileStatus _KmzGd2xImageFile__load_from(KmzGd2xImageFil
         if (NULL == me->pixels.palette) {
             return me->status = KMZ_GD_ERR_OUT_OF_MEMORY;
         }
+        me->owns_pixels = KMZ_TRUE;
         if (0 != _kmz_read_byte_buffer(f, me->pixels.palette, len)) {
             return me->status = KMZ_GD_ERR_READ_PIXELS;
         }
@@ -432,6 +515,9 @@ static const KmzGd2xImageFileStatus _KmzGd2xImageFile__read_palette_pixels(KmzGd
         if (me->header.signature.type != KMZ_GD_2X_IMAGE_FILE_PALETTE) {
             return me->status = (KmzGd2xImageFileStatus)KMZ_IMAGE_FILE_ERR_NOT_PALETTE_IMAGE;
         }
+        if (NULL == me->pixels.palette) {
+            return (KmzGd2xImageFileStatus)KMZ_IMAGE_FILE_ERR_NOT_LOADED;
+        }
         memcpy(buffer, me->pixels.palette, me->header.signature.dimen.h * me->header.signature.dimen.w * sizeof(uint8_t));
     }
     return me->status;
@@ -442,6 +528,9 @@ static const KmzGd2xImageFileStatus _KmzGd2xImageFile__read_truecolor_pixels(Kmz
         if (me->header.signature.type != KMZ_GD_2X_IMAGE_FILE_TRUECOLOR) {
             return me->status = (KmzGd2xImageFileStatus)KMZ_IMAGE_FILE_ERR_NOT_TRUECOLOR_IMAGE;
         }
+        if (NULL == me->pixels.truecolor) {
+            return (KmzGd2xImageFileStatus)KMZ_IMAGE_FILE_ERR_NOT_LOADED;
+        }
         memcpy(buffer, me->pixels.truecolor, me->header.signature.dimen.h * me->header.signature.dimen.w * sizeof(kmz_color_32));
     }
     return me->status;
@@ -449,48 +538,228 @@ static const KmzGd2xImageFileStatus _KmzGd2xImageFile__read_truecolor_pixels(Kmz
 
 static const KmzGd2xImageFileStatus _KmzGd2xImageFile__set_palette_image(KmzGd2xImageFile * const restrict me, const size_t color_count,
         kmz_color_32 * const palette, const KmzSize dimen, uint8_t * const pixels, const KmzBool copy_source) {
-    if (KMZ_GD_OK == me->status) {
-        if (KMZ_TRUE == me->owns_pixels) {
-            free(me->pixels.palette);
-        }
-
-        me->header.signature.dimen = dimen;
-        me->header.signature.type = KMZ_GD_2X_IMAGE_FILE_PALETTE;
-        me->header.color.is_truecolor = 0;
-        me->header.color.value.palette.count = color_count;
-        memcpy(me->header.color.value.palette.colors, palette, color_count * sizeof(kmz_color_32));
-
-        me->owns_pixels = copy_source;
-        if (KMZ_TRUE == me->owns_pixels) {
-            me->pixels.palette = calloc(dimen.h * dimen.w, sizeof(uint8_t));
-            memcpy(me->pixels.palette, pixels, dimen.h * dimen.w * sizeof(uint8_t));
-        } else {
-            me->pixels.palette = pixels;
+    // A file that has never been loaded may still be given an image to save.
+    if (KMZ_GD_OK != me->status && (KmzGd2xImageFileStatus)KMZ_IMAGE_FILE_ERR_NOT_LOADED != me->status) {
+        return me->status;
+    } else if (256 < color_count) {
+        return me->status = KMZ_GD_ERR_WRITE_PALETTE_COUNT;
+    }
+
+    _KmzGd2xImageFile__release(me);
+
+    me->header.signature.dimen = dimen;
+    me->header.signature.type = KMZ_GD_2X_IMAGE_FILE_PALETTE;
+    me->header.color.is_truecolor = 0;
+    me->header.color.value.palette.count = (uint16_t)color_count;
+    // GD stores -1 as the transparent color of palette images without one.
+    me->header.color.value.palette.transparent = 0xFFFFFFFF;
+    memset(me->header.color.value.palette.colors, 0, sizeof(me->header.color.value.palette.colors));
+    memcpy(me->header.color.value.palette.colors, palette, color_count * sizeof(kmz_color_32));
+
+    if (KMZ_TRUE == copy_source) {
+        me->pixels.palette = calloc(dimen.h * dimen.w, sizeof(uint8_t));
+        if (NULL == me->pixels.palette) {
+            return me->status = KMZ_GD_ERR_OUT_OF_MEMORY;
         }
+        memcpy(me->pixels.palette, pixels, dimen.h * dimen.w * sizeof(uint8_t));
+    } else {
+        me->pixels.palette = pixels;
     }
-    return me->status;
+    me->owns_pixels = copy_source;
+    return me->status = KMZ_GD_OK;
 }
 
 static const KmzGd2xImageFileStatus _KmzGd2xImageFile__set_truecolor_image(KmzGd2xImageFile * const restrict me, const KmzSize dimen,
         kmz_color_32 * const restrict pixels, const KmzBool copy_source) {
-    if (KMZ_GD_OK == me->status) {
-        if (KMZ_TRUE == me->owns_pixels) {
-            free(me->pixels.palette);
+    // A file that has never been loaded may still be given an image to save.
+    if (KMZ_GD_OK != me->status && (KmzGd2xImageFileStatus)KMZ_IMAGE_FILE_ERR_NOT_LOADED != me->status) {
+        return me->status;
+    }
+
+    _KmzGd2xImageFile__release(me);
+
+    me->header.signature.dimen = dimen;
+    me->header.signature.type = KMZ_GD_2X_IMAGE_FILE_TRUECOLOR;
+    me->header.color.is_truecolor = 1;
+    me->header.color.value.truecolor.transparent = 0xFFFFFFFF;
+
+    if (KMZ_TRUE == copy_source) {
+        me->pixels.truecolor = calloc(dimen.h * dimen.w , sizeof(kmz_color_32));
+        if (NULL == me->pixels.truecolor) {
+            return me->status = KMZ_GD_ERR_OUT_OF_MEMORY;
         }
+        memcpy(me->pixels.truecolor, pixels, dimen.h * dimen.w * sizeof(kmz_color_32));
+    } else {
+        me->pixels.truecolor = pixels;
+    }
+    me->owns_pixels = copy_source;
+    return me->status = KMZ_GD_OK;
+}
+
+static inline const uint16_t _kmz_mapped_short(const uint8_t * const restrict bytes) {
+    return (uint16_t)((bytes[0] << 8u) | bytes[1]);
+}
 
-        me->header.signature.dimen = dimen;
-        me->header.signature.type = KMZ_GD_2X_IMAGE_FILE_TRUECOLOR;
-        me->header.color.is_truecolor = 1;
+static const KmzGd2xImageFileStatus _KmzGd2xImageFile__map(KmzGd2xImageFile * const restrict me, const char * const restrict path) {
+#ifdef KMZ_GD_2X_IMAGE_FILE_MAP_SUPPORTED
+    if (NULL == path) {
+        return me->status = KMZ_GD_ERR_INVALID_FILE_PTR;
+    }
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return me->status = KMZ_GD_ERR_INVALID_FILE_PTR;
+    }
 
-        me->owns_pixels = copy_source;
-        if (KMZ_TRUE == me->owns_pixels) {
-            me->pixels.truecolor = calloc(dimen.h * dimen.w , sizeof(kmz_color_32));
-            memcpy(me->pixels.truecolor, pixels, dimen.h * dimen.w * sizeof(kmz_color_32));
-        } else {
-            me->pixels.truecolor = pixels;
+    struct stat st;
+    if (0 != fstat(fd, &st) || st.st_size < 7) {
+        close(fd);
+        return me->status = KMZ_GD_ERR_READ_SIGNATURE;
+    }
+
+    // The mapping is private so the pixels can be converted to host order in place without ever writing to the file.
+    const size_t size = (size_t)st.st_size;
+    uint8_t * const mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == mapping) {
+        return me->status = KMZ_GD_ERR_OUT_OF_MEMORY;
+    }
+
+    _KmzGd2xImageFile__release(me);
+
+    KmzGd2xImageFileHeader header;
+    header.signature.type = _kmz_mapped_short(mapping);
+    header.signature.dimen.w = _kmz_mapped_short(mapping + 2);
+    header.signature.dimen.h = _kmz_mapped_short(mapping + 4);
+    header.color.is_truecolor = mapping[6];
+
+    const size_t len = (size_t)header.signature.dimen.w * header.signature.dimen.h;
+    size_t offset = 7;
+    KmzGd2xImageFileStatus status = KMZ_GD_OK;
+
+    switch (header.signature.type) {
+        case KMZ_GD_2X_IMAGE_FILE_TRUECOLOR:
+            if (size < offset + sizeof(uint32_t)) {
+                status = KMZ_GD_ERR_READ_TRUECOLOR_TRANSPARENT;
+                break;
+            }
+            memcpy(&header.color.value.truecolor.transparent, mapping + offset, sizeof(uint32_t));
+            offset += sizeof(uint32_t);
+            if (size < offset + (len * sizeof(kmz_color_32))) {
+                status = KMZ_GD_ERR_READ_PIXELS;
+            }
+            break;
+        case KMZ_GD_2X_IMAGE_FILE_PALETTE:
+            if (size < offset + sizeof(uint16_t) + sizeof(uint32_t) + (256 * sizeof(kmz_color_32))) {
+                status = KMZ_GD_ERR_READ_PALETTE_COLORS;
+                break;
+            }
+            header.color.value.palette.count = _kmz_mapped_short(mapping + offset);
+            offset += sizeof(uint16_t);
+            memcpy(&header.color.value.palette.transparent, mapping + offset, sizeof(uint32_t));
+            offset += sizeof(uint32_t);
+            _kmz_swap_int_buffer(header.color.value.palette.colors, mapping + offset, 256);
+            offset += 256 * sizeof(kmz_color_32);
+            if (size < offset + len) {
+                status = KMZ_GD_ERR_READ_PIXELS;
+            }
+            break;
+        default:
+            status = KMZ_GD_ERR_READ_SIGNATURE;
+    }
+
+    if (KMZ_GD_OK != status) {
+        munmap(mapping, size);
+        return me->status = status;
+    }
+
+    header.color.is_truecolor = header.signature.type == KMZ_GD_2X_IMAGE_FILE_TRUECOLOR;
+    me->header = header;
+    me->mapping = mapping;
+    me->mapping_size = size;
+    me->owns_pixels = KMZ_FALSE;
+
+    if (header.color.is_truecolor) {
+        // Truecolor pixels begin 11 bytes into the file, so they are swapped down onto the first 8 byte boundary in a single pass.
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        me->pixels.truecolor = (kmz_color_32 *)(mapping + 8);
+        _kmz_swap_int_buffer(me->pixels.truecolor, mapping + offset, len);
+    } else {
+        me->pixels.palette = mapping + offset;
+    }
+
+    return me->status = KMZ_GD_OK;
+#else
+    return me->status = KMZ_GD_ERR_UNSUPPORTED_OPERATION;
+#endif
+}
+
+static kmz_color_32 * const _KmzGd2xImageFile__truecolor_pixels(KmzGd2xImageFile * const restrict me) {
+    if (KMZ_GD_OK == me->status && KMZ_GD_2X_IMAGE_FILE_TRUECOLOR == me->header.signature.type) {
+        return me->pixels.truecolor;
+    }
+    return NULL;
+}
+
+static const KmzGd2xImageFileStatus _KmzGd2xImageFile__read_rows(KmzGd2xImageFile * const restrict me, FILE * const restrict f, const size_t count,
+        kmz_color_32 * const restrict buffer) {
+    if (KMZ_GD_OK != me->status) {
+        return me->status;
+    }
+
+    const size_t w = me->header.signature.dimen.w;
+    if (me->header.color.is_truecolor) {
+        if (0 != _kmz_read_int_buffer(f, buffer, count * w)) {
+            return me->status = KMZ_GD_ERR_READ_PIXELS;
         }
+        return KMZ_GD_OK;
     }
-    return me->status;
+
+    uint8_t * const restrict line = malloc(w ? w : 1);
+    if (NULL == line) {
+        return me->status = KMZ_GD_ERR_OUT_OF_MEMORY;
+    }
+
+    const kmz_color_32 * const restrict colors = me->header.color.value.palette.colors;
+    for (size_t r = 0; r < count; ++r) {
+        if (0 != _kmz_read_byte_buffer(f, line, w)) {
+            free(line);
+            return me->status = KMZ_GD_ERR_READ_PIXELS;
+        }
+        for (size_t x = 0; x < w; ++x) {
+            buffer[(r * w) + x] = colors[line[x]];
+        }
+    }
+
+    free(line);
+    return KMZ_GD_OK;
+}
+
+static const KmzGd2xImageFileStatus _KmzGd2xImageFile__write_header(KmzGd2xImageFile * const restrict me, FILE * const restrict f, const KmzSize dimen) {
+    if (NULL == f) {
+        return me->status = KMZ_GD_ERR_INVALID_FILE_PTR;
+    }
+    _KmzGd2xImageFile__release(me);
+
+    // GD stores -1 as the transparent color of truecolor images without one.
+    me->header.signature.type = KMZ_GD_2X_IMAGE_FILE_TRUECOLOR;
+    me->header.signature.dimen = dimen;
+    me->header.color.is_truecolor = 1;
+    me->header.color.value.truecolor.transparent = 0xFFFFFFFF;
+
+    const KmzGd2xImageFileStatus status = _KmzGd2xImageFile__save_header(me, f);
+    return me->status = status;
+}
+
+static const KmzGd2xImageFileStatus _KmzGd2xImageFile__write_rows(KmzGd2xImageFile * const restrict me, FILE * const restrict f, const size_t count,
+        const kmz_color_32 * const restrict buffer) {
+    if (KMZ_GD_OK != me->status) {
+        return me->status;
+    }
+    if (0 != _kmz_write_swapped_int_buffer(f, buffer, count * me->header.signature.dimen.w)) {
+        return me->status = KMZ_GD_ERR_WRITE_PIXELS;
+    }
+    return KMZ_GD_OK;
 }
 
 const KmzImageFileType kmz_gd_2x_image_file = {
@@ -518,6 +787,12 @@ const KmzImageFileType kmz_gd_2x_image_file = {
     .has_metadata=NULL,
     .set_metadata=NULL,
     .remove_metadata=NULL,
+    .map=(const KmzImageFileStatus (*)(void * const, const char * const))&_KmzGd2xImageFile__map,
+    .truecolor_pixels=(kmz_color_32 * const (*)(void * const))&_KmzGd2xImageFile__truecolor_pixels,
+    .read_header=(const KmzImageFileStatus (*)(void * const, FILE * const))&_KmzGd2xImageFile__read_header,
+    .read_rows=(const KmzImageFileStatus (*)(void * const, FILE * const, const size_t, kmz_color_32 * const))&_KmzGd2xImageFile__read_rows,
+    .write_header=(const KmzImageFileStatus (*)(void * const, FILE * const, const KmzSize))&_KmzGd2xImageFile__write_header,
+    .write_rows=(const KmzImageFileStatus (*)(void * const, FILE * const, const size_t, const kmz_color_32 * const))&_KmzGd2xImageFile__write_rows,
 };
 
 KmzImageFile * const KmzGd2xImageFile__new(void) {
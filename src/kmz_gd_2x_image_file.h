@@ -50,9 +50,15 @@
 #include <Winsock.h>
 #else
 #include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define KMZ_GD_2X_IMAGE_FILE_MAP_SUPPORTED 1
 #endif
 
 #include "kmz_shared.h"
+#include "kmz_utilities.h"
 #include "kmz_geometry.h"
 #include "kmz_color.h"
 #include "../include/libkempozer/gdfile.h"
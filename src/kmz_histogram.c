@@ -0,0 +1,282 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_histogram.h"
+
+#define _KMZ_HISTOGRAM_CACHE_LINE 64
+#define _KMZ_HISTOGRAM_BAND_ROWS 16
+/**
+ * The number of copies of every histogram that each worker fills, one for each pixel of an unrolled group. Consecutive pixels of the same color
+ * increment separate counters, so the increment of one pixel never waits on the store of the previous one.
+ */
+#define _KMZ_HISTOGRAM_COPIES 4
+
+enum _kmz_histogram_channel_e {
+    _KMZ_HISTOGRAM_A,
+    _KMZ_HISTOGRAM_R,
+    _KMZ_HISTOGRAM_G,
+    _KMZ_HISTOGRAM_B,
+    _KMZ_HISTOGRAM_H,
+    _KMZ_HISTOGRAM_S,
+    _KMZ_HISTOGRAM_L,
+    _KMZ_HISTOGRAM_CHANNELS,
+};
+
+/**
+ * The private state of a single worker. The counts of every worker begin on their own cache line, so workers never write to the same line.
+ */
+struct _kmz_histogram_worker_t {
+    kmz_color_32 * line;
+    KmzAhslColor * ahsl;
+    uint32_t (* counts)[_KMZ_HISTOGRAM_COPIES][KMZ_HISTOGRAM_BINS];
+};
+
+struct _kmz_histogram_t {
+    const KmzImage * me;
+    KmzRectangle area;
+    KmzBool hsl;
+    struct _kmz_histogram_worker_t * workers;
+    KmzPixelOperationStatus status;
+};
+
+/**
+ * Returns the bin of a hue, saturation or lightness, which are never negative, so only 1 falls past the last bin.
+ */
+static inline const uint32_t _kmz_histogram_bin(const kmz_percent value) {
+    const uint32_t bin = (uint32_t)(value * (float)KMZ_HISTOGRAM_BINS);
+    return bin < KMZ_HISTOGRAM_BINS - 1 ? bin : KMZ_HISTOGRAM_BINS - 1;
+}
+
+static void _kmz_histogram_argb(const kmz_color_32 * const restrict line, const size_t count,
+        uint32_t (* const restrict counts)[_KMZ_HISTOGRAM_COPIES][KMZ_HISTOGRAM_BINS]) {
+    uint32_t (* const restrict a)[KMZ_HISTOGRAM_BINS] = counts[_KMZ_HISTOGRAM_A], (* const restrict r)[KMZ_HISTOGRAM_BINS] = counts[_KMZ_HISTOGRAM_R],
+             (* const restrict g)[KMZ_HISTOGRAM_BINS] = counts[_KMZ_HISTOGRAM_G], (* const restrict b)[KMZ_HISTOGRAM_BINS] = counts[_KMZ_HISTOGRAM_B];
+    size_t x = 0;
+    for (; x + _KMZ_HISTOGRAM_COPIES <= count; x += _KMZ_HISTOGRAM_COPIES) {
+        const kmz_color_32 c0 = line[x], c1 = line[x + 1], c2 = line[x + 2], c3 = line[x + 3];
+        ++a[0][(c0 >> 24) & 0x7F]; ++a[1][(c1 >> 24) & 0x7F]; ++a[2][(c2 >> 24) & 0x7F]; ++a[3][(c3 >> 24) & 0x7F];
+        ++r[0][(c0 >> 16) & 0xFF]; ++r[1][(c1 >> 16) & 0xFF]; ++r[2][(c2 >> 16) & 0xFF]; ++r[3][(c3 >> 16) & 0xFF];
+        ++g[0][(c0 >> 8) & 0xFF]; ++g[1][(c1 >> 8) & 0xFF]; ++g[2][(c2 >> 8) & 0xFF]; ++g[3][(c3 >> 8) & 0xFF];
+        ++b[0][c0 & 0xFF]; ++b[1][c1 & 0xFF]; ++b[2][c2 & 0xFF]; ++b[3][c3 & 0xFF];
+    }
+    for (; x < count; ++x) {
+        const kmz_color_32 c = line[x];
+        ++a[0][(c >> 24) & 0x7F];
+        ++r[0][(c >> 16) & 0xFF];
+        ++g[0][(c >> 8) & 0xFF];
+        ++b[0][c & 0xFF];
+    }
+}
+
+static void _kmz_histogram_hsl(const KmzAhslColor * const restrict ahsl, const size_t count,
+        uint32_t (* const restrict counts)[_KMZ_HISTOGRAM_COPIES][KMZ_HISTOGRAM_BINS]) {
+    uint32_t (* const restrict h)[KMZ_HISTOGRAM_BINS] = counts[_KMZ_HISTOGRAM_H], (* const restrict s)[KMZ_HISTOGRAM_BINS] = counts[_KMZ_HISTOGRAM_S],
+             (* const restrict l)[KMZ_HISTOGRAM_BINS] = counts[_KMZ_HISTOGRAM_L];
+    size_t x = 0;
+    for (; x + _KMZ_HISTOGRAM_COPIES <= count; x += _KMZ_HISTOGRAM_COPIES) {
+        for (size_t k = 0; k < _KMZ_HISTOGRAM_COPIES; ++k) {
+            ++h[k][_kmz_histogram_bin(ahsl[x + k].h)];
+            ++s[k][_kmz_histogram_bin(ahsl[x + k].s)];
+            ++l[k][_kmz_histogram_bin(ahsl[x + k].l)];
+        }
+    }
+    for (; x < count; ++x) {
+        ++h[0][_kmz_histogram_bin(ahsl[x].h)];
+        ++s[0][_kmz_histogram_bin(ahsl[x].s)];
+        ++l[0][_kmz_histogram_bin(ahsl[x].l)];
+    }
+}
+
+static void _KmzImage__histogram_band(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_histogram_t * const restrict ctx = arg;
+    if (__atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_PIXEL_OP_OK) {
+        return;
+    }
+
+    struct _kmz_histogram_worker_t * const restrict state = ctx->workers + worker;
+    const size_t w = ctx->area.size.w, y0 = index * _KMZ_HISTOGRAM_BAND_ROWS,
+          y1 = y0 + _KMZ_HISTOGRAM_BAND_ROWS < ctx->area.size.h ? y0 + _KMZ_HISTOGRAM_BAND_ROWS : ctx->area.size.h;
+    KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+
+    if (NULL == state->line) {
+        void * counts = NULL;
+        state->line = malloc(w * sizeof(kmz_color_32));
+        state->ahsl = ctx->hsl ? malloc(w * sizeof(KmzAhslColor)) : NULL;
+        if (0 == posix_memalign(&counts, _KMZ_HISTOGRAM_CACHE_LINE, _KMZ_HISTOGRAM_CHANNELS * sizeof(*state->counts))) {
+            memset(counts, 0, _KMZ_HISTOGRAM_CHANNELS * sizeof(*state->counts));
+            state->counts = counts;
+        }
+    }
+
+    if (NULL == state->line || NULL == state->counts || (ctx->hsl && NULL == state->ahsl)) {
+        status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    for (size_t y = y0; KMZ_PIXEL_OP_OK == status && y < y1; ++y) {
+        status = KmzImage__read_row_span(ctx->me, kmz_point(ctx->area.pos.x, ctx->area.pos.y + (ssize_t)y), w, state->line);
+        if (KMZ_PIXEL_OP_OK == status) {
+            _kmz_histogram_argb(state->line, w, state->counts);
+            if (ctx->hsl) {
+                kmz_color_32__to_ahsl_span(state->line, state->ahsl, w);
+                _kmz_histogram_hsl(state->ahsl, w, state->counts);
+            }
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK != status) {
+        KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, status, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+static void _kmz_histogram_merge(const struct _kmz_histogram_worker_t * const restrict workers, const size_t count, KmzHistogram * const restrict histogram) {
+    uint64_t * const restrict bins[_KMZ_HISTOGRAM_CHANNELS] = {histogram->a, histogram->r, histogram->g, histogram->b, histogram->h, histogram->s, histogram->l};
+    for (size_t i = 0; i < count; ++i) {
+        if (NULL == workers[i].counts) {
+            continue;
+        }
+        for (size_t c = 0; c < _KMZ_HISTOGRAM_CHANNELS; ++c) {
+            for (size_t k = 0; k < _KMZ_HISTOGRAM_COPIES; ++k) {
+                for (size_t v = 0; v < KMZ_HISTOGRAM_BINS; ++v) {
+                    bins[c][v] += workers[i].counts[c][k][v];
+                }
+            }
+        }
+    }
+}
+
+const KmzPixelOperationStatus KmzImage__histogram(const KmzImage * const me, const KmzRectangle area, const KmzBool hsl,
+        KmzHistogram * const restrict histogram, const size_t threads) {
+    const KmzSize dimen = KmzImage__dimen(me);
+    const ssize_t x = kmz_clamp(area.pos.x, 0, dimen.w),
+          y = kmz_clamp(area.pos.y, 0, dimen.h),
+          max_x = kmz_clamp(area.size.w + x, x, dimen.w),
+          max_y = kmz_clamp(area.size.h + y, y, dimen.h);
+
+    const size_t w = (size_t)(max_x - x),
+          h = (size_t)(max_y - y);
+
+    memset(histogram, 0, sizeof(KmzHistogram));
+    if (!w || !h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t bands = (h + _KMZ_HISTOGRAM_BAND_ROWS - 1) / _KMZ_HISTOGRAM_BAND_ROWS,
+          workers = _kmz_parallel_workers(threads, bands);
+
+    struct _kmz_histogram_t ctx = {
+        .me = me,
+        .area = kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)w, (uint16_t)h)),
+        .hsl = hsl,
+        .workers = calloc(workers, sizeof(struct _kmz_histogram_worker_t)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (NULL == ctx.workers) {
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    _kmz_parallel_for(workers, bands, &_KmzImage__histogram_band, &ctx);
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        histogram->count = (uint64_t)w * h;
+        _kmz_histogram_merge(ctx.workers, workers, histogram);
+    }
+
+    for (size_t i = 0; i < workers; ++i) {
+        free(ctx.workers[i].line);
+        free(ctx.workers[i].ahsl);
+        free(ctx.workers[i].counts);
+    }
+    free(ctx.workers);
+
+    return ctx.status;
+}
+
+/**
+ * Computes the statistics of a single channel from its histogram, where a percentile is the lowest value that at least that percent of the pixels
+ * are lower than or equal to.
+ */
+static void _kmz_channel_stats(const uint64_t * const restrict bins, const uint64_t count, KmzChannelStats * const restrict stats) {
+    memset(stats, 0, sizeof(KmzChannelStats));
+    if (!count) {
+        return;
+    }
+
+    uint64_t sum = 0, squares = 0;
+    size_t min = KMZ_HISTOGRAM_BINS, max = 0;
+    for (size_t v = 0; v < KMZ_HISTOGRAM_BINS; ++v) {
+        if (bins[v]) {
+            min = v < min ? v : min;
+            max = v;
+            sum += bins[v] * v;
+            squares += bins[v] * v * v;
+        }
+    }
+
+    const double mean = (double)sum / (double)count;
+    stats->min = (kmz_channel)min;
+    stats->max = (kmz_channel)max;
+    stats->mean = mean;
+    stats->variance = (double)squares / (double)count - mean * mean;
+    stats->variance = stats->variance < 0. ? 0. : stats->variance;
+
+    uint64_t seen = 0;
+    size_t v = min;
+    for (size_t p = 0; p <= 100; ++p) {
+        // The number of pixels that must be at or below the percentile, rounded up and never below the first pixel.
+        const uint64_t needed = p ? (count * p + 99) / 100 : 1;
+        while (seen + bins[v] < needed) {
+            seen += bins[v++];
+        }
+        stats->percentiles[p] = (kmz_channel)v;
+    }
+}
+
+const KmzPixelOperationStatus KmzImage__stats(const KmzImage * const me, const KmzRectangle area, KmzImageStats * const restrict stats,
+        const size_t threads) {
+    KmzHistogram * const restrict histogram = malloc(sizeof(KmzHistogram));
+    if (NULL == histogram) {
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    const KmzPixelOperationStatus status = KmzImage__histogram(me, area, KMZ_FALSE, histogram, threads);
+    if (KMZ_PIXEL_OP_OK == status) {
+        stats->count = histogram->count;
+        _kmz_channel_stats(histogram->a, histogram->count, &stats->a);
+        _kmz_channel_stats(histogram->r, histogram->count, &stats->r);
+        _kmz_channel_stats(histogram->g, histogram->count, &stats->g);
+        _kmz_channel_stats(histogram->b, histogram->count, &stats->b);
+    }
+
+    free(histogram);
+    return status;
+}
@@ -52,40 +52,55 @@ struct _kmz_image_argv_t {
 KmzImage * const KmzImage__new_from_file(KmzImageFile * const restrict file) {
     const KmzImageFileColorType color_type = KmzImageFile__color_type(file);
     struct _kmz_image_argv_t argv = {KmzImageFile__dimen(file), NULL, KMZ_TRUE};
-    const size_t count = argv.dimen.h * argv.dimen.w;
+    const size_t count = (size_t)argv.dimen.h * argv.dimen.w;
 
     if (KMZ_IMAGE_FILE_TRUECOLOR == color_type) {
         argv.pixels = calloc(count, sizeof(kmz_color_32));
         KmzImageFile__read_truecolor_pixels(file, argv.pixels);
-    } else if (KMZ_IMAGE_FILE_PALETTE == color_type) {
+    } else if (KMZ_IMAGE_FILE_PALETTE == color_type && 256 >= KmzImageFile__palette_color_count(file)) {
+        kmz_color_32 colors[256] = {0};
         argv.pixels = calloc(count, sizeof(kmz_color_32));
-        kmz_color_32 * const restrict colors = calloc(KmzImageFile__palette_color_count(file), sizeof(kmz_color_32));
-        uint8_t * const restrict buffer = calloc(count, sizeof(uint8_t));
-        KmzImageFile__read_palette_colors(file, colors);
-        KmzImageFile__read_palette_pixels(file, buffer);
-        for (size_t i = 0; i < count; ++i) {
-            argv.pixels[i] = colors[buffer[i]];
+        if (NULL != argv.pixels) {
+            // The indices are read into the last quarter of the pixels, which is only overwritten after every index in it has been expanded.
+            kmz_color_32 * const pixels = argv.pixels;
+            const uint8_t * const indices = (uint8_t *)argv.pixels + (count * (sizeof(kmz_color_32) - 1));
+            KmzImageFile__read_palette_colors(file, colors);
+            KmzImageFile__read_palette_pixels(file, (uint8_t *)indices);
+            for (size_t i = 0; i < count; ++i) {
+                pixels[i] = colors[indices[i]];
+            }
         }
-        free(colors);
-        free(buffer);
     } else if (KMZ_IMAGE_FILE_AHSL == color_type) {
-        argv.pixels = calloc(argv.dimen.h * argv.dimen.w, sizeof(kmz_color_32));
+        argv.pixels = calloc(count, sizeof(kmz_color_32));
         KmzAhslColor * const restrict buffer = calloc(count, sizeof(KmzAhslColor));
         KmzImageFile__read_ahsl_pixels(file, buffer);
-        for (size_t i = 0; i < count; ++i) {
-            argv.pixels[i] = kmz_color_32__from_ahsl_color(buffer[i]);
-        }
+        kmz_color_32__from_ahsl_span(buffer, argv.pixels, count);
         free(buffer);
     }
     
     if (NULL == argv.pixels) {
         return NULL;
     }
+
+    // The decoded pixels are handed over to the image instead of being copied a second time.
+    argv.copy_source = KMZ_FALSE;
     KmzImage * const restrict me = KmzImage__new(&kmz_image, &argv);
-    free(argv.pixels);
+    if (NULL == me) {
+        free(argv.pixels);
+        return NULL;
+    }
+    ((struct _kmz_image_t *)_KmzImage__impl(me))->owns_buffer = KMZ_TRUE;
     return me;
 }
 
+KmzImage * const KmzImage__new_borrowed_from_file(KmzImageFile * const restrict file) {
+    kmz_color_32 * const restrict pixels = KmzImageFile__truecolor_pixels(file);
+    if (NULL == pixels) {
+        return KmzImage__new_from_file(file);
+    }
+    return KmzImage__new_from_buffer(KmzImageFile__dimen(file), pixels, KMZ_FALSE);
+}
+
 KmzImage * const KmzImage__new_from_buffer(const KmzSize dimen, kmz_color_32 * const restrict buffer, const KmzBool copy_source) {
     struct _kmz_image_argv_t argv = {dimen, buffer, copy_source};
     return KmzImage__new(&kmz_image, &argv);
@@ -199,6 +214,69 @@ static const KmzBool _KmzImage__is_valid(const struct _kmz_image_t * const restr
     return (me->dimen.w > point.x && point.x > -1 && me->dimen.h > point.y && point.y > -1);
 }
 
+static const KmzPixelOperationStatus _KmzImage__read_row_span(const struct _kmz_image_t * const restrict me, const KmzPoint start, const size_t count,
+        kmz_color_32 * const restrict dst) {
+    if (start.x < 0 || start.x >= me->dimen.w || start.y < 0 || start.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_POS;
+    } else if (count > (size_t)(me->dimen.w - start.x)) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_SIZE;
+    } else if (NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    memcpy(dst, me->pixels + _KmzImage__get_offset(start, me->dimen), count * sizeof(kmz_color_32));
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzImage__write_row_span(struct _kmz_image_t * const restrict me, const KmzPoint start, const size_t count,
+        const kmz_color_32 * const restrict src) {
+    if (start.x < 0 || start.x >= me->dimen.w || start.y < 0 || start.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_POS;
+    } else if (count > (size_t)(me->dimen.w - start.x)) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    } else if (NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    memcpy(me->pixels + _KmzImage__get_offset(start, me->dimen), src, count * sizeof(kmz_color_32));
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzImage__gather(const struct _kmz_image_t * const restrict me, const KmzPoint * const restrict points, const size_t count,
+        kmz_color_32 * const restrict dst) {
+    if (NULL == points || NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    // Negative coordinates wrap around to large unsigned values, so a single comparison per axis rejects every invalid point.
+    const size_t w = me->dimen.w, h = me->dimen.h;
+    const kmz_color_32 * const restrict pixels = me->pixels;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t x = (size_t)points[i].x, y = (size_t)points[i].y;
+        dst[i] = (x < w && y < h) ? pixels[y * w + x] : 0x00000000;
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzImage__scatter(struct _kmz_image_t * const restrict me, const KmzPoint * const restrict points, const size_t count,
+        const kmz_color_32 * const restrict src) {
+    if (NULL == points || NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    const size_t w = me->dimen.w, h = me->dimen.h;
+    kmz_color_32 * const restrict pixels = me->pixels;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t x = (size_t)points[i].x, y = (size_t)points[i].y;
+        if (x < w && y < h) {
+            pixels[y * w + x] = src[i];
+        }
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
 const KmzImageType kmz_image = {
     ._new=(void * const (*)(void))&_KmzImage__new,
     ._ctor=(void (*)(void * const restrict, const void * const restrict))&_KmzImage__ctor,
@@ -208,6 +286,10 @@ const KmzImageType kmz_image = {
     .set_argb_at=(void (*)(void * const restrict, const KmzPoint, const kmz_color_32))&_KmzImage__set_argb_at,
     .is_valid=(const KmzBool (*)(const void * const restrict, const KmzPoint))&_KmzImage__is_valid,
     .read_argb_block=(const KmzPixelOperationStatus (*)(const void * const restrict, const KmzRectangle, kmz_color_32 * const restrict))&_KmzImage__read_argb_block,
-    .write_argb_block=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzRectangle, const kmz_color_32 * const restrict))&_KmzImage__write_argb_block
+    .write_argb_block=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzRectangle, const kmz_color_32 * const restrict))&_KmzImage__write_argb_block,
+    .read_row_span=(const KmzPixelOperationStatus (*)(const void * const restrict, const KmzPoint, const size_t, kmz_color_32 * const restrict))&_KmzImage__read_row_span,
+    .write_row_span=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzPoint, const size_t, const kmz_color_32 * const restrict))&_KmzImage__write_row_span,
+    .gather=(const KmzPixelOperationStatus (*)(const void * const restrict, const KmzPoint * const restrict, const size_t, kmz_color_32 * const restrict))&_KmzImage__gather,
+    .scatter=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzPoint * const restrict, const size_t, const kmz_color_32 * const restrict))&_KmzImage__scatter
 };
 
@@ -31,10 +31,11 @@
   */
 
 /**
- * |Definition                  |Header                 |
- * |KmzImage__new_from_file()   |libkempozer/image.h    |
- * |KmzImage__new_from_buffer() |libkempozer/image.h    |
- * |const KmzImageType kmz_image|libkempozer/image.h    |
+ * |Definition                          |Header                 |
+ * |KmzImage__new_from_file()           |libkempozer/image.h    |
+ * |KmzImage__new_from_buffer()         |libkempozer/image.h    |
+ * |KmzImage__new_borrowed_from_file()  |libkempozer/image.h    |
+ * |const KmzImageType kmz_image        |libkempozer/image.h    |
  */
 #ifndef kmz_image_h
 #define kmz_image_h
@@ -126,6 +126,120 @@ const KmzImageFileStatus KmzImageFile__load_from(KmzImageFile * const restrict m
     return me->_type->load_from(me->_me, path);
 }
 
+const KmzImageFileStatus KmzImageFile__map(KmzImageFile * const restrict me, const char * const restrict path) {
+    if (me->_type->map) {
+        return me->_type->map(me->_me, path);
+    }
+    return KMZ_IMAGE_FILE_ERR_UNSUPPORTED_OPERATION;
+}
+
+kmz_color_32 * const KmzImageFile__truecolor_pixels(const KmzImageFile * const restrict me) {
+    if (me->_type->truecolor_pixels) {
+        return me->_type->truecolor_pixels(me->_me);
+    }
+    return NULL;
+}
+
+struct kmz_image_stream_t {
+    KmzImageFile * file;
+    FILE * stream;
+    KmzSize dimen;
+    size_t row;
+    KmzBool writing;
+    KmzImageFileStatus status;
+};
+
+static KmzImageStream * const _KmzImageStream__new(KmzImageFile * const restrict file, FILE * const restrict stream, const KmzSize dimen, const KmzBool writing) {
+    KmzImageStream * const restrict me = malloc(sizeof(KmzImageStream));
+    if (NULL != me) {
+        me->file = file;
+        me->stream = stream;
+        me->dimen = dimen;
+        me->row = 0;
+        me->writing = writing;
+        me->status = KMZ_IMAGE_FILE_OK;
+    }
+    return me;
+}
+
+KmzImageStream * const KmzImageFile__open_stream(KmzImageFile * const restrict me, FILE * const restrict file) {
+    if (NULL == me->_type->read_header || NULL == me->_type->read_rows || NULL == file) {
+        return NULL;
+    }
+    if (KMZ_IMAGE_FILE_OK != me->_type->read_header(me->_me, file)) {
+        return NULL;
+    }
+    return _KmzImageStream__new(me, file, KmzImageFile__dimen(me), KMZ_FALSE);
+}
+
+KmzImageStream * const KmzImageFile__create_stream(KmzImageFile * const restrict me, FILE * const restrict file, const KmzSize dimen) {
+    if (NULL == me->_type->write_header || NULL == me->_type->write_rows || NULL == file) {
+        return NULL;
+    }
+    if (KMZ_IMAGE_FILE_OK != me->_type->write_header(me->_me, file, dimen)) {
+        return NULL;
+    }
+    return _KmzImageStream__new(me, file, dimen, KMZ_TRUE);
+}
+
+void KmzImageStream__free(KmzImageStream * const restrict me) {
+    free(me);
+}
+
+const KmzSize KmzImageStream__dimen(const KmzImageStream * const restrict me) {
+    return me->dimen;
+}
+
+const size_t KmzImageStream__row(const KmzImageStream * const restrict me) {
+    return me->row;
+}
+
+const KmzImageFileStatus KmzImageStream__status(const KmzImageStream * const restrict me) {
+    return me->status;
+}
+
+const size_t KmzImageStream__next_rows(KmzImageStream * const restrict me, const size_t count, kmz_color_32 * const restrict buffer) {
+    if (me->writing || KMZ_IMAGE_FILE_OK != me->status) {
+        return 0;
+    } else if (NULL == buffer) {
+        me->status = KMZ_IMAGE_FILE_ERR_READ_INVALID_BUFFER;
+        return 0;
+    }
+
+    const size_t remaining = me->dimen.h - me->row, rows = count < remaining ? count : remaining;
+    if (!rows) {
+        return 0;
+    }
+
+    me->status = me->file->_type->read_rows(me->file->_me, me->stream, rows, buffer);
+    if (KMZ_IMAGE_FILE_OK != me->status) {
+        return 0;
+    }
+    me->row += rows;
+    return rows;
+}
+
+const size_t KmzImageStream__write_rows(KmzImageStream * const restrict me, const size_t count, const kmz_color_32 * const restrict buffer) {
+    if (!me->writing || KMZ_IMAGE_FILE_OK != me->status) {
+        return 0;
+    } else if (NULL == buffer) {
+        me->status = KMZ_IMAGE_FILE_ERR_WRITE_INVALID_BUFFER;
+        return 0;
+    }
+
+    const size_t remaining = me->dimen.h - me->row, rows = count < remaining ? count : remaining;
+    if (!rows) {
+        return 0;
+    }
+
+    me->status = me->file->_type->write_rows(me->file->_me, me->stream, rows, buffer);
+    if (KMZ_IMAGE_FILE_OK != me->status) {
+        return 0;
+    }
+    me->row += rows;
+    return rows;
+}
+
 const size_t KmzImageFile__palette_color_count(const KmzImageFile * const restrict me) {
     if (me->_type->palette_color_count) {
         return me->_type->palette_color_count(me->_me);
@@ -0,0 +1,904 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_image_painter.h"
+
+/**
+ * Float coordinates are clamped this far from the origin before they're converted to integers, which lies beyond every image while leaving room for the largest circle around them.
+ */
+#define _KMZ_IMAGE_PAINTER_FAR 1073741824.
+/**
+ * The largest radius of a circle, which keeps the squares used to compute its rows within 64 bits.
+ */
+#define _KMZ_IMAGE_PAINTER_MAX_RADIUS ((size_t)1 << 29)
+
+struct _kmz_image_painter_snapshot_t {
+    KmzRectangle area;
+    kmz_color_32 * pixels;
+};
+
+struct _kmz_image_painter_edge_t {
+    double y0;
+    double y1;
+    double x0;
+    double dxdy;
+};
+
+struct _kmz_image_painter_t {
+    KmzImage * image;
+    KmzSize dimen;
+    KmzBrush brush;
+    KmzPen pen;
+    kmz_color_32 * line;
+    size_t history;
+    struct _kmz_image_painter_snapshot_t * undo;
+    size_t undo_count;
+    struct _kmz_image_painter_snapshot_t * redo;
+    size_t redo_count;
+};
+
+struct _kmz_image_painter_argv_t {
+    KmzImage * image;
+    size_t history;
+};
+
+KmzPainter * const KmzPainter__new_for_image(KmzImage * const restrict image, const size_t history) {
+    const struct _kmz_image_painter_argv_t argv = {image, history};
+    return KmzPainter__new(&kmz_image_painter, &argv);
+}
+
+// region History:
+
+static void _kmz_image_painter_snapshots_clear(struct _kmz_image_painter_snapshot_t * const restrict stack, size_t * const restrict count) {
+    for (size_t i = 0; i < *count; ++i) {
+        free(stack[i].pixels);
+    }
+    *count = 0;
+}
+
+static void _kmz_image_painter_snapshots_push(struct _kmz_image_painter_snapshot_t * const restrict stack, size_t * const restrict count, const size_t history, const struct _kmz_image_painter_snapshot_t snapshot) {
+    if (*count == history) {
+        free(stack[0].pixels);
+        memmove(stack, stack + 1, sizeof(struct _kmz_image_painter_snapshot_t) * (history - 1));
+        --*count;
+    }
+    stack[(*count)++] = snapshot;
+}
+
+/**
+ * Saves the pixels within the inclusive bounds so the next change can be undone, clipping the bounds to the image.
+ */
+static const KmzDrawStatus _KmzImagePainter__record(struct _kmz_image_painter_t * const restrict me, ssize_t x0, ssize_t y0, ssize_t x1, ssize_t y1) {
+    if (0 == me->history) {
+        return KMZ_DRAW_OK;
+    }
+
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 >= me->dimen.w ? me->dimen.w - 1 : x1;
+    y1 = y1 >= me->dimen.h ? me->dimen.h - 1 : y1;
+    if (x0 > x1 || y0 > y1) {
+        return KMZ_DRAW_OK;
+    }
+
+    const struct _kmz_image_painter_snapshot_t snapshot = {
+        kmz_rectangle(kmz_point(x0, y0), kmz_size((uint16_t)(x1 - x0 + 1), (uint16_t)(y1 - y0 + 1))),
+        malloc(sizeof(kmz_color_32) * (size_t)(x1 - x0 + 1) * (size_t)(y1 - y0 + 1)),
+    };
+    if (NULL == snapshot.pixels) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+    KmzImage__read_argb_block(me->image, snapshot.area, snapshot.pixels);
+
+    _kmz_image_painter_snapshots_clear(me->redo, &me->redo_count);
+    _kmz_image_painter_snapshots_push(me->undo, &me->undo_count, me->history, snapshot);
+    return KMZ_DRAW_OK;
+}
+
+/**
+ * Moves the most recent snapshot of `from` back onto the image, saving the pixels it replaces onto `to`.
+ */
+static const KmzBool _KmzImagePainter__restore(struct _kmz_image_painter_t * const restrict me, struct _kmz_image_painter_snapshot_t * const restrict from, size_t * const restrict from_count, struct _kmz_image_painter_snapshot_t * const restrict to, size_t * const restrict to_count) {
+    if (0 == *from_count) {
+        return KMZ_FALSE;
+    }
+
+    struct _kmz_image_painter_snapshot_t snapshot = from[--*from_count];
+    kmz_color_32 * const restrict current = malloc(sizeof(kmz_color_32) * snapshot.area.size.w * snapshot.area.size.h);
+    if (NULL != current) {
+        KmzImage__read_argb_block(me->image, snapshot.area, current);
+    }
+    KmzImage__write_argb_block(me->image, snapshot.area, snapshot.pixels);
+    free(snapshot.pixels);
+
+    if (NULL == current) {
+        _kmz_image_painter_snapshots_clear(to, to_count);
+    } else {
+        snapshot.pixels = current;
+        _kmz_image_painter_snapshots_push(to, to_count, me->history, snapshot);
+    }
+    return KMZ_TRUE;
+}
+
+// endregion;
+
+// region Rasterization:
+
+/**
+ * Fills the inclusive span [x0, x1] of row `y` using `color`, or `pattern` if it isn't {@link NULL}, writing the whole span to the image at once.
+ */
+static void _KmzImagePainter__fill_span(struct _kmz_image_painter_t * const restrict me, const ssize_t y, ssize_t x0, ssize_t x1, const kmz_color_32 color, const KmzPattern * const restrict pattern) {
+    if (y < 0 || y >= me->dimen.h) {
+        return;
+    }
+    x0 = x0 < 0 ? 0 : x0;
+    x1 = x1 >= me->dimen.w ? me->dimen.w - 1 : x1;
+    if (x0 > x1) {
+        return;
+    }
+
+    const KmzPoint start = kmz_point(x0, y);
+    const size_t count = (size_t)(x1 - x0 + 1);
+    kmz_color_32 * const restrict line = me->line;
+
+    if (NULL == pattern && 127u == _kmz_draw_opacity(color)) {
+        for (size_t i = 0; i < count; ++i) {
+            line[i] = color;
+        }
+    } else {
+        KmzImage__read_row_span(me->image, start, count, line);
+        if (NULL == pattern) {
+            for (size_t i = 0; i < count; ++i) {
+                line[i] = _kmz_draw_blend(line[i], color, 255u);
+            }
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                line[i] = _kmz_draw_blend(line[i], KmzPattern__color_at(pattern, kmz_point(x0 + (ssize_t)i, y)), 255u);
+            }
+        }
+    }
+    KmzImage__write_row_span(me->image, start, count, line);
+}
+
+static void _KmzImagePainter__plot(struct _kmz_image_painter_t * const restrict me, const ssize_t x, const ssize_t y, const kmz_color_32 color, const uint32_t coverage) {
+    if (0 == coverage || x < 0 || y < 0 || x >= me->dimen.w || y >= me->dimen.h) {
+        return;
+    }
+    const KmzPoint point = kmz_point(x, y);
+    KmzImage__set_argb_at(me->image, point, _kmz_draw_blend(KmzImage__argb_at(me->image, point), color, coverage));
+}
+
+static inline const KmzBool _kmz_image_painter_is_finite(const KmzPointF point) {
+    return isfinite(point.x) && isfinite(point.y) ? KMZ_TRUE : KMZ_FALSE;
+}
+
+static inline const ssize_t _kmz_image_painter_coordinate(const double value) {
+    return (ssize_t)(value < -_KMZ_IMAGE_PAINTER_FAR ? -_KMZ_IMAGE_PAINTER_FAR : value > _KMZ_IMAGE_PAINTER_FAR ? _KMZ_IMAGE_PAINTER_FAR : value);
+}
+
+/**
+ * Clips a line to the image grown by `margin` pixels on every side using the Liang-Barsky algorithm, returning {@link KMZ_FALSE} if none of the line remains. A line that lies within the grown image is left unchanged.
+ */
+static const KmzBool _KmzImagePainter__clip(const struct _kmz_image_painter_t * const restrict me, KmzPointF * const restrict start, KmzPointF * const restrict end, const double margin) {
+    const double x = start->x, y = start->y, dx = (double)end->x - x, dy = (double)end->y - y;
+    const double p[4] = {-dx, dx, -dy, dy},
+                 q[4] = {x + margin, me->dimen.w - 1. + margin - x, y + margin, me->dimen.h - 1. + margin - y};
+    double t0 = 0., t1 = 1.;
+
+    for (size_t i = 0; i < 4; ++i) {
+        if (0. == p[i]) {
+            if (q[i] < 0.) {
+                return KMZ_FALSE;
+            }
+            continue;
+        }
+        const double t = q[i] / p[i];
+        if (p[i] < 0.) {
+            t0 = t > t0 ? t : t0;
+        } else {
+            t1 = t < t1 ? t : t1;
+        }
+        if (t0 > t1) {
+            return KMZ_FALSE;
+        }
+    }
+
+    if (t0 > 0.) {
+        *start = kmz_pointf((float)(x + t0 * dx), (float)(y + t0 * dy));
+    }
+    if (t1 < 1.) {
+        *end = kmz_pointf((float)(x + t1 * dx), (float)(y + t1 * dy));
+    }
+    return KMZ_TRUE;
+}
+
+/**
+ * @par Draws an aliased, single pixel wide line using Bresenham's algorithm, filling each horizontal run of the line as a single span.
+ *
+ * @par Only the steps along the major axis that lie within the image are walked. Within its first `n` steps along the major axis the algorithm takes `(2 * minor * n + major) / (2 * major)` steps along the minor axis, so the line starts from its first step within the image with the same position and error that walking there would have reached.
+ */
+static void _KmzImagePainter__bresenham(struct _kmz_image_painter_t * const restrict me, const KmzPoint start, const KmzPoint end, const kmz_color_32 color) {
+    const ssize_t dx = end.x > start.x ? end.x - start.x : start.x - end.x,
+                  dy = end.y > start.y ? start.y - end.y : end.y - start.y,
+                  sx = start.x < end.x ? 1 : -1,
+                  sy = start.y < end.y ? 1 : -1;
+    const KmzBool steep = -dy > dx;
+    const ssize_t major = steep ? -dy : dx, minor = steep ? dx : -dy, from = steep ? start.y : start.x, limit = (steep ? me->dimen.h : me->dimen.w) - 1;
+    ssize_t first = (steep ? sy : sx) > 0 ? -from : from - limit, last = (steep ? sy : sx) > 0 ? limit - from : from;
+    first = first > 0 ? first : 0;
+    last = last < major ? last : major;
+    if (first > last) {
+        return;
+    }
+
+    const int64_t skipped = major ? ((int64_t)2 * minor * first + major) / ((int64_t)2 * major) : 0,
+                  steps_x = steep ? skipped : first, steps_y = steep ? first : skipped;
+    ssize_t err = (ssize_t)((int64_t)dx + dy + steps_x * dy + steps_y * dx),
+            x = start.x + sx * (ssize_t)steps_x, y = start.y + sy * (ssize_t)steps_y, run = x;
+
+    for (ssize_t step = first; step < last; ++step) {
+        const ssize_t e2 = 2 * err;
+        ssize_t nx = x, ny = y;
+        if (e2 >= dy) {
+            err += dy;
+            nx += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            ny += sy;
+        }
+        if (ny != y) {
+            _KmzImagePainter__fill_span(me, y, run < x ? run : x, run < x ? x : run, color, NULL);
+            run = nx;
+        }
+        x = nx;
+        y = ny;
+    }
+    _KmzImagePainter__fill_span(me, y, run < x ? run : x, run < x ? x : run, color, NULL);
+}
+
+static inline const uint32_t _kmz_coverage(const double amount) {
+    return amount <= 0. ? 0u : amount >= 1. ? 255u : (uint32_t)(amount * 255. + .5);
+}
+
+/**
+ * Draws an antialiased, single pixel wide line using Wu's algorithm.
+ */
+static void _KmzImagePainter__wu(struct _kmz_image_painter_t * const restrict me, KmzPointF start, KmzPointF end, const kmz_color_32 color) {
+    const KmzBool steep = fabsf(end.y - start.y) > fabsf(end.x - start.x);
+    if (steep) {
+        start = kmz_pointf(start.y, start.x);
+        end = kmz_pointf(end.y, end.x);
+    }
+    if (start.x > end.x) {
+        const KmzPointF tmp = start;
+        start = end;
+        end = tmp;
+    }
+
+    const double dx = (double)end.x - start.x, gradient = 0. == dx ? 1. : ((double)end.y - start.y) / dx;
+    double xend = floor(start.x + .5), yend = start.y + gradient * (xend - start.x), gap = 1. - (start.x + .5 - floor(start.x + .5));
+    const ssize_t x1 = (ssize_t)xend;
+    double ipart = floor(yend), fpart = yend - ipart;
+    if (steep) {
+        _KmzImagePainter__plot(me, (ssize_t)ipart, x1, color, _kmz_coverage((1. - fpart) * gap));
+        _KmzImagePainter__plot(me, (ssize_t)ipart + 1, x1, color, _kmz_coverage(fpart * gap));
+    } else {
+        _KmzImagePainter__plot(me, x1, (ssize_t)ipart, color, _kmz_coverage((1. - fpart) * gap));
+        _KmzImagePainter__plot(me, x1, (ssize_t)ipart + 1, color, _kmz_coverage(fpart * gap));
+    }
+    double intery = yend + gradient;
+
+    xend = floor(end.x + .5);
+    yend = end.y + gradient * (xend - end.x);
+    gap = end.x + .5 - floor(end.x + .5);
+    const ssize_t x2 = (ssize_t)xend;
+    if (x2 != x1) {
+        ipart = floor(yend);
+        fpart = yend - ipart;
+        if (steep) {
+            _KmzImagePainter__plot(me, (ssize_t)ipart, x2, color, _kmz_coverage((1. - fpart) * gap));
+            _KmzImagePainter__plot(me, (ssize_t)ipart + 1, x2, color, _kmz_coverage(fpart * gap));
+        } else {
+            _KmzImagePainter__plot(me, x2, (ssize_t)ipart, color, _kmz_coverage((1. - fpart) * gap));
+            _KmzImagePainter__plot(me, x2, (ssize_t)ipart + 1, color, _kmz_coverage(fpart * gap));
+        }
+    }
+
+    ssize_t x = x1 + 1;
+    const ssize_t limit = steep ? me->dimen.h : me->dimen.w, x_end = x2 < limit ? x2 : limit;
+    if (x < 0) {
+        intery += gradient * (double)-x;
+        x = 0;
+    }
+    for (; x < x_end; ++x, intery += gradient) {
+        ipart = floor(intery);
+        fpart = intery - ipart;
+        if (steep) {
+            _KmzImagePainter__plot(me, (ssize_t)ipart, x, color, _kmz_coverage(1. - fpart));
+            _KmzImagePainter__plot(me, (ssize_t)ipart + 1, x, color, _kmz_coverage(fpart));
+        } else {
+            _KmzImagePainter__plot(me, x, (ssize_t)ipart, color, _kmz_coverage(1. - fpart));
+            _KmzImagePainter__plot(me, x, (ssize_t)ipart + 1, color, _kmz_coverage(fpart));
+        }
+    }
+}
+
+static int _kmz_image_painter_edge_cmp(const void * const a, const void * const b) {
+    const double ya = ((const struct _kmz_image_painter_edge_t *)a)->y0, yb = ((const struct _kmz_image_painter_edge_t *)b)->y0;
+    return ya < yb ? -1 : ya > yb;
+}
+
+/**
+ * @par Fills a closed polygon using the even-odd rule with an active edge table.
+ *
+ * @par A pixel is filled when its center lies inside the polygon, so a polygon with integer vertices fills the same pixels as the equivalent {@link KmzRectangle}.
+ */
+static const KmzDrawStatus _KmzImagePainter__fill_polygon(struct _kmz_image_painter_t * const restrict me, const KmzPointF * const restrict points, const size_t count, const kmz_color_32 color, const KmzPattern * const restrict pattern) {
+    if (count < 3) {
+        return KMZ_DRAW_OK;
+    }
+
+    struct _kmz_image_painter_edge_t * const restrict edges = malloc(sizeof(struct _kmz_image_painter_edge_t) * count);
+    size_t * const restrict active = malloc(sizeof(size_t) * count);
+    double * const restrict xs = malloc(sizeof(double) * count);
+    if (NULL == edges || NULL == active || NULL == xs) {
+        free(edges);
+        free(active);
+        free(xs);
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    size_t edge_count = 0;
+    double min_y = INFINITY, max_y = -INFINITY;
+    for (size_t i = 0; i < count; ++i) {
+        KmzPointF a = points[i], b = points[(i + 1) % count];
+        if (a.y == b.y) {
+            continue;
+        } else if (a.y > b.y) {
+            const KmzPointF tmp = a;
+            a = b;
+            b = tmp;
+        }
+        edges[edge_count++] = (struct _kmz_image_painter_edge_t){a.y, b.y, a.x, ((double)b.x - a.x) / ((double)b.y - a.y)};
+        min_y = a.y < min_y ? a.y : min_y;
+        max_y = b.y > max_y ? b.y : max_y;
+    }
+    qsort(edges, edge_count, sizeof(struct _kmz_image_painter_edge_t), &_kmz_image_painter_edge_cmp);
+
+    const double first = ceil(min_y - .5), last = ceil(max_y - .5) - 1.;
+    if (!(first < me->dimen.h && last >= 0.)) {
+        free(edges);
+        free(active);
+        free(xs);
+        return KMZ_DRAW_OK;
+    }
+    const ssize_t y_end = last < me->dimen.h - 1 ? (ssize_t)last : me->dimen.h - 1;
+    ssize_t y = first > 0. ? (ssize_t)first : 0;
+    size_t next = 0, active_count = 0;
+
+    for (; y <= y_end; ++y) {
+        const double center = y + .5;
+        while (next < edge_count && edges[next].y0 <= center) {
+            active[active_count++] = next++;
+        }
+
+        size_t crossings = 0;
+        for (size_t i = 0; i < active_count;) {
+            const struct _kmz_image_painter_edge_t * const restrict edge = &edges[active[i]];
+            if (edge->y1 <= center) {
+                active[i] = active[--active_count];
+                continue;
+            } else if (edge->y0 <= center) {
+                const double x = edge->x0 + (center - edge->y0) * edge->dxdy;
+                size_t j = crossings++;
+                for (; j > 0 && xs[j - 1] > x; --j) {
+                    xs[j] = xs[j - 1];
+                }
+                xs[j] = x;
+            }
+            ++i;
+        }
+
+        for (size_t i = 0; i + 1 < crossings; i += 2) {
+            const double x0 = ceil(xs[i] - .5), x1 = ceil(xs[i + 1] - .5) - 1.;
+            if (x1 < 0. || x0 >= me->dimen.w || x0 > x1) {
+                continue;
+            }
+            _KmzImagePainter__fill_span(me, y, x0 < 0. ? 0 : (ssize_t)x0, x1 >= me->dimen.w ? me->dimen.w - 1 : (ssize_t)x1, color, pattern);
+        }
+    }
+
+    free(edges);
+    free(active);
+    free(xs);
+    return KMZ_DRAW_OK;
+}
+
+static inline const uint64_t _kmz_isqrt(const uint64_t value) {
+    uint64_t root = (uint64_t)sqrt((double)value);
+    while (root * root > value) {
+        --root;
+    }
+    while ((root + 1) * (root + 1) <= value) {
+        ++root;
+    }
+    return root;
+}
+
+/**
+ * @par Computes the half width of a single row of a circle with the provided radius, or -1 if the row lies outside of the circle.
+ *
+ * @par This matches the midpoint algorithm without walking it, which keeps an error of `x * (x - 1) + (y + 1)^2 - radius^2` while it steps along the first octant. The row is either reached as `y` within that octant, where `x` is the largest value with `x * (x - 1) + y^2 < radius^2`, or as the mirrored `x`, where the furthest `y` is the largest value with `x * (x - 1) + y^2 < radius^2`.
+ */
+static const ssize_t _kmz_image_painter_circle_extent(const size_t radius, const size_t row) {
+    if (row > radius) {
+        return -1;
+    }
+
+    const uint64_t r2 = (uint64_t)radius * radius, j = row, k = r2 - j * j;
+    const uint64_t across = k ? (_kmz_isqrt(4 * k - 3) + 1) / 2 : 0, along = r2 - j * (j ? j - 1 : 0);
+    ssize_t extent = 0;
+    if (across >= j) {
+        extent = (ssize_t)across;
+    }
+    if (along) {
+        const uint64_t y = _kmz_isqrt(along - 1);
+        extent = y <= j && (ssize_t)y > extent ? (ssize_t)y : extent;
+    }
+    return extent;
+}
+
+/**
+ * @par Draws a circle one span per row, filling it with `fill` and stroking a ring `thickness` pixels wide around its edge with `stroke`.
+ *
+ * @par A ring 1 pixel wide holds the pixels of the midpoint circle that touch its outside, while wider rings remove the midpoint circle of the reduced radius. Either `fill` or `stroke` may be {@link NULL} to skip that part of the circle.
+ */
+static const KmzDrawStatus _KmzImagePainter__fill_circle(struct _kmz_image_painter_t * const restrict me, const KmzPoint center, const size_t radius, const size_t thickness, const KmzBrush * const restrict fill, const kmz_color_32 * const restrict stroke) {
+    if (radius > _KMZ_IMAGE_PAINTER_MAX_RADIUS) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    // Only the rows that cross the image are computed, so the cost of a circle doesn't grow with the part of it that lies outside of the image.
+    const ssize_t y_start = center.y - (ssize_t)radius < 0 ? 0 : center.y - (ssize_t)radius,
+                  y_end = center.y + (ssize_t)radius >= me->dimen.h ? me->dimen.h - 1 : center.y + (ssize_t)radius;
+    for (ssize_t y = y_start; y <= y_end; ++y) {
+        const size_t row = (size_t)(y < center.y ? center.y - y : y - center.y);
+        const ssize_t outer = _kmz_image_painter_circle_extent(radius, row);
+        ssize_t inner = outer;
+        if (NULL != stroke && thickness > radius) {
+            inner = -1;
+        } else if (NULL != stroke && thickness <= 1) {
+            const ssize_t next = _kmz_image_painter_circle_extent(radius, row + 1);
+            inner = next < outer - 1 ? next : outer - 1;
+        } else if (NULL != stroke) {
+            inner = _kmz_image_painter_circle_extent(radius - thickness, row);
+        }
+
+        if (NULL != stroke && inner < 0) {
+            _KmzImagePainter__fill_span(me, y, center.x - outer, center.x + outer, *stroke, NULL);
+            continue;
+        } else if (NULL != stroke) {
+            _KmzImagePainter__fill_span(me, y, center.x - outer, center.x - inner - 1, *stroke, NULL);
+            _KmzImagePainter__fill_span(me, y, center.x + inner + 1, center.x + outer, *stroke, NULL);
+        }
+        if (NULL != fill && inner >= 0) {
+            _KmzImagePainter__fill_span(me, y, center.x - inner, center.x + inner, fill->color, fill->pattern);
+        }
+    }
+    return KMZ_DRAW_OK;
+}
+
+// endregion;
+
+// region Helpers:
+
+static inline const KmzBool _KmzImagePainter__has_pen(const struct _kmz_image_painter_t * const restrict me) {
+    return _kmz_draw_opacity(me->pen.color) ? KMZ_TRUE : KMZ_FALSE;
+}
+
+static inline const KmzBool _KmzImagePainter__has_brush(const struct _kmz_image_painter_t * const restrict me) {
+    return NULL != me->brush.pattern || _kmz_draw_opacity(me->brush.color) ? KMZ_TRUE : KMZ_FALSE;
+}
+
+static inline const size_t _KmzImagePainter__pen_thickness(const struct _kmz_image_painter_t * const restrict me) {
+    return me->pen.width > 1.f ? (size_t)lroundf(me->pen.width) : 1;
+}
+
+static inline const ssize_t _KmzImagePainter__pen_margin(const struct _kmz_image_painter_t * const restrict me) {
+    return (ssize_t)ceilf(me->pen.width > 1.f ? me->pen.width / 2.f : 0.f) + 1;
+}
+
+static const KmzBool _KmzImagePainter__reserve(struct _kmz_image_painter_t * const restrict me) {
+    if (NULL == me->line) {
+        me->line = malloc(sizeof(kmz_color_32) * (me->dimen.w ? me->dimen.w : 1));
+    }
+    return NULL != me->line ? KMZ_TRUE : KMZ_FALSE;
+}
+
+/**
+ * Strokes a line with the pen without recording it, drawing pens wider than a pixel as a filled quadrilateral.
+ */
+static const KmzDrawStatus _KmzImagePainter__stroke(struct _kmz_image_painter_t * const restrict me, const KmzPointF start, const KmzPointF end) {
+    if (me->pen.width > 1.f) {
+        const double dx = (double)end.x - start.x, dy = (double)end.y - start.y, length = sqrt(dx * dx + dy * dy);
+        const double half = me->pen.width / 2.;
+        // Pixel centers of integer lines lie on integer coordinates, so the outline is shifted by half a pixel to match the filler.
+        const double nx = 0. == length ? half : -dy / length * half, ny = 0. == length ? half : dx / length * half,
+                     sx = start.x + .5, sy = start.y + .5, ex = end.x + .5, ey = end.y + .5;
+        KmzPointF quad[4];
+        if (0. == length) {
+            quad[0] = kmz_pointf((float)(sx - nx), (float)(sy - ny));
+            quad[1] = kmz_pointf((float)(sx + nx), (float)(sy - ny));
+            quad[2] = kmz_pointf((float)(sx + nx), (float)(sy + ny));
+            quad[3] = kmz_pointf((float)(sx - nx), (float)(sy + ny));
+        } else {
+            quad[0] = kmz_pointf((float)(sx + nx), (float)(sy + ny));
+            quad[1] = kmz_pointf((float)(ex + nx), (float)(ey + ny));
+            quad[2] = kmz_pointf((float)(ex - nx), (float)(ey - ny));
+            quad[3] = kmz_pointf((float)(sx - nx), (float)(sy - ny));
+        }
+        return _KmzImagePainter__fill_polygon(me, quad, 4, me->pen.color, NULL);
+    }
+
+    // Thin lines only step through the part of them within the image, but their ends must still fit within the integers that step through them.
+    KmzPointF a = start, b = end;
+    if (!_KmzImagePainter__clip(me, &a, &b, _KMZ_IMAGE_PAINTER_FAR / 2.)) {
+        return KMZ_DRAW_OK;
+    } else if (me->pen.antialias) {
+        _KmzImagePainter__wu(me, a, b, me->pen.color);
+    } else {
+        _KmzImagePainter__bresenham(me, kmz_point((ssize_t)lroundf(a.x), (ssize_t)lroundf(a.y)), kmz_point((ssize_t)lroundf(b.x), (ssize_t)lroundf(b.y)), me->pen.color);
+    }
+    return KMZ_DRAW_OK;
+}
+
+/**
+ * Computes the pixels covered by a float rectangle, which are the pixels whose centers lie within it.
+ */
+static const KmzBool _kmz_image_painter_rectangle_bounds(const KmzRectangleF rectangle, ssize_t * const restrict bounds) {
+    const double x0 = ceil(rectangle.pos.x - .5), y0 = ceil(rectangle.pos.y - .5),
+                 x1 = ceil((double)rectangle.pos.x + rectangle.size.w - .5) - 1., y1 = ceil((double)rectangle.pos.y + rectangle.size.h - .5) - 1.;
+    if (!(x0 <= x1 && y0 <= y1) || fabs(x0) > INT32_MAX || fabs(y0) > INT32_MAX || fabs(x1) > INT32_MAX || fabs(y1) > INT32_MAX) {
+        return KMZ_FALSE;
+    }
+    bounds[0] = (ssize_t)x0;
+    bounds[1] = (ssize_t)y0;
+    bounds[2] = (ssize_t)x1;
+    bounds[3] = (ssize_t)y1;
+    return KMZ_TRUE;
+}
+
+/**
+ * Draws the inclusive rectangle [x0, x1] by [y0, y1], filling it with the brush and stroking the inside of its edges with the pen.
+ */
+static const KmzDrawStatus _KmzImagePainter__draw_bounds(struct _kmz_image_painter_t * const restrict me, const ssize_t x0, const ssize_t y0, const ssize_t x1, const ssize_t y1) {
+    if (!_KmzImagePainter__reserve(me)) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    const KmzBool has_brush = _KmzImagePainter__has_brush(me), has_pen = _KmzImagePainter__has_pen(me);
+    if (!has_brush && !has_pen) {
+        return KMZ_DRAW_OK;
+    }
+
+    const KmzDrawStatus status = _KmzImagePainter__record(me, x0, y0, x1, y1);
+    if (KMZ_DRAW_OK != status) {
+        return status;
+    }
+
+    const ssize_t t = has_pen ? (ssize_t)_KmzImagePainter__pen_thickness(me) : 0;
+    const ssize_t y_start = y0 < 0 ? 0 : y0, y_end = y1 >= me->dimen.h ? me->dimen.h - 1 : y1;
+    for (ssize_t y = y_start; y <= y_end; ++y) {
+        if (has_pen && (y < y0 + t || y > y1 - t || 2 * t > x1 - x0)) {
+            _KmzImagePainter__fill_span(me, y, x0, x1, me->pen.color, NULL);
+            continue;
+        } else if (has_pen) {
+            _KmzImagePainter__fill_span(me, y, x0, x0 + t - 1, me->pen.color, NULL);
+            _KmzImagePainter__fill_span(me, y, x1 - t + 1, x1, me->pen.color, NULL);
+        }
+        if (has_brush) {
+            _KmzImagePainter__fill_span(me, y, x0 + t, x1 - t, me->brush.color, me->brush.pattern);
+        }
+    }
+    return KMZ_DRAW_OK;
+}
+
+// endregion;
+
+static struct _kmz_image_painter_t * const _KmzImagePainter__new(void) {
+    struct _kmz_image_painter_t * const restrict me = malloc(sizeof(struct _kmz_image_painter_t));
+
+    if (NULL != me) {
+        me->image = NULL;
+        me->dimen = KmzSize__ZERO;
+        me->brush = KmzBrush__TRANSPARENT;
+        me->pen = KmzPen__TRANSPARENT;
+        me->line = NULL;
+        me->history = 0;
+        me->undo = NULL;
+        me->undo_count = 0;
+        me->redo = NULL;
+        me->redo_count = 0;
+    }
+
+    return me;
+}
+
+static void _KmzImagePainter__ctor(struct _kmz_image_painter_t * const restrict me, const struct _kmz_image_painter_argv_t * const restrict args) {
+    me->image = args->image;
+    me->dimen = KmzImage__dimen(args->image);
+    me->history = args->history;
+    if (me->history) {
+        me->undo = malloc(sizeof(struct _kmz_image_painter_snapshot_t) * me->history);
+        me->redo = malloc(sizeof(struct _kmz_image_painter_snapshot_t) * me->history);
+        if (NULL == me->undo || NULL == me->redo) {
+            free(me->undo);
+            free(me->redo);
+            me->undo = me->redo = NULL;
+            me->history = 0;
+        }
+    }
+    _KmzImagePainter__reserve(me);
+}
+
+static void _KmzImagePainter__dtor(struct _kmz_image_painter_t * const restrict me) {
+    _kmz_image_painter_snapshots_clear(me->undo, &me->undo_count);
+    _kmz_image_painter_snapshots_clear(me->redo, &me->redo_count);
+    free(me->undo);
+    free(me->redo);
+    free(me->line);
+    free(me);
+}
+
+static const KmzBrush _KmzImagePainter__brush(const struct _kmz_image_painter_t * const restrict me) {
+    return me->brush;
+}
+
+static void _KmzImagePainter__set_brush(struct _kmz_image_painter_t * const restrict me, const KmzBrush brush) {
+    me->brush = brush;
+}
+
+static const KmzPen _KmzImagePainter__pen(const struct _kmz_image_painter_t * const restrict me) {
+    return me->pen;
+}
+
+static void _KmzImagePainter__set_pen(struct _kmz_image_painter_t * const restrict me, const KmzPen pen) {
+    me->pen = pen;
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_linef(struct _kmz_image_painter_t * const restrict me, const KmzLineF line) {
+    if (!_kmz_image_painter_is_finite(line.start) || !_kmz_image_painter_is_finite(line.end)) {
+        return KMZ_DRAW_ERR_INVALID_GEOMETRY;
+    } else if (!_KmzImagePainter__has_pen(me)) {
+        return KMZ_DRAW_OK;
+    } else if (!_KmzImagePainter__reserve(me)) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    const ssize_t margin = _KmzImagePainter__pen_margin(me);
+    const KmzDrawStatus status = _KmzImagePainter__record(me,
+            _kmz_image_painter_coordinate(floorf(fminf(line.start.x, line.end.x))) - margin, _kmz_image_painter_coordinate(floorf(fminf(line.start.y, line.end.y))) - margin,
+            _kmz_image_painter_coordinate(ceilf(fmaxf(line.start.x, line.end.x))) + margin, _kmz_image_painter_coordinate(ceilf(fmaxf(line.start.y, line.end.y))) + margin);
+    if (KMZ_DRAW_OK != status) {
+        return status;
+    }
+    return _KmzImagePainter__stroke(me, line.start, line.end);
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_line(struct _kmz_image_painter_t * const restrict me, const KmzLine line) {
+    return _KmzImagePainter__draw_linef(me, kmz_linef(kmz_pointf((float)line.start.x, (float)line.start.y), kmz_pointf((float)line.end.x, (float)line.end.y)));
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_point(struct _kmz_image_painter_t * const restrict me, const KmzPoint point) {
+    if (!_KmzImagePainter__has_pen(me)) {
+        return KMZ_DRAW_OK;
+    } else if (!_KmzImagePainter__reserve(me)) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    const ssize_t margin = _KmzImagePainter__pen_margin(me);
+    const KmzDrawStatus status = _KmzImagePainter__record(me, point.x - margin, point.y - margin, point.x + margin, point.y + margin);
+    if (KMZ_DRAW_OK != status) {
+        return status;
+    } else if (me->pen.width > 1.f) {
+        const KmzBrush fill = {me->pen.color, NULL};
+        return _KmzImagePainter__fill_circle(me, point, (size_t)lroundf((me->pen.width - 1.f) / 2.f), 0, &fill, NULL);
+    }
+    _KmzImagePainter__fill_span(me, point.y, point.x, point.x, me->pen.color, NULL);
+    return KMZ_DRAW_OK;
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_pointf(struct _kmz_image_painter_t * const restrict me, const KmzPointF point) {
+    if (!_kmz_image_painter_is_finite(point)) {
+        return KMZ_DRAW_ERR_INVALID_GEOMETRY;
+    }
+    return _KmzImagePainter__draw_point(me, kmz_point(_kmz_image_painter_coordinate(round(point.x)), _kmz_image_painter_coordinate(round(point.y))));
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_polygonf(struct _kmz_image_painter_t * const restrict me, const KmzPolygonF polygon) {
+    for (size_t i = 0; i < polygon.count; ++i) {
+        if (!_kmz_image_painter_is_finite(polygon.points[i])) {
+            return KMZ_DRAW_ERR_INVALID_GEOMETRY;
+        }
+    }
+
+    const KmzBool has_brush = polygon.closed && polygon.count >= 3 && _KmzImagePainter__has_brush(me), has_pen = _KmzImagePainter__has_pen(me);
+    if (0 == polygon.count || (!has_brush && !has_pen)) {
+        return KMZ_DRAW_OK;
+    } else if (!_KmzImagePainter__reserve(me)) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    float min_x = polygon.points[0].x, min_y = polygon.points[0].y, max_x = min_x, max_y = min_y;
+    for (size_t i = 1; i < polygon.count; ++i) {
+        min_x = fminf(min_x, polygon.points[i].x);
+        min_y = fminf(min_y, polygon.points[i].y);
+        max_x = fmaxf(max_x, polygon.points[i].x);
+        max_y = fmaxf(max_y, polygon.points[i].y);
+    }
+    const ssize_t margin = _KmzImagePainter__pen_margin(me);
+    KmzDrawStatus status = _KmzImagePainter__record(me, _kmz_image_painter_coordinate(floorf(min_x)) - margin, _kmz_image_painter_coordinate(floorf(min_y)) - margin,
+            _kmz_image_painter_coordinate(ceilf(max_x)) + margin, _kmz_image_painter_coordinate(ceilf(max_y)) + margin);
+
+    if (KMZ_DRAW_OK == status && has_brush) {
+        status = _KmzImagePainter__fill_polygon(me, polygon.points, polygon.count, me->brush.color, me->brush.pattern);
+    }
+    if (KMZ_DRAW_OK == status && has_pen) {
+        const size_t segments = polygon.closed && polygon.count > 2 ? polygon.count : polygon.count - 1;
+        if (0 == segments) {
+            status = _KmzImagePainter__stroke(me, polygon.points[0], polygon.points[0]);
+        }
+        for (size_t i = 0; i < segments && KMZ_DRAW_OK == status; ++i) {
+            status = _KmzImagePainter__stroke(me, polygon.points[i], polygon.points[(i + 1) % polygon.count]);
+        }
+    }
+    return status;
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_polygon(struct _kmz_image_painter_t * const restrict me, const KmzPolygon polygon) {
+    KmzPointF * const restrict points = malloc(sizeof(KmzPointF) * (polygon.count ? polygon.count : 1));
+    if (NULL == points) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+    for (size_t i = 0; i < polygon.count; ++i) {
+        points[i] = kmz_pointf((float)polygon.points[i].x, (float)polygon.points[i].y);
+    }
+
+    const KmzDrawStatus status = _KmzImagePainter__draw_polygonf(me, (KmzPolygonF){polygon.closed, polygon.count, points});
+    free(points);
+    return status;
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_rectangle(struct _kmz_image_painter_t * const restrict me, const KmzRectangle rectangle) {
+    if (0 == rectangle.size.w || 0 == rectangle.size.h) {
+        return KMZ_DRAW_OK;
+    }
+    return _KmzImagePainter__draw_bounds(me, rectangle.pos.x, rectangle.pos.y, rectangle.pos.x + rectangle.size.w - 1, rectangle.pos.y + rectangle.size.h - 1);
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_rectanglef(struct _kmz_image_painter_t * const restrict me, const KmzRectangleF rectangle) {
+    ssize_t bounds[4];
+    if (!_kmz_image_painter_is_finite(rectangle.pos) || !isfinite(rectangle.size.w) || !isfinite(rectangle.size.h)) {
+        return KMZ_DRAW_ERR_INVALID_GEOMETRY;
+    } else if (!_kmz_image_painter_rectangle_bounds(rectangle, bounds)) {
+        return KMZ_DRAW_OK;
+    }
+    return _KmzImagePainter__draw_bounds(me, bounds[0], bounds[1], bounds[2], bounds[3]);
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_circle(struct _kmz_image_painter_t * const restrict me, const KmzCircle circle) {
+    const KmzBool has_brush = _KmzImagePainter__has_brush(me), has_pen = _KmzImagePainter__has_pen(me);
+    if (!has_brush && !has_pen) {
+        return KMZ_DRAW_OK;
+    } else if (circle.radius > _KMZ_IMAGE_PAINTER_MAX_RADIUS || !_KmzImagePainter__reserve(me)) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    const ssize_t r = (ssize_t)circle.radius;
+    const KmzDrawStatus status = _KmzImagePainter__record(me, circle.center.x - r, circle.center.y - r, circle.center.x + r, circle.center.y + r);
+    if (KMZ_DRAW_OK != status) {
+        return status;
+    }
+    return _KmzImagePainter__fill_circle(me, circle.center, circle.radius, _KmzImagePainter__pen_thickness(me), has_brush ? &me->brush : NULL, has_pen ? &me->pen.color : NULL);
+}
+
+static const KmzDrawStatus _KmzImagePainter__draw_circlef(struct _kmz_image_painter_t * const restrict me, const KmzCircleF circle) {
+    if (!_kmz_image_painter_is_finite(circle.center) || !isfinite(circle.radius)) {
+        return KMZ_DRAW_ERR_INVALID_GEOMETRY;
+    } else if (circle.radius > (float)_KMZ_IMAGE_PAINTER_MAX_RADIUS) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+    const KmzPoint center = kmz_point(_kmz_image_painter_coordinate(round(circle.center.x)), _kmz_image_painter_coordinate(round(circle.center.y)));
+    return _KmzImagePainter__draw_circle(me, kmz_circle(center, circle.radius > 0.f ? (size_t)lroundf(circle.radius) : 0));
+}
+
+static const KmzDrawStatus _KmzImagePainter__paint(struct _kmz_image_painter_t * const restrict me, const KmzPoint pos, KmzImage * const restrict image) {
+    const KmzSize dimen = KmzImage__dimen(image);
+    const ssize_t x0 = pos.x < 0 ? 0 : pos.x, y0 = pos.y < 0 ? 0 : pos.y,
+                  x1 = pos.x + me->dimen.w > dimen.w ? dimen.w : pos.x + me->dimen.w,
+                  y1 = pos.y + me->dimen.h > dimen.h ? dimen.h : pos.y + me->dimen.h;
+    if (x0 >= x1 || y0 >= y1) {
+        return KMZ_DRAW_OK;
+    } else if (!_KmzImagePainter__reserve(me)) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    const size_t count = (size_t)(x1 - x0);
+    kmz_color_32 * const restrict target = malloc(sizeof(kmz_color_32) * count);
+    if (NULL == target) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+
+    for (ssize_t y = y0; y < y1; ++y) {
+        KmzImage__read_row_span(me->image, kmz_point(x0 - pos.x, y - pos.y), count, me->line);
+        KmzImage__read_row_span(image, kmz_point(x0, y), count, target);
+        for (size_t i = 0; i < count; ++i) {
+            target[i] = _kmz_draw_blend(target[i], me->line[i], 255u);
+        }
+        KmzImage__write_row_span(image, kmz_point(x0, y), count, target);
+    }
+
+    free(target);
+    return KMZ_DRAW_OK;
+}
+
+static const KmzBool _KmzImagePainter__undo(struct _kmz_image_painter_t * const restrict me) {
+    return _KmzImagePainter__restore(me, me->undo, &me->undo_count, me->redo, &me->redo_count);
+}
+
+static const KmzBool _KmzImagePainter__redo(struct _kmz_image_painter_t * const restrict me) {
+    return _KmzImagePainter__restore(me, me->redo, &me->redo_count, me->undo, &me->undo_count);
+}
+
+const KmzPainterType kmz_image_painter = {
+    ._new=(void * const (*)(void))&_KmzImagePainter__new,
+    ._ctor=(void (*)(void * const restrict, const void * const restrict))&_KmzImagePainter__ctor,
+    ._dtor=(void (*)(void * const restrict))&_KmzImagePainter__dtor,
+    .brush=(const KmzBrush (*)(void * const restrict))&_KmzImagePainter__brush,
+    .set_brush=(void (*)(void * const restrict, const KmzBrush))&_KmzImagePainter__set_brush,
+    .pen=(const KmzPen (*)(void * const restrict))&_KmzImagePainter__pen,
+    .set_pen=(void (*)(void * const restrict, const KmzPen))&_KmzImagePainter__set_pen,
+    .draw_line=(const KmzDrawStatus (*)(void * const restrict, const KmzLine))&_KmzImagePainter__draw_line,
+    .draw_linef=(const KmzDrawStatus (*)(void * const restrict, const KmzLineF))&_KmzImagePainter__draw_linef,
+    .draw_point=(const KmzDrawStatus (*)(void * const restrict, const KmzPoint))&_KmzImagePainter__draw_point,
+    .draw_pointf=(const KmzDrawStatus (*)(void * const restrict, const KmzPointF))&_KmzImagePainter__draw_pointf,
+    .draw_polygon=(const KmzDrawStatus (*)(void * const restrict, const KmzPolygon))&_KmzImagePainter__draw_polygon,
+    .draw_polygonf=(const KmzDrawStatus (*)(void * const restrict, const KmzPolygonF))&_KmzImagePainter__draw_polygonf,
+    .draw_rectangle=(const KmzDrawStatus (*)(void * const restrict, const KmzRectangle))&_KmzImagePainter__draw_rectangle,
+    .draw_rectanglef=(const KmzDrawStatus (*)(void * const restrict, const KmzRectangleF))&_KmzImagePainter__draw_rectanglef,
+    .draw_circle=(const KmzDrawStatus (*)(void * const restrict, const KmzCircle))&_KmzImagePainter__draw_circle,
+    .draw_circlef=(const KmzDrawStatus (*)(void * const restrict, const KmzCircleF))&_KmzImagePainter__draw_circlef,
+    .paint=(const KmzDrawStatus (*)(void * const restrict, const KmzPoint, KmzImage * const restrict))&_KmzImagePainter__paint,
+    .undo=(const KmzBool (*)(void * const restrict))&_KmzImagePainter__undo,
+    .redo=(const KmzBool (*)(void * const restrict))&_KmzImagePainter__redo
+};
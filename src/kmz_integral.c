@@ -0,0 +1,455 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_integral.h"
+
+#define _KMZ_INTEGRAL_BAND_ROWS 16
+/**
+ * The number of pixels of each strip of columns accumulated down the table by a single unit of work.
+ */
+#define _KMZ_INTEGRAL_STRIP 256
+
+/**
+ * The number of pixels up to which no channel of an image can sum past 32 bits.
+ */
+#define _KMZ_INTEGRAL_NARROW_PIXELS (UINT32_MAX / 255)
+
+/**
+ * Every row of the tables begins with a column of zeros and the tables begin with a row of zeros, so the sum of any area is 4 lookups. The sums are
+ * kept in 32 bits whenever no area of the image can sum past 32 bits, which halves the memory that is written and read by every filter. The squares
+ * are always kept in 64 bits.
+ */
+struct kmz_integral_image_t {
+    KmzSize dimen;
+    size_t stride;
+    uint32_t * sums_32;
+    uint64_t * sums_64;
+    uint64_t * squares;
+};
+
+struct _kmz_integral_t {
+    const KmzImage * image;
+    KmzIntegralImage * me;
+    KmzImage * output;
+    float * variances;
+    size_t radius;
+    kmz_color_32 ** lines;
+    pthread_mutex_t lock;
+    KmzPixelOperationStatus status;
+};
+
+static inline void _kmz_integral_fail(struct _kmz_integral_t * const restrict ctx, const KmzPixelOperationStatus status) {
+    KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+    __atomic_compare_exchange_n(&ctx->status, &expected, status, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+static inline kmz_color_32 * const _kmz_integral_line(struct _kmz_integral_t * const restrict ctx, const size_t worker, const size_t count) {
+    if (NULL == ctx->lines[worker]) {
+        ctx->lines[worker] = malloc(count * sizeof(kmz_color_32));
+    }
+    return ctx->lines[worker];
+}
+
+/**
+ * Writes the sums of the alpha, red, green and blue channels within `[x0, x1)` and `[y0, y1)` of a table.
+ */
+static inline void _kmz_integral_area(const uint64_t * const restrict table, const size_t stride, const size_t x0, const size_t y0, const size_t x1,
+        const size_t y1, uint64_t * const restrict sums) {
+    const uint64_t * const restrict top = table + y0 * stride, * const restrict bottom = table + y1 * stride;
+    for (size_t c = 0; c < 4; ++c) {
+        sums[c] = bottom[4 * x1 + c] - bottom[4 * x0 + c] - top[4 * x1 + c] + top[4 * x0 + c];
+    }
+}
+
+/**
+ * Writes the sums of the channels within an area of whichever table of sums is kept, where the 32-bit sums wrap around exactly.
+ */
+static inline void _kmz_integral_sums(const KmzIntegralImage * const restrict me, const size_t x0, const size_t y0, const size_t x1, const size_t y1,
+        uint64_t * const restrict sums) {
+    if (NULL == me->sums_32) {
+        _kmz_integral_area(me->sums_64, me->stride, x0, y0, x1, y1, sums);
+        return;
+    }
+
+    const uint32_t * const restrict top = me->sums_32 + y0 * me->stride, * const restrict bottom = me->sums_32 + y1 * me->stride;
+    for (size_t c = 0; c < 4; ++c) {
+        sums[c] = (uint32_t)(bottom[4 * x1 + c] - bottom[4 * x0 + c] - top[4 * x1 + c] + top[4 * x0 + c]);
+    }
+}
+
+// region Construction:
+
+/**
+ * Sums a band of rows from left to right, which is the row parallel half of the prefix sum.
+ */
+static void _KmzIntegralImage__scan_rows(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_integral_t * const restrict ctx = arg;
+    if (__atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_PIXEL_OP_OK) {
+        return;
+    }
+
+    const KmzIntegralImage * const restrict me = ctx->me;
+    const size_t w = me->dimen.w, y0 = index * _KMZ_INTEGRAL_BAND_ROWS,
+          y1 = y0 + _KMZ_INTEGRAL_BAND_ROWS < me->dimen.h ? y0 + _KMZ_INTEGRAL_BAND_ROWS : me->dimen.h;
+    kmz_color_32 * const restrict line = _kmz_integral_line(ctx, worker, w);
+    if (NULL == line) {
+        _kmz_integral_fail(ctx, KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY);
+        return;
+    }
+
+    for (size_t y = y0; y < y1; ++y) {
+        const KmzPixelOperationStatus status = KmzImage__read_row_span(ctx->image, kmz_point(0, (ssize_t)y), w, line);
+        if (KMZ_PIXEL_OP_OK != status) {
+            _kmz_integral_fail(ctx, status);
+            return;
+        }
+
+        const size_t offset = (y + 1) * me->stride;
+        uint32_t * const restrict sums_32 = NULL == me->sums_32 ? NULL : me->sums_32 + offset;
+        uint64_t * const restrict sums_64 = NULL == me->sums_64 ? NULL : me->sums_64 + offset,
+                 * const restrict squares = NULL == me->squares ? NULL : me->squares + offset;
+        uint64_t s[4] = {0}, q[4] = {0};
+        for (size_t x = 0; x < w; ++x) {
+            const uint64_t v[4] = {(line[x] >> 24) & 0x7F, (line[x] >> 16) & 0xFF, (line[x] >> 8) & 0xFF, line[x] & 0xFF};
+            for (size_t c = 0; c < 4; ++c) {
+                s[c] += v[c];
+            }
+            if (NULL != sums_32) {
+                for (size_t c = 0; c < 4; ++c) {
+                    sums_32[4 * (x + 1) + c] = (uint32_t)s[c];
+                }
+            } else {
+                for (size_t c = 0; c < 4; ++c) {
+                    sums_64[4 * (x + 1) + c] = s[c];
+                }
+            }
+            if (NULL != squares) {
+                for (size_t c = 0; c < 4; ++c) {
+                    q[c] += v[c] * v[c];
+                    squares[4 * (x + 1) + c] = q[c];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Accumulates a strip of columns from top to bottom, which is the column parallel half of the prefix sum.
+ */
+static void _KmzIntegralImage__scan_columns(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_integral_t * const restrict ctx = arg;
+    const KmzIntegralImage * const restrict me = ctx->me;
+    const size_t first = 4 * (1 + index * _KMZ_INTEGRAL_STRIP), last = first + 4 * _KMZ_INTEGRAL_STRIP < me->stride ? first + 4 * _KMZ_INTEGRAL_STRIP : me->stride;
+    (void)worker;
+
+    if (NULL != me->sums_32) {
+        for (size_t y = 2; y <= me->dimen.h; ++y) {
+            const uint32_t * const restrict above = me->sums_32 + (y - 1) * me->stride;
+            uint32_t * const restrict row = me->sums_32 + y * me->stride;
+            for (size_t i = first; i < last; ++i) {
+                row[i] += above[i];
+            }
+        }
+    }
+
+    for (size_t table = 0; table < 2; ++table) {
+        uint64_t * const restrict values = table ? me->squares : me->sums_64;
+        if (NULL == values) {
+            continue;
+        }
+        for (size_t y = 2; y <= me->dimen.h; ++y) {
+            const uint64_t * const restrict above = values + (y - 1) * me->stride;
+            uint64_t * const restrict row = values + y * me->stride;
+            for (size_t i = first; i < last; ++i) {
+                row[i] += above[i];
+            }
+        }
+    }
+}
+
+KmzIntegralImage * const KmzIntegralImage__new(const KmzImage * const image, const KmzBool squares, const size_t threads) {
+    const KmzSize dimen = KmzImage__dimen(image);
+    KmzIntegralImage * const restrict me = calloc(1, sizeof(KmzIntegralImage));
+    if (NULL == me) {
+        return NULL;
+    }
+
+    me->dimen = dimen;
+    me->stride = 4 * ((size_t)dimen.w + 1);
+    const size_t count = me->stride * ((size_t)dimen.h + 1);
+    if ((size_t)dimen.w * dimen.h <= _KMZ_INTEGRAL_NARROW_PIXELS) {
+        me->sums_32 = malloc(count * sizeof(uint32_t));
+    } else {
+        me->sums_64 = malloc(count * sizeof(uint64_t));
+    }
+    me->squares = squares ? malloc(count * sizeof(uint64_t)) : NULL;
+    if ((NULL == me->sums_32 && NULL == me->sums_64) || (squares && NULL == me->squares)) {
+        KmzIntegralImage__free(me);
+        return NULL;
+    }
+
+    // Only the leading row and column are never written by the scans.
+    for (size_t y = 0; y <= dimen.h; ++y) {
+        const size_t length = y ? 4 : me->stride;
+        if (NULL != me->sums_32) {
+            memset(me->sums_32 + y * me->stride, 0, length * sizeof(uint32_t));
+        } else {
+            memset(me->sums_64 + y * me->stride, 0, length * sizeof(uint64_t));
+        }
+        if (squares) {
+            memset(me->squares + y * me->stride, 0, length * sizeof(uint64_t));
+        }
+    }
+
+    if (!dimen.w || !dimen.h) {
+        return me;
+    }
+
+    const size_t bands = ((size_t)dimen.h + _KMZ_INTEGRAL_BAND_ROWS - 1) / _KMZ_INTEGRAL_BAND_ROWS,
+          strips = ((size_t)dimen.w + _KMZ_INTEGRAL_STRIP - 1) / _KMZ_INTEGRAL_STRIP,
+          workers = _kmz_parallel_workers(threads, bands);
+    struct _kmz_integral_t ctx = {
+        .image = image,
+        .me = me,
+        .lines = calloc(workers, sizeof(kmz_color_32 *)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (NULL == ctx.lines) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        _kmz_parallel_for(workers, bands, &_KmzIntegralImage__scan_rows, &ctx);
+        if (KMZ_PIXEL_OP_OK == ctx.status) {
+            _kmz_parallel_for(_kmz_parallel_workers(threads, strips), strips, &_KmzIntegralImage__scan_columns, &ctx);
+        }
+        for (size_t i = 0; i < workers; ++i) {
+            free(ctx.lines[i]);
+        }
+    }
+
+    free(ctx.lines);
+    if (KMZ_PIXEL_OP_OK != ctx.status) {
+        KmzIntegralImage__free(me);
+        return NULL;
+    }
+    return me;
+}
+
+void KmzIntegralImage__free(KmzIntegralImage * const restrict me) {
+    free(me->sums_32);
+    free(me->sums_64);
+    free(me->squares);
+    free(me);
+}
+
+// endregion;
+
+const KmzSize KmzIntegralImage__dimen(const KmzIntegralImage * const restrict me) {
+    return me->dimen;
+}
+
+static const KmzPixelOperationStatus _kmz_integral_sum(const KmzIntegralImage * const restrict me, const KmzBool squares, const KmzRectangle area,
+        uint64_t * const restrict sums) {
+    const ssize_t x = kmz_clamp(area.pos.x, 0, me->dimen.w),
+          y = kmz_clamp(area.pos.y, 0, me->dimen.h),
+          max_x = kmz_clamp(area.size.w + x, x, me->dimen.w),
+          max_y = kmz_clamp(area.size.h + y, y, me->dimen.h);
+
+    if (squares) {
+        _kmz_integral_area(me->squares, me->stride, (size_t)x, (size_t)y, (size_t)max_x, (size_t)max_y, sums);
+    } else {
+        _kmz_integral_sums(me, (size_t)x, (size_t)y, (size_t)max_x, (size_t)max_y, sums);
+    }
+    return KMZ_PIXEL_OP_OK;
+}
+
+const KmzPixelOperationStatus KmzIntegralImage__sum(const KmzIntegralImage * const restrict me, const KmzRectangle area, uint64_t * const restrict sums) {
+    return _kmz_integral_sum(me, KMZ_FALSE, area, sums);
+}
+
+const KmzPixelOperationStatus KmzIntegralImage__sum_squares(const KmzIntegralImage * const restrict me, const KmzRectangle area,
+        uint64_t * const restrict sums) {
+    if (NULL == me->squares) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+    return _kmz_integral_sum(me, KMZ_TRUE, area, sums);
+}
+
+// region Filters:
+
+/**
+ * Returns the bounds of the window of `radius` pixels around `i` within an axis of `length` pixels.
+ */
+static inline void _kmz_integral_window(const size_t i, const size_t radius, const size_t length, size_t * const restrict first,
+        size_t * const restrict last) {
+    *first = i > radius ? i - radius : 0;
+    *last = length - i > radius ? i + radius + 1 : length;
+}
+
+/**
+ * Divides a sum by a count rounding to nearest. A quotient that is not a tie is at least `1 / (2 * count)` away from one, which is more than
+ * 2^-38 for every count within an image, while the error of the reciprocal is below 2^-43, so the small bias rounds ties up without moving any
+ * other quotient across a boundary.
+ */
+static inline const uint32_t _kmz_integral_divide(const uint64_t sum, const double reciprocal) {
+    // The sum fits within 63 bits, so the signed conversions are exact and avoid the slower unsigned ones.
+    return (uint32_t)(int64_t)((double)(int64_t)sum * reciprocal + (.5 + 0x1p-38));
+}
+
+static void _KmzIntegralImage__filter_band(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_integral_t * const restrict ctx = arg;
+    if (__atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_PIXEL_OP_OK) {
+        return;
+    }
+
+    const KmzIntegralImage * const restrict me = ctx->me;
+    const size_t w = me->dimen.w, h = me->dimen.h, y0 = index * _KMZ_INTEGRAL_BAND_ROWS,
+          y1 = y0 + _KMZ_INTEGRAL_BAND_ROWS < h ? y0 + _KMZ_INTEGRAL_BAND_ROWS : h;
+    kmz_color_32 * const restrict out = NULL == ctx->output ? NULL : _kmz_integral_line(ctx, worker, w * _KMZ_INTEGRAL_BAND_ROWS);
+    if (NULL != ctx->output && NULL == out) {
+        _kmz_integral_fail(ctx, KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY);
+        return;
+    }
+
+    for (size_t y = y0; y < y1; ++y) {
+        size_t top, bottom;
+        uint64_t last = 0;
+        double reciprocal = 0.;
+        _kmz_integral_window(y, ctx->radius, h, &top, &bottom);
+        for (size_t x = 0; x < w; ++x) {
+            size_t left, right;
+            _kmz_integral_window(x, ctx->radius, w, &left, &right);
+            // The count only changes near the left and right edges, so the reciprocal is rarely recomputed.
+            const uint64_t count = (uint64_t)(right - left) * (bottom - top);
+            if (count != last) {
+                last = count;
+                reciprocal = 1. / (double)count;
+            }
+            uint64_t sums[4];
+            _kmz_integral_sums(me, left, top, right, bottom, sums);
+
+            if (NULL != ctx->output) {
+                out[(y - y0) * w + x] = (kmz_color_32)(_kmz_integral_divide(sums[0], reciprocal) << 24 | _kmz_integral_divide(sums[1], reciprocal) << 16
+                        | _kmz_integral_divide(sums[2], reciprocal) << 8 | _kmz_integral_divide(sums[3], reciprocal));
+            } else {
+                uint64_t squares[4];
+                float * const restrict variances = ctx->variances + 4 * (y * w + x);
+                _kmz_integral_area(me->squares, me->stride, left, top, right, bottom, squares);
+                for (size_t c = 0; c < 4; ++c) {
+                    const double mean = (double)(int64_t)sums[c] * reciprocal, variance = (double)(int64_t)squares[c] * reciprocal - mean * mean;
+                    variances[c] = (float)(variance > 0. ? variance : 0.);
+                }
+            }
+        }
+    }
+
+    if (NULL != ctx->output) {
+        pthread_mutex_lock(&ctx->lock);
+        const KmzPixelOperationStatus status = KmzImage__write_argb_block(ctx->output,
+                kmz_rectangle(kmz_point(0, (ssize_t)y0), kmz_size((uint16_t)w, (uint16_t)(y1 - y0))), out);
+        pthread_mutex_unlock(&ctx->lock);
+        if (KMZ_PIXEL_OP_OK != status) {
+            _kmz_integral_fail(ctx, status);
+        }
+    }
+}
+
+static const KmzPixelOperationStatus _kmz_integral_filter(const KmzIntegralImage * const me, const size_t radius, KmzImage * const output,
+        float * const variances, const size_t threads) {
+    if (!me->dimen.w || !me->dimen.h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t bands = ((size_t)me->dimen.h + _KMZ_INTEGRAL_BAND_ROWS - 1) / _KMZ_INTEGRAL_BAND_ROWS,
+          workers = _kmz_parallel_workers(threads, bands);
+    struct _kmz_integral_t ctx = {
+        .me = (KmzIntegralImage *)me,
+        .output = output,
+        .variances = variances,
+        .radius = radius,
+        .lines = calloc(workers, sizeof(kmz_color_32 *)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (NULL == ctx.lines) {
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_init(&ctx.lock, NULL);
+    _kmz_parallel_for(workers, bands, &_KmzIntegralImage__filter_band, &ctx);
+    pthread_mutex_destroy(&ctx.lock);
+
+    for (size_t i = 0; i < workers; ++i) {
+        free(ctx.lines[i]);
+    }
+    free(ctx.lines);
+    return ctx.status;
+}
+
+const KmzPixelOperationStatus KmzIntegralImage__box_blur(const KmzIntegralImage * const me, const size_t radius, KmzImage * const output,
+        const size_t threads) {
+    const KmzSize o_dimen = KmzImage__dimen(output);
+    if (o_dimen.w != me->dimen.w || o_dimen.h != me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    }
+    return _kmz_integral_filter(me, radius, output, NULL, threads);
+}
+
+const KmzPixelOperationStatus KmzIntegralImage__local_variance(const KmzIntegralImage * const me, const size_t radius, float * const variances,
+        const size_t threads) {
+    if (NULL == me->squares) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+    if (NULL == variances) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+    return _kmz_integral_filter(me, radius, NULL, variances, threads);
+}
+
+const KmzPixelOperationStatus KmzImage__box_blur(const KmzImage * const me, const size_t radius, KmzImage * const output, const size_t threads) {
+    const KmzSize dimen = KmzImage__dimen(me), o_dimen = KmzImage__dimen(output);
+    if (o_dimen.w != dimen.w || o_dimen.h != dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    }
+
+    // The table holds every sum before the output is written, so the output MAY be the image itself.
+    KmzIntegralImage * const integral = KmzIntegralImage__new(me, KMZ_FALSE, threads);
+    if (NULL == integral) {
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    const KmzPixelOperationStatus status = KmzIntegralImage__box_blur(integral, radius, output, threads);
+    KmzIntegralImage__free(integral);
+    return status;
+}
+
+// endregion;
@@ -0,0 +1,461 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_kernel.h"
+
+#define _KMZ_KERNEL_MAX_BITS 14
+
+struct kmz_kernel_t {
+    size_t size;
+    /**
+     * Every pass reads its weights in pairs, so each row of weights is padded with a 0 weight up to an even number of taps.
+     */
+    size_t taps;
+    KmzBool separable;
+    /**
+     * Separable kernels store the horizontal weights followed by the vertical weights, otherwise `size` rows of weights are stored.
+     */
+    int16_t * weights;
+    unsigned int h_shift;
+    unsigned int shift;
+    int32_t h_bound;
+};
+
+/**
+ * Converts the weights to fixed point using the most fractional bits that keep every weight within an int16_t and every sum of weights multiplied by
+ * inputs of up to `max_input` within half of an int32_t, adjusting the center weight so the fixed point weights keep the sum of the original weights.
+ *
+ * @return The number of fractional bits used, or -1 if the weights can't be represented.
+ */
+static int _kmz_kernel_quantize(const float * const restrict weights, const size_t rows, const size_t size, const size_t taps, const int32_t max_input,
+        int16_t * const restrict out, int64_t * const restrict magnitude) {
+    const size_t center = (rows / 2) * taps + size / 2;
+    double sum = 0;
+
+    for (size_t i = 0; i < rows * size; ++i) {
+        if (!isfinite(weights[i])) {
+            return -1;
+        }
+        sum += weights[i];
+    }
+
+    for (int bits = _KMZ_KERNEL_MAX_BITS; bits >= 0; --bits) {
+        const double scale = ldexp(1.0, bits);
+        KmzBool fits = KMZ_TRUE;
+        int64_t total = 0;
+
+        for (size_t r = 0; r < rows && fits; ++r) {
+            for (size_t i = 0; i < size; ++i) {
+                const long long q = llround(weights[r * size + i] * scale);
+                if (q > INT16_MAX || q < -INT16_MAX) {
+                    fits = KMZ_FALSE;
+                    break;
+                }
+                out[r * taps + i] = (int16_t)q;
+                total += q;
+            }
+        }
+        if (!fits) {
+            continue;
+        }
+
+        const int64_t c = out[center] + (llround(sum * scale) - total);
+        if (c > INT16_MAX || c < -INT16_MAX) {
+            continue;
+        }
+        out[center] = (int16_t)c;
+
+        *magnitude = 0;
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t i = 0; i < size; ++i) {
+                *magnitude += abs(out[r * taps + i]);
+            }
+        }
+        if (*magnitude * max_input <= INT32_MAX / 2) {
+            return bits;
+        }
+    }
+
+    return -1;
+}
+
+static KmzKernel * const _KmzKernel__new(const size_t size, const KmzBool separable) {
+    if (!(size & 1)) {
+        return NULL;
+    }
+
+    KmzKernel * const restrict me = malloc(sizeof(KmzKernel));
+    if (NULL == me) {
+        return NULL;
+    }
+
+    me->size = size;
+    me->taps = size + 1;
+    me->separable = separable;
+    me->weights = calloc(separable ? 2 * me->taps : size * me->taps, sizeof(int16_t));
+    me->h_shift = 0;
+    me->shift = 0;
+    me->h_bound = 0;
+
+    if (NULL == me->weights) {
+        free(me);
+        return NULL;
+    }
+    return me;
+}
+
+KmzKernel * const KmzKernel__new(const size_t size, const float * const restrict weights) {
+    if (NULL == weights) {
+        return NULL;
+    }
+
+    KmzKernel * const restrict me = _KmzKernel__new(size, KMZ_FALSE);
+    if (NULL == me) {
+        return NULL;
+    }
+
+    int64_t magnitude = 0;
+    const int bits = _kmz_kernel_quantize(weights, size, size, me->taps, UINT8_MAX, me->weights, &magnitude);
+    if (bits < 0) {
+        KmzKernel__free(me);
+        return NULL;
+    }
+    me->shift = (unsigned int)bits;
+
+    return me;
+}
+
+KmzKernel * const KmzKernel__new_from_integers(const size_t size, const int32_t * const restrict weights, const int32_t divisor) {
+    if (NULL == weights || !divisor || !size) {
+        return NULL;
+    }
+
+    float * const restrict f_weights = malloc(size * size * sizeof(float));
+    if (NULL == f_weights) {
+        return NULL;
+    }
+    for (size_t i = 0; i < size * size; ++i) {
+        f_weights[i] = (float)((double)weights[i] / divisor);
+    }
+
+    KmzKernel * const restrict me = KmzKernel__new(size, f_weights);
+    free(f_weights);
+    return me;
+}
+
+KmzKernel * const KmzKernel__new_separable(const size_t size, const float * const restrict h_weights, const float * const restrict v_weights) {
+    if (NULL == h_weights || NULL == v_weights) {
+        return NULL;
+    }
+
+    KmzKernel * const restrict me = _KmzKernel__new(size, KMZ_TRUE);
+    if (NULL == me) {
+        return NULL;
+    }
+
+    int64_t h_magnitude = 0, v_magnitude = 0;
+    const int h_bits = _kmz_kernel_quantize(h_weights, 1, size, me->taps, UINT8_MAX, me->weights, &h_magnitude);
+    if (h_bits < 0) {
+        KmzKernel__free(me);
+        return NULL;
+    }
+
+    // The horizontal pass is narrowed back to 16 bits, keeping as many fractional bits as its largest possible result allows.
+    unsigned int h_shift = 0;
+    while (((UINT8_MAX * h_magnitude) >> h_shift) + 1 > INT16_MAX) {
+        ++h_shift;
+    }
+
+    me->h_shift = h_shift;
+    me->h_bound = (int32_t)(((UINT8_MAX * h_magnitude) >> h_shift) + 1);
+
+    const int v_bits = _kmz_kernel_quantize(v_weights, 1, size, me->taps, me->h_bound, me->weights + me->taps, &v_magnitude);
+    if (v_bits < 0 || v_bits + h_bits < (int)h_shift) {
+        KmzKernel__free(me);
+        return NULL;
+    }
+    me->shift = (unsigned int)(v_bits + h_bits) - h_shift;
+
+    return me;
+}
+
+KmzKernel * const KmzKernel__new_box(const size_t size) {
+    if (!size) {
+        return NULL;
+    }
+
+    float * const restrict weights = malloc(size * sizeof(float));
+    if (NULL == weights) {
+        return NULL;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        weights[i] = 1.f / size;
+    }
+
+    KmzKernel * const restrict me = KmzKernel__new_separable(size, weights, weights);
+    free(weights);
+    return me;
+}
+
+KmzKernel * const KmzKernel__new_gaussian(const size_t size, float sigma) {
+    if (!size) {
+        return NULL;
+    }
+
+    float * const restrict weights = malloc(size * sizeof(float));
+    if (NULL == weights) {
+        return NULL;
+    }
+
+    if (sigma <= 0) {
+        sigma = 0.3f * ((size - 1) * 0.5f - 1) + 0.8f;
+    }
+
+    const ssize_t hsize = (ssize_t)(size / 2);
+    double sum = 0;
+    for (ssize_t i = -hsize; i <= hsize; ++i) {
+        sum += exp(-(double)(i * i) / (2.0 * sigma * sigma));
+    }
+    for (ssize_t i = -hsize; i <= hsize; ++i) {
+        weights[i + hsize] = (float)(exp(-(double)(i * i) / (2.0 * sigma * sigma)) / sum);
+    }
+
+    KmzKernel * const restrict me = KmzKernel__new_separable(size, weights, weights);
+    free(weights);
+    return me;
+}
+
+void KmzKernel__free(KmzKernel * const restrict me) {
+    free(me->weights);
+    free(me);
+}
+
+const size_t KmzKernel__size(const KmzKernel * const restrict me) {
+    return me->size;
+}
+
+const KmzBool KmzKernel__is_separable(const KmzKernel * const restrict me) {
+    return me->separable;
+}
+
+// region Passes:
+
+static inline const uint32_t _kmz_kernel_pair(const int16_t * const restrict weights, const size_t k) {
+    return (uint32_t)(uint16_t)weights[k] | ((uint32_t)(uint16_t)weights[k + 1] << 16);
+}
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static size_t _kmz_sse2_kernel_pass(int32_t * const restrict acc, const int16_t * const * const restrict rows,
+        const int16_t * const restrict weights, const size_t taps, const size_t count, size_t x) {
+    for (; x + 8 <= count; x += 8) {
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+
+        for (size_t k = 0; k < taps; k += 2) {
+            const __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + x)),
+                  b = _mm_loadu_si128((const __m128i *)(rows[k + 1] + x)),
+                  pair = _mm_set1_epi32((int)_kmz_kernel_pair(weights, k));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), pair));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), pair));
+        }
+
+        __m128i * const restrict out = (__m128i *)(acc + x);
+        _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), lo));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), hi));
+    }
+    return x;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_kernel_pass(int32_t * const restrict acc, const int16_t * const * const restrict rows,
+        const int16_t * const restrict weights, const size_t taps, const size_t count, size_t x) {
+    for (; x + 16 <= count; x += 16) {
+        __m256i lo = _mm256_setzero_si256(), hi = _mm256_setzero_si256();
+
+        for (size_t k = 0; k < taps; k += 2) {
+            const __m256i a = _mm256_loadu_si256((const __m256i *)(rows[k] + x)),
+                  b = _mm256_loadu_si256((const __m256i *)(rows[k + 1] + x)),
+                  pair = _mm256_set1_epi32((int)_kmz_kernel_pair(weights, k));
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), pair));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), pair));
+        }
+
+        // The unpacks work within each 128 bit lane, so lo holds x + 0..3 and x + 8..11 while hi holds x + 4..7 and x + 12..15.
+        __m256i * const restrict out = (__m256i *)(acc + x);
+        _mm256_storeu_si256(out, _mm256_add_epi32(_mm256_loadu_si256(out), _mm256_permute2x128_si256(lo, hi, 0x20)));
+        _mm256_storeu_si256(out + 1, _mm256_add_epi32(_mm256_loadu_si256(out + 1), _mm256_permute2x128_si256(lo, hi, 0x31)));
+    }
+    return x;
+}
+#endif
+
+void _kmz_kernel_pass(int32_t * const restrict acc, const int16_t * const * const restrict rows, const int16_t * const restrict weights,
+        const size_t taps, const size_t count) {
+    size_t x = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        x = _kmz_avx2_kernel_pass(acc, rows, weights, taps, count, x);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        x = _kmz_sse2_kernel_pass(acc, rows, weights, taps, count, x);
+    }
+#endif
+    for (; x < count; ++x) {
+        int32_t sum = acc[x];
+        for (size_t k = 0; k < taps; ++k) {
+            sum += (int32_t)weights[k] * rows[k][x];
+        }
+        acc[x] = sum;
+    }
+}
+
+static inline void _kmz_kernel_store(const int32_t * const restrict acc, kmz_color_32 * const restrict dst, const size_t count, const unsigned int shift,
+        const unsigned int channel) {
+    const int32_t half = shift ? (int32_t)1 << (shift - 1) : 0;
+    for (size_t x = 0; x < count; ++x) {
+        const int32_t value = (acc[x] + half) >> shift;
+        dst[x] |= (kmz_color_32)kmz_clamp(value, 0, UINT8_MAX) << channel;
+    }
+}
+
+// endregion;
+
+const size_t _kmz_kernel_scratch_size(const KmzKernel * const restrict kernel, const size_t w, const size_t h) {
+    const size_t b_w = w + 2 * (kernel->size / 2), b_h = h + 2 * (kernel->size / 2);
+    return kernel->taps * sizeof(int16_t *) + w * sizeof(int32_t) + ((b_w + 1) * b_h + (kernel->separable ? w * b_h : 0)) * sizeof(int16_t);
+}
+
+void _kmz_kernel_convolve(const KmzKernel * const restrict kernel, const kmz_color_32 * const restrict buffer, const size_t b_stride, const size_t w,
+        const size_t h, kmz_color_32 * const restrict o_buffer, const size_t o_stride, void * const restrict scratch) {
+    const size_t size = kernel->size, taps = kernel->taps, hsize = size / 2;
+
+    // The padding tap of each row reads one pixel past the buffer, so every plane row is given an extra 0.
+    const size_t b_w = w + 2 * hsize, b_h = h + 2 * hsize, stride = b_w + 1;
+    const int16_t ** const restrict rows = scratch;
+    int32_t * const restrict acc = (int32_t *)(rows + taps);
+    int16_t * const restrict plane = (int16_t *)(acc + w);
+    int16_t * const restrict inter = plane + stride * b_h;
+
+    for (size_t o_y = 0; o_y < h; ++o_y) {
+        memset(o_buffer + o_y * o_stride, 0, w * sizeof(kmz_color_32));
+    }
+
+    for (size_t c = 0; c < 4; ++c) {
+        const unsigned int channel = 24 - 8 * (unsigned int)c;
+
+        for (size_t b_y = 0; b_y < b_h; ++b_y) {
+            for (size_t b_x = 0; b_x < b_w; ++b_x) {
+                plane[b_y * stride + b_x] = (int16_t)((buffer[b_y * b_stride + b_x] >> channel) & 0xFF);
+            }
+            plane[b_y * stride + b_w] = 0;
+        }
+
+        if (kernel->separable) {
+            const int16_t * const restrict h_weights = kernel->weights, * const restrict v_weights = kernel->weights + taps;
+            const int32_t half = kernel->h_shift ? (int32_t)1 << (kernel->h_shift - 1) : 0;
+
+            for (size_t b_y = 0; b_y < b_h; ++b_y) {
+                for (size_t k = 0; k < taps; ++k) {
+                    rows[k] = plane + b_y * stride + k;
+                }
+                memset(acc, 0, w * sizeof(int32_t));
+                _kmz_kernel_pass(acc, rows, h_weights, taps, w);
+                for (size_t i = 0; i < w; ++i) {
+                    inter[b_y * w + i] = (int16_t)((acc[i] + half) >> kernel->h_shift);
+                }
+            }
+
+            for (size_t o_y = 0; o_y < h; ++o_y) {
+                for (size_t k = 0; k < size; ++k) {
+                    rows[k] = inter + (o_y + k) * w;
+                }
+                rows[size] = rows[size - 1];
+                memset(acc, 0, w * sizeof(int32_t));
+                _kmz_kernel_pass(acc, rows, v_weights, taps, w);
+                _kmz_kernel_store(acc, o_buffer + o_y * o_stride, w, kernel->shift, channel);
+            }
+        } else {
+            for (size_t o_y = 0; o_y < h; ++o_y) {
+                memset(acc, 0, w * sizeof(int32_t));
+                for (size_t r = 0; r < size; ++r) {
+                    for (size_t k = 0; k < taps; ++k) {
+                        rows[k] = plane + (o_y + r) * stride + k;
+                    }
+                    _kmz_kernel_pass(acc, rows, kernel->weights + r * taps, taps, w);
+                }
+                _kmz_kernel_store(acc, o_buffer + o_y * o_stride, w, kernel->shift, channel);
+            }
+        }
+    }
+}
+
+const KmzPixelOperationStatus KmzImage__apply_kernel(const KmzImage * const restrict me, const KmzKernel * const restrict kernel, const KmzRectangle area,
+        KmzImage * const restrict output) {
+    const KmzSize dimen = KmzImage__dimen(me);
+    const size_t hsize = kernel->size / 2;
+    const ssize_t x = kmz_clamp(area.pos.x, 0, dimen.w),
+          y = kmz_clamp(area.pos.y, 0, dimen.h),
+          max_x = kmz_clamp(area.size.w + x, x, dimen.w),
+          max_y = kmz_clamp(area.size.h + y, y, dimen.h);
+
+    const size_t w = (size_t)(max_x - x),
+          h = (size_t)(max_y - y);
+
+    if (!w || !h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t b_w = w + 2 * hsize, b_h = h + 2 * hsize;
+    const KmzRectangle c_area = kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)w, (uint16_t)h));
+
+    kmz_color_32 * const restrict buffer = malloc(b_w * b_h * sizeof(kmz_color_32));
+    kmz_color_32 * const restrict o_buffer = malloc(w * h * sizeof(kmz_color_32));
+    void * const restrict scratch = malloc(_kmz_kernel_scratch_size(kernel, w, h));
+    KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+
+    if (NULL == buffer || NULL == o_buffer || NULL == scratch) {
+        status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        status = _KmzImage__populate_buffer(me, buffer, c_area, kmz_size((uint16_t)b_w, (uint16_t)b_h), kmz_size((uint16_t)(w + hsize), (uint16_t)(h + hsize)),
+                hsize, w);
+    }
+
+    if (status == KMZ_PIXEL_OP_OK) {
+        _kmz_kernel_convolve(kernel, buffer, b_w, w, h, o_buffer, w, scratch);
+        status = KmzImage__write_argb_block(output, c_area, o_buffer);
+    }
+
+    free(buffer);
+    free(o_buffer);
+    free(scratch);
+
+    return status;
+}
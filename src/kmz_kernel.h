@@ -0,0 +1,94 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+/**
+ * |Definition                          |Header                 |
+ * |KmzKernel__new()                    |libkempozer/image.h    |
+ * |KmzKernel__new_from_integers()      |libkempozer/image.h    |
+ * |KmzKernel__new_separable()          |libkempozer/image.h    |
+ * |KmzKernel__new_box()                |libkempozer/image.h    |
+ * |KmzKernel__new_gaussian()           |libkempozer/image.h    |
+ * |KmzKernel__free()                   |libkempozer/image.h    |
+ * |KmzKernel__size()                   |libkempozer/image.h    |
+ * |KmzKernel__is_separable()           |libkempozer/image.h    |
+ * |KmzImage__apply_kernel()            |libkempozer/image.h    |
+ */
+#ifndef kmz_kernel_h
+#define kmz_kernel_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kmz_config.h"
+#include "kmz_shared.h"
+#include "kmz_utilities.h"
+#include "kmz_core.h"
+
+/**
+ * Adds `weights[k] * rows[k][x]` for every tap `k` to `acc[x]` for every `x` below `count`, dispatched to the widest SIMD kernel supported by the
+ * processor.
+ *
+ * @param acc The sums to add to.
+ * @param rows The rows of 16-bit values to weigh, one for every tap.
+ * @param weights The 16-bit fixed point weight of every tap.
+ * @param taps The number of taps, which MUST be even.
+ * @param count The number of values within every row.
+ */
+void _kmz_kernel_pass(int32_t * const acc, const int16_t * const * const rows, const int16_t * const weights, const size_t taps, const size_t count);
+
+/**
+ * Returns the number of bytes of scratch memory {@link _kmz_kernel_convolve} needs to convolve an output of `w` by `h` pixels.
+ *
+ * @param kernel The kernel to convolve with.
+ * @param w The width of the output.
+ * @param h The height of the output.
+ * @return The size of the scratch memory in bytes.
+ */
+const size_t _kmz_kernel_scratch_size(const KmzKernel * const kernel, const size_t w, const size_t h);
+
+/**
+ * Convolves a buffer of `w + 2 * hsize` by `h + 2 * hsize` pixels with `kernel`, writing the `w` by `h` pixels of the output to `o_buffer`.
+ *
+ * @param kernel The kernel to convolve with.
+ * @param buffer The first pixel of the input, whose halo of `hsize` pixels is already in place.
+ * @param b_stride The number of pixels between the rows of `buffer`.
+ * @param w The width of the output.
+ * @param h The height of the output.
+ * @param o_buffer The first pixel of the output.
+ * @param o_stride The number of pixels between the rows of `o_buffer`.
+ * @param scratch At least {@link _kmz_kernel_scratch_size} bytes of memory aligned for a pointer.
+ */
+void _kmz_kernel_convolve(const KmzKernel * const kernel, const kmz_color_32 * const buffer, const size_t b_stride, const size_t w, const size_t h,
+        kmz_color_32 * const o_buffer, const size_t o_stride, void * const scratch);
+
+#endif /* kmz_kernel_h */
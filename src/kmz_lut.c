@@ -0,0 +1,581 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_lut.h"
+
+#define _KMZ_LUT_BAND_ROWS 16
+/**
+ * The number of pixels below which an image is transformed by the calling thread alone, as starting threads would take longer than the lookups.
+ */
+#define _KMZ_LUT_PARALLEL_PIXELS 65536
+/**
+ * The number of entries along every side of the largest table that a `.cube` file may define.
+ */
+#define _KMZ_LUT_MAX_SIZE 256
+/**
+ * The fixed point scale of every entry, which keeps every channel to within 1/128 of its exact value and still fits 16 bits signed.
+ */
+#define _KMZ_LUT_ENTRY 128.f
+/**
+ * The fixed point scale of every interpolation weight, where the weights of every pixel sum to exactly `_KMZ_LUT_ONE`.
+ */
+#define _KMZ_LUT_SHIFT 14
+#define _KMZ_LUT_ONE (1 << _KMZ_LUT_SHIFT)
+/**
+ * The shift that takes a sum of weighted entries back to an 8-bit channel.
+ */
+#define _KMZ_LUT_OUT_SHIFT (_KMZ_LUT_SHIFT + 7)
+#define _KMZ_LUT_LINE 256
+
+/**
+ * Every entry is kept as 4 fixed point channels in the order of the channels of a {@link kmz_color_32}, so that the channels of a corner are a single
+ * 8-byte load and the weighted sums pack straight back into a color. The grid position of every 8-bit value of every channel is looked up rather
+ * than computed, which also maps the domain of the table.
+ */
+struct kmz_color_lut_3d_t {
+    size_t size;
+    /**
+     * The entries in the order of `.cube` files, where red changes fastest and blue slowest, each as blue, green, red and 0.
+     */
+    int16_t * entries;
+    /**
+     * The index of the first corner along red, green and blue of every 8-bit value, already multiplied by the stride of the channel.
+     */
+    uint32_t offsets[3][256];
+    /**
+     * The distance past the first corner along red, green and blue of every 8-bit value, from 0 to `_KMZ_LUT_ONE`.
+     */
+    int32_t fractions[3][256];
+};
+
+struct _kmz_lut_t {
+    const KmzImage * image;
+    KmzImage * output;
+    _KmzLutSpan span;
+    const void * arg;
+    KmzSize dimen;
+    kmz_color_32 ** lines;
+    pthread_mutex_t lock;
+    KmzPixelOperationStatus status;
+};
+
+static inline void _kmz_lut_fail(struct _kmz_lut_t * const restrict ctx, const KmzPixelOperationStatus status) {
+    KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+    __atomic_compare_exchange_n(&ctx->status, &expected, status, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+// region Construction:
+
+static inline const int16_t _kmz_lut_entry(const float value) {
+    // NaN compares false both ways and is taken as 0.
+    const float clamped = value > 0.f ? (value < 1.f ? value : 1.f) : 0.f;
+    return (int16_t)(clamped * 255.f * _KMZ_LUT_ENTRY + .5f);
+}
+
+static inline void _kmz_lut_store(KmzColorLut3D * const restrict me, const size_t index, const float red, const float green, const float blue) {
+    int16_t * const restrict entry = me->entries + 4 * index;
+    entry[0] = _kmz_lut_entry(blue);
+    entry[1] = _kmz_lut_entry(green);
+    entry[2] = _kmz_lut_entry(red);
+    entry[3] = 0;
+}
+
+KmzColorLut3D * const _kmz_lut_new_shaped(const size_t size, const double * const restrict inputs) {
+    if (size < 2 || size > _KMZ_LUT_MAX_SIZE) {
+        return NULL;
+    }
+
+    KmzColorLut3D * const restrict me = malloc(sizeof(KmzColorLut3D));
+    if (NULL == me) {
+        return NULL;
+    }
+    me->size = size;
+    me->entries = malloc(4 * size * size * size * sizeof(int16_t));
+    if (NULL == me->entries) {
+        free(me);
+        return NULL;
+    }
+
+    const uint32_t strides[3] = {1, (uint32_t)size, (uint32_t)(size * size)};
+    for (size_t c = 0; c < 3; ++c) {
+        for (size_t v = 0; v < 256; ++v) {
+            // NaN compares false both ways and is taken as 0.
+            const double input = inputs[256 * c + v], position = (input > 0. ? (input < 1. ? input : 1.) : 0.) * (double)(size - 1);
+            // The last value sits on the far corner of the last cell rather than past the end of the table.
+            const size_t index = (size_t)position < size - 1 ? (size_t)position : size - 2;
+            me->offsets[c][v] = (uint32_t)index * strides[c];
+            me->fractions[c][v] = (int32_t)((position - (double)index) * _KMZ_LUT_ONE + .5);
+        }
+    }
+    return me;
+}
+
+/**
+ * Allocates a table of `size` entries along every side whose domain runs from `min` to `max` in every channel, where no entry is initialized.
+ */
+static KmzColorLut3D * const _kmz_lut_new(const size_t size, const float * const restrict min, const float * const restrict max) {
+    double inputs[3 * 256];
+    for (size_t c = 0; c < 3; ++c) {
+        if (!(max[c] > min[c]) || !isfinite(max[c] - min[c])) {
+            return NULL;
+        }
+        for (size_t v = 0; v < 256; ++v) {
+            inputs[256 * c + v] = ((double)v / 255. - min[c]) / ((double)max[c] - min[c]);
+        }
+    }
+    return _kmz_lut_new_shaped(size, inputs);
+}
+
+KmzColorLut3D * const KmzColorLut3D__new(const size_t size) {
+    static const float min[3] = {0.f, 0.f, 0.f}, max[3] = {1.f, 1.f, 1.f};
+    KmzColorLut3D * const restrict me = _kmz_lut_new(size, min, max);
+    if (NULL == me) {
+        return NULL;
+    }
+
+    const float scale = 1.f / (float)(size - 1);
+    for (size_t b = 0, index = 0; b < size; ++b) {
+        for (size_t g = 0; g < size; ++g) {
+            for (size_t r = 0; r < size; ++r, ++index) {
+                _kmz_lut_store(me, index, (float)r * scale, (float)g * scale, (float)b * scale);
+            }
+        }
+    }
+    return me;
+}
+
+/**
+ * Skips the keyword at the start of `text` and returns the text after it, or {@link NULL} if `text` does not start with the keyword.
+ */
+static char * const _kmz_lut_keyword(char * const restrict text, const char * const restrict keyword) {
+    const size_t length = strlen(keyword);
+    if (0 != strncmp(text, keyword, length) || !isspace((unsigned char)text[length])) {
+        return NULL;
+    }
+    return text + length;
+}
+
+/**
+ * Parses exactly `count` numbers separated by whitespace from `text` into `values`.
+ */
+static const KmzBool _kmz_lut_floats(const char * restrict text, const size_t count, float * const restrict values) {
+    for (size_t i = 0; i < count; ++i) {
+        char * end;
+        values[i] = strtof(text, &end);
+        if (end == text) {
+            return KMZ_FALSE;
+        }
+        text = end;
+    }
+    while (isspace((unsigned char)*text)) {
+        ++text;
+    }
+    return '\0' == *text;
+}
+
+KmzColorLut3D * const KmzColorLut3D__new_from_cube(FILE * const file) {
+    char line[_KMZ_LUT_LINE];
+    float min[3] = {0.f, 0.f, 0.f}, max[3] = {1.f, 1.f, 1.f}, range[2];
+    size_t size = 0, count = 0, total = 0;
+    KmzColorLut3D * restrict me = NULL;
+    KmzBool valid = NULL != file;
+
+    while (valid && NULL != fgets(line, sizeof(line), file)) {
+        // Only titles and comments are longer than the buffer, so the rest of a long line is skipped.
+        if (NULL == strchr(line, '\n')) {
+            int c;
+            while (EOF != (c = fgetc(file)) && '\n' != c) {
+            }
+        }
+
+        char * text = line, * rest;
+        while (isspace((unsigned char)*text)) {
+            ++text;
+        }
+        if ('\0' == *text || '#' == *text) {
+            continue;
+        }
+
+        if (isalpha((unsigned char)*text)) {
+            // Every keyword precedes the table.
+            if (NULL != me) {
+                valid = KMZ_FALSE;
+            } else if (NULL != (rest = _kmz_lut_keyword(text, "LUT_3D_SIZE"))) {
+                char * end;
+                const long value = strtol(rest, &end, 10);
+                valid = end != rest && value >= 2 && value <= _KMZ_LUT_MAX_SIZE && _kmz_lut_floats(end, 0, NULL);
+                size = (size_t)value;
+            } else if (NULL != (rest = _kmz_lut_keyword(text, "DOMAIN_MIN"))) {
+                valid = _kmz_lut_floats(rest, 3, min);
+            } else if (NULL != (rest = _kmz_lut_keyword(text, "DOMAIN_MAX"))) {
+                valid = _kmz_lut_floats(rest, 3, max);
+            } else if (NULL != (rest = _kmz_lut_keyword(text, "LUT_3D_INPUT_RANGE"))) {
+                valid = _kmz_lut_floats(rest, 2, range);
+                min[0] = min[1] = min[2] = range[0];
+                max[0] = max[1] = max[2] = range[1];
+            } else if (NULL != _kmz_lut_keyword(text, "LUT_1D_SIZE")) {
+                valid = KMZ_FALSE;
+            }
+            // TITLE and unknown keywords are ignored.
+            continue;
+        }
+
+        if (NULL == me) {
+            me = size ? _kmz_lut_new(size, min, max) : NULL;
+            total = size * size * size;
+            if (NULL == me) {
+                valid = KMZ_FALSE;
+                break;
+            }
+        }
+
+        float rgb[3];
+        valid = count < total && _kmz_lut_floats(text, 3, rgb);
+        if (valid) {
+            _kmz_lut_store(me, count++, rgb[0], rgb[1], rgb[2]);
+        }
+    }
+
+    if (!valid || NULL == me || count != total || ferror(file)) {
+        if (NULL != me) {
+            KmzColorLut3D__free(me);
+        }
+        return NULL;
+    }
+    return me;
+}
+
+void KmzColorLut3D__free(KmzColorLut3D * const restrict me) {
+    free(me->entries);
+    free(me);
+}
+
+// endregion;
+
+const size_t KmzColorLut3D__size(const KmzColorLut3D * const restrict me) {
+    return me->size;
+}
+
+const KmzPixelOperationStatus KmzColorLut3D__set(KmzColorLut3D * const restrict me, const size_t r, const size_t g, const size_t b, const float red,
+        const float green, const float blue) {
+    if (r >= me->size || g >= me->size || b >= me->size) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_POS;
+    }
+    _kmz_lut_store(me, (b * me->size + g) * me->size + r, red, green, blue);
+    return KMZ_PIXEL_OP_OK;
+}
+
+// region Kernels:
+
+/**
+ * Finds the corners of the cell around a color and the weight of each, returning the number of corners, which is always even.
+ *
+ * @par Tetrahedral interpolation walks from the first corner of the cell to the opposite one along the channels from the furthest into the cell to
+ * the nearest, so only the 4 corners of the tetrahedron that holds the color are weighed. The walk is taken from the furthest and nearest channels
+ * alone, which needs no branches. Ties give a weight of 0 to every corner that depends on how they are broken.
+ */
+static inline const size_t _kmz_lut_corners(const KmzColorLut3D * const restrict me, const KmzLutInterpolation interpolation, const kmz_color_32 color,
+        uint32_t * const restrict corners, int32_t * const restrict weights) {
+    const size_t r = color >> 16 & 0xFF, g = color >> 8 & 0xFF, b = color & 0xFF;
+    const uint32_t base = me->offsets[0][r] + me->offsets[1][g] + me->offsets[2][b], size = (uint32_t)me->size;
+    const int32_t fr = me->fractions[0][r], fg = me->fractions[1][g], fb = me->fractions[2][b];
+
+    if (KMZ_LUT_TETRAHEDRAL == interpolation) {
+        const int32_t max = fr > fg ? (fr > fb ? fr : fb) : (fg > fb ? fg : fb), min = fr < fg ? (fr < fb ? fr : fb) : (fg < fb ? fg : fb),
+              mid = fr + fg + fb - max - min;
+        const uint32_t furthest = fr >= fg && fr >= fb ? 1 : (fg >= fb ? size : size * size),
+              nearest = fr <= fg && fr <= fb ? 1 : (fg <= fb ? size : size * size), opposite = 1 + size + size * size;
+        corners[0] = base;
+        corners[1] = base + furthest;
+        corners[2] = base + opposite - nearest;
+        corners[3] = base + opposite;
+        weights[0] = _KMZ_LUT_ONE - max;
+        weights[1] = max - mid;
+        weights[2] = mid - min;
+        weights[3] = min;
+        return 4;
+    }
+
+    const int32_t wr[2] = {_KMZ_LUT_ONE - fr, fr}, wg[2] = {_KMZ_LUT_ONE - fg, fg}, wb[2] = {_KMZ_LUT_ONE - fb, fb};
+    int32_t rest = 0;
+    for (size_t k = 1; k < 8; ++k) {
+        const size_t i = k & 1, j = k >> 1 & 1, l = k >> 2;
+        corners[k] = base + (uint32_t)i + (uint32_t)j * size + (uint32_t)l * size * size;
+        weights[k] = (((wr[i] * wg[j] + _KMZ_LUT_ONE / 2) >> _KMZ_LUT_SHIFT) * wb[l] + _KMZ_LUT_ONE / 2) >> _KMZ_LUT_SHIFT;
+        rest += weights[k];
+    }
+    // The rounding of the other weights is taken up by the first, so a table of a single color yields exactly that color.
+    corners[0] = base;
+    weights[0] = _KMZ_LUT_ONE - rest;
+    return 8;
+}
+
+static inline const kmz_color_32 _kmz_lut_color(const KmzColorLut3D * const restrict me, const KmzLutInterpolation interpolation, const kmz_color_32 color) {
+    uint32_t corners[8];
+    int32_t weights[8], sums[3] = {0, 0, 0};
+    const size_t count = _kmz_lut_corners(me, interpolation, color, corners, weights);
+    for (size_t k = 0; k < count; ++k) {
+        const int16_t * const restrict entry = me->entries + 4 * (size_t)corners[k];
+        for (size_t c = 0; c < 3; ++c) {
+            sums[c] += weights[k] * entry[c];
+        }
+    }
+
+    kmz_color_32 out = color & 0x7F000000u;
+    for (size_t c = 0; c < 3; ++c) {
+        const int32_t channel = (sums[c] + (1 << (_KMZ_LUT_OUT_SHIFT - 1))) >> _KMZ_LUT_OUT_SHIFT;
+        out |= (kmz_color_32)kmz_clamp(channel, 0, 255) << (8 * c);
+    }
+    return out;
+}
+
+#ifdef KMZ_SIMD_X86
+/**
+ * Weighs the corners of a single color as pairs, where every pair of corners is interleaved so a single multiply-add weighs both for every channel.
+ */
+kmz__target("sse2") static inline __m128i _kmz_sse2_lut_sum(const KmzColorLut3D * const restrict me, const KmzLutInterpolation interpolation,
+        const kmz_color_32 color) {
+    uint32_t corners[8];
+    int32_t weights[8];
+    const size_t count = _kmz_lut_corners(me, interpolation, color, corners, weights);
+    __m128i sum = _mm_set1_epi32(1 << (_KMZ_LUT_OUT_SHIFT - 1));
+    for (size_t k = 0; k < count; k += 2) {
+        const __m128i first = _mm_loadl_epi64((const __m128i *)(me->entries + 4 * (size_t)corners[k])),
+              second = _mm_loadl_epi64((const __m128i *)(me->entries + 4 * (size_t)corners[k + 1])),
+              pair = _mm_set1_epi32((int32_t)((uint32_t)weights[k + 1] << 16 | (uint16_t)weights[k]));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_unpacklo_epi16(first, second), pair));
+    }
+    return _mm_srai_epi32(sum, _KMZ_LUT_OUT_SHIFT);
+}
+
+kmz__target("sse2") static size_t _kmz_sse2_lut_span(const KmzColorLut3D * const restrict me, const KmzLutInterpolation interpolation,
+        kmz_color_32 * const restrict colors, const size_t count, size_t i) {
+    const __m128i alpha_mask = _mm_set1_epi32(0x7F000000);
+    for (; i + 2 <= count; i += 2) {
+        const __m128i lo = _kmz_sse2_lut_sum(me, interpolation, colors[i]), hi = _kmz_sse2_lut_sum(me, interpolation, colors[i + 1]),
+              packed = _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128()),
+              src = _mm_loadl_epi64((const __m128i *)(colors + i));
+        _mm_storel_epi64((__m128i *)(colors + i), _mm_or_si128(packed, _mm_and_si128(src, alpha_mask)));
+    }
+    return i;
+}
+
+/**
+ * Weighs the corners of 8 colors at once, where the corners of 4 colors are a single gather and every pair of corners of a color is a single
+ * multiply-add. The corners and weights are found as in {@link _kmz_lut_corners}.
+ */
+kmz__target("avx2") static size_t _kmz_avx2_lut_span(const KmzColorLut3D * const restrict me, const KmzLutInterpolation interpolation,
+        kmz_color_32 * const restrict colors, const size_t count, size_t i) {
+    const int32_t size = (int32_t)me->size;
+    const __m256i channel = _mm256_set1_epi32(0xFF), one = _mm256_set1_epi32(_KMZ_LUT_ONE), half = _mm256_set1_epi32(_KMZ_LUT_ONE / 2),
+          low = _mm256_set1_epi32(0xFFFF), rounding = _mm256_set1_epi32(1 << (_KMZ_LUT_OUT_SHIFT - 1)), alpha_mask = _mm256_set1_epi32(0x7F000000),
+          dr = _mm256_set1_epi32(1), dg = _mm256_set1_epi32(size), db = _mm256_set1_epi32(size * size),
+          opposite = _mm256_set1_epi32(1 + size + size * size),
+          spread[4] = {_mm256_setr_epi32(0, 0, 0, 0, 2, 2, 2, 2), _mm256_setr_epi32(1, 1, 1, 1, 3, 3, 3, 3),
+                       _mm256_setr_epi32(4, 4, 4, 4, 6, 6, 6, 6), _mm256_setr_epi32(5, 5, 5, 5, 7, 7, 7, 7)};
+    const long long * const restrict entries = (const long long *)me->entries;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m256i src = _mm256_loadu_si256((const __m256i *)(colors + i)),
+              r = _mm256_and_si256(_mm256_srli_epi32(src, 16), channel), g = _mm256_and_si256(_mm256_srli_epi32(src, 8), channel),
+              b = _mm256_and_si256(src, channel),
+              base = _mm256_add_epi32(_mm256_add_epi32(_mm256_i32gather_epi32((const int *)me->offsets[0], r, 4),
+                      _mm256_i32gather_epi32((const int *)me->offsets[1], g, 4)), _mm256_i32gather_epi32((const int *)me->offsets[2], b, 4)),
+              fr = _mm256_i32gather_epi32(me->fractions[0], r, 4), fg = _mm256_i32gather_epi32(me->fractions[1], g, 4),
+              fb = _mm256_i32gather_epi32(me->fractions[2], b, 4);
+        __m256i corners[8], weights[8];
+        size_t n;
+
+        if (KMZ_LUT_TETRAHEDRAL == interpolation) {
+            const __m256i max = _mm256_max_epi32(_mm256_max_epi32(fr, fg), fb), min = _mm256_min_epi32(_mm256_min_epi32(fr, fg), fb),
+                  mid = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(_mm256_add_epi32(fr, fg), fb), max), min),
+                  r_furthest = _mm256_or_si256(_mm256_cmpgt_epi32(fg, fr), _mm256_cmpgt_epi32(fb, fr)),
+                  r_nearest = _mm256_or_si256(_mm256_cmpgt_epi32(fr, fg), _mm256_cmpgt_epi32(fr, fb)),
+                  furthest = _mm256_blendv_epi8(dr, _mm256_blendv_epi8(dg, db, _mm256_cmpgt_epi32(fb, fg)), r_furthest),
+                  nearest = _mm256_blendv_epi8(dr, _mm256_blendv_epi8(dg, db, _mm256_cmpgt_epi32(fg, fb)), r_nearest);
+            corners[0] = base;
+            corners[1] = _mm256_add_epi32(base, furthest);
+            corners[2] = _mm256_sub_epi32(_mm256_add_epi32(base, opposite), nearest);
+            corners[3] = _mm256_add_epi32(base, opposite);
+            weights[0] = _mm256_sub_epi32(one, max);
+            weights[1] = _mm256_sub_epi32(max, mid);
+            weights[2] = _mm256_sub_epi32(mid, min);
+            weights[3] = min;
+            n = 4;
+        } else {
+            const __m256i wr[2] = {_mm256_sub_epi32(one, fr), fr}, wg[2] = {_mm256_sub_epi32(one, fg), fg}, wb[2] = {_mm256_sub_epi32(one, fb), fb},
+                  steps[3][2] = {{_mm256_setzero_si256(), dr}, {_mm256_setzero_si256(), dg}, {_mm256_setzero_si256(), db}};
+            __m256i rest = _mm256_setzero_si256();
+            for (size_t k = 1; k < 8; ++k) {
+                const size_t x = k & 1, y = k >> 1 & 1, z = k >> 2;
+                corners[k] = _mm256_add_epi32(_mm256_add_epi32(base, steps[0][x]), _mm256_add_epi32(steps[1][y], steps[2][z]));
+                const __m256i rg = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(wr[x], wg[y]), half), _KMZ_LUT_SHIFT);
+                weights[k] = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(rg, wb[z]), half), _KMZ_LUT_SHIFT);
+                rest = _mm256_add_epi32(rest, weights[k]);
+            }
+            corners[0] = base;
+            weights[0] = _mm256_sub_epi32(one, rest);
+            n = 8;
+        }
+
+        // Gathering the corners of colors 0 to 3 gives colors 0 and 2 in the low and 1 and 3 in the high halves once a pair is interleaved.
+        __m256i sums[4] = {rounding, rounding, rounding, rounding};
+        for (size_t k = 0; k < n; k += 2) {
+            const __m256i pairs = _mm256_or_si256(_mm256_and_si256(weights[k], low), _mm256_slli_epi32(weights[k + 1], 16));
+            for (size_t half_index = 0; half_index < 2; ++half_index) {
+                const __m128i first = half_index ? _mm256_extracti128_si256(corners[k], 1) : _mm256_castsi256_si128(corners[k]),
+                      second = half_index ? _mm256_extracti128_si256(corners[k + 1], 1) : _mm256_castsi256_si128(corners[k + 1]);
+                const __m256i a = _mm256_i32gather_epi64(entries, first, 8), c = _mm256_i32gather_epi64(entries, second, 8);
+                __m256i * const restrict sum = sums + 2 * half_index;
+                sum[0] = _mm256_add_epi32(sum[0], _mm256_madd_epi16(_mm256_unpacklo_epi16(a, c),
+                        _mm256_permutevar8x32_epi32(pairs, spread[2 * half_index])));
+                sum[1] = _mm256_add_epi32(sum[1], _mm256_madd_epi16(_mm256_unpackhi_epi16(a, c),
+                        _mm256_permutevar8x32_epi32(pairs, spread[2 * half_index + 1])));
+            }
+        }
+
+        const __m256i first = _mm256_packs_epi32(_mm256_srai_epi32(sums[0], _KMZ_LUT_OUT_SHIFT), _mm256_srai_epi32(sums[1], _KMZ_LUT_OUT_SHIFT)),
+              second = _mm256_packs_epi32(_mm256_srai_epi32(sums[2], _KMZ_LUT_OUT_SHIFT), _mm256_srai_epi32(sums[3], _KMZ_LUT_OUT_SHIFT)),
+              packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(colors + i), _mm256_or_si256(packed, _mm256_and_si256(src, alpha_mask)));
+    }
+    return i;
+}
+#endif
+
+void _kmz_lut_span(const KmzColorLut3D * const restrict me, const KmzLutInterpolation interpolation, kmz_color_32 * const restrict colors,
+        const size_t count) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_lut_span(me, interpolation, colors, count, i);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        i = _kmz_sse2_lut_span(me, interpolation, colors, count, i);
+    }
+#endif
+    for (; i < count; ++i) {
+        colors[i] = _kmz_lut_color(me, interpolation, colors[i]);
+    }
+}
+
+// endregion;
+
+static void _KmzImage__lut_band(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_lut_t * const restrict ctx = arg;
+    const size_t w = ctx->dimen.w, y0 = index * _KMZ_LUT_BAND_ROWS,
+          y1 = y0 + _KMZ_LUT_BAND_ROWS < ctx->dimen.h ? y0 + _KMZ_LUT_BAND_ROWS : ctx->dimen.h;
+    if (NULL == ctx->lines[worker]) {
+        ctx->lines[worker] = malloc(w * _KMZ_LUT_BAND_ROWS * sizeof(kmz_color_32));
+    }
+    kmz_color_32 * const restrict colors = ctx->lines[worker];
+    if (NULL == colors) {
+        _kmz_lut_fail(ctx, KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY);
+        return;
+    }
+
+    const KmzRectangle band = kmz_rectangle(kmz_point(0, (ssize_t)y0), kmz_size((uint16_t)w, (uint16_t)(y1 - y0)));
+    KmzPixelOperationStatus status = KmzImage__read_argb_block(ctx->image, band, colors);
+    if (KMZ_PIXEL_OP_OK == status) {
+        ctx->span(ctx->arg, colors, w * (y1 - y0));
+        pthread_mutex_lock(&ctx->lock);
+        status = KmzImage__write_argb_block(ctx->output, band, colors);
+        pthread_mutex_unlock(&ctx->lock);
+    }
+    if (KMZ_PIXEL_OP_OK != status) {
+        _kmz_lut_fail(ctx, status);
+    }
+}
+
+const KmzPixelOperationStatus _kmz_lut_map(const KmzImage * const image, KmzImage * const output, const _KmzLutSpan span, const void * const arg,
+        const size_t threads) {
+    const KmzSize dimen = KmzImage__dimen(image), o_dimen = KmzImage__dimen(output);
+    if (o_dimen.w != dimen.w || o_dimen.h != dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    }
+    if (!dimen.w || !dimen.h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    // Every band is read and written by the same unit of work, so the output may be the image itself.
+    const size_t bands = ((size_t)dimen.h + _KMZ_LUT_BAND_ROWS - 1) / _KMZ_LUT_BAND_ROWS,
+          workers = _kmz_parallel_workers((size_t)dimen.w * dimen.h < _KMZ_LUT_PARALLEL_PIXELS ? 1 : threads, bands);
+    struct _kmz_lut_t ctx = {
+        .image = image,
+        .output = output,
+        .span = span,
+        .arg = arg,
+        .dimen = dimen,
+        .lines = calloc(workers, sizeof(kmz_color_32 *)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+    if (NULL == ctx.lines) {
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_init(&ctx.lock, NULL);
+    _kmz_parallel_for(workers, bands, &_KmzImage__lut_band, &ctx);
+    pthread_mutex_destroy(&ctx.lock);
+
+    for (size_t i = 0; i < workers; ++i) {
+        free(ctx.lines[i]);
+    }
+    free(ctx.lines);
+    return ctx.status;
+}
+
+/**
+ * The arguments of {@link _kmz_lut_interpolate}.
+ */
+struct _kmz_lut_lookup_t {
+    const KmzColorLut3D * lut;
+    KmzLutInterpolation interpolation;
+};
+
+static void _kmz_lut_interpolate(const void * const restrict arg, kmz_color_32 * const restrict colors, const size_t count) {
+    const struct _kmz_lut_lookup_t * const restrict lookup = arg;
+    _kmz_lut_span(lookup->lut, lookup->interpolation, colors, count);
+}
+
+const KmzPixelOperationStatus KmzImage__apply_lut3d(const KmzImage * const me, const KmzColorLut3D * const lut, const KmzLutInterpolation interpolation,
+        KmzImage * const output, const size_t threads) {
+    if (NULL == lut) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+    if (KMZ_LUT_TRILINEAR != interpolation && KMZ_LUT_TETRAHEDRAL != interpolation) {
+        return KMZ_PIXEL_OP_ERR_UNKNOWN;
+    }
+
+    const struct _kmz_lut_lookup_t lookup = {.lut = lut, .interpolation = interpolation};
+    return _kmz_lut_map(me, output, &_kmz_lut_interpolate, &lookup, threads);
+}
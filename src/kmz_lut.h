@@ -0,0 +1,102 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+/**
+ * |Definition                          |Header                 |
+ * |KmzColorLut3D__new()                |libkempozer/image.h    |
+ * |KmzColorLut3D__new_from_cube()      |libkempozer/image.h    |
+ * |KmzColorLut3D__free()               |libkempozer/image.h    |
+ * |KmzColorLut3D__size()               |libkempozer/image.h    |
+ * |KmzColorLut3D__set()                |libkempozer/image.h    |
+ * |KmzImage__apply_lut3d()             |libkempozer/image.h    |
+ */
+#ifndef kmz_lut_h
+#define kmz_lut_h
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "kmz_config.h"
+#include "kmz_shared.h"
+#include "kmz_utilities.h"
+#include "kmz_core.h"
+#include "kmz_parallel.h"
+
+/**
+ * Maps a span of colors in place for {@link _kmz_lut_map}.
+ *
+ * @param arg The argument shared by every span.
+ * @param colors The colors to map.
+ * @param count The number of colors.
+ */
+typedef void (* _KmzLutSpan)(const void * const arg, kmz_color_32 * const colors, const size_t count);
+
+/**
+ * @par Allocates a {@link KmzColorLut3D} of `size` entries along every side, where no entry is initialized.
+ *
+ * @par The grid position of every 8-bit value of every channel is taken from `inputs`, which holds the positions from 0 to 1 of the 256 values of red, then green, then blue. A curve that is applied to every channel before the table is so folded into the lookup of the grid position.
+ *
+ * @param size The number of entries along every side of the table, from 2 to 256.
+ * @param inputs The 768 grid positions.
+ * @return A new {@link KmzColorLut3D}, or {@link NULL} if the size is invalid or there isn't enough memory.
+ */
+KmzColorLut3D * const _kmz_lut_new_shaped(const size_t size, const double * const inputs);
+
+/**
+ * Maps every color of a span in place through a {@link KmzColorLut3D}, dispatched to the widest SIMD kernel supported by the processor.
+ *
+ * @param me The table to map through.
+ * @param interpolation The interpolation between the entries of the table, which MUST be a known {@link KmzLutInterpolation}.
+ * @param colors The colors to map.
+ * @param count The number of colors.
+ */
+void _kmz_lut_span(const KmzColorLut3D * const me, const KmzLutInterpolation interpolation, kmz_color_32 * const colors, const size_t count);
+
+/**
+ * @par Maps every pixel of an image through `span` to the output image, which MUST have the dimensions of the image and MAY be the image.
+ *
+ * @par The image is mapped in bands of 16 rows in parallel, unless it is too small for threads to pay off.
+ *
+ * @param image The image to map.
+ * @param output The image to write the result to.
+ * @param span The span to map every band through.
+ * @param arg The argument passed to every call of `span`.
+ * @param threads The number of threads to use, or 0 to use {@link kmz_thread_count}.
+ * @return {@link KMZ_PIXEL_OP_OK} if the image is mapped, otherwise an appropriate {@link KmzPixelOperationStatus}.
+ */
+const KmzPixelOperationStatus _kmz_lut_map(const KmzImage * const image, KmzImage * const output, const _KmzLutSpan span, const void * const arg,
+        const size_t threads);
+
+#endif /* kmz_lut_h */
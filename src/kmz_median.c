@@ -0,0 +1,412 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_median.h"
+
+/**
+ * The number of pixels of each strip of columns filtered by a single worker.
+ */
+#define _KMZ_MEDIAN_STRIP 128
+/**
+ * The largest radius whose window still fits every count of its histograms in 16 bits.
+ */
+#define _KMZ_MEDIAN_MAX_RADIUS 127
+/**
+ * The number of bins of every coarse histogram, each of which covers 16 bins of its fine histogram.
+ */
+#define _KMZ_MEDIAN_COARSE 16
+#define _KMZ_MEDIAN_FINE 256
+#define _KMZ_MEDIAN_CHANNELS 4
+/**
+ * Flips the 7-bit alpha of a pixel into its opacity, so that low percentiles pick the least opaque pixels just as they pick the darkest ones.
+ */
+#define _KMZ_MEDIAN_OPACITY 0x7F000000u
+
+/**
+ * The histograms of the window around the current pixel. The coarse histograms are kept up to date at every pixel, while every segment of 16 fine bins
+ * is only brought up to date when the percentile falls within it, from the column it was last used at.
+ */
+struct _kmz_median_kernel_t {
+    uint16_t coarse[_KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE];
+    uint16_t fine[_KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_FINE];
+    size_t fine_x[_KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE];
+};
+
+struct _kmz_median_worker_t {
+    uint16_t * coarse;
+    uint16_t * fine;
+    struct _kmz_median_kernel_t * kernel;
+};
+
+struct _kmz_median_t {
+    KmzSize dimen;
+    size_t radius;
+    double percentile;
+    size_t columns;
+    const kmz_color_32 * pixels;
+    kmz_color_32 * out;
+    struct _kmz_median_worker_t * workers;
+    KmzPixelOperationStatus status;
+};
+
+/**
+ * The coarse histograms of a column outside of the image, which are added or removed whenever the window slides past an edge.
+ */
+static const uint16_t _kmz_median_empty[_KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE];
+
+// region Kernels:
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static size_t _kmz_sse2_median_slide(uint16_t * const restrict bins, const uint16_t * const restrict add,
+        const uint16_t * const restrict sub, const size_t count, size_t i) {
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_add_epi16(_mm_loadu_si128((const __m128i *)(bins + i)), _mm_loadu_si128((const __m128i *)(add + i)));
+        _mm_storeu_si128((__m128i *)(bins + i), _mm_sub_epi16(v, _mm_loadu_si128((const __m128i *)(sub + i))));
+    }
+    return i;
+}
+
+/**
+ * Finds the bin of 16 holding the `needed`th pixel by comparing the prefix sums of the bins against it, with no branch that depends on the pixels.
+ */
+kmz__target("sse2") static size_t _kmz_sse2_median_find(const uint16_t * const restrict bins, const size_t needed, size_t * const restrict seen) {
+    __m128i lo = _mm_loadu_si128((const __m128i *)bins), hi = _mm_loadu_si128((const __m128i *)(bins + 8));
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 2));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 2));
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 4));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 4));
+    lo = _mm_add_epi16(lo, _mm_slli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_slli_si128(hi, 8));
+    hi = _mm_add_epi16(hi, _mm_unpackhi_epi64(_mm_shufflehi_epi16(lo, 0xFF), _mm_shufflehi_epi16(lo, 0xFF)));
+
+    // The counts are unsigned, so both sides are biased into the signed range before comparing.
+    const __m128i bias = _mm_set1_epi16((short)0x8000), limit = _mm_set1_epi16((short)(needed ^ 0x8000));
+    const __m128i below = _mm_packs_epi16(_mm_cmpgt_epi16(limit, _mm_xor_si128(lo, bias)), _mm_cmpgt_epi16(limit, _mm_xor_si128(hi, bias)));
+    // Only the bins before the one found are below it, so it is the lowest bin whose sum is not.
+    const size_t b = (size_t)__builtin_ctz(~(unsigned int)_mm_movemask_epi8(below));
+
+    uint16_t sums[16];
+    _mm_storeu_si128((__m128i *)sums, lo);
+    _mm_storeu_si128((__m128i *)(sums + 8), hi);
+    *seen += b ? sums[b - 1] : 0;
+    return b;
+}
+
+kmz__target("sse2") static void _kmz_sse2_median_sum(uint16_t * const restrict segment, const uint16_t * const restrict columns,
+        const size_t count, const KmzBool subtract) {
+    __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    for (size_t c = 0; c < count; ++c) {
+        lo = _mm_add_epi16(lo, _mm_loadu_si128((const __m128i *)(columns + c * _KMZ_MEDIAN_COARSE)));
+        hi = _mm_add_epi16(hi, _mm_loadu_si128((const __m128i *)(columns + c * _KMZ_MEDIAN_COARSE + 8)));
+    }
+    const __m128i s_lo = _mm_loadu_si128((const __m128i *)segment), s_hi = _mm_loadu_si128((const __m128i *)(segment + 8));
+    _mm_storeu_si128((__m128i *)segment, subtract ? _mm_sub_epi16(s_lo, lo) : _mm_add_epi16(s_lo, lo));
+    _mm_storeu_si128((__m128i *)(segment + 8), subtract ? _mm_sub_epi16(s_hi, hi) : _mm_add_epi16(s_hi, hi));
+}
+
+kmz__target("avx2") static void _kmz_avx2_median_sum(uint16_t * const restrict segment, const uint16_t * const restrict columns,
+        const size_t count, const KmzBool subtract) {
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t c = 0; c < count; ++c) {
+        sum = _mm256_add_epi16(sum, _mm256_loadu_si256((const __m256i *)(columns + c * _KMZ_MEDIAN_COARSE)));
+    }
+    const __m256i v = _mm256_loadu_si256((const __m256i *)segment);
+    _mm256_storeu_si256((__m256i *)segment, subtract ? _mm256_sub_epi16(v, sum) : _mm256_add_epi16(v, sum));
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_median_slide(uint16_t * const restrict bins, const uint16_t * const restrict add,
+        const uint16_t * const restrict sub, const size_t count, size_t i) {
+    for (; i + 16 <= count; i += 16) {
+        const __m256i v = _mm256_add_epi16(_mm256_loadu_si256((const __m256i *)(bins + i)), _mm256_loadu_si256((const __m256i *)(add + i)));
+        _mm256_storeu_si256((__m256i *)(bins + i), _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i *)(sub + i))));
+    }
+    return i;
+}
+#endif
+
+/**
+ * Adds the histogram `add` to, and removes the histogram `sub` from, `count` bins. The counts wrap around, which is harmless as every bin of a window
+ * ends up between 0 and its size.
+ */
+static inline void _kmz_median_slide(const KmzSimdLevel level, uint16_t * const restrict bins, const uint16_t * const restrict add,
+        const uint16_t * const restrict sub, const size_t count) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_median_slide(bins, add, sub, count, i);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        i = _kmz_sse2_median_slide(bins, add, sub, count, i);
+    }
+#else
+    (void)level;
+#endif
+    for (; i < count; ++i) {
+        bins[i] = (uint16_t)(bins[i] + add[i] - sub[i]);
+    }
+}
+
+/**
+ * Adds the segments of `count` consecutive columns to a segment of the window, or removes them when subtracting.
+ */
+static inline void _kmz_median_sum(const KmzSimdLevel level, uint16_t * const restrict segment, const uint16_t * const restrict columns,
+        const size_t count, const KmzBool subtract) {
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_AVX2 <= level) {
+        _kmz_avx2_median_sum(segment, columns, count, subtract);
+        return;
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        _kmz_sse2_median_sum(segment, columns, count, subtract);
+        return;
+    }
+#else
+    (void)level;
+#endif
+    for (size_t i = 0; i < _KMZ_MEDIAN_COARSE; ++i) {
+        uint16_t sum = 0;
+        for (size_t c = 0; c < count; ++c) {
+            sum = (uint16_t)(sum + columns[c * _KMZ_MEDIAN_COARSE + i]);
+        }
+        segment[i] = (uint16_t)(subtract ? segment[i] - sum : segment[i] + sum);
+    }
+}
+
+/**
+ * Returns the first of 16 bins at which at least `needed` pixels, counting the `seen` pixels below the bins, have been seen, and adds the pixels of
+ * the bins before it to `seen`.
+ */
+static inline const size_t _kmz_median_find(const KmzSimdLevel level, const uint16_t * const restrict bins, const size_t needed,
+        size_t * const restrict seen) {
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_SSE2 <= level) {
+        return _kmz_sse2_median_find(bins, needed - *seen, seen);
+    }
+#else
+    (void)level;
+#endif
+    size_t b = 0, sum = *seen, below = *seen;
+    for (size_t i = 0; i < _KMZ_MEDIAN_COARSE; ++i) {
+        sum += bins[i];
+        b += sum < needed;
+        below = sum < needed ? sum : below;
+    }
+    *seen = below;
+    return b;
+}
+
+/**
+ * Adds a row of the image to, or removes it from, the histograms of every column of a strip. The coarse histograms of a column are kept together, as
+ * the window slides over all of them at once, while each segment of the fine histograms is kept together for every column, as the window only slides
+ * over one of them at a time.
+ */
+static void _kmz_median_row(const kmz_color_32 * const restrict row, const size_t columns, const size_t stride, uint16_t * const restrict coarse,
+        uint16_t * const restrict fine, const uint16_t delta) {
+    for (size_t c = 0; c < columns; ++c) {
+        const kmz_color_32 color = row[c];
+        for (size_t ch = 0; ch < _KMZ_MEDIAN_CHANNELS; ++ch) {
+            const size_t v = (color >> (ch * 8)) & 0xFF, b = ch * _KMZ_MEDIAN_COARSE + (v >> 4);
+            coarse[(c * _KMZ_MEDIAN_CHANNELS + ch) * _KMZ_MEDIAN_COARSE + (v >> 4)] += delta;
+            fine[(b * stride + c) * _KMZ_MEDIAN_COARSE + (v & 0xF)] += delta;
+        }
+    }
+}
+
+// endregion;
+
+static inline struct _kmz_median_worker_t * const _kmz_median_worker(struct _kmz_median_t * const restrict ctx, const size_t worker) {
+    struct _kmz_median_worker_t * const restrict state = ctx->workers + worker;
+    if (NULL == state->kernel) {
+        state->coarse = malloc(ctx->columns * _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE * sizeof(uint16_t));
+        state->fine = malloc(ctx->columns * _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_FINE * sizeof(uint16_t));
+        state->kernel = malloc(sizeof(struct _kmz_median_kernel_t));
+    }
+
+    if (NULL == state->coarse || NULL == state->fine || NULL == state->kernel) {
+        KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    return state;
+}
+
+/**
+ * Filters a strip of columns from top to bottom with the Perreault-Hébert algorithm. Every column of the strip, and `radius` columns on either side of
+ * it, keeps a histogram of the rows of the window, which takes one row in and one row out as the window moves down. Along every row the coarse
+ * histograms of the window take one column in and one column out as it moves right, so the cost of every pixel does not depend on the radius.
+ */
+static void _KmzImage__median_strip(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_median_t * const restrict ctx = arg;
+    struct _kmz_median_worker_t * const restrict state = _kmz_median_worker(ctx, worker);
+    if (NULL == state) {
+        return;
+    }
+
+    const KmzSimdLevel level = kmz_simd_level();
+    const size_t w = ctx->dimen.w, h = ctx->dimen.h, r = ctx->radius, x0 = index * _KMZ_MEDIAN_STRIP,
+          x1 = x0 + _KMZ_MEDIAN_STRIP < w ? x0 + _KMZ_MEDIAN_STRIP : w, c0 = x0 > r ? x0 - r : 0, c1 = x1 + r < w ? x1 + r : w, columns = c1 - c0;
+    uint16_t * const restrict coarse = state->coarse, * const restrict fine = state->fine;
+    struct _kmz_median_kernel_t * const restrict kernel = state->kernel;
+
+    memset(coarse, 0, columns * _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE * sizeof(uint16_t));
+    memset(fine, 0, ctx->columns * _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_FINE * sizeof(uint16_t));
+    for (size_t y = 0; y < r && y < h; ++y) {
+        _kmz_median_row(ctx->pixels + y * w + c0, columns, ctx->columns, coarse, fine, 1);
+    }
+
+    for (size_t y = 0; y < h; ++y) {
+        if (y + r < h) {
+            _kmz_median_row(ctx->pixels + (y + r) * w + c0, columns, ctx->columns, coarse, fine, 1);
+        }
+        if (y > r) {
+            _kmz_median_row(ctx->pixels + (y - r - 1) * w + c0, columns, ctx->columns, coarse, fine, (uint16_t)-1);
+        }
+        const size_t rows = (y + r < h ? y + r + 1 : h) - (y > r ? y - r : 0);
+
+        memset(kernel->coarse, 0, sizeof(kernel->coarse));
+        for (size_t c = x0 > r ? x0 - r : 0; c < x0 + r + 1 && c < w; ++c) {
+            _kmz_median_slide(level, kernel->coarse, coarse + (c - c0) * _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE, _kmz_median_empty,
+                _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE);
+        }
+        for (size_t i = 0; i < _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE; ++i) {
+            kernel->fine_x[i] = SIZE_MAX;
+        }
+
+        size_t last_count = 0, needed = 0;
+        for (size_t x = x0; x < x1; ++x) {
+            if (x > x0) {
+                _kmz_median_slide(level, kernel->coarse,
+                    x + r < w ? coarse + (x + r - c0) * _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE : _kmz_median_empty,
+                    x > r ? coarse + (x - r - 1 - c0) * _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE : _kmz_median_empty,
+                    _KMZ_MEDIAN_CHANNELS * _KMZ_MEDIAN_COARSE);
+            }
+
+            // The number of pixels that must be at or below the percentile, rounded up and never below the first pixel, as in KmzImage__stats(). It
+            // only changes near the edges of the image.
+            const size_t lo = x > r ? x - r : 0, hi = x + r < w ? x + r + 1 : w, count = rows * (hi - lo);
+            if (count != last_count) {
+                last_count = count;
+                needed = (size_t)ceil(ctx->percentile * (double)count);
+                needed = needed ? (needed < count ? needed : count) : 1;
+            }
+
+            kmz_color_32 color = 0;
+            for (size_t ch = 0; ch < _KMZ_MEDIAN_CHANNELS; ++ch) {
+                const uint16_t * const restrict bins = kernel->coarse + ch * _KMZ_MEDIAN_COARSE;
+                size_t seen = 0;
+                const size_t b = _kmz_median_find(level, bins, needed, &seen);
+
+                // Brings the fine segment holding the percentile up to date, rebuilding it when that is cheaper than sliding it.
+                uint16_t * const restrict segment = kernel->fine + ch * _KMZ_MEDIAN_FINE + b * _KMZ_MEDIAN_COARSE;
+                size_t * const restrict last = kernel->fine_x + ch * _KMZ_MEDIAN_COARSE + b;
+                const uint16_t * const restrict columns_fine = fine + (ch * _KMZ_MEDIAN_COARSE + b) * ctx->columns * _KMZ_MEDIAN_COARSE;
+                if (SIZE_MAX == *last || 2 * (x - *last) > hi - lo) {
+                    memset(segment, 0, _KMZ_MEDIAN_COARSE * sizeof(uint16_t));
+                    _kmz_median_sum(level, segment, columns_fine + (lo - c0) * _KMZ_MEDIAN_COARSE, hi - lo, KMZ_FALSE);
+                } else if (*last != x) {
+                    // The columns that entered and left the window since it was last brought up to date are both contiguous.
+                    const size_t in = *last + r + 1 < w ? *last + r + 1 : w, left = *last > r ? *last - r : 0;
+                    _kmz_median_sum(level, segment, columns_fine + (in - c0) * _KMZ_MEDIAN_COARSE, hi - in, KMZ_FALSE);
+                    _kmz_median_sum(level, segment, columns_fine + (left - c0) * _KMZ_MEDIAN_COARSE, lo - left, KMZ_TRUE);
+                }
+                *last = x;
+
+                const size_t v = _kmz_median_find(level, segment, needed, &seen);
+                color |= (kmz_color_32)(b * _KMZ_MEDIAN_COARSE + v) << (ch * 8);
+            }
+            ctx->out[y * w + x] = color ^ _KMZ_MEDIAN_OPACITY;
+        }
+    }
+}
+
+const KmzPixelOperationStatus KmzImage__percentile_filter(const KmzImage * const me, const size_t radius, const kmz_percent percentile,
+        KmzImage * const output, const size_t threads) {
+    if (radius > _KMZ_MEDIAN_MAX_RADIUS || !(percentile >= 0.f && percentile <= 1.f)) {
+        return KMZ_PIXEL_OP_ERR_UNKNOWN;
+    }
+
+    const KmzSize dimen = KmzImage__dimen(me), o_dimen = KmzImage__dimen(output);
+    if (o_dimen.w != dimen.w || o_dimen.h != dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    }
+    if (!dimen.w || !dimen.h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t pixels = (size_t)dimen.w * dimen.h, strips = ((size_t)dimen.w + _KMZ_MEDIAN_STRIP - 1) / _KMZ_MEDIAN_STRIP,
+          workers = _kmz_parallel_workers(threads, strips);
+    kmz_color_32 * const restrict buffer = malloc(pixels * sizeof(kmz_color_32));
+    struct _kmz_median_t ctx = {
+        .dimen = dimen,
+        .radius = radius,
+        .percentile = percentile,
+        .columns = _KMZ_MEDIAN_STRIP + 2 * radius,
+        .pixels = buffer,
+        .out = malloc(pixels * sizeof(kmz_color_32)),
+        .workers = calloc(workers, sizeof(struct _kmz_median_worker_t)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (NULL == buffer || NULL == ctx.out || NULL == ctx.workers) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        ctx.status = KmzImage__read_argb_block(me, kmz_rectangle(KmzPoint__ZERO, dimen), buffer);
+    }
+
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        for (size_t i = 0; i < pixels; ++i) {
+            buffer[i] ^= _KMZ_MEDIAN_OPACITY;
+        }
+        _kmz_parallel_for(workers, strips, &_KmzImage__median_strip, &ctx);
+    }
+
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        ctx.status = KmzImage__write_argb_block(output, kmz_rectangle(KmzPoint__ZERO, dimen), ctx.out);
+    }
+
+    if (NULL != ctx.workers) {
+        for (size_t i = 0; i < workers; ++i) {
+            free(ctx.workers[i].coarse);
+            free(ctx.workers[i].fine);
+            free(ctx.workers[i].kernel);
+        }
+    }
+    free(buffer);
+    free(ctx.out);
+    free(ctx.workers);
+
+    return ctx.status;
+}
+
+const KmzPixelOperationStatus KmzImage__median(const KmzImage * const me, const size_t radius, KmzImage * const output, const size_t threads) {
+    return KmzImage__percentile_filter(me, radius, .5f, output, threads);
+}
@@ -0,0 +1,352 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_morphology.h"
+
+/**
+ * The number of rows interleaved by the horizontal pass, so that every step of its recurrence is a single vector operation.
+ */
+#define _KMZ_MORPHOLOGY_BAND_ROWS 16
+/**
+ * The number of pixels of each strip of columns filtered by the vertical pass.
+ */
+#define _KMZ_MORPHOLOGY_STRIP 64
+/**
+ * Flips the 7-bit alpha of a pixel into its opacity, so that eroding shrinks opaque shapes just as it shrinks bright ones.
+ */
+#define _KMZ_MORPHOLOGY_OPACITY 0x7F000000u
+
+struct _kmz_morphology_worker_t {
+    uint8_t * line;
+    uint8_t * g;
+    uint8_t * h;
+    uint8_t * out;
+};
+
+struct _kmz_morphology_t {
+    KmzSize dimen;
+    KmzSize element;
+    KmzBool dilate;
+    size_t size;
+    kmz_color_32 * pixels;
+    kmz_color_32 * rows;
+    struct _kmz_morphology_worker_t * workers;
+    KmzPixelOperationStatus status;
+};
+
+// region Kernels:
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static size_t _kmz_sse2_morphology_combine(const KmzBool dilate, const uint8_t * const restrict a, const uint8_t * const restrict b,
+        uint8_t * const restrict out, const size_t bytes, size_t i) {
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(a + i)), y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(out + i), dilate ? _mm_max_epu8(x, y) : _mm_min_epu8(x, y));
+    }
+    return i;
+}
+
+/**
+ * Transposes blocks of 4 rows by 4 pixels between rows and a line that interleaves `_KMZ_MORPHOLOGY_BAND_ROWS` rows, in either direction.
+ */
+kmz__target("sse2") static size_t _kmz_sse2_morphology_interleave(kmz_color_32 * const * const restrict rows, const size_t count, const size_t w,
+        kmz_color_32 * const restrict line, const KmzBool scatter, size_t x) {
+    for (; x + 4 <= w; x += 4) {
+        kmz_color_32 * const restrict block = line + x * _KMZ_MORPHOLOGY_BAND_ROWS;
+        for (size_t r = 0; r + 4 <= count; r += 4) {
+            __m128i v[4];
+            for (size_t k = 0; k < 4; ++k) {
+                v[k] = _mm_loadu_si128((const __m128i *)(scatter ? block + k * _KMZ_MORPHOLOGY_BAND_ROWS + r : rows[r + k] + x));
+            }
+            const __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]), t1 = _mm_unpacklo_epi32(v[2], v[3]),
+                  t2 = _mm_unpackhi_epi32(v[0], v[1]), t3 = _mm_unpackhi_epi32(v[2], v[3]);
+            v[0] = _mm_unpacklo_epi64(t0, t1);
+            v[1] = _mm_unpackhi_epi64(t0, t1);
+            v[2] = _mm_unpacklo_epi64(t2, t3);
+            v[3] = _mm_unpackhi_epi64(t2, t3);
+            for (size_t k = 0; k < 4; ++k) {
+                _mm_storeu_si128((__m128i *)(scatter ? rows[r + k] + x : block + k * _KMZ_MORPHOLOGY_BAND_ROWS + r), v[k]);
+            }
+        }
+    }
+    return x;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_morphology_combine(const KmzBool dilate, const uint8_t * const restrict a, const uint8_t * const restrict b,
+        uint8_t * const restrict out, const size_t bytes, size_t i) {
+    for (; i + 32 <= bytes; i += 32) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *)(a + i)), y = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(out + i), dilate ? _mm256_max_epu8(x, y) : _mm256_min_epu8(x, y));
+    }
+    return i;
+}
+#endif
+
+/**
+ * Writes the bytewise minimum, or maximum when dilating, of `a` and `b` to `out`.
+ */
+static void _kmz_morphology_combine(const KmzBool dilate, const uint8_t * const restrict a, const uint8_t * const restrict b, uint8_t * const restrict out,
+        const size_t bytes) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_morphology_combine(dilate, a, b, out, bytes, i);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        i = _kmz_sse2_morphology_combine(dilate, a, b, out, bytes, i);
+    }
+#endif
+    for (; i < bytes; ++i) {
+        out[i] = dilate ? (a[i] > b[i] ? a[i] : b[i]) : (a[i] < b[i] ? a[i] : b[i]);
+    }
+}
+
+/**
+ * Filters a line of `count` elements of `bytes` bytes with the van Herk/Gil-Werman recurrence, writing `count - size + 1` elements to `dst`. The line
+ * is split into blocks of `size` elements, each of which is accumulated forwards into `g` and backwards into `h`, so that every window spans the end
+ * of one block and the start of the next and takes a single combination of `h` and `g`. That is about 3 combinations per element whatever the size.
+ */
+static void _kmz_morphology_line(const KmzBool dilate, const uint8_t * const restrict src, const size_t count, const size_t size, const size_t bytes,
+        uint8_t * const restrict g, uint8_t * const restrict h, uint8_t * const restrict dst) {
+    const size_t n = count - size + 1;
+    if (1 == size) {
+        memcpy(dst, src, n * bytes);
+        return;
+    }
+
+    for (size_t b = 0; b < count; b += size) {
+        const size_t e = b + size < count ? b + size : count;
+        memcpy(g + b * bytes, src + b * bytes, bytes);
+        for (size_t i = b + 1; i < e; ++i) {
+            _kmz_morphology_combine(dilate, g + (i - 1) * bytes, src + i * bytes, g + i * bytes, bytes);
+        }
+        memcpy(h + (e - 1) * bytes, src + (e - 1) * bytes, bytes);
+        for (size_t i = e - 1; i-- > b;) {
+            _kmz_morphology_combine(dilate, h + (i + 1) * bytes, src + i * bytes, h + i * bytes, bytes);
+        }
+    }
+
+    for (size_t x = 0; x < n; ++x) {
+        _kmz_morphology_combine(dilate, h + x * bytes, g + (x + size - 1) * bytes, dst + x * bytes, bytes);
+    }
+}
+
+/**
+ * Copies `count` rows of `w` pixels into a line that interleaves `_KMZ_MORPHOLOGY_BAND_ROWS` rows, or back out of it when scattering.
+ */
+static void _kmz_morphology_interleave(kmz_color_32 * const * const restrict rows, const size_t count, const size_t w, kmz_color_32 * const restrict line,
+        const KmzBool scatter) {
+    size_t x = 0, blocked = 0;
+#ifdef KMZ_SIMD_X86
+    if (KMZ_SIMD_SSE2 <= kmz_simd_level()) {
+        blocked = count & ~(size_t)3;
+        x = _kmz_sse2_morphology_interleave(rows, blocked, w, line, scatter, x);
+    }
+#endif
+    for (size_t r = 0; r < count; ++r) {
+        for (size_t i = r < blocked ? x : 0; i < w; ++i) {
+            if (scatter) {
+                rows[r][i] = line[i * _KMZ_MORPHOLOGY_BAND_ROWS + r];
+            } else {
+                line[i * _KMZ_MORPHOLOGY_BAND_ROWS + r] = rows[r][i];
+            }
+        }
+    }
+}
+
+// endregion;
+
+// region Passes:
+
+static inline struct _kmz_morphology_worker_t * const _kmz_morphology_worker(struct _kmz_morphology_t * const restrict ctx, const size_t worker) {
+    struct _kmz_morphology_worker_t * const restrict state = ctx->workers + worker;
+    if (NULL == state->line) {
+        state->line = malloc(ctx->size);
+        state->g = malloc(ctx->size);
+        state->h = malloc(ctx->size);
+        state->out = malloc(ctx->size);
+    }
+
+    if (NULL == state->line || NULL == state->g || NULL == state->h || NULL == state->out) {
+        KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    return state;
+}
+
+/**
+ * Filters a band of rows horizontally, where pixels past the left and right edges take the value that never wins so every window is clipped to the
+ * image.
+ */
+static void _KmzImage__morphology_rows(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_morphology_t * const restrict ctx = arg;
+    struct _kmz_morphology_worker_t * const restrict state = _kmz_morphology_worker(ctx, worker);
+    if (NULL == state) {
+        return;
+    }
+
+    const size_t w = ctx->dimen.w, y0 = index * _KMZ_MORPHOLOGY_BAND_ROWS,
+          rows = y0 + _KMZ_MORPHOLOGY_BAND_ROWS < ctx->dimen.h ? _KMZ_MORPHOLOGY_BAND_ROWS : ctx->dimen.h - y0,
+          size = ctx->element.w, before = (size - 1) / 2, count = w + size - 1;
+    kmz_color_32 * band[_KMZ_MORPHOLOGY_BAND_ROWS];
+
+    memset(state->line, ctx->dilate ? 0 : UINT8_MAX, count * _KMZ_MORPHOLOGY_BAND_ROWS * sizeof(kmz_color_32));
+    for (size_t r = 0; r < rows; ++r) {
+        band[r] = ctx->pixels + (y0 + r) * w;
+    }
+    _kmz_morphology_interleave(band, rows, w, (kmz_color_32 *)state->line + before * _KMZ_MORPHOLOGY_BAND_ROWS, KMZ_FALSE);
+
+    _kmz_morphology_line(ctx->dilate, state->line, count, size, _KMZ_MORPHOLOGY_BAND_ROWS * sizeof(kmz_color_32), state->g, state->h, state->out);
+
+    for (size_t r = 0; r < rows; ++r) {
+        band[r] = ctx->rows + (y0 + r) * w;
+    }
+    _kmz_morphology_interleave(band, rows, w, (kmz_color_32 *)state->out, KMZ_TRUE);
+}
+
+/**
+ * Filters a strip of columns vertically, where rows past the top and bottom edges take the value that never wins.
+ */
+static void _KmzImage__morphology_columns(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_morphology_t * const restrict ctx = arg;
+    struct _kmz_morphology_worker_t * const restrict state = _kmz_morphology_worker(ctx, worker);
+    if (NULL == state) {
+        return;
+    }
+
+    const size_t w = ctx->dimen.w, h = ctx->dimen.h, x0 = index * _KMZ_MORPHOLOGY_STRIP,
+          columns = x0 + _KMZ_MORPHOLOGY_STRIP < w ? _KMZ_MORPHOLOGY_STRIP : w - x0,
+          size = ctx->element.h, before = (size - 1) / 2, count = h + size - 1, bytes = columns * sizeof(kmz_color_32);
+    const uint8_t fill = ctx->dilate ? 0 : UINT8_MAX;
+
+    for (size_t j = 0; j < count; ++j) {
+        const size_t y = j - before;
+        if (j >= before && y < h) {
+            memcpy(state->line + j * bytes, ctx->rows + y * w + x0, bytes);
+        } else {
+            memset(state->line + j * bytes, fill, bytes);
+        }
+    }
+
+    _kmz_morphology_line(ctx->dilate, state->line, count, size, bytes, state->g, state->h, state->out);
+
+    for (size_t y = 0; y < h; ++y) {
+        memcpy(ctx->pixels + y * w + x0, state->out + y * bytes, bytes);
+    }
+}
+
+// endregion;
+
+/**
+ * Returns the luma of a pixel using the Rec. 601 weights, as a pixel of the same alpha whose every color channel is that luma.
+ */
+static inline const kmz_color_32 _kmz_morphology_gray(const kmz_color_32 color) {
+    const uint32_t luma = (77 * ((color >> 16) & 0xFF) + 150 * ((color >> 8) & 0xFF) + 29 * (color & 0xFF) + 128) >> 8;
+    return (color & 0xFF000000u) | luma << 16 | luma << 8 | luma;
+}
+
+const KmzPixelOperationStatus KmzImage__morphology(const KmzImage * const me, const KmzMorphologyOp op, const KmzSize element, const KmzBool grayscale,
+        KmzImage * const output, const size_t threads) {
+    if ((unsigned int)op > KMZ_MORPHOLOGY_CLOSE || !element.w || !element.h) {
+        return KMZ_PIXEL_OP_ERR_UNKNOWN;
+    }
+
+    const KmzSize dimen = KmzImage__dimen(me), o_dimen = KmzImage__dimen(output);
+    if (o_dimen.w != dimen.w || o_dimen.h != dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    }
+    if (!dimen.w || !dimen.h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t pixels = (size_t)dimen.w * dimen.h,
+          bands = ((size_t)dimen.h + _KMZ_MORPHOLOGY_BAND_ROWS - 1) / _KMZ_MORPHOLOGY_BAND_ROWS,
+          strips = ((size_t)dimen.w + _KMZ_MORPHOLOGY_STRIP - 1) / _KMZ_MORPHOLOGY_STRIP,
+          h_size = ((size_t)dimen.w + element.w - 1) * _KMZ_MORPHOLOGY_BAND_ROWS * sizeof(kmz_color_32),
+          v_size = ((size_t)dimen.h + element.h - 1) * _KMZ_MORPHOLOGY_STRIP * sizeof(kmz_color_32),
+          workers = _kmz_parallel_workers(threads, bands > strips ? bands : strips);
+    struct _kmz_morphology_t ctx = {
+        .dimen = dimen,
+        .element = element,
+        .size = h_size > v_size ? h_size : v_size,
+        .pixels = malloc(pixels * sizeof(kmz_color_32)),
+        .rows = malloc(pixels * sizeof(kmz_color_32)),
+        .workers = calloc(workers, sizeof(struct _kmz_morphology_worker_t)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (NULL == ctx.pixels || NULL == ctx.rows || NULL == ctx.workers) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        ctx.status = KmzImage__read_argb_block(me, kmz_rectangle(KmzPoint__ZERO, dimen), ctx.pixels);
+    }
+
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        for (size_t i = 0; i < pixels; ++i) {
+            ctx.pixels[i] = (grayscale ? _kmz_morphology_gray(ctx.pixels[i]) : ctx.pixels[i]) ^ _KMZ_MORPHOLOGY_OPACITY;
+        }
+
+        // Opening erodes then dilates, while closing dilates then erodes.
+        const size_t stages = KMZ_MORPHOLOGY_OPEN <= op ? 2 : 1;
+        for (size_t stage = 0; KMZ_PIXEL_OP_OK == ctx.status && stage < stages; ++stage) {
+            ctx.dilate = KMZ_MORPHOLOGY_DILATE == op || (KMZ_MORPHOLOGY_OPEN == op && stage) || (KMZ_MORPHOLOGY_CLOSE == op && !stage)
+                ? KMZ_TRUE : KMZ_FALSE;
+            _kmz_parallel_for(_kmz_parallel_workers(threads, bands), bands, &_KmzImage__morphology_rows, &ctx);
+            if (KMZ_PIXEL_OP_OK == ctx.status) {
+                _kmz_parallel_for(_kmz_parallel_workers(threads, strips), strips, &_KmzImage__morphology_columns, &ctx);
+            }
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        for (size_t i = 0; i < pixels; ++i) {
+            ctx.pixels[i] ^= _KMZ_MORPHOLOGY_OPACITY;
+        }
+        ctx.status = KmzImage__write_argb_block(output, kmz_rectangle(KmzPoint__ZERO, dimen), ctx.pixels);
+    }
+
+    if (NULL != ctx.workers) {
+        for (size_t i = 0; i < workers; ++i) {
+            free(ctx.workers[i].line);
+            free(ctx.workers[i].g);
+            free(ctx.workers[i].h);
+            free(ctx.workers[i].out);
+        }
+    }
+    free(ctx.pixels);
+    free(ctx.rows);
+    free(ctx.workers);
+
+    return ctx.status;
+}
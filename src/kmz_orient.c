@@ -0,0 +1,318 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_orient.h"
+
+/**
+ * The length of the square tiles that an image is reoriented in, which keeps every tile of an orbit and its reoriented copy within the L1 cache.
+ */
+#define _KMZ_ORIENT_TILE 64
+
+enum _kmz_orient_e {
+    _KMZ_ORIENT_TRANSPOSE,
+    _KMZ_ORIENT_ROTATE90,
+    _KMZ_ORIENT_ROTATE180,
+    _KMZ_ORIENT_ROTATE270,
+    _KMZ_ORIENT_FLIP_H,
+    _KMZ_ORIENT_FLIP_V,
+};
+typedef enum _kmz_orient_e _KmzOrient;
+
+static inline const KmzBool _kmz_orient_swaps_axes(const _KmzOrient op) {
+    return _KMZ_ORIENT_TRANSPOSE == op || _KMZ_ORIENT_ROTATE90 == op || _KMZ_ORIENT_ROTATE270 == op ? KMZ_TRUE : KMZ_FALSE;
+}
+
+/**
+ * Returns the area that an area of an image of the given dimensions covers once it is reoriented.
+ */
+static inline const KmzRectangle _kmz_orient_area(const _KmzOrient op, const KmzSize dimen, const KmzRectangle area) {
+    const ssize_t x = area.pos.x, y = area.pos.y, w = area.size.w, h = area.size.h;
+    const KmzSize swapped = kmz_size(area.size.h, area.size.w);
+    switch (op) {
+        case _KMZ_ORIENT_TRANSPOSE:
+            return kmz_rectangle(kmz_point(y, x), swapped);
+        case _KMZ_ORIENT_ROTATE90:
+            return kmz_rectangle(kmz_point(dimen.h - y - h, x), swapped);
+        case _KMZ_ORIENT_ROTATE270:
+            return kmz_rectangle(kmz_point(y, dimen.w - x - w), swapped);
+        case _KMZ_ORIENT_ROTATE180:
+            return kmz_rectangle(kmz_point(dimen.w - x - w, dimen.h - y - h), area.size);
+        case _KMZ_ORIENT_FLIP_H:
+            return kmz_rectangle(kmz_point(dimen.w - x - w, y), area.size);
+        default:
+            return kmz_rectangle(kmz_point(x, dimen.h - y - h), area.size);
+    }
+}
+
+/**
+ * Splits an axis into tiles whose bounds mirror each other around its centre, so that every reoriented tile covers exactly one other tile.
+ *
+ * @return The number of tiles, where `bounds` receives one more bound than there are tiles.
+ */
+static const size_t _kmz_orient_bounds(const size_t length, size_t * const restrict bounds) {
+    const size_t half = length / 2;
+    size_t count = 0;
+    for (size_t bound = 0; bound < half; bound += _KMZ_ORIENT_TILE) {
+        bounds[count++] = bound;
+    }
+    const size_t left = count;
+    bounds[count++] = half;
+    if (length - half != half) {
+        bounds[count++] = length - half;
+    }
+    for (size_t i = left; i > 0; --i) {
+        bounds[count++] = length - bounds[i - 1];
+    }
+    return count - 1;
+}
+
+// region Kernels:
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static void _kmz_sse2_transpose_block(const kmz_color_32 * const * const restrict rows, kmz_color_32 * const * const restrict outs) {
+    for (size_t i = 0; i < 8; i += 4) {
+        for (size_t j = 0; j < 8; j += 4) {
+            const __m128i r0 = _mm_loadu_si128((const __m128i *)(rows[i] + j)), r1 = _mm_loadu_si128((const __m128i *)(rows[i + 1] + j)),
+                  r2 = _mm_loadu_si128((const __m128i *)(rows[i + 2] + j)), r3 = _mm_loadu_si128((const __m128i *)(rows[i + 3] + j)),
+                  t0 = _mm_unpacklo_epi32(r0, r1), t1 = _mm_unpacklo_epi32(r2, r3), t2 = _mm_unpackhi_epi32(r0, r1), t3 = _mm_unpackhi_epi32(r2, r3);
+            _mm_storeu_si128((__m128i *)(outs[j] + i), _mm_unpacklo_epi64(t0, t1));
+            _mm_storeu_si128((__m128i *)(outs[j + 1] + i), _mm_unpackhi_epi64(t0, t1));
+            _mm_storeu_si128((__m128i *)(outs[j + 2] + i), _mm_unpacklo_epi64(t2, t3));
+            _mm_storeu_si128((__m128i *)(outs[j + 3] + i), _mm_unpackhi_epi64(t2, t3));
+        }
+    }
+}
+
+kmz__target("sse2") static size_t _kmz_sse2_reverse(const kmz_color_32 * const restrict src, kmz_color_32 * const restrict dst, const size_t count,
+        size_t x) {
+    for (; x + 4 <= count; x += 4) {
+        _mm_storeu_si128((__m128i *)(dst + count - x - 4), _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(src + x)), 0x1B));
+    }
+    return x;
+}
+
+kmz__target("avx2") static void _kmz_avx2_transpose_block(const kmz_color_32 * const * const restrict rows, kmz_color_32 * const * const restrict outs) {
+    __m256i r[8], t[8], u[8];
+    for (size_t i = 0; i < 8; ++i) {
+        r[i] = _mm256_loadu_si256((const __m256i *)rows[i]);
+    }
+    for (size_t i = 0; i < 8; i += 2) {
+        t[i] = _mm256_unpacklo_epi32(r[i], r[i + 1]);
+        t[i + 1] = _mm256_unpackhi_epi32(r[i], r[i + 1]);
+    }
+    for (size_t i = 0; i < 8; i += 4) {
+        u[i] = _mm256_unpacklo_epi64(t[i], t[i + 2]);
+        u[i + 1] = _mm256_unpackhi_epi64(t[i], t[i + 2]);
+        u[i + 2] = _mm256_unpacklo_epi64(t[i + 1], t[i + 3]);
+        u[i + 3] = _mm256_unpackhi_epi64(t[i + 1], t[i + 3]);
+    }
+    // Each 128 bit lane now holds half of a column, the low lanes columns 0 to 3 and the high lanes columns 4 to 7.
+    for (size_t j = 0; j < 4; ++j) {
+        _mm256_storeu_si256((__m256i *)outs[j], _mm256_permute2x128_si256(u[j], u[j + 4], 0x20));
+        _mm256_storeu_si256((__m256i *)outs[j + 4], _mm256_permute2x128_si256(u[j], u[j + 4], 0x31));
+    }
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_reverse(const kmz_color_32 * const restrict src, kmz_color_32 * const restrict dst, const size_t count,
+        size_t x) {
+    const __m256i order = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    for (; x + 8 <= count; x += 8) {
+        _mm256_storeu_si256((__m256i *)(dst + count - x - 8), _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)(src + x)), order));
+    }
+    return x;
+}
+#endif
+
+/**
+ * Transposes a block of at most 8x8 pixels, where the rows of the block are read from `rows` and the columns are written to `outs`.
+ */
+static void _kmz_transpose_block(const kmz_color_32 * const * const restrict rows, kmz_color_32 * const * const restrict outs, const size_t w,
+        const size_t h) {
+#ifdef KMZ_SIMD_X86
+    if (8 == w && 8 == h) {
+        const KmzSimdLevel level = kmz_simd_level();
+        if (KMZ_SIMD_AVX2 <= level) {
+            _kmz_avx2_transpose_block(rows, outs);
+            return;
+        }
+        if (KMZ_SIMD_SSE2 <= level) {
+            _kmz_sse2_transpose_block(rows, outs);
+            return;
+        }
+    }
+#endif
+    for (size_t j = 0; j < w; ++j) {
+        for (size_t i = 0; i < h; ++i) {
+            outs[j][i] = rows[i][j];
+        }
+    }
+}
+
+static void _kmz_reverse(const kmz_color_32 * const restrict src, kmz_color_32 * const restrict dst, const size_t count) {
+    size_t x = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        x = _kmz_avx2_reverse(src, dst, count, x);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        x = _kmz_sse2_reverse(src, dst, count, x);
+    }
+#endif
+    for (; x < count; ++x) {
+        dst[count - x - 1] = src[x];
+    }
+}
+
+/**
+ * Reorients a tile of `w` by `h` pixels. The operations that swap axes transpose the tile in blocks of 8x8 pixels, reading the rows of each block
+ * bottom up to rotate by 90 degrees or writing its columns right to left to rotate by 270 degrees.
+ */
+static void _kmz_orient_tile(const _KmzOrient op, const kmz_color_32 * const restrict src, const size_t w, const size_t h,
+        kmz_color_32 * const restrict dst) {
+    if (_kmz_orient_swaps_axes(op)) {
+        const kmz_color_32 * rows[8];
+        kmz_color_32 * outs[8];
+        for (size_t by = 0; by < h; by += 8) {
+            const size_t b_h = by + 8 <= h ? 8 : h - by;
+            for (size_t bx = 0; bx < w; bx += 8) {
+                const size_t b_w = bx + 8 <= w ? 8 : w - bx;
+                for (size_t i = 0; i < b_h; ++i) {
+                    rows[i] = src + (_KMZ_ORIENT_ROTATE90 == op ? h - 1 - by - i : by + i) * w + bx;
+                }
+                for (size_t j = 0; j < b_w; ++j) {
+                    outs[j] = dst + (_KMZ_ORIENT_ROTATE270 == op ? w - 1 - bx - j : bx + j) * h + by;
+                }
+                _kmz_transpose_block(rows, outs, b_w, b_h);
+            }
+        }
+    } else {
+        for (size_t y = 0; y < h; ++y) {
+            kmz_color_32 * const restrict out = dst + (_KMZ_ORIENT_FLIP_H == op ? y : h - 1 - y) * w;
+            if (_KMZ_ORIENT_FLIP_V == op) {
+                memcpy(out, src + y * w, w * sizeof(kmz_color_32));
+            } else {
+                _kmz_reverse(src + y * w, out, w);
+            }
+        }
+    }
+}
+
+// endregion;
+
+/**
+ * Reorients an image one tile at a time. When reorienting in place, the tiles that a tile is moved through until it returns to itself are read
+ * before any of them is written, which is at most 4 tiles as every operation repeated 4 times is the identity.
+ */
+static const KmzPixelOperationStatus _kmz_orient(const KmzImage * const me, const _KmzOrient op, KmzImage * const output) {
+    const KmzSize dimen = KmzImage__dimen(me), o_dimen = KmzImage__dimen(output);
+    const KmzBool swaps = _kmz_orient_swaps_axes(op);
+    if (o_dimen.w != (swaps ? dimen.h : dimen.w) || o_dimen.h != (swaps ? dimen.w : dimen.h)) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    }
+    if (!dimen.w || !dimen.h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t tile = _KMZ_ORIENT_TILE * _KMZ_ORIENT_TILE;
+    size_t * const restrict xs = malloc(((size_t)dimen.w / _KMZ_ORIENT_TILE + (size_t)dimen.h / _KMZ_ORIENT_TILE + 8) * sizeof(size_t));
+    kmz_color_32 * const restrict tiles = malloc(5 * tile * sizeof(kmz_color_32));
+    if (NULL == xs || NULL == tiles) {
+        free(xs);
+        free(tiles);
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    size_t * const restrict ys = xs + dimen.w / _KMZ_ORIENT_TILE + 4;
+    const size_t columns = _kmz_orient_bounds(dimen.w, xs), rows = _kmz_orient_bounds(dimen.h, ys);
+    kmz_color_32 * const restrict out = tiles + 4 * tile;
+    KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+
+    for (size_t ty = 0; KMZ_PIXEL_OP_OK == status && ty < rows; ++ty) {
+        for (size_t tx = 0; KMZ_PIXEL_OP_OK == status && tx < columns; ++tx) {
+            KmzRectangle orbit[4] = {kmz_rectangle(kmz_point((ssize_t)xs[tx], (ssize_t)ys[ty]),
+                    kmz_size((uint16_t)(xs[tx + 1] - xs[tx]), (uint16_t)(ys[ty + 1] - ys[ty])))};
+            size_t count = 1;
+            KmzBool first = KMZ_TRUE;
+            if (output == me) {
+                // Only the first tile of each orbit in scan order moves the orbit.
+                for (KmzRectangle next = _kmz_orient_area(op, dimen, orbit[0]); count < 4 && (next.pos.x != orbit[0].pos.x || next.pos.y != orbit[0].pos.y);
+                        next = _kmz_orient_area(op, dimen, next)) {
+                    if (next.pos.y < orbit[0].pos.y || (next.pos.y == orbit[0].pos.y && next.pos.x < orbit[0].pos.x)) {
+                        first = KMZ_FALSE;
+                        break;
+                    }
+                    orbit[count++] = next;
+                }
+            }
+            if (!first) {
+                continue;
+            }
+
+            for (size_t i = 0; KMZ_PIXEL_OP_OK == status && i < count; ++i) {
+                status = KmzImage__read_argb_block(me, orbit[i], tiles + i * tile);
+            }
+            for (size_t i = 0; KMZ_PIXEL_OP_OK == status && i < count; ++i) {
+                _kmz_orient_tile(op, tiles + i * tile, orbit[i].size.w, orbit[i].size.h, out);
+                status = KmzImage__write_argb_block(output, _kmz_orient_area(op, dimen, orbit[i]), out);
+            }
+        }
+    }
+
+    free(xs);
+    free(tiles);
+    return status;
+}
+
+const KmzPixelOperationStatus KmzImage__transpose(const KmzImage * const me, KmzImage * const output) {
+    return _kmz_orient(me, _KMZ_ORIENT_TRANSPOSE, output);
+}
+
+const KmzPixelOperationStatus KmzImage__rotate90(const KmzImage * const me, KmzImage * const output) {
+    return _kmz_orient(me, _KMZ_ORIENT_ROTATE90, output);
+}
+
+const KmzPixelOperationStatus KmzImage__rotate180(const KmzImage * const me, KmzImage * const output) {
+    return _kmz_orient(me, _KMZ_ORIENT_ROTATE180, output);
+}
+
+const KmzPixelOperationStatus KmzImage__rotate270(const KmzImage * const me, KmzImage * const output) {
+    return _kmz_orient(me, _KMZ_ORIENT_ROTATE270, output);
+}
+
+const KmzPixelOperationStatus KmzImage__flip_h(const KmzImage * const me, KmzImage * const output) {
+    return _kmz_orient(me, _KMZ_ORIENT_FLIP_H, output);
+}
+
+const KmzPixelOperationStatus KmzImage__flip_v(const KmzImage * const me, KmzImage * const output) {
+    return _kmz_orient(me, _KMZ_ORIENT_FLIP_V, output);
+}
@@ -0,0 +1,537 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_palette_image.h"
+
+#define _KMZ_PALETTE_IMAGE_COLORS 256
+#define _KMZ_PALETTE_IMAGE_SLOTS 1024
+#define _KmzPaletteImage__hash(color) ((size_t)(((color) * 0x9E3779B1u) >> 22))
+
+/**
+ * An open addressing table that maps ARGB values to palette indices, including the nearest palette index of colors that aren't in the
+ * palette, so that writes don't search the palette once per pixel.
+ */
+struct _kmz_palette_lookup_t {
+    size_t used;
+    kmz_color_32 colors[_KMZ_PALETTE_IMAGE_SLOTS];
+    int16_t indices[_KMZ_PALETTE_IMAGE_SLOTS];
+};
+
+struct _kmz_palette_image_t {
+    KmzSize dimen;
+    size_t len;
+    size_t count;
+    KmzBool owns_indices;
+    uint8_t * indices;
+    struct _kmz_palette_lookup_t * lookup;
+    kmz_color_32 palette[_KMZ_PALETTE_IMAGE_COLORS];
+    // Every channel of the first 16 palette entries as its own byte table, used to expand small palettes with byte shuffles.
+    uint8_t planes[4][16];
+};
+
+struct _kmz_palette_image_argv_t {
+    KmzSize dimen;
+    const kmz_color_32 * palette;
+    size_t count;
+    uint8_t * indices;
+    KmzBool copy_source;
+};
+
+#ifdef KMZ_SIMD_X86
+kmz__target("ssse3") static size_t _kmz_ssse3_expand_indices(const uint8_t (* const restrict planes)[16], const uint8_t * const restrict indices,
+        kmz_color_32 * const restrict dst, const size_t count) {
+    const __m128i b = _mm_loadu_si128((const __m128i *)planes[0]), g = _mm_loadu_si128((const __m128i *)planes[1]),
+          r = _mm_loadu_si128((const __m128i *)planes[2]), a = _mm_loadu_si128((const __m128i *)planes[3]);
+    size_t i = 0;
+
+    for (; i + 16 <= count; i += 16) {
+        const __m128i index = _mm_loadu_si128((const __m128i *)(indices + i));
+        const __m128i bv = _mm_shuffle_epi8(b, index), gv = _mm_shuffle_epi8(g, index),
+              rv = _mm_shuffle_epi8(r, index), av = _mm_shuffle_epi8(a, index);
+        const __m128i bg_lo = _mm_unpacklo_epi8(bv, gv), bg_hi = _mm_unpackhi_epi8(bv, gv),
+              ra_lo = _mm_unpacklo_epi8(rv, av), ra_hi = _mm_unpackhi_epi8(rv, av);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi16(bg_lo, ra_lo));
+        _mm_storeu_si128((__m128i *)(dst + i + 4), _mm_unpackhi_epi16(bg_lo, ra_lo));
+        _mm_storeu_si128((__m128i *)(dst + i + 8), _mm_unpacklo_epi16(bg_hi, ra_hi));
+        _mm_storeu_si128((__m128i *)(dst + i + 12), _mm_unpackhi_epi16(bg_hi, ra_hi));
+    }
+    return i;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_expand_indices(const kmz_color_32 * const restrict palette, const uint8_t * const restrict indices,
+        kmz_color_32 * const restrict dst, const size_t count) {
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indices + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_i32gather_epi32((const int *)palette, index, 4));
+    }
+    return i;
+}
+#endif
+
+static void _KmzPaletteImage__expand(const struct _kmz_palette_image_t * const restrict me, const size_t offset, kmz_color_32 * const restrict dst,
+        const size_t count) {
+    const uint8_t * const restrict indices = me->indices + offset;
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    // Every index is below the color count, so palettes of up to 16 colors never reach past the byte tables.
+    if (16 >= me->count && KMZ_SIMD_SSSE3 <= level) {
+        i = _kmz_ssse3_expand_indices((const uint8_t (*)[16])me->planes, indices, dst, count);
+    } else if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_expand_indices(me->palette, indices, dst, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = me->palette[indices[i]];
+    }
+}
+
+static void _KmzPaletteImage__split_planes(struct _kmz_palette_image_t * const restrict me) {
+    for (size_t i = 0; i < 16; ++i) {
+        me->planes[0][i] = (uint8_t)me->palette[i];
+        me->planes[1][i] = (uint8_t)(me->palette[i] >> 8);
+        me->planes[2][i] = (uint8_t)(me->palette[i] >> 16);
+        me->planes[3][i] = (uint8_t)(me->palette[i] >> 24);
+    }
+}
+
+static void _KmzPaletteImage__palette_changed(struct _kmz_palette_image_t * const restrict me) {
+    _KmzPaletteImage__split_planes(me);
+
+    // The lookup is rebuilt the next time a color is written, since the nearest colors it remembers may no longer be the nearest.
+    if (NULL != me->lookup) {
+        me->lookup->used = 0;
+        memset(me->lookup->indices, 0xFF, sizeof(me->lookup->indices));
+    }
+}
+
+static const uint8_t _KmzPaletteImage__nearest(const struct _kmz_palette_image_t * const restrict me, const kmz_color_32 color) {
+    uint32_t best_distance = UINT32_MAX;
+    uint8_t best = 0;
+
+    for (size_t i = 0; i < me->count && 0 != best_distance; ++i) {
+        uint32_t distance = 0;
+        for (unsigned shift = 0; shift < 32; shift += 8) {
+            const int32_t d = (int32_t)((color >> shift) & 0xFFu) - (int32_t)((me->palette[i] >> shift) & 0xFFu);
+            distance += (uint32_t)(d * d);
+        }
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = (uint8_t)i;
+        }
+    }
+    return best;
+}
+
+static void _KmzPaletteImage__remember(struct _kmz_palette_lookup_t * const restrict lookup, const kmz_color_32 color, const uint8_t index) {
+    size_t slot = _KmzPaletteImage__hash(color);
+    while (-1 != lookup->indices[slot]) {
+        if (lookup->colors[slot] == color) {
+            return;
+        }
+        slot = (slot + 1) & (_KMZ_PALETTE_IMAGE_SLOTS - 1);
+    }
+    lookup->colors[slot] = color;
+    lookup->indices[slot] = index;
+    ++lookup->used;
+}
+
+/**
+ * Returns the palette index used to store `color`, appending it to the palette while there is room and using the nearest palette color
+ * otherwise. Returns -1 if there isn't enough memory for the lookup table.
+ */
+static const int _KmzPaletteImage__index_of(struct _kmz_palette_image_t * const restrict me, const kmz_color_32 color) {
+    if (NULL == me->lookup) {
+        me->lookup = malloc(sizeof(struct _kmz_palette_lookup_t));
+        if (NULL == me->lookup) {
+            return -1;
+        }
+        me->lookup->used = 0;
+        memset(me->lookup->indices, 0xFF, sizeof(me->lookup->indices));
+    }
+
+    struct _kmz_palette_lookup_t * const restrict lookup = me->lookup;
+    if (0 == lookup->used) {
+        for (size_t i = 0; i < me->count; ++i) {
+            _KmzPaletteImage__remember(lookup, me->palette[i], (uint8_t)i);
+        }
+    }
+
+    size_t slot = _KmzPaletteImage__hash(color);
+    while (-1 != lookup->indices[slot]) {
+        if (lookup->colors[slot] == color) {
+            return lookup->indices[slot];
+        }
+        slot = (slot + 1) & (_KMZ_PALETTE_IMAGE_SLOTS - 1);
+    }
+
+    uint8_t index;
+    if (_KMZ_PALETTE_IMAGE_COLORS > me->count) {
+        index = (uint8_t)me->count;
+        me->palette[me->count++] = color;
+        if (16 >= me->count) {
+            _KmzPaletteImage__split_planes(me);
+        }
+    } else {
+        index = _KmzPaletteImage__nearest(me, color);
+    }
+
+    // Nearest colors are forgotten once the table fills up, while the palette itself is always remembered again.
+    if (lookup->used >= (_KMZ_PALETTE_IMAGE_SLOTS / 4) * 3) {
+        lookup->used = 0;
+        memset(lookup->indices, 0xFF, sizeof(lookup->indices));
+        for (size_t i = 0; i < me->count; ++i) {
+            _KmzPaletteImage__remember(lookup, me->palette[i], (uint8_t)i);
+        }
+        _KmzPaletteImage__remember(lookup, color, index);
+    } else {
+        lookup->colors[slot] = color;
+        lookup->indices[slot] = index;
+        ++lookup->used;
+    }
+    return index;
+}
+
+static const KmzBool _KmzPaletteImage__store(struct _kmz_palette_image_t * const restrict me, const size_t offset, const kmz_color_32 * const restrict src,
+        const size_t count) {
+    uint8_t * const restrict indices = me->indices + offset;
+    kmz_color_32 last = 0;
+    int index = -1;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (-1 == index || src[i] != last) {
+            last = src[i];
+            index = _KmzPaletteImage__index_of(me, last);
+            if (-1 == index) {
+                return KMZ_FALSE;
+            }
+        }
+        indices[i] = (uint8_t)index;
+    }
+    return KMZ_TRUE;
+}
+
+static struct _kmz_palette_image_t * const _KmzPaletteImage__new(void) {
+    struct _kmz_palette_image_t * const restrict me = malloc(sizeof(struct _kmz_palette_image_t));
+
+    if (NULL != me) {
+        me->dimen = KmzSize__ZERO;
+        me->len = 0;
+        me->count = 0;
+        me->owns_indices = KMZ_FALSE;
+        me->indices = NULL;
+        me->lookup = NULL;
+    }
+
+    return me;
+}
+
+static void _KmzPaletteImage__ctor(struct _kmz_palette_image_t * const restrict me, const struct _kmz_palette_image_argv_t * const restrict args) {
+    const size_t len = (size_t)args->dimen.w * args->dimen.h;
+    const size_t count = args->count < _KMZ_PALETTE_IMAGE_COLORS ? args->count : _KMZ_PALETTE_IMAGE_COLORS;
+
+    if (NULL == args->indices || KMZ_TRUE == args->copy_source) {
+        me->indices = calloc(len ? len : 1, sizeof(uint8_t));
+        if (NULL == me->indices) {
+            // The missing indices are detected by _KmzPaletteImage__new_image, which frees the image.
+            return;
+        }
+        me->owns_indices = KMZ_TRUE;
+        if (NULL != args->indices) {
+            memcpy(me->indices, args->indices, len * sizeof(uint8_t));
+        }
+    } else {
+        me->indices = args->indices;
+        me->owns_indices = KMZ_FALSE;
+    }
+
+    me->dimen = args->dimen;
+    me->len = len;
+    memset(me->palette, 0, sizeof(me->palette));
+    if (NULL != args->palette) {
+        memcpy(me->palette, args->palette, count * sizeof(kmz_color_32));
+    }
+
+    // Indices beyond the given colors still have a palette entry, so the color count always covers the highest index in use.
+    uint8_t highest = 0;
+    for (size_t i = 0; i < len; ++i) {
+        highest = me->indices[i] > highest ? me->indices[i] : highest;
+    }
+    me->count = (0 == len || (size_t)highest < count) ? count : (size_t)highest + 1;
+    _KmzPaletteImage__palette_changed(me);
+}
+
+static void _KmzPaletteImage__dtor(struct _kmz_palette_image_t * const restrict me) {
+    if (KMZ_TRUE == me->owns_indices) {
+        free(me->indices);
+    }
+    free(me->lookup);
+    free(me);
+}
+
+static const KmzSize _KmzPaletteImage__dimen(const struct _kmz_palette_image_t * const restrict me) {
+    return me->dimen;
+}
+
+static const KmzBool _KmzPaletteImage__is_valid(const struct _kmz_palette_image_t * const restrict me, const KmzPoint point) {
+    return (me->dimen.w > point.x && point.x > -1 && me->dimen.h > point.y && point.y > -1);
+}
+
+static const kmz_color_32 _KmzPaletteImage__argb_at(const struct _kmz_palette_image_t * const restrict me, const KmzPoint point) {
+    return me->palette[me->indices[(size_t)((me->dimen.w * point.y) + point.x)]];
+}
+
+static void _KmzPaletteImage__set_argb_at(struct _kmz_palette_image_t * const restrict me, const KmzPoint point, const kmz_color_32 color) {
+    const int index = _KmzPaletteImage__index_of(me, color);
+    if (-1 != index) {
+        me->indices[(size_t)((me->dimen.w * point.y) + point.x)] = (uint8_t)index;
+    }
+}
+
+static const KmzPixelOperationStatus _KmzPaletteImage__read_argb_block(const struct _kmz_palette_image_t * const restrict me, const KmzRectangle src_area,
+        kmz_color_32 * const restrict dst) {
+    if (src_area.pos.x < 0 || src_area.pos.x >= me->dimen.w || src_area.pos.y < 0 || src_area.pos.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_POS;
+    } else if ((src_area.size.w + src_area.pos.x) > me->dimen.w || (src_area.size.h + src_area.pos.y) > me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_SIZE;
+    } else if (NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    if (src_area.size.w == me->dimen.w) {
+        _KmzPaletteImage__expand(me, (size_t)src_area.pos.y * me->dimen.w, dst, (size_t)src_area.size.h * src_area.size.w);
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    size_t src_offset = (size_t)((src_area.pos.y * me->dimen.w) + src_area.pos.x), dst_offset = 0;
+    for (uint16_t line = 0; line < src_area.size.h; ++line) {
+        _KmzPaletteImage__expand(me, src_offset, dst + dst_offset, src_area.size.w);
+        src_offset += me->dimen.w;
+        dst_offset += src_area.size.w;
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzPaletteImage__write_argb_block(struct _kmz_palette_image_t * const restrict me, const KmzRectangle dst_area,
+        const kmz_color_32 * const restrict src) {
+    if (dst_area.pos.x < 0 || dst_area.pos.x >= me->dimen.w || dst_area.pos.y < 0 || dst_area.pos.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_POS;
+    } else if ((dst_area.size.w + dst_area.pos.x) > me->dimen.w || (dst_area.size.h + dst_area.pos.y) > me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    } else if (NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    size_t dst_offset = (size_t)((dst_area.pos.y * me->dimen.w) + dst_area.pos.x), src_offset = 0;
+    for (uint16_t line = 0; line < dst_area.size.h; ++line) {
+        if (KMZ_TRUE != _KmzPaletteImage__store(me, dst_offset, src + src_offset, dst_area.size.w)) {
+            return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+        }
+        dst_offset += me->dimen.w;
+        src_offset += dst_area.size.w;
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzPaletteImage__read_row_span(const struct _kmz_palette_image_t * const restrict me, const KmzPoint start,
+        const size_t count, kmz_color_32 * const restrict dst) {
+    if (start.x < 0 || start.x >= me->dimen.w || start.y < 0 || start.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_POS;
+    } else if (count > (size_t)(me->dimen.w - start.x)) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_SIZE;
+    } else if (NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    _KmzPaletteImage__expand(me, (size_t)((start.y * me->dimen.w) + start.x), dst, count);
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzPaletteImage__write_row_span(struct _kmz_palette_image_t * const restrict me, const KmzPoint start,
+        const size_t count, const kmz_color_32 * const restrict src) {
+    if (start.x < 0 || start.x >= me->dimen.w || start.y < 0 || start.y >= me->dimen.h) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_POS;
+    } else if (count > (size_t)(me->dimen.w - start.x)) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    } else if (NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    if (KMZ_TRUE != _KmzPaletteImage__store(me, (size_t)((start.y * me->dimen.w) + start.x), src, count)) {
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzPaletteImage__gather(const struct _kmz_palette_image_t * const restrict me, const KmzPoint * const restrict points,
+        const size_t count, kmz_color_32 * const restrict dst) {
+    if (NULL == points || NULL == dst) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    const size_t w = me->dimen.w, h = me->dimen.h;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t x = (size_t)points[i].x, y = (size_t)points[i].y;
+        dst[i] = (x < w && y < h) ? me->palette[me->indices[y * w + x]] : 0x00000000;
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+static const KmzPixelOperationStatus _KmzPaletteImage__scatter(struct _kmz_palette_image_t * const restrict me, const KmzPoint * const restrict points,
+        const size_t count, const kmz_color_32 * const restrict src) {
+    if (NULL == points || NULL == src) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    }
+
+    const size_t w = me->dimen.w, h = me->dimen.h;
+    for (size_t i = 0; i < count; ++i) {
+        const size_t x = (size_t)points[i].x, y = (size_t)points[i].y;
+        if (x < w && y < h) {
+            const int index = _KmzPaletteImage__index_of(me, src[i]);
+            if (-1 == index) {
+                return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+            }
+            me->indices[y * w + x] = (uint8_t)index;
+        }
+    }
+
+    return KMZ_PIXEL_OP_OK;
+}
+
+const KmzImageType kmz_palette_image = {
+    ._new=(void * const (*)(void))&_KmzPaletteImage__new,
+    ._ctor=(void (*)(void * const restrict, const void * const restrict))&_KmzPaletteImage__ctor,
+    ._dtor=(void (*)(void * const restrict))&_KmzPaletteImage__dtor,
+    .dimen=(const KmzSize (*)(const void * const restrict))&_KmzPaletteImage__dimen,
+    .argb_at=(const kmz_color_32 (*)(const void * const restrict, const KmzPoint))&_KmzPaletteImage__argb_at,
+    .set_argb_at=(void (*)(void * const restrict, const KmzPoint, const kmz_color_32))&_KmzPaletteImage__set_argb_at,
+    .is_valid=(const KmzBool (*)(const void * const restrict, const KmzPoint))&_KmzPaletteImage__is_valid,
+    .read_argb_block=(const KmzPixelOperationStatus (*)(const void * const restrict, const KmzRectangle, kmz_color_32 * const restrict))&_KmzPaletteImage__read_argb_block,
+    .write_argb_block=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzRectangle, const kmz_color_32 * const restrict))&_KmzPaletteImage__write_argb_block,
+    .read_row_span=(const KmzPixelOperationStatus (*)(const void * const restrict, const KmzPoint, const size_t, kmz_color_32 * const restrict))&_KmzPaletteImage__read_row_span,
+    .write_row_span=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzPoint, const size_t, const kmz_color_32 * const restrict))&_KmzPaletteImage__write_row_span,
+    .gather=(const KmzPixelOperationStatus (*)(const void * const restrict, const KmzPoint * const restrict, const size_t, kmz_color_32 * const restrict))&_KmzPaletteImage__gather,
+    .scatter=(const KmzPixelOperationStatus (*)(void * const restrict, const KmzPoint * const restrict, const size_t, const kmz_color_32 * const restrict))&_KmzPaletteImage__scatter
+};
+
+static KmzImage * const _KmzPaletteImage__new_image(const struct _kmz_palette_image_argv_t * const restrict argv) {
+    KmzImage * const restrict me = KmzImage__new(&kmz_palette_image, argv);
+
+    if (NULL != me && NULL == ((struct _kmz_palette_image_t *)_KmzImage__impl(me))->indices) {
+        KmzImage__free(me);
+        return NULL;
+    }
+    return me;
+}
+
+KmzImage * const KmzImage__new_palette_from_buffer(const KmzSize dimen, const kmz_color_32 * const restrict palette, const size_t color_count,
+        uint8_t * const restrict indices, const KmzBool copy_source) {
+    const struct _kmz_palette_image_argv_t argv = {dimen, palette, color_count, indices, copy_source};
+    return _KmzPaletteImage__new_image(&argv);
+}
+
+KmzImage * const KmzImage__new_palette_from_file(KmzImageFile * const restrict file) {
+    if (KMZ_IMAGE_FILE_PALETTE != KmzImageFile__color_type(file)) {
+        return NULL;
+    }
+
+    const KmzSize dimen = KmzImageFile__dimen(file);
+    const size_t count = KmzImageFile__palette_color_count(file);
+    kmz_color_32 colors[_KMZ_PALETTE_IMAGE_COLORS];
+    if (_KMZ_PALETTE_IMAGE_COLORS < count) {
+        return NULL;
+    }
+
+    const size_t len = (size_t)dimen.w * dimen.h;
+    uint8_t * const restrict indices = malloc(len ? len : 1);
+    if (NULL == indices) {
+        return NULL;
+    }
+    if (KMZ_IMAGE_FILE_OK != KmzImageFile__read_palette_colors(file, colors)
+            || KMZ_IMAGE_FILE_OK != KmzImageFile__read_palette_pixels(file, indices)) {
+        free(indices);
+        return NULL;
+    }
+
+    // The index plane read from the file is handed over to the image instead of being copied a second time.
+    const struct _kmz_palette_image_argv_t argv = {dimen, colors, count, indices, KMZ_FALSE};
+    KmzImage * const restrict me = _KmzPaletteImage__new_image(&argv);
+    if (NULL == me) {
+        free(indices);
+        return NULL;
+    }
+    ((struct _kmz_palette_image_t *)_KmzImage__impl(me))->owns_indices = KMZ_TRUE;
+    return me;
+}
+
+const size_t KmzImage__palette_color_count(const KmzImage * const restrict me) {
+    if (&kmz_palette_image != KmzImage__type(me)) {
+        return 0;
+    }
+    return ((const struct _kmz_palette_image_t *)_KmzImage__impl(me))->count;
+}
+
+uint8_t * const KmzImage__palette_indices(KmzImage * const restrict me) {
+    if (&kmz_palette_image != KmzImage__type(me)) {
+        return NULL;
+    }
+    return ((struct _kmz_palette_image_t *)_KmzImage__impl(me))->indices;
+}
+
+const KmzPixelOperationStatus KmzImage__read_palette(const KmzImage * const restrict me, kmz_color_32 * const restrict colors) {
+    if (&kmz_palette_image != KmzImage__type(me) || NULL == colors) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    const struct _kmz_palette_image_t * const restrict impl = _KmzImage__impl(me);
+    memcpy(colors, impl->palette, impl->count * sizeof(kmz_color_32));
+    return KMZ_PIXEL_OP_OK;
+}
+
+const KmzPixelOperationStatus KmzImage__write_palette(KmzImage * const restrict me, const kmz_color_32 * const restrict colors, const size_t count) {
+    if (&kmz_palette_image != KmzImage__type(me) || NULL == colors) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_PTR;
+    } else if (_KMZ_PALETTE_IMAGE_COLORS < count) {
+        return KMZ_PIXEL_OP_ERR_WRITE_INVALID_SIZE;
+    }
+
+    struct _kmz_palette_image_t * const restrict impl = _KmzImage__impl(me);
+    memcpy(impl->palette, colors, count * sizeof(kmz_color_32));
+    impl->count = count > impl->count ? count : impl->count;
+    _KmzPaletteImage__palette_changed(impl);
+    return KMZ_PIXEL_OP_OK;
+}
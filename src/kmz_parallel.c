@@ -0,0 +1,184 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_parallel.h"
+
+static size_t _kmz_thread_count = 0;
+
+struct _kmz_parallel_t {
+    size_t count;
+    size_t next;
+    _KmzParallelTask task;
+    void * arg;
+};
+
+static void _kmz_parallel_run(struct _kmz_parallel_t * const restrict shared, const size_t worker) {
+    for (size_t i = __atomic_fetch_add(&shared->next, 1, __ATOMIC_RELAXED); i < shared->count;
+            i = __atomic_fetch_add(&shared->next, 1, __ATOMIC_RELAXED)) {
+        shared->task(shared->arg, i, worker);
+    }
+}
+
+/**
+ * The persistent workers shared by every call of {@link _kmz_parallel_for}, which are started on first use and kept sleeping between calls. The
+ * pool runs a single job at a time, and every field is guarded by `lock`.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    size_t threads;
+    /**
+     * Incremented for every job, so a woken thread can tell a new job from a spurious wake up.
+     */
+    size_t generation;
+    struct _kmz_parallel_t * job;
+    /**
+     * The number of pool threads that take part in the current job, which are those with a worker index below `workers`.
+     */
+    size_t workers;
+    size_t pending;
+    KmzBool busy;
+} _kmz_parallel_pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+static void * _kmz_parallel_thread(void * const restrict arg) {
+    const size_t worker = (size_t)(uintptr_t)arg;
+    // A thread is started while the lock is held for the job that needs it, so it takes part in whichever job is current once it gets the lock.
+    size_t seen = SIZE_MAX;
+
+    pthread_mutex_lock(&_kmz_parallel_pool.lock);
+    for (;;) {
+        while (seen == _kmz_parallel_pool.generation) {
+            pthread_cond_wait(&_kmz_parallel_pool.wake, &_kmz_parallel_pool.lock);
+        }
+        seen = _kmz_parallel_pool.generation;
+        if (NULL == _kmz_parallel_pool.job || worker >= _kmz_parallel_pool.workers) {
+            continue;
+        }
+
+        struct _kmz_parallel_t * const restrict job = _kmz_parallel_pool.job;
+        pthread_mutex_unlock(&_kmz_parallel_pool.lock);
+        _kmz_parallel_run(job, worker);
+        pthread_mutex_lock(&_kmz_parallel_pool.lock);
+
+        if (0 == --_kmz_parallel_pool.pending) {
+            pthread_cond_signal(&_kmz_parallel_pool.done);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Starts pool threads until there are `threads` of them, which MUST be called with the lock of the pool held.
+ */
+static void _kmz_parallel_grow(const size_t threads) {
+    pthread_attr_t attr;
+    if (_kmz_parallel_pool.threads >= threads || 0 != pthread_attr_init(&attr)) {
+        return;
+    }
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    while (_kmz_parallel_pool.threads < threads) {
+        pthread_t thread;
+        // Pool thread `i` is worker `i + 1`, as the calling thread is always worker 0.
+        if (0 != pthread_create(&thread, &attr, &_kmz_parallel_thread, (void *)(uintptr_t)(_kmz_parallel_pool.threads + 1))) {
+            break;
+        }
+        ++_kmz_parallel_pool.threads;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+const size_t kmz_thread_count(void) {
+    const size_t threads = __atomic_load_n(&_kmz_thread_count, __ATOMIC_RELAXED);
+    if (threads) {
+        return threads;
+    }
+
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (size_t)online : 1;
+}
+
+void kmz_set_thread_count(const size_t threads) {
+    __atomic_store_n(&_kmz_thread_count, threads, __ATOMIC_RELAXED);
+}
+
+const size_t _kmz_parallel_workers(const size_t threads, const size_t count) {
+    const size_t requested = threads ? threads : kmz_thread_count();
+    const size_t workers = requested < count ? requested : count;
+    return workers ? workers : 1;
+}
+
+void _kmz_parallel_for(const size_t workers, const size_t count, const _KmzParallelTask task, void * const restrict arg) {
+    struct _kmz_parallel_t shared = {count, 0, task, arg};
+
+    if (workers <= 1 || count <= 1) {
+        _kmz_parallel_run(&shared, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&_kmz_parallel_pool.lock);
+    // A call made from within a task, or while another thread owns the pool, runs on the calling thread alone.
+    if (_kmz_parallel_pool.busy) {
+        pthread_mutex_unlock(&_kmz_parallel_pool.lock);
+        _kmz_parallel_run(&shared, 0);
+        return;
+    }
+
+    const size_t size = kmz_thread_count();
+    _kmz_parallel_grow((workers > size ? workers : size) - 1);
+
+    const size_t helpers = workers - 1 < _kmz_parallel_pool.threads ? workers - 1 : _kmz_parallel_pool.threads;
+    _kmz_parallel_pool.busy = KMZ_TRUE;
+    _kmz_parallel_pool.job = &shared;
+    _kmz_parallel_pool.workers = helpers + 1;
+    _kmz_parallel_pool.pending = helpers;
+    ++_kmz_parallel_pool.generation;
+    if (helpers) {
+        pthread_cond_broadcast(&_kmz_parallel_pool.wake);
+    }
+    pthread_mutex_unlock(&_kmz_parallel_pool.lock);
+
+    _kmz_parallel_run(&shared, 0);
+
+    pthread_mutex_lock(&_kmz_parallel_pool.lock);
+    while (_kmz_parallel_pool.pending) {
+        pthread_cond_wait(&_kmz_parallel_pool.done, &_kmz_parallel_pool.lock);
+    }
+    _kmz_parallel_pool.job = NULL;
+    _kmz_parallel_pool.busy = KMZ_FALSE;
+    pthread_mutex_unlock(&_kmz_parallel_pool.lock);
+}
@@ -0,0 +1,82 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+/**
+ * |Definition                  |Header         |
+ * |kmz_thread_count()          |libkempozer.h  |
+ * |kmz_set_thread_count()      |libkempozer.h  |
+ */
+#ifndef kmz_parallel_h
+#define kmz_parallel_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "kmz_config.h"
+#include "kmz_shared.h"
+#include "../include/libkempozer.h"
+
+/**
+ * Defines a single unit of work executed by {@link _kmz_parallel_for}.
+ *
+ * @param arg The argument shared by every unit of work.
+ * @param index The index of the unit of work being executed.
+ * @param worker The index of the worker executing the unit of work, which is always lower than the worker count used.
+ */
+typedef void (* _KmzParallelTask)(void * const arg, const size_t index, const size_t worker);
+
+/**
+ * Returns the number of workers that {@link _kmz_parallel_for} will use for the given thread count and units of work.
+ *
+ * @param threads The requested thread count, or 0 to use {@link kmz_thread_count}.
+ * @param count The total number of units of work.
+ * @return The number of workers to allocate per-worker state for, which is at least 1.
+ */
+const size_t _kmz_parallel_workers(const size_t threads, const size_t count);
+
+/**
+ * @par Executes `count` units of work using `workers` workers, where the calling thread acts as worker 0 and the others are taken from a pool of persistent threads.
+ *
+ * @par The pool is started on first use with {@link kmz_thread_count} threads including the calling thread, and grows if more workers are ever requested, so no thread is created or joined by later calls. The pool runs one call at a time, so a call made from within a unit of work or while another thread is using the pool runs on the calling thread alone.
+ *
+ * @par Units of work are handed out dynamically, so every index is executed exactly once even if some threads can't be started.
+ *
+ * @param workers The number of workers returned by {@link _kmz_parallel_workers}.
+ * @param count The total number of units of work.
+ * @param task The task to execute for every unit of work.
+ * @param arg The argument shared by every unit of work.
+ */
+void _kmz_parallel_for(const size_t workers, const size_t count, const _KmzParallelTask task, void * const arg);
+
+#endif /* kmz_parallel_h */
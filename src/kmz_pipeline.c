@@ -0,0 +1,480 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_pipeline.h"
+
+/**
+ * The size of every tile, which keeps both buffers of a tile within the L2 cache while the rows are long enough to stream in and out of the images.
+ */
+#define _KMZ_PIPELINE_TILE_W 256
+#define _KMZ_PIPELINE_TILE_H 64
+
+enum _kmz_pipeline_op_e {
+    _KMZ_PIPELINE_FILTER,
+    _KMZ_PIPELINE_KERNEL,
+    _KMZ_PIPELINE_TRANSFORM,
+    _KMZ_PIPELINE_COMPOSITE,
+};
+typedef enum _kmz_pipeline_op_e _KmzPipelineOp;
+
+struct _kmz_pipeline_stage_t {
+    _KmzPipelineOp op;
+    /**
+     * The number of pixels around every pixel that the stage reads, which is 0 for every stage that maps pixels on their own.
+     */
+    size_t hsize;
+    const void * argv;
+    KmzFilter filter;
+    size_t m_size;
+    const KmzKernel * kernel;
+    KmzColorTransform * transform;
+    const KmzImage * src;
+    KmzRectangle src_rect;
+    KmzPoint dst_pos;
+    KmzCompositeOp composite_op;
+    kmz_percent opacity;
+};
+
+struct kmz_pipeline_t {
+    struct _kmz_pipeline_stage_t * stages;
+    size_t count;
+    size_t capacity;
+    size_t halo;
+};
+
+/**
+ * The state of a stage that is resolved once for every run, as it depends on the images the pipeline is run with.
+ */
+struct _kmz_pipeline_pass_t {
+    _KmzLutSpan span;
+    struct _kmz_composite_t composite;
+    /**
+     * Whether the composite changes any pixel, and whether it copies the source unchanged.
+     */
+    KmzBool active;
+    KmzBool copies;
+    KmzRectangle s_area;
+    KmzPoint d_pos;
+};
+
+struct _kmz_pipeline_worker_t {
+    kmz_color_32 * buffers[2];
+    kmz_color_32 * line;
+    void * scratch;
+};
+
+struct _kmz_pipeline_run_t {
+    const KmzPipeline * pipeline;
+    const KmzImage * me;
+    KmzImage * output;
+    KmzRectangle area;
+    size_t tiles_x;
+    KmzBool in_place;
+    struct _kmz_pipeline_pass_t * passes;
+    size_t scratch_size;
+    struct _kmz_pipeline_worker_t * workers;
+    kmz_color_32 * tiles;
+    pthread_mutex_t lock;
+    KmzPixelOperationStatus status;
+};
+
+static inline void _kmz_pipeline_fail(struct _kmz_pipeline_run_t * const restrict ctx, const KmzPixelOperationStatus status) {
+    KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+    __atomic_compare_exchange_n(&ctx->status, &expected, status, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+// region Stages:
+
+static struct _kmz_pipeline_stage_t * const _kmz_pipeline_push(KmzPipeline * const restrict me, const _KmzPipelineOp op, const size_t hsize) {
+    if (2 * (me->halo + hsize) + _KMZ_PIPELINE_TILE_W > UINT16_MAX) {
+        return NULL;
+    }
+    if (me->count == me->capacity) {
+        const size_t capacity = me->capacity ? 2 * me->capacity : 8;
+        struct _kmz_pipeline_stage_t * const restrict stages = realloc(me->stages, capacity * sizeof(struct _kmz_pipeline_stage_t));
+        if (NULL == stages) {
+            return NULL;
+        }
+        me->stages = stages;
+        me->capacity = capacity;
+    }
+
+    struct _kmz_pipeline_stage_t * const restrict stage = me->stages + me->count++;
+    memset(stage, 0, sizeof(*stage));
+    stage->op = op;
+    stage->hsize = hsize;
+    me->halo += hsize;
+    return stage;
+}
+
+KmzPipeline * const KmzPipeline__new(void) {
+    return calloc(1, sizeof(KmzPipeline));
+}
+
+void KmzPipeline__free(KmzPipeline * const restrict me) {
+    free(me->stages);
+    free(me);
+}
+
+const size_t KmzPipeline__halo(const KmzPipeline * const restrict me) {
+    return me->halo;
+}
+
+const KmzBool KmzPipeline__add_filter(KmzPipeline * const restrict me, const void * const restrict argv, const KmzFilter filter, const size_t m_size) {
+    if (NULL == filter) {
+        return KMZ_FALSE;
+    }
+
+    struct _kmz_pipeline_stage_t * const restrict stage = _kmz_pipeline_push(me, _KMZ_PIPELINE_FILTER, m_size / 2);
+    if (NULL == stage) {
+        return KMZ_FALSE;
+    }
+    stage->argv = argv;
+    stage->filter = filter;
+    stage->m_size = m_size;
+    return KMZ_TRUE;
+}
+
+const KmzBool KmzPipeline__add_kernel(KmzPipeline * const restrict me, const KmzKernel * const restrict kernel) {
+    if (NULL == kernel) {
+        return KMZ_FALSE;
+    }
+
+    struct _kmz_pipeline_stage_t * const restrict stage = _kmz_pipeline_push(me, _KMZ_PIPELINE_KERNEL, KmzKernel__size(kernel) / 2);
+    if (NULL == stage) {
+        return KMZ_FALSE;
+    }
+    stage->kernel = kernel;
+    return KMZ_TRUE;
+}
+
+const KmzBool KmzPipeline__add_color_transform(KmzPipeline * const restrict me, KmzColorTransform * const restrict transform) {
+    if (NULL == transform) {
+        return KMZ_FALSE;
+    }
+
+    struct _kmz_pipeline_stage_t * const restrict stage = _kmz_pipeline_push(me, _KMZ_PIPELINE_TRANSFORM, 0);
+    if (NULL == stage) {
+        return KMZ_FALSE;
+    }
+    stage->transform = transform;
+    return KMZ_TRUE;
+}
+
+const KmzBool KmzPipeline__add_composite(KmzPipeline * const restrict me, const KmzImage * const restrict src, const KmzRectangle src_rect,
+        const KmzPoint dst_pos, const KmzCompositeOp op, const kmz_percent opacity) {
+    struct _kmz_composite_t state;
+    if (NULL == src || !_kmz_composite_init(&state, op, opacity)) {
+        return KMZ_FALSE;
+    }
+
+    struct _kmz_pipeline_stage_t * const restrict stage = _kmz_pipeline_push(me, _KMZ_PIPELINE_COMPOSITE, 0);
+    if (NULL == stage) {
+        return KMZ_FALSE;
+    }
+    stage->src = src;
+    stage->src_rect = src_rect;
+    stage->dst_pos = dst_pos;
+    stage->composite_op = op;
+    stage->opacity = opacity;
+    return KMZ_TRUE;
+}
+
+// endregion;
+
+// region Tiles:
+
+/**
+ * Returns the part of `a` that is within `b`, which is empty if they don't overlap.
+ */
+static inline const KmzRectangle _kmz_pipeline_clip(const KmzRectangle a, const KmzRectangle b) {
+    const ssize_t x = a.pos.x > b.pos.x ? a.pos.x : b.pos.x,
+          y = a.pos.y > b.pos.y ? a.pos.y : b.pos.y,
+          a_max_x = a.pos.x + a.size.w, b_max_x = b.pos.x + b.size.w,
+          a_max_y = a.pos.y + a.size.h, b_max_y = b.pos.y + b.size.h,
+          max_x = a_max_x < b_max_x ? a_max_x : b_max_x,
+          max_y = a_max_y < b_max_y ? a_max_y : b_max_y;
+
+    return kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)(max_x > x ? max_x - x : 0), (uint16_t)(max_y > y ? max_y - y : 0)));
+}
+
+static inline const KmzRectangle _kmz_pipeline_inset(const KmzSize dimen, const size_t inset) {
+    return kmz_rectangle(kmz_point((ssize_t)inset, (ssize_t)inset), kmz_size((uint16_t)(dimen.w - 2 * inset), (uint16_t)(dimen.h - 2 * inset)));
+}
+
+static inline const KmzRectangle _kmz_pipeline_tile(const struct _kmz_pipeline_run_t * const restrict ctx, const size_t index) {
+    const size_t tx = index % ctx->tiles_x, ty = index / ctx->tiles_x;
+    const ssize_t x = ctx->area.pos.x + (ssize_t)(tx * _KMZ_PIPELINE_TILE_W),
+          y = ctx->area.pos.y + (ssize_t)(ty * _KMZ_PIPELINE_TILE_H);
+    const ssize_t max_x = ctx->area.pos.x + ctx->area.size.w, max_y = ctx->area.pos.y + ctx->area.size.h;
+
+    return kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)kmz_clamp(max_x - x, 0, _KMZ_PIPELINE_TILE_W),
+            (uint16_t)kmz_clamp(max_y - y, 0, _KMZ_PIPELINE_TILE_H)));
+}
+
+/**
+ * Composites the source of a stage onto the pixels of `region` of a tile buffer, whose top left pixel is at `origin` within the image.
+ */
+static const KmzPixelOperationStatus _kmz_pipeline_composite(const struct _kmz_pipeline_pass_t * const restrict pass, const KmzImage * const restrict src,
+        kmz_color_32 * const restrict buffer, const size_t b_w, const KmzPoint origin, const KmzRectangle region, kmz_color_32 * const restrict line) {
+    const KmzRectangle target = kmz_rectangle(kmz_point(pass->d_pos.x - origin.x, pass->d_pos.y - origin.y), pass->s_area.size),
+          clip = _kmz_pipeline_clip(region, target);
+    const size_t count = clip.size.w;
+    if (!count || !clip.size.h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const ssize_t s_x = pass->s_area.pos.x + clip.pos.x - target.pos.x, s_y = pass->s_area.pos.y + clip.pos.y - target.pos.y;
+    for (size_t y = 0; y < clip.size.h; ++y) {
+        kmz_color_32 * const restrict dst = buffer + (size_t)(clip.pos.y + (ssize_t)y) * b_w + (size_t)clip.pos.x;
+        const KmzPixelOperationStatus status = KmzImage__read_row_span(src, kmz_point(s_x, s_y + (ssize_t)y), count, pass->copies ? dst : line);
+        if (KMZ_PIXEL_OP_OK != status) {
+            return status;
+        }
+        if (!pass->copies) {
+            _kmz_composite_span(&pass->composite, line, dst, count);
+        }
+    }
+    return KMZ_PIXEL_OP_OK;
+}
+
+/**
+ * Runs every stage over a single tile. The tile is read together with the halo of the pipeline into the first of two buffers, then every filter and
+ * kernel reads the pixels left by the stage before from one buffer and writes a region shrunk by half its size to the other, while every other
+ * stage changes the pixels in place. The pixels outside of the area are kept at 0, so every filter sees the same border it would if the stages ran
+ * one at a time over the whole area.
+ */
+static void _KmzImage__pipeline_tile(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_pipeline_run_t * const restrict ctx = arg;
+    if (__atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_PIXEL_OP_OK) {
+        return;
+    }
+
+    const KmzPipeline * const restrict pipeline = ctx->pipeline;
+    const size_t halo = pipeline->halo, b_area = (_KMZ_PIPELINE_TILE_W + 2 * halo) * (_KMZ_PIPELINE_TILE_H + 2 * halo);
+    struct _kmz_pipeline_worker_t * const restrict w = ctx->workers + worker;
+    if (NULL == w->buffers[0]) {
+        w->buffers[0] = malloc(b_area * sizeof(kmz_color_32));
+        w->buffers[1] = malloc(b_area * sizeof(kmz_color_32));
+        w->line = malloc((_KMZ_PIPELINE_TILE_W + 2 * halo) * sizeof(kmz_color_32));
+        w->scratch = ctx->scratch_size ? malloc(ctx->scratch_size) : NULL;
+    }
+    if (NULL == w->buffers[0] || NULL == w->buffers[1] || NULL == w->line || (ctx->scratch_size && NULL == w->scratch)) {
+        _kmz_pipeline_fail(ctx, KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY);
+        return;
+    }
+
+    const KmzRectangle tile = _kmz_pipeline_tile(ctx, index);
+    const KmzSize dimen = kmz_size((uint16_t)(tile.size.w + 2 * halo), (uint16_t)(tile.size.h + 2 * halo));
+    const size_t b_w = dimen.w;
+    const KmzPoint origin = kmz_point(tile.pos.x - (ssize_t)halo, tile.pos.y - (ssize_t)halo);
+    const KmzRectangle area = kmz_rectangle(kmz_point(ctx->area.pos.x - origin.x, ctx->area.pos.y - origin.y), ctx->area.size);
+    size_t current = 0, inset = 0;
+
+    KmzPixelOperationStatus status = _KmzImage__populate_tile(ctx->me, w->buffers[0], ctx->area, tile, halo);
+    for (size_t i = 0; KMZ_PIXEL_OP_OK == status && i < pipeline->count; ++i) {
+        const struct _kmz_pipeline_stage_t * const restrict stage = pipeline->stages + i;
+        const struct _kmz_pipeline_pass_t * const restrict pass = ctx->passes + i;
+        kmz_color_32 * const restrict buffer = w->buffers[current];
+        const KmzRectangle region = _kmz_pipeline_inset(dimen, inset), clip = _kmz_pipeline_clip(region, area);
+
+        switch (stage->op) {
+            case _KMZ_PIPELINE_FILTER:
+            case _KMZ_PIPELINE_KERNEL: {
+                kmz_color_32 * const restrict o_buffer = w->buffers[1 - current];
+                const KmzRectangle o_region = _kmz_pipeline_inset(dimen, inset + stage->hsize), o_clip = _kmz_pipeline_clip(o_region, area);
+
+                if (o_clip.size.w != o_region.size.w || o_clip.size.h != o_region.size.h) {
+                    for (size_t y = 0; y < o_region.size.h; ++y) {
+                        memset(o_buffer + (size_t)(o_region.pos.y + (ssize_t)y) * b_w + (size_t)o_region.pos.x, 0, o_region.size.w * sizeof(kmz_color_32));
+                    }
+                }
+                if (o_clip.size.w && o_clip.size.h) {
+                    if (_KMZ_PIPELINE_FILTER == stage->op) {
+                        _kmz_filter_region(stage->argv, stage->filter, stage->m_size, buffer, dimen, o_clip, o_buffer);
+                    } else {
+                        const size_t hsize = stage->hsize;
+                        _kmz_kernel_convolve(stage->kernel, buffer + (size_t)(o_clip.pos.y - (ssize_t)hsize) * b_w + (size_t)(o_clip.pos.x - (ssize_t)hsize),
+                                b_w, o_clip.size.w, o_clip.size.h, o_buffer + (size_t)o_clip.pos.y * b_w + (size_t)o_clip.pos.x, b_w, w->scratch);
+                    }
+                }
+                current = 1 - current;
+                inset += stage->hsize;
+                break;
+            }
+            case _KMZ_PIPELINE_TRANSFORM:
+                for (size_t y = 0; y < clip.size.h; ++y) {
+                    pass->span(stage->transform, buffer + (size_t)(clip.pos.y + (ssize_t)y) * b_w + (size_t)clip.pos.x, clip.size.w);
+                }
+                break;
+            case _KMZ_PIPELINE_COMPOSITE:
+            default:
+                if (pass->active) {
+                    status = _kmz_pipeline_composite(pass, stage->src, buffer, b_w, origin, clip, w->line);
+                }
+                break;
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK != status) {
+        _kmz_pipeline_fail(ctx, status);
+        return;
+    }
+
+    // Every filter and kernel has shrunk the halo away, so the tile itself is left at the offset of the halo.
+    const kmz_color_32 * const restrict result = w->buffers[current] + halo * b_w + halo;
+    if (ctx->in_place) {
+        kmz_color_32 * const restrict stored = ctx->tiles + index * _KMZ_PIPELINE_TILE_W * _KMZ_PIPELINE_TILE_H;
+        for (size_t y = 0; y < tile.size.h; ++y) {
+            memcpy(stored + y * tile.size.w, result + y * b_w, tile.size.w * sizeof(kmz_color_32));
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    for (size_t y = 0; KMZ_PIXEL_OP_OK == status && y < tile.size.h; ++y) {
+        status = KmzImage__write_row_span(ctx->output, kmz_point(tile.pos.x, tile.pos.y + (ssize_t)y), tile.size.w, result + y * b_w);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+    if (KMZ_PIXEL_OP_OK != status) {
+        _kmz_pipeline_fail(ctx, status);
+    }
+}
+
+// endregion;
+
+const KmzPixelOperationStatus KmzImage__apply_pipeline(const KmzImage * const restrict me, const KmzPipeline * const restrict pipeline, const KmzRectangle area,
+        KmzImage * const restrict output, const size_t threads) {
+    if (NULL == pipeline) {
+        return KMZ_PIXEL_OP_ERR_READ_INVALID_PTR;
+    }
+
+    const KmzSize dimen = KmzImage__dimen(me);
+    const ssize_t x = kmz_clamp(area.pos.x, 0, dimen.w),
+          y = kmz_clamp(area.pos.y, 0, dimen.h),
+          max_x = kmz_clamp(area.size.w + x, x, dimen.w),
+          max_y = kmz_clamp(area.size.h + y, y, dimen.h);
+
+    const size_t w = (size_t)(max_x - x),
+          h = (size_t)(max_y - y);
+
+    if (!w || !h) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    const size_t tiles_x = (w + _KMZ_PIPELINE_TILE_W - 1) / _KMZ_PIPELINE_TILE_W,
+          tiles = tiles_x * ((h + _KMZ_PIPELINE_TILE_H - 1) / _KMZ_PIPELINE_TILE_H),
+          workers = _kmz_parallel_workers(threads, tiles);
+
+    struct _kmz_pipeline_run_t ctx = {
+        .pipeline = pipeline,
+        .me = me,
+        .output = output,
+        .area = kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)w, (uint16_t)h)),
+        .tiles_x = tiles_x,
+        .in_place = output == me ? KMZ_TRUE : KMZ_FALSE,
+        .passes = calloc(pipeline->count ? pipeline->count : 1, sizeof(struct _kmz_pipeline_pass_t)),
+        .scratch_size = 0,
+        .workers = calloc(workers, sizeof(struct _kmz_pipeline_worker_t)),
+        .tiles = NULL,
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (NULL == ctx.passes || NULL == ctx.workers) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    // Resolve every stage against the images of this run, where the scratch of a kernel is sized for the largest region it may write.
+    for (size_t i = 0, inset = 0; KMZ_PIXEL_OP_OK == ctx.status && i < pipeline->count; ++i) {
+        const struct _kmz_pipeline_stage_t * const restrict stage = pipeline->stages + i;
+        struct _kmz_pipeline_pass_t * const restrict pass = ctx.passes + i;
+
+        switch (stage->op) {
+            case _KMZ_PIPELINE_FILTER:
+            case _KMZ_PIPELINE_KERNEL:
+                inset += stage->hsize;
+                if (_KMZ_PIPELINE_KERNEL == stage->op) {
+                    const size_t border = 2 * (pipeline->halo - inset),
+                          size = _kmz_kernel_scratch_size(stage->kernel, _KMZ_PIPELINE_TILE_W + border, _KMZ_PIPELINE_TILE_H + border);
+                    ctx.scratch_size = size > ctx.scratch_size ? size : ctx.scratch_size;
+                }
+                break;
+            case _KMZ_PIPELINE_TRANSFORM:
+                if (!KmzColorTransform__compile(stage->transform)) {
+                    ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+                }
+                pass->span = _kmz_transform_span(stage->transform);
+                break;
+            case _KMZ_PIPELINE_COMPOSITE:
+            default:
+                _kmz_composite_init(&pass->composite, stage->composite_op, stage->opacity);
+                pass->active = _kmz_composite_clip(KmzImage__dimen(stage->src), dimen, stage->src_rect, stage->dst_pos, &pass->s_area, &pass->d_pos)
+                        && KMZ_COMPOSITE_DST != stage->composite_op && !(pass->composite.keeps_dst && 0 == pass->composite.opacity);
+                pass->copies = KMZ_COMPOSITE_SRC == stage->composite_op && 255 == pass->composite.opacity;
+                // A source that is also the output would be read by one tile while another tile writes it.
+                if (stage->src == output) {
+                    ctx.in_place = KMZ_TRUE;
+                }
+                break;
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK == ctx.status && ctx.in_place) {
+        ctx.tiles = malloc(tiles * _KMZ_PIPELINE_TILE_W * _KMZ_PIPELINE_TILE_H * sizeof(kmz_color_32));
+        if (NULL == ctx.tiles) {
+            ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK == ctx.status) {
+        pthread_mutex_init(&ctx.lock, NULL);
+        _kmz_parallel_for(workers, tiles, &_KmzImage__pipeline_tile, &ctx);
+        pthread_mutex_destroy(&ctx.lock);
+
+        // Every tile reads its halo from `me`, so in-place output is written back only once all tiles are run.
+        for (size_t i = 0; ctx.in_place && KMZ_PIXEL_OP_OK == ctx.status && i < tiles; ++i) {
+            ctx.status = KmzImage__write_argb_block(output, _kmz_pipeline_tile(&ctx, i), ctx.tiles + i * _KMZ_PIPELINE_TILE_W * _KMZ_PIPELINE_TILE_H);
+        }
+    }
+
+    for (size_t i = 0; NULL != ctx.workers && i < workers; ++i) {
+        free(ctx.workers[i].buffers[0]);
+        free(ctx.workers[i].buffers[1]);
+        free(ctx.workers[i].line);
+        free(ctx.workers[i].scratch);
+    }
+    free(ctx.workers);
+    free(ctx.passes);
+    free(ctx.tiles);
+
+    return ctx.status;
+}
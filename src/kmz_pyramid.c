@@ -0,0 +1,354 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_pyramid.h"
+
+/**
+ * Halving a 65535 pixel wide image reaches a single pixel after 16 levels.
+ */
+#define _KMZ_PYRAMID_MAX_LEVELS 17
+/**
+ * The number of rows of a level kept for the level below it, which is the number of rows weighed by {@link KMZ_PYRAMID_GAUSSIAN}.
+ */
+#define _KMZ_PYRAMID_RING_ROWS 4
+
+struct kmz_pyramid_t {
+    size_t count;
+    kmz_color_32 * pixels;
+    KmzImage * levels[_KMZ_PYRAMID_MAX_LEVELS];
+};
+
+struct _kmz_pyramid_level_t {
+    KmzSize dimen;
+    kmz_color_32 * pixels;
+    /**
+     * The latest premultiplied rows of this level, or {@link NULL} for the last level.
+     */
+    int16_t * ring;
+    /**
+     * The next row of the level below to reduce from this level.
+     */
+    size_t next;
+};
+
+struct _kmz_pyramid_t {
+    KmzPyramidFilter filter;
+    size_t count;
+    struct _kmz_pyramid_level_t levels[_KMZ_PYRAMID_MAX_LEVELS];
+    /**
+     * A single row of the level being reduced after its rows are combined vertically.
+     */
+    int16_t * column;
+    /**
+     * The premultiplied rows of the last level, which has no ring.
+     */
+    int16_t * out;
+};
+
+// region Passes:
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static size_t _kmz_sse2_pyramid_vertical(const KmzPyramidFilter filter, const int16_t * const * const restrict rows,
+        int16_t * const restrict dst, const size_t count, size_t i) {
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)(rows[0] + i)), b = _mm_loadu_si128((const __m128i *)(rows[1] + i));
+        if (KMZ_PYRAMID_BOX == filter) {
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi16(a, b));
+        } else {
+            const __m128i c = _mm_loadu_si128((const __m128i *)(rows[2] + i)), d = _mm_loadu_si128((const __m128i *)(rows[3] + i)),
+                  t = _mm_add_epi16(b, c);
+            _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi16(_mm_add_epi16(a, d), _mm_add_epi16(t, _mm_add_epi16(t, t))));
+        }
+    }
+    return i;
+}
+
+kmz__target("sse2") static size_t _kmz_sse2_pyramid_horizontal(const KmzPyramidFilter filter, const int16_t * const restrict src, const size_t w,
+        int16_t * const restrict dst, const size_t count, size_t x) {
+    if (KMZ_PYRAMID_BOX == filter) {
+        for (; x + 2 <= count && 2 * x + 4 <= w; x += 2) {
+            const __m128i a = _mm_loadu_si128((const __m128i *)(src + 8 * x)), b = _mm_loadu_si128((const __m128i *)(src + 8 * x + 8)),
+                  sum = _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+            _mm_storeu_si128((__m128i *)(dst + 4 * x), _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2));
+        }
+    } else {
+        // Every output pixel weighs the pixels 2x - 1 to 2x + 2, so pixel 0 is left to the scalar path.
+        for (x = x ? x : 1; x + 2 <= count && 2 * x + 5 <= w; x += 2) {
+            const int16_t * const restrict p = src + 4 * (2 * x - 1);
+            const __m128i l0 = _mm_loadu_si128((const __m128i *)p), l1 = _mm_loadu_si128((const __m128i *)(p + 8)),
+                  l2 = _mm_loadu_si128((const __m128i *)(p + 16)),
+                  t = _mm_add_epi16(_mm_unpackhi_epi64(l0, l1), _mm_unpacklo_epi64(l1, l2)),
+                  sum = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi64(l0, l1), _mm_unpackhi_epi64(l1, l2)), _mm_add_epi16(t, _mm_add_epi16(t, t)));
+            _mm_storeu_si128((__m128i *)(dst + 4 * x), _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(32)), 6));
+        }
+    }
+    return x;
+}
+
+kmz__target("avx2") static size_t _kmz_avx2_pyramid_vertical(const KmzPyramidFilter filter, const int16_t * const * const restrict rows,
+        int16_t * const restrict dst, const size_t count, size_t i) {
+    for (; i + 16 <= count; i += 16) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *)(rows[0] + i)), b = _mm256_loadu_si256((const __m256i *)(rows[1] + i));
+        if (KMZ_PYRAMID_BOX == filter) {
+            _mm256_storeu_si256((__m256i *)(dst + i), _mm256_add_epi16(a, b));
+        } else {
+            const __m256i c = _mm256_loadu_si256((const __m256i *)(rows[2] + i)), d = _mm256_loadu_si256((const __m256i *)(rows[3] + i)),
+                  t = _mm256_add_epi16(b, c);
+            _mm256_storeu_si256((__m256i *)(dst + i), _mm256_add_epi16(_mm256_add_epi16(a, d), _mm256_add_epi16(t, _mm256_add_epi16(t, t))));
+        }
+    }
+    return i;
+}
+
+/**
+ * The 64 bit unpacks pair pixels within each 128 bit lane, which leaves the output pixels in the order 0, 2, 1, 3 until they are permuted.
+ */
+kmz__target("avx2") static size_t _kmz_avx2_pyramid_horizontal(const KmzPyramidFilter filter, const int16_t * const restrict src, const size_t w,
+        int16_t * const restrict dst, const size_t count, size_t x) {
+    if (KMZ_PYRAMID_BOX == filter) {
+        for (; x + 4 <= count && 2 * x + 8 <= w; x += 4) {
+            const __m256i a = _mm256_loadu_si256((const __m256i *)(src + 8 * x)), b = _mm256_loadu_si256((const __m256i *)(src + 8 * x + 16)),
+                  sum = _mm256_add_epi16(_mm256_unpacklo_epi64(a, b), _mm256_unpackhi_epi64(a, b));
+            _mm256_storeu_si256((__m256i *)(dst + 4 * x),
+                    _mm256_permute4x64_epi64(_mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2), 0xD8));
+        }
+    } else {
+        for (x = x ? x : 1; x + 4 <= count && 2 * x + 9 <= w; x += 4) {
+            const int16_t * const restrict p = src + 4 * (2 * x - 1);
+            const __m256i l0 = _mm256_loadu_si256((const __m256i *)p), l1 = _mm256_loadu_si256((const __m256i *)(p + 8)),
+                  l2 = _mm256_loadu_si256((const __m256i *)(p + 16)), l3 = _mm256_loadu_si256((const __m256i *)(p + 24)),
+                  t = _mm256_add_epi16(_mm256_unpackhi_epi64(l0, l2), _mm256_unpacklo_epi64(l1, l3)),
+                  sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(l0, l2), _mm256_unpackhi_epi64(l1, l3)),
+                        _mm256_add_epi16(t, _mm256_add_epi16(t, t)));
+            _mm256_storeu_si256((__m256i *)(dst + 4 * x),
+                    _mm256_permute4x64_epi64(_mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(32)), 6), 0xD8));
+        }
+    }
+    return x;
+}
+#endif
+
+/**
+ * Combines the rows weighed by the filter into a single row, which is 1, 1 for {@link KMZ_PYRAMID_BOX} and 1, 3, 3, 1 for
+ * {@link KMZ_PYRAMID_GAUSSIAN}.
+ */
+static void _kmz_pyramid_vertical(const KmzPyramidFilter filter, const int16_t * const * const restrict rows, int16_t * const restrict dst,
+        const size_t count) {
+    size_t i = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        i = _kmz_avx2_pyramid_vertical(filter, rows, dst, count, i);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        i = _kmz_sse2_pyramid_vertical(filter, rows, dst, count, i);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = (int16_t)(KMZ_PYRAMID_BOX == filter ? rows[0][i] + rows[1][i] : rows[0][i] + 3 * (rows[1][i] + rows[2][i]) + rows[3][i]);
+    }
+}
+
+static inline void _kmz_pyramid_pixel(const KmzPyramidFilter filter, const int16_t * const restrict src, const size_t w,
+        int16_t * const restrict dst, const size_t x) {
+    const size_t last = w - 1, b = 2 * x, c = b + 1 < last ? b + 1 : last;
+    if (KMZ_PYRAMID_BOX == filter) {
+        for (size_t i = 0; i < 4; ++i) {
+            dst[4 * x + i] = (int16_t)((src[4 * b + i] + src[4 * c + i] + 2) >> 2);
+        }
+    } else {
+        const size_t a = b ? b - 1 : 0, d = b + 2 < last ? b + 2 : last;
+        for (size_t i = 0; i < 4; ++i) {
+            dst[4 * x + i] = (int16_t)((src[4 * a + i] + 3 * (src[4 * b + i] + src[4 * c + i]) + src[4 * d + i] + 32) >> 6);
+        }
+    }
+}
+
+/**
+ * Halves a row that is combined vertically using the same weights as {@link _kmz_pyramid_vertical}, repeating the last pixel past the edges.
+ */
+static void _kmz_pyramid_horizontal(const KmzPyramidFilter filter, const int16_t * const restrict src, const size_t w, int16_t * const restrict dst,
+        const size_t count) {
+    size_t x = 0;
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_SSE2 <= level && KMZ_PYRAMID_GAUSSIAN == filter) {
+        _kmz_pyramid_pixel(filter, src, w, dst, x++);
+    }
+    if (KMZ_SIMD_AVX2 <= level) {
+        x = _kmz_avx2_pyramid_horizontal(filter, src, w, dst, count, x);
+    }
+    if (KMZ_SIMD_SSE2 <= level) {
+        x = _kmz_sse2_pyramid_horizontal(filter, src, w, dst, count, x);
+    }
+#endif
+    for (; x < count; ++x) {
+        _kmz_pyramid_pixel(filter, src, w, dst, x);
+    }
+}
+
+// endregion;
+
+static inline int16_t * const _kmz_pyramid_ring_row(const struct _kmz_pyramid_level_t * const restrict level, const size_t row) {
+    return level->ring + (row % _KMZ_PYRAMID_RING_ROWS) * 4 * (size_t)level->dimen.w;
+}
+
+/**
+ * Reduces row `y` of the level below `index` from the rows of `index` that are still within its ring.
+ */
+static void _kmz_pyramid_reduce(struct _kmz_pyramid_t * const restrict me, const size_t index, const size_t y) {
+    const struct _kmz_pyramid_level_t * const restrict src = me->levels + index, * const restrict dst = src + 1;
+    const size_t last = (size_t)src->dimen.h - 1, b = 2 * y, c = b + 1 < last ? b + 1 : last;
+    const int16_t * rows[4];
+
+    if (KMZ_PYRAMID_BOX == me->filter) {
+        rows[0] = _kmz_pyramid_ring_row(src, b);
+        rows[1] = _kmz_pyramid_ring_row(src, c);
+    } else {
+        rows[0] = _kmz_pyramid_ring_row(src, b ? b - 1 : 0);
+        rows[1] = _kmz_pyramid_ring_row(src, b);
+        rows[2] = _kmz_pyramid_ring_row(src, c);
+        rows[3] = _kmz_pyramid_ring_row(src, b + 2 < last ? b + 2 : last);
+    }
+
+    int16_t * const restrict out = NULL == dst->ring ? me->out : _kmz_pyramid_ring_row(dst, y);
+    _kmz_pyramid_vertical(me->filter, rows, me->column, 4 * (size_t)src->dimen.w);
+    _kmz_pyramid_horizontal(me->filter, me->column, src->dimen.w, out, dst->dimen.w);
+    _kmz_color_unpremultiply_span(out, dst->pixels + y * dst->dimen.w, dst->dimen.w);
+}
+
+/**
+ * Reduces every row of the level below `index` that only needs rows of `index` up to `row`, pushing each of them further down while its rows are
+ * still within the cache.
+ */
+static void _kmz_pyramid_push(struct _kmz_pyramid_t * const restrict me, const size_t index, const size_t row) {
+    if (index + 1 >= me->count) {
+        return;
+    }
+
+    struct _kmz_pyramid_level_t * const restrict src = me->levels + index;
+    const size_t last = (size_t)src->dimen.h - 1, reach = KMZ_PYRAMID_BOX == me->filter ? 1 : 2;
+    while (src->next < src[1].dimen.h) {
+        const size_t y = src->next, needed = 2 * y + reach < last ? 2 * y + reach : last;
+        if (needed > row) {
+            break;
+        }
+        _kmz_pyramid_reduce(me, index, y);
+        ++src->next;
+        _kmz_pyramid_push(me, index + 1, y);
+    }
+}
+
+KmzPyramid * const KmzImage__build_pyramid(const KmzImage * const restrict me, const KmzPyramidFilter filter, const size_t levels) {
+    if (KMZ_PYRAMID_BOX != filter && KMZ_PYRAMID_GAUSSIAN != filter) {
+        return NULL;
+    }
+
+    const KmzSize dimen = KmzImage__dimen(me);
+    if (!dimen.w || !dimen.h) {
+        return NULL;
+    }
+
+    struct _kmz_pyramid_t ctx = {.filter = filter, .count = 1};
+    const size_t max = levels && levels < _KMZ_PYRAMID_MAX_LEVELS ? levels : _KMZ_PYRAMID_MAX_LEVELS;
+    size_t total = (size_t)dimen.w * dimen.h, rings = 0;
+
+    ctx.levels[0].dimen = dimen;
+    while (ctx.count < max && (ctx.levels[ctx.count - 1].dimen.w > 1 || ctx.levels[ctx.count - 1].dimen.h > 1)) {
+        const KmzSize above = ctx.levels[ctx.count - 1].dimen;
+        rings += _KMZ_PYRAMID_RING_ROWS * 4 * (size_t)above.w;
+        ctx.levels[ctx.count++].dimen = kmz_size((uint16_t)((above.w + 1u) / 2u), (uint16_t)((above.h + 1u) / 2u));
+        total += (size_t)ctx.levels[ctx.count - 1].dimen.w * ctx.levels[ctx.count - 1].dimen.h;
+    }
+
+    KmzPyramid * const restrict pyramid = calloc(1, sizeof(struct kmz_pyramid_t));
+    // The rings, the combined row and the rows of the last level share a single block of scratch memory.
+    int16_t * const restrict scratch = malloc((rings + 4 * (size_t)dimen.w + 4 * (size_t)ctx.levels[ctx.count - 1].dimen.w) * sizeof(int16_t));
+    if (NULL == pyramid || NULL == scratch || NULL == (pyramid->pixels = malloc(total * sizeof(kmz_color_32)))) {
+        free(pyramid);
+        free(scratch);
+        return NULL;
+    }
+
+    pyramid->count = ctx.count;
+    int16_t * ring = scratch;
+    kmz_color_32 * pixels = pyramid->pixels;
+    for (size_t i = 0; i < ctx.count; ++i) {
+        struct _kmz_pyramid_level_t * const restrict level = ctx.levels + i;
+        level->pixels = pixels;
+        pixels += (size_t)level->dimen.w * level->dimen.h;
+        if (i + 1 < ctx.count) {
+            level->ring = ring;
+            ring += _KMZ_PYRAMID_RING_ROWS * 4 * (size_t)level->dimen.w;
+        }
+    }
+    ctx.column = ring;
+    ctx.out = ring + 4 * (size_t)dimen.w;
+
+    KmzBool ok = KMZ_TRUE;
+    for (size_t y = 0; ok && y < dimen.h; ++y) {
+        kmz_color_32 * const restrict row = ctx.levels[0].pixels + y * dimen.w;
+        ok = KMZ_PIXEL_OP_OK == KmzImage__read_row_span(me, kmz_point(0, (ssize_t)y), dimen.w, row);
+        if (ok && ctx.count > 1) {
+            _kmz_color_premultiply_span(row, _kmz_pyramid_ring_row(ctx.levels, y), dimen.w);
+            _kmz_pyramid_push(&ctx, 0, y);
+        }
+    }
+
+    for (size_t i = 0; ok && i < ctx.count; ++i) {
+        pyramid->levels[i] = KmzImage__new_from_buffer(ctx.levels[i].dimen, ctx.levels[i].pixels, KMZ_FALSE);
+        ok = NULL != pyramid->levels[i];
+    }
+
+    free(scratch);
+    if (!ok) {
+        KmzPyramid__free(pyramid);
+        return NULL;
+    }
+    return pyramid;
+}
+
+void KmzPyramid__free(KmzPyramid * const restrict me) {
+    for (size_t i = 0; i < me->count; ++i) {
+        KmzImage__free(me->levels[i]);
+    }
+    free(me->pixels);
+    free(me);
+}
+
+const size_t KmzPyramid__level_count(const KmzPyramid * const restrict me) {
+    return me->count;
+}
+
+KmzImage * const KmzPyramid__level(const KmzPyramid * const restrict me, const size_t level) {
+    return level < me->count ? me->levels[level] : NULL;
+}
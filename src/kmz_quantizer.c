@@ -0,0 +1,711 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_quantizer.h"
+
+#define _KMZ_QUANTIZE_BINS ((size_t)1 << 17)
+#define _KMZ_QUANTIZE_SAMPLES ((size_t)1 << 22)
+#define _KMZ_QUANTIZE_BAND 16
+#define _KMZ_QUANTIZE_COLORS 256
+#define _KMZ_QUANTIZE_OCTREE_DEPTH 5
+#define _KMZ_QUANTIZE_UNSET 0xFFFFu
+
+/**
+ * Defines the population of a single histogram bin, where every channel sum uses the 8-bit channels of {@link _kmz_quantize_channels}.
+ */
+struct _kmz_quantize_bin_t {
+    uint32_t count;
+    uint32_t sum[4];
+};
+
+/**
+ * Defines a single populated histogram bin along with the mean color of the pixels within it.
+ */
+struct _kmz_quantize_color_t {
+    uint8_t mean[4];
+    uint32_t count;
+    uint32_t sum[4];
+};
+
+struct _kmz_quantize_box_t {
+    size_t start;
+    size_t end;
+    uint64_t count;
+    size_t channel;
+    uint32_t range;
+};
+
+struct _kmz_octree_node_t {
+    uint64_t sum[4];
+    uint64_t count;
+    int32_t children[16];
+    int32_t next;
+    KmzBool leaf;
+};
+
+struct _kmz_octree_t {
+    struct _kmz_octree_node_t * nodes;
+    size_t size;
+    size_t capacity;
+    int32_t free;
+    int32_t levels[_KMZ_QUANTIZE_OCTREE_DEPTH];
+    size_t leaves;
+};
+
+struct _kmz_quantize_histogram_t {
+    const KmzImage * image;
+    size_t w;
+    size_t step;
+    size_t rows;
+    struct _kmz_quantize_bin_t ** bins;
+    kmz_color_32 ** lines;
+    KmzPixelOperationStatus status;
+};
+
+struct _kmz_quantize_remap_t {
+    const KmzImage * image;
+    size_t w;
+    size_t h;
+    size_t count;
+    uint8_t channels[_KMZ_QUANTIZE_COLORS][4];
+    uint8_t order[_KMZ_QUANTIZE_COLORS];
+    uint16_t * lut;
+    uint8_t * indices;
+    kmz_color_32 ** lines;
+    KmzPixelOperationStatus status;
+};
+
+/**
+ * Splits a color into alpha, red, green and blue channels of 8 bits each, widening the 7-bit alpha channel so that every channel weighs
+ * the same when colors are compared.
+ */
+static inline void _kmz_quantize_channels(const kmz_color_32 color, uint8_t * const restrict channels) {
+    const uint32_t a = (color >> 24) & 0x7Fu;
+    channels[0] = (uint8_t)((a << 1) | (a >> 6));
+    channels[1] = (uint8_t)(color >> 16);
+    channels[2] = (uint8_t)(color >> 8);
+    channels[3] = (uint8_t)color;
+}
+
+static inline const kmz_color_32 _kmz_quantize_color(const uint8_t * const restrict channels) {
+    return ((kmz_color_32)(channels[0] >> 1) << 24) | ((kmz_color_32)channels[1] << 16) | ((kmz_color_32)channels[2] << 8) | channels[3];
+}
+
+/**
+ * Returns the histogram bin of a color, made of the top 5 bits of the red, green and blue channels and one of 4 alpha classes that keep
+ * opaque and fully transparent pixels apart from translucent ones.
+ */
+static inline const size_t _kmz_quantize_bin(const kmz_color_32 color) {
+    const uint32_t a = (color >> 24) & 0x7Fu;
+    const size_t alpha = 0 == a ? 0 : (a < 64 ? 1 : (a < 127 ? 2 : 3));
+    return (alpha << 15) | ((color >> 9) & 0x7C00u) | ((color >> 6) & 0x03E0u) | ((color >> 3) & 0x001Fu);
+}
+
+static inline const kmz_color_32 _kmz_quantize_mean(const uint64_t * const restrict sum, const uint64_t count) {
+    uint8_t channels[4];
+    for (size_t c = 0; c < 4; ++c) {
+        channels[c] = (uint8_t)((sum[c] + count / 2) / count);
+    }
+    return _kmz_quantize_color(channels);
+}
+
+static void _kmz_quantize_histogram_band(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_quantize_histogram_t * const restrict ctx = arg;
+    if (__atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_PIXEL_OP_OK) {
+        return;
+    }
+
+    if (NULL == ctx->bins[worker]) {
+        ctx->bins[worker] = calloc(_KMZ_QUANTIZE_BINS, sizeof(struct _kmz_quantize_bin_t));
+        ctx->lines[worker] = malloc(ctx->w * sizeof(kmz_color_32));
+    }
+
+    struct _kmz_quantize_bin_t * const restrict bins = ctx->bins[worker];
+    kmz_color_32 * const restrict line = ctx->lines[worker];
+    KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+
+    if (NULL == bins || NULL == line) {
+        status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        const size_t end = (index + 1) * _KMZ_QUANTIZE_BAND < ctx->rows ? (index + 1) * _KMZ_QUANTIZE_BAND : ctx->rows;
+        for (size_t row = index * _KMZ_QUANTIZE_BAND; row < end && KMZ_PIXEL_OP_OK == status; ++row) {
+            status = KmzImage__read_row_span(ctx->image, kmz_point(0, (ssize_t)(row * ctx->step)), ctx->w, line);
+            for (size_t x = 0; x < ctx->w && KMZ_PIXEL_OP_OK == status; x += ctx->step) {
+                struct _kmz_quantize_bin_t * const restrict bin = bins + _kmz_quantize_bin(line[x]);
+                uint8_t channels[4];
+                _kmz_quantize_channels(line[x], channels);
+                ++bin->count;
+                bin->sum[0] += channels[0];
+                bin->sum[1] += channels[1];
+                bin->sum[2] += channels[2];
+                bin->sum[3] += channels[3];
+            }
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK != status) {
+        KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, status, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Builds the histogram of every populated bin of the image from a subsample of at most {@link _KMZ_QUANTIZE_SAMPLES} pixels, taken
+ * from every row and column for smaller images and from a regular grid otherwise.
+ */
+static struct _kmz_quantize_color_t * const _kmz_quantize_histogram(const KmzImage * const restrict me, const size_t threads, size_t * const restrict count) {
+    const KmzSize dimen = KmzImage__dimen(me);
+    size_t step = 1;
+    while (((size_t)(dimen.w + step - 1) / step) * ((size_t)(dimen.h + step - 1) / step) > _KMZ_QUANTIZE_SAMPLES) {
+        ++step;
+    }
+
+    const size_t rows = (dimen.h + step - 1) / step, bands = (rows + _KMZ_QUANTIZE_BAND - 1) / _KMZ_QUANTIZE_BAND,
+          workers = _kmz_parallel_workers(threads, bands);
+    struct _kmz_quantize_histogram_t ctx = {
+        .image = me,
+        .w = dimen.w,
+        .step = step,
+        .rows = rows,
+        .bins = calloc(workers, sizeof(struct _kmz_quantize_bin_t *)),
+        .lines = calloc(workers, sizeof(kmz_color_32 *)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+    struct _kmz_quantize_color_t * colors = NULL;
+    *count = 0;
+
+    if (NULL == ctx.bins || NULL == ctx.lines) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        _kmz_parallel_for(workers, bands, &_kmz_quantize_histogram_band, &ctx);
+    }
+
+    struct _kmz_quantize_bin_t * restrict bins = NULL;
+    for (size_t i = 0; KMZ_PIXEL_OP_OK == ctx.status && i < workers; ++i) {
+        if (NULL == ctx.bins[i]) {
+            continue;
+        } else if (NULL == bins) {
+            bins = ctx.bins[i];
+            continue;
+        }
+        for (size_t b = 0; b < _KMZ_QUANTIZE_BINS; ++b) {
+            bins[b].count += ctx.bins[i][b].count;
+            for (size_t c = 0; c < 4; ++c) {
+                bins[b].sum[c] += ctx.bins[i][b].sum[c];
+            }
+        }
+    }
+
+    if (NULL != bins) {
+        size_t populated = 0;
+        for (size_t b = 0; b < _KMZ_QUANTIZE_BINS; ++b) {
+            populated += 0 != bins[b].count;
+        }
+        colors = malloc((populated ? populated : 1) * sizeof(struct _kmz_quantize_color_t));
+        for (size_t b = 0; NULL != colors && b < _KMZ_QUANTIZE_BINS; ++b) {
+            if (0 == bins[b].count) {
+                continue;
+            }
+            struct _kmz_quantize_color_t * const restrict color = colors + (*count)++;
+            color->count = bins[b].count;
+            for (size_t c = 0; c < 4; ++c) {
+                color->sum[c] = bins[b].sum[c];
+                color->mean[c] = (uint8_t)((bins[b].sum[c] + bins[b].count / 2) / bins[b].count);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < workers; ++i) {
+        if (NULL != ctx.bins) {
+            free(ctx.bins[i]);
+        }
+        if (NULL != ctx.lines) {
+            free(ctx.lines[i]);
+        }
+    }
+    free(ctx.bins);
+    free(ctx.lines);
+
+    return colors;
+}
+
+// region Median cut:
+
+static void _kmz_median_cut_measure(const struct _kmz_quantize_color_t * const restrict colors, struct _kmz_quantize_box_t * const restrict box) {
+    uint8_t min[4] = {255, 255, 255, 255}, max[4] = {0, 0, 0, 0};
+    box->count = 0;
+    for (size_t i = box->start; i < box->end; ++i) {
+        box->count += colors[i].count;
+        for (size_t c = 0; c < 4; ++c) {
+            min[c] = colors[i].mean[c] < min[c] ? colors[i].mean[c] : min[c];
+            max[c] = colors[i].mean[c] > max[c] ? colors[i].mean[c] : max[c];
+        }
+    }
+
+    box->channel = 0;
+    box->range = 0;
+    for (size_t c = 0; c < 4; ++c) {
+        if ((uint32_t)(max[c] - min[c]) > box->range) {
+            box->channel = c;
+            box->range = (uint32_t)(max[c] - min[c]);
+        }
+    }
+}
+
+/**
+ * Sorts the colors of a box by a single channel using a counting sort, since every channel only has 256 possible values.
+ */
+static void _kmz_median_cut_sort(struct _kmz_quantize_color_t * const restrict colors, struct _kmz_quantize_color_t * const restrict scratch,
+        const struct _kmz_quantize_box_t * const restrict box) {
+    size_t offsets[257] = {0};
+    for (size_t i = box->start; i < box->end; ++i) {
+        ++offsets[colors[i].mean[box->channel] + 1];
+    }
+    for (size_t v = 1; v < 257; ++v) {
+        offsets[v] += offsets[v - 1];
+    }
+    for (size_t i = box->start; i < box->end; ++i) {
+        scratch[offsets[colors[i].mean[box->channel]]++] = colors[i];
+    }
+    memcpy(colors + box->start, scratch, (box->end - box->start) * sizeof(struct _kmz_quantize_color_t));
+}
+
+static const size_t _kmz_median_cut(struct _kmz_quantize_color_t * const restrict colors, const size_t count, const size_t max,
+        kmz_color_32 * const restrict palette) {
+    struct _kmz_quantize_box_t boxes[_KMZ_QUANTIZE_COLORS];
+    struct _kmz_quantize_color_t * const restrict scratch = malloc(count * sizeof(struct _kmz_quantize_color_t));
+    size_t used = 1;
+
+    if (NULL == scratch) {
+        return 0;
+    }
+
+    boxes[0].start = 0;
+    boxes[0].end = count;
+    _kmz_median_cut_measure(colors, boxes);
+
+    // The box with the most pixels spread over the widest range is split at the median pixel of its widest channel.
+    while (used < max) {
+        struct _kmz_quantize_box_t * restrict box = NULL;
+        uint64_t best = 0;
+        for (size_t i = 0; i < used; ++i) {
+            const uint64_t score = (uint64_t)boxes[i].range * boxes[i].count;
+            if (boxes[i].end - boxes[i].start > 1 && score > best) {
+                best = score;
+                box = boxes + i;
+            }
+        }
+        if (NULL == box) {
+            break;
+        }
+
+        _kmz_median_cut_sort(colors, scratch, box);
+        uint64_t below = 0;
+        size_t split = box->start;
+        while (split < box->end - 1 && 2 * (below + colors[split].count) <= box->count) {
+            below += colors[split++].count;
+        }
+        split = split == box->start ? box->start + 1 : split;
+
+        boxes[used].start = split;
+        boxes[used].end = box->end;
+        box->end = split;
+        _kmz_median_cut_measure(colors, box);
+        _kmz_median_cut_measure(colors, boxes + used);
+        ++used;
+    }
+
+    for (size_t i = 0; i < used; ++i) {
+        uint64_t sum[4] = {0, 0, 0, 0};
+        for (size_t j = boxes[i].start; j < boxes[i].end; ++j) {
+            for (size_t c = 0; c < 4; ++c) {
+                sum[c] += colors[j].sum[c];
+            }
+        }
+        palette[i] = _kmz_quantize_mean(sum, boxes[i].count);
+    }
+
+    free(scratch);
+    return used;
+}
+
+// endregion;
+
+// region Octree:
+
+static const int32_t _kmz_octree_node(struct _kmz_octree_t * const restrict tree) {
+    int32_t index = tree->free;
+    if (-1 != index) {
+        tree->free = tree->nodes[index].next;
+    } else {
+        if (tree->size == tree->capacity) {
+            const size_t capacity = tree->capacity ? tree->capacity * 2 : 1024;
+            struct _kmz_octree_node_t * const restrict nodes = realloc(tree->nodes, capacity * sizeof(struct _kmz_octree_node_t));
+            if (NULL == nodes) {
+                return -1;
+            }
+            tree->nodes = nodes;
+            tree->capacity = capacity;
+        }
+        index = (int32_t)tree->size++;
+    }
+
+    struct _kmz_octree_node_t * const restrict node = tree->nodes + index;
+    memset(node->sum, 0, sizeof(node->sum));
+    node->count = 0;
+    memset(node->children, 0xFF, sizeof(node->children));
+    node->next = -1;
+    node->leaf = KMZ_FALSE;
+    return index;
+}
+
+/**
+ * Merges the children of the most recently created node of the deepest level that still has children, all of which are leaves since
+ * every deeper level has already been merged. The root is never merged, since merging its 16 children at once could leave a single color.
+ */
+static const KmzBool _kmz_octree_reduce(struct _kmz_octree_t * const restrict tree) {
+    size_t level = _KMZ_QUANTIZE_OCTREE_DEPTH - 1;
+    while (level > 0 && -1 == tree->levels[level]) {
+        --level;
+    }
+    if (0 == level) {
+        return KMZ_FALSE;
+    }
+
+    struct _kmz_octree_node_t * const restrict node = tree->nodes + tree->levels[level];
+    tree->levels[level] = node->next;
+    for (size_t i = 0; i < 16; ++i) {
+        if (-1 == node->children[i]) {
+            continue;
+        }
+        struct _kmz_octree_node_t * const restrict child = tree->nodes + node->children[i];
+        for (size_t c = 0; c < 4; ++c) {
+            node->sum[c] += child->sum[c];
+        }
+        node->count += child->count;
+        child->next = tree->free;
+        tree->free = node->children[i];
+        node->children[i] = -1;
+        --tree->leaves;
+    }
+    node->leaf = KMZ_TRUE;
+    ++tree->leaves;
+    return KMZ_TRUE;
+}
+
+static const KmzBool _kmz_octree_insert(struct _kmz_octree_t * const restrict tree, const struct _kmz_quantize_color_t * const restrict color) {
+    int32_t index = 0;
+    for (size_t level = 0; ; ++level) {
+        if (tree->nodes[index].leaf) {
+            struct _kmz_octree_node_t * const restrict node = tree->nodes + index;
+            for (size_t c = 0; c < 4; ++c) {
+                node->sum[c] += color->sum[c];
+            }
+            node->count += color->count;
+            return KMZ_TRUE;
+        }
+
+        const unsigned shift = 7 - (unsigned)level;
+        const size_t branch = (size_t)((((color->mean[0] >> shift) & 1u) << 3) | (((color->mean[1] >> shift) & 1u) << 2)
+                | (((color->mean[2] >> shift) & 1u) << 1) | ((color->mean[3] >> shift) & 1u));
+        int32_t child = tree->nodes[index].children[branch];
+        if (-1 == child) {
+            child = _kmz_octree_node(tree);
+            if (-1 == child) {
+                return KMZ_FALSE;
+            }
+            if (level + 1 == _KMZ_QUANTIZE_OCTREE_DEPTH) {
+                tree->nodes[child].leaf = KMZ_TRUE;
+                ++tree->leaves;
+            } else {
+                tree->nodes[child].next = tree->levels[level + 1];
+                tree->levels[level + 1] = child;
+            }
+            tree->nodes[index].children[branch] = child;
+        }
+        index = child;
+    }
+}
+
+static void _kmz_octree_collect(const struct _kmz_octree_t * const restrict tree, const int32_t index, struct _kmz_octree_node_t * const restrict leaves,
+        size_t * const restrict count) {
+    const struct _kmz_octree_node_t * const restrict node = tree->nodes + index;
+    if (node->leaf) {
+        if (0 != node->count) {
+            leaves[(*count)++] = *node;
+        }
+        return;
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        if (-1 != node->children[i]) {
+            _kmz_octree_collect(tree, node->children[i], leaves, count);
+        }
+    }
+}
+
+/**
+ * Merges the pair of leaves whose merge adds the least error until at most `max` leaves remain, which only happens when the children
+ * of the root alone outnumber `max`.
+ */
+static void _kmz_octree_merge(struct _kmz_octree_node_t * const restrict leaves, size_t * const restrict count, const size_t max) {
+    while (*count > max) {
+        double best = -1.;
+        size_t a = 0, b = 1;
+        for (size_t i = 0; i < *count; ++i) {
+            for (size_t j = i + 1; j < *count; ++j) {
+                double distance = 0.;
+                for (size_t c = 0; c < 4; ++c) {
+                    const double d = (double)leaves[i].sum[c] / (double)leaves[i].count - (double)leaves[j].sum[c] / (double)leaves[j].count;
+                    distance += d * d;
+                }
+                distance *= (double)leaves[i].count * (double)leaves[j].count / (double)(leaves[i].count + leaves[j].count);
+                if (best < 0. || distance < best) {
+                    best = distance;
+                    a = i;
+                    b = j;
+                }
+            }
+        }
+        for (size_t c = 0; c < 4; ++c) {
+            leaves[a].sum[c] += leaves[b].sum[c];
+        }
+        leaves[a].count += leaves[b].count;
+        leaves[b] = leaves[--(*count)];
+    }
+}
+
+static const size_t _kmz_octree(const struct _kmz_quantize_color_t * const restrict colors, const size_t count, const size_t max,
+        kmz_color_32 * const restrict palette) {
+    struct _kmz_octree_t tree = {NULL, 0, 0, -1, {-1, -1, -1, -1, -1}, 0};
+    struct _kmz_octree_node_t * const restrict leaves = malloc(_KMZ_QUANTIZE_COLORS * sizeof(struct _kmz_octree_node_t));
+    size_t used = 0;
+
+    if (NULL != leaves && -1 != _kmz_octree_node(&tree)) {
+        size_t i = 0;
+        for (; i < count && _kmz_octree_insert(&tree, colors + i); ++i) {
+            KmzBool reduced = KMZ_TRUE;
+            while (tree.leaves > max && reduced) {
+                reduced = _kmz_octree_reduce(&tree);
+            }
+        }
+        if (i == count) {
+            _kmz_octree_collect(&tree, 0, leaves, &used);
+            _kmz_octree_merge(leaves, &used, max);
+            for (size_t l = 0; l < used; ++l) {
+                palette[l] = _kmz_quantize_mean(leaves[l].sum, leaves[l].count);
+            }
+        }
+    }
+
+    free(leaves);
+    free(tree.nodes);
+    return used;
+}
+
+// endregion;
+
+// region Remapping:
+
+/**
+ * Keeps the given palette color if it is closer to `center` than the best color so far, returning {@link KMZ_FALSE} once the green
+ * channel alone is as far as the best color.
+ */
+static inline const KmzBool _kmz_quantize_closer(const struct _kmz_quantize_remap_t * const restrict ctx, const uint8_t i,
+        const int32_t * const restrict center, uint32_t * const restrict best, uint16_t * const restrict index) {
+    const int32_t dg = center[2] - (int32_t)ctx->channels[i][2];
+    uint32_t distance = (uint32_t)(dg * dg);
+    if (distance >= *best) {
+        return KMZ_FALSE;
+    }
+    for (size_t c = 0; c < 4; ++c) {
+        const int32_t d = center[c] - (int32_t)ctx->channels[i][c];
+        distance += 2 != c ? (uint32_t)(d * d) : 0;
+    }
+    if (distance < *best) {
+        *best = distance;
+        *index = i;
+    }
+    return KMZ_TRUE;
+}
+
+/**
+ * Returns the palette index of a color through an inverse colormap that holds the palette color nearest to the center of every histogram
+ * bin. Bins are only resolved the first time one of their colors is remapped, and workers that race to resolve the same bin store the
+ * same index.
+ */
+static inline const uint8_t _kmz_quantize_index(struct _kmz_quantize_remap_t * const restrict ctx, const kmz_color_32 color) {
+    const size_t bin = _kmz_quantize_bin(color);
+    uint16_t index = __atomic_load_n(ctx->lut + bin, __ATOMIC_RELAXED);
+    if (_KMZ_QUANTIZE_UNSET != index) {
+        return (uint8_t)index;
+    }
+
+    static const uint8_t alpha[4] = {0, 65, 191, 255};
+    const int32_t center[4] = {alpha[bin >> 15], (int32_t)(((bin >> 7) & 0xF8u) | 4u), (int32_t)(((bin >> 2) & 0xF8u) | 4u),
+        (int32_t)(((bin << 3) & 0xF8u) | 4u)};
+    // The palette is sorted by its green channel, so the search walks outwards from the closest green and stops once green alone is too far.
+    uint32_t best = UINT32_MAX;
+    size_t start = 0;
+    while (start < ctx->count && (int32_t)ctx->channels[ctx->order[start]][2] < center[2]) {
+        ++start;
+    }
+    index = 0;
+    for (size_t i = start; i < ctx->count; ++i) {
+        if (!_kmz_quantize_closer(ctx, ctx->order[i], center, &best, &index)) {
+            break;
+        }
+    }
+    for (size_t i = start; i-- > 0;) {
+        if (!_kmz_quantize_closer(ctx, ctx->order[i], center, &best, &index)) {
+            break;
+        }
+    }
+    __atomic_store_n(ctx->lut + bin, index, __ATOMIC_RELAXED);
+    return (uint8_t)index;
+}
+
+static void _kmz_quantize_remap_band(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_quantize_remap_t * const restrict ctx = arg;
+    if (__atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_PIXEL_OP_OK) {
+        return;
+    }
+
+    if (NULL == ctx->lines[worker]) {
+        ctx->lines[worker] = malloc(ctx->w * sizeof(kmz_color_32));
+    }
+
+    kmz_color_32 * const restrict line = ctx->lines[worker];
+    KmzPixelOperationStatus status = NULL == line ? KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY : KMZ_PIXEL_OP_OK;
+    const size_t end = (index + 1) * _KMZ_QUANTIZE_BAND < ctx->h ? (index + 1) * _KMZ_QUANTIZE_BAND : ctx->h;
+
+    for (size_t y = index * _KMZ_QUANTIZE_BAND; y < end && KMZ_PIXEL_OP_OK == status; ++y) {
+        status = KmzImage__read_row_span(ctx->image, kmz_point(0, (ssize_t)y), ctx->w, line);
+        uint8_t * const restrict indices = ctx->indices + y * ctx->w;
+        kmz_color_32 last = line[0];
+        uint8_t last_index = _kmz_quantize_index(ctx, last);
+        for (size_t x = 0; x < ctx->w && KMZ_PIXEL_OP_OK == status; ++x) {
+            if (line[x] != last) {
+                last = line[x];
+                last_index = _kmz_quantize_index(ctx, last);
+            }
+            indices[x] = last_index;
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK != status) {
+        KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, status, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+// endregion;
+
+const size_t KmzImage__quantize(const KmzImage * const restrict me, const KmzQuantizeMode mode, const size_t color_count,
+        kmz_color_32 * const restrict palette, const size_t threads) {
+    const size_t max = kmz_clamp(color_count, 1, _KMZ_QUANTIZE_COLORS);
+    size_t count = 0, used = 0;
+
+    if (NULL == palette) {
+        return 0;
+    }
+
+    struct _kmz_quantize_color_t * const restrict colors = _kmz_quantize_histogram(me, threads, &count);
+    if (NULL != colors && 0 != count) {
+        switch (mode) {
+            case KMZ_QUANTIZE_OCTREE:
+                used = _kmz_octree(colors, count, max, palette);
+                break;
+            case KMZ_QUANTIZE_MEDIAN_CUT:
+            default:
+                used = _kmz_median_cut(colors, count, max, palette);
+                break;
+        }
+    }
+
+    free(colors);
+    return used;
+}
+
+KmzImage * const KmzImage__new_palette_from_image(const KmzImage * const restrict image, const KmzQuantizeMode mode, const size_t color_count,
+        const size_t threads) {
+    const KmzSize dimen = KmzImage__dimen(image);
+    kmz_color_32 palette[_KMZ_QUANTIZE_COLORS];
+    const size_t count = KmzImage__quantize(image, mode, color_count, palette, threads);
+
+    if (0 == count && 0 != dimen.w && 0 != dimen.h) {
+        return NULL;
+    }
+
+    KmzImage * restrict me = KmzImage__new_palette_from_buffer(dimen, palette, count, NULL, KMZ_TRUE);
+    if (NULL == me || 0 == count) {
+        return me;
+    }
+
+    const size_t bands = (dimen.h + _KMZ_QUANTIZE_BAND - 1) / _KMZ_QUANTIZE_BAND, workers = _kmz_parallel_workers(threads, bands);
+    struct _kmz_quantize_remap_t ctx = {
+        .image = image,
+        .w = dimen.w,
+        .h = dimen.h,
+        .count = count,
+        .lut = malloc(_KMZ_QUANTIZE_BINS * sizeof(uint16_t)),
+        .indices = KmzImage__palette_indices(me),
+        .lines = calloc(workers, sizeof(kmz_color_32 *)),
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (NULL == ctx.lut || NULL == ctx.lines) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            _kmz_quantize_channels(palette[i], ctx.channels[i]);
+            size_t j = i;
+            for (; j > 0 && ctx.channels[ctx.order[j - 1]][2] > ctx.channels[i][2]; --j) {
+                ctx.order[j] = ctx.order[j - 1];
+            }
+            ctx.order[j] = (uint8_t)i;
+        }
+        memset(ctx.lut, 0xFF, _KMZ_QUANTIZE_BINS * sizeof(uint16_t));
+        _kmz_parallel_for(workers, bands, &_kmz_quantize_remap_band, &ctx);
+    }
+
+    for (size_t i = 0; NULL != ctx.lines && i < workers; ++i) {
+        free(ctx.lines[i]);
+    }
+    free(ctx.lines);
+    free(ctx.lut);
+
+    if (KMZ_PIXEL_OP_OK != ctx.status) {
+        KmzImage__free(me);
+        me = NULL;
+    }
+    return me;
+}
@@ -0,0 +1,516 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_resample.h"
+
+#define _KMZ_RESAMPLE_WEIGHT_BITS 14
+/**
+ * The number of fractional bits that the horizontal pass keeps for the vertical pass, which leaves room within an int16_t for the overshoot of
+ * the negative lobes of {@link KMZ_RESAMPLE_BICUBIC} and {@link KMZ_RESAMPLE_LANCZOS_3}.
+ */
+#define _KMZ_RESAMPLE_EXTRA_BITS 6
+#define _KMZ_RESAMPLE_BAND_ROWS 16
+#define _KMZ_RESAMPLE_CACHE_SIZE 16
+
+/**
+ * The contributors of every output pixel along a single axis for a single source and output length and filter.
+ */
+struct _kmz_resample_table_t {
+    size_t src_len;
+    size_t dst_len;
+    KmzResampleFilter filter;
+    /**
+     * The number of weights of every output pixel, which is padded with 0 weights up to a multiple of 4 so every SIMD kernel reads whole groups.
+     */
+    size_t taps;
+    size_t * starts;
+    int16_t * weights;
+    size_t refs;
+    uint64_t used;
+    KmzBool cached;
+};
+
+struct _kmz_resample_worker_t {
+    kmz_color_32 * line;
+    int16_t * src;
+    int16_t * h_rows;
+    int32_t * acc;
+    const int16_t ** rows;
+    kmz_color_32 * out;
+};
+
+struct _kmz_resample_t {
+    const KmzImage * me;
+    KmzImage * output;
+    KmzRectangle area;
+    KmzSize dimen;
+    struct _kmz_resample_table_t * h;
+    struct _kmz_resample_table_t * v;
+    size_t max_rows;
+    int16_t * zero_row;
+    struct _kmz_resample_worker_t * workers;
+    kmz_color_32 * pixels;
+    pthread_mutex_t lock;
+    KmzPixelOperationStatus status;
+};
+
+// region Weights:
+
+static const double _kmz_resample_support[] = {
+    [KMZ_RESAMPLE_BOX] = .5,
+    [KMZ_RESAMPLE_BILINEAR] = 1.,
+    [KMZ_RESAMPLE_BICUBIC] = 2.,
+    [KMZ_RESAMPLE_LANCZOS_3] = 3.,
+};
+
+static const double _kmz_resample_weight(const KmzResampleFilter filter, double x) {
+    switch (filter) {
+        case KMZ_RESAMPLE_BOX:
+            return x >= -.5 && x < .5 ? 1. : 0.;
+        case KMZ_RESAMPLE_BILINEAR:
+            x = fabs(x);
+            return x < 1. ? 1. - x : 0.;
+        case KMZ_RESAMPLE_BICUBIC:
+            // Catmull-Rom, the cubic convolution with a = -0.5.
+            x = fabs(x);
+            if (x < 1.) {
+                return (1.5 * x - 2.5) * x * x + 1.;
+            } else if (x < 2.) {
+                return ((-.5 * x + 2.5) * x - 4.) * x + 2.;
+            }
+            return 0.;
+        case KMZ_RESAMPLE_LANCZOS_3:
+            if (0. == x) {
+                return 1.;
+            } else if (x > -3. && x < 3.) {
+                return 3. * sin(M_PI * x) * sin(M_PI * x / 3.) / (M_PI * M_PI * x * x);
+            }
+            return 0.;
+        default:
+            return 0.;
+    }
+}
+
+/**
+ * Computes the contributors of every output pixel, normalizing the weights of every pixel after they are clipped to the source so that their
+ * fixed point sum is exactly 1.
+ */
+static struct _kmz_resample_table_t * const _kmz_resample_table_new(const size_t src_len, const size_t dst_len, const KmzResampleFilter filter) {
+    const double scale = (double)src_len / (double)dst_len, f_scale = scale > 1. ? scale : 1., support = _kmz_resample_support[filter] * f_scale;
+    const size_t taps = ((size_t)ceil(2. * support) + 2 + 3) & ~(size_t)3;
+
+    struct _kmz_resample_table_t * const restrict me = malloc(sizeof(struct _kmz_resample_table_t));
+    double * const restrict weights = malloc(taps * sizeof(double));
+    if (NULL != me) {
+        me->starts = malloc(dst_len * sizeof(size_t));
+        me->weights = calloc(dst_len * taps, sizeof(int16_t));
+    }
+    if (NULL == me || NULL == weights || NULL == me->starts || NULL == me->weights) {
+        if (NULL != me) {
+            free(me->starts);
+            free(me->weights);
+        }
+        free(me);
+        free(weights);
+        return NULL;
+    }
+
+    *me = (struct _kmz_resample_table_t){src_len, dst_len, filter, taps, me->starts, me->weights, 0, 0, KMZ_FALSE};
+    for (size_t i = 0; i < dst_len; ++i) {
+        const double center = ((double)i + .5) * scale;
+        ssize_t lo = (ssize_t)floor(center - support), hi = (ssize_t)ceil(center + support);
+        lo = lo < 0 ? 0 : lo;
+        hi = hi > (ssize_t)src_len ? (ssize_t)src_len : hi;
+
+        double sum = 0.;
+        for (ssize_t j = lo; j < hi; ++j) {
+            weights[j - lo] = _kmz_resample_weight(filter, ((double)j + .5 - center) / f_scale);
+            sum += weights[j - lo];
+        }
+        if (0. == sum) {
+            lo = kmz_clamp((ssize_t)center, 0, (ssize_t)src_len - 1);
+            hi = lo + 1;
+            weights[0] = sum = 1.;
+        }
+
+        int16_t * const restrict out = me->weights + i * taps;
+        int32_t total = 0;
+        size_t largest = 0;
+        for (size_t k = 0; k < (size_t)(hi - lo); ++k) {
+            out[k] = (int16_t)lround(weights[k] / sum * (1 << _KMZ_RESAMPLE_WEIGHT_BITS));
+            total += out[k];
+            largest = abs(out[k]) > abs(out[largest]) ? k : largest;
+        }
+        out[largest] = (int16_t)(out[largest] + (1 << _KMZ_RESAMPLE_WEIGHT_BITS) - total);
+        me->starts[i] = (size_t)lo;
+    }
+
+    free(weights);
+    return me;
+}
+
+static void _kmz_resample_table_free(struct _kmz_resample_table_t * const restrict me) {
+    free(me->starts);
+    free(me->weights);
+    free(me);
+}
+
+// endregion;
+
+// region Cache:
+
+static pthread_mutex_t _kmz_resample_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct _kmz_resample_table_t * _kmz_resample_cache[_KMZ_RESAMPLE_CACHE_SIZE];
+static uint64_t _kmz_resample_cache_tick;
+
+static struct _kmz_resample_table_t * const _kmz_resample_cache_find(const size_t src_len, const size_t dst_len, const KmzResampleFilter filter) {
+    for (size_t i = 0; i < _KMZ_RESAMPLE_CACHE_SIZE; ++i) {
+        struct _kmz_resample_table_t * const restrict table = _kmz_resample_cache[i];
+        if (NULL != table && table->src_len == src_len && table->dst_len == dst_len && table->filter == filter) {
+            ++table->refs;
+            table->used = ++_kmz_resample_cache_tick;
+            return table;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Returns the table for the given lengths and filter, reusing one of the most recently used tables when possible. Tables are built outside of
+ * the lock, so a table built concurrently by another thread is preferred over the one built by this thread.
+ */
+static struct _kmz_resample_table_t * const _kmz_resample_table_acquire(const size_t src_len, const size_t dst_len, const KmzResampleFilter filter) {
+    pthread_mutex_lock(&_kmz_resample_cache_lock);
+    struct _kmz_resample_table_t * table = _kmz_resample_cache_find(src_len, dst_len, filter);
+    pthread_mutex_unlock(&_kmz_resample_cache_lock);
+    if (NULL != table) {
+        return table;
+    }
+
+    struct _kmz_resample_table_t * const restrict built = _kmz_resample_table_new(src_len, dst_len, filter);
+    if (NULL == built) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&_kmz_resample_cache_lock);
+    table = _kmz_resample_cache_find(src_len, dst_len, filter);
+    if (NULL != table) {
+        _kmz_resample_table_free(built);
+    } else {
+        size_t slot = _KMZ_RESAMPLE_CACHE_SIZE;
+        for (size_t i = 0; i < _KMZ_RESAMPLE_CACHE_SIZE; ++i) {
+            const struct _kmz_resample_table_t * const restrict other = _kmz_resample_cache[i];
+            if (NULL == other) {
+                slot = i;
+                break;
+            } else if (0 == other->refs && (_KMZ_RESAMPLE_CACHE_SIZE == slot || other->used < _kmz_resample_cache[slot]->used)) {
+                slot = i;
+            }
+        }
+
+        table = built;
+        table->refs = 1;
+        table->used = ++_kmz_resample_cache_tick;
+        // Every cached table may be in use, in which case this one is freed once it is released.
+        if (_KMZ_RESAMPLE_CACHE_SIZE != slot) {
+            if (NULL != _kmz_resample_cache[slot]) {
+                _kmz_resample_table_free(_kmz_resample_cache[slot]);
+            }
+            _kmz_resample_cache[slot] = table;
+            table->cached = KMZ_TRUE;
+        }
+    }
+    pthread_mutex_unlock(&_kmz_resample_cache_lock);
+    return table;
+}
+
+static void _kmz_resample_table_release(struct _kmz_resample_table_t * const restrict me) {
+    if (NULL == me) {
+        return;
+    }
+    pthread_mutex_lock(&_kmz_resample_cache_lock);
+    if (0 == --me->refs && !me->cached) {
+        _kmz_resample_table_free(me);
+    }
+    pthread_mutex_unlock(&_kmz_resample_cache_lock);
+}
+
+// endregion;
+
+// region Passes:
+
+static inline const uint32_t _kmz_resample_pair(const int16_t * const restrict weights, const size_t k) {
+    return (uint32_t)(uint16_t)weights[k] | ((uint32_t)(uint16_t)weights[k + 1] << 16);
+}
+
+#ifdef KMZ_SIMD_X86
+kmz__target("sse2") static void _kmz_sse2_resample_row(const struct _kmz_resample_table_t * const restrict table, const int16_t * const restrict src,
+        int16_t * const restrict dst) {
+    const size_t taps = table->taps;
+    for (size_t x = 0; x < table->dst_len; ++x) {
+        const int16_t * const restrict p = src + 4 * table->starts[x], * const restrict w = table->weights + x * taps;
+        __m128i acc = _mm_set1_epi32(1 << (_KMZ_RESAMPLE_WEIGHT_BITS - _KMZ_RESAMPLE_EXTRA_BITS - 1));
+        for (size_t k = 0; k < taps; k += 2) {
+            const __m128i v = _mm_loadu_si128((const __m128i *)(p + 4 * k));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(v, _mm_srli_si128(v, 8)), _mm_set1_epi32((int)_kmz_resample_pair(w, k))));
+        }
+        acc = _mm_srai_epi32(acc, _KMZ_RESAMPLE_WEIGHT_BITS - _KMZ_RESAMPLE_EXTRA_BITS);
+        _mm_storel_epi64((__m128i *)(dst + 4 * x), _mm_packs_epi32(acc, acc));
+    }
+}
+
+kmz__target("avx2") static void _kmz_avx2_resample_row(const struct _kmz_resample_table_t * const restrict table, const int16_t * const restrict src,
+        int16_t * const restrict dst) {
+    const size_t taps = table->taps;
+    for (size_t x = 0; x < table->dst_len; ++x) {
+        const int16_t * const restrict p = src + 4 * table->starts[x], * const restrict w = table->weights + x * taps;
+        __m256i sum = _mm256_setzero_si256();
+        for (size_t k = 0; k < taps; k += 4) {
+            // Each 128 bit lane interleaves the channels of a pair of pixels, weighing pixels k and k + 1 in the low lane and k + 2 and k + 3 in the high one.
+            const __m256i v = _mm256_loadu_si256((const __m256i *)(p + 4 * k)),
+                  pair = _mm256_setr_m128i(_mm_set1_epi32((int)_kmz_resample_pair(w, k)), _mm_set1_epi32((int)_kmz_resample_pair(w, k + 2)));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_unpacklo_epi16(v, _mm256_srli_si256(v, 8)), pair));
+        }
+        __m128i acc = _mm_add_epi32(_mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)),
+                _mm_set1_epi32(1 << (_KMZ_RESAMPLE_WEIGHT_BITS - _KMZ_RESAMPLE_EXTRA_BITS - 1)));
+        acc = _mm_srai_epi32(acc, _KMZ_RESAMPLE_WEIGHT_BITS - _KMZ_RESAMPLE_EXTRA_BITS);
+        _mm_storel_epi64((__m128i *)(dst + 4 * x), _mm_packs_epi32(acc, acc));
+    }
+}
+#endif
+
+/**
+ * Resamples a single row of premultiplied channels horizontally, keeping {@link _KMZ_RESAMPLE_EXTRA_BITS} fractional bits.
+ */
+static void _kmz_resample_row(const struct _kmz_resample_table_t * const restrict table, const int16_t * const restrict src, int16_t * const restrict dst) {
+#ifdef KMZ_SIMD_X86
+    const KmzSimdLevel level = kmz_simd_level();
+    if (KMZ_SIMD_AVX2 <= level) {
+        _kmz_avx2_resample_row(table, src, dst);
+        return;
+    } else if (KMZ_SIMD_SSE2 <= level) {
+        _kmz_sse2_resample_row(table, src, dst);
+        return;
+    }
+#endif
+    const size_t taps = table->taps;
+    for (size_t x = 0; x < table->dst_len; ++x) {
+        const int16_t * const restrict p = src + 4 * table->starts[x], * const restrict w = table->weights + x * taps;
+        for (size_t c = 0; c < 4; ++c) {
+            int32_t sum = 1 << (_KMZ_RESAMPLE_WEIGHT_BITS - _KMZ_RESAMPLE_EXTRA_BITS - 1);
+            for (size_t k = 0; k < taps; ++k) {
+                sum += (int32_t)w[k] * p[4 * k + c];
+            }
+            sum >>= _KMZ_RESAMPLE_WEIGHT_BITS - _KMZ_RESAMPLE_EXTRA_BITS;
+            dst[4 * x + c] = (int16_t)kmz_clamp(sum, INT16_MIN, INT16_MAX);
+        }
+    }
+}
+
+/**
+ * Rounds the vertically resampled channels back to 8 bits and unpremultiplies them.
+ */
+static void _kmz_resample_store(const int32_t * const restrict acc, kmz_color_32 * const restrict out, const size_t count) {
+    const int32_t half = 1 << (_KMZ_RESAMPLE_WEIGHT_BITS + _KMZ_RESAMPLE_EXTRA_BITS - 1);
+    for (size_t x = 0; x < count; ++x) {
+        int32_t v[4];
+        for (size_t c = 0; c < 4; ++c) {
+            const int32_t value = (acc[4 * x + c] + half) >> (_KMZ_RESAMPLE_WEIGHT_BITS + _KMZ_RESAMPLE_EXTRA_BITS);
+            v[c] = kmz_clamp(value, 0, 255);
+        }
+
+        out[x] = _kmz_color_unpremultiply(v);
+    }
+}
+
+// endregion;
+
+static void _KmzImage__resample_band(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_resample_t * const restrict ctx = arg;
+    if (__atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_PIXEL_OP_OK) {
+        return;
+    }
+
+    const struct _kmz_resample_table_t * const restrict h = ctx->h, * const restrict v = ctx->v;
+    const size_t w = ctx->area.size.w, o_w = ctx->dimen.w, stride = 4 * o_w,
+          y0 = index * _KMZ_RESAMPLE_BAND_ROWS,
+          y1 = y0 + _KMZ_RESAMPLE_BAND_ROWS < ctx->dimen.h ? y0 + _KMZ_RESAMPLE_BAND_ROWS : ctx->dimen.h,
+          first = v->starts[y0],
+          last = v->starts[y1 - 1] + v->taps < ctx->area.size.h ? v->starts[y1 - 1] + v->taps : ctx->area.size.h;
+    struct _kmz_resample_worker_t * const restrict buffers = ctx->workers + worker;
+    KmzPixelOperationStatus status = KMZ_PIXEL_OP_OK;
+
+    if (NULL == buffers->line) {
+        buffers->line = malloc(w * sizeof(kmz_color_32));
+        // The padding lets every output pixel read all of its taps, which weigh the pixels past the source by 0.
+        buffers->src = calloc(4 * (w + h->taps), sizeof(int16_t));
+        buffers->h_rows = malloc(ctx->max_rows * stride * sizeof(int16_t));
+        buffers->acc = malloc(stride * sizeof(int32_t));
+        buffers->rows = malloc(v->taps * sizeof(int16_t *));
+        if (NULL == ctx->pixels) {
+            buffers->out = malloc(_KMZ_RESAMPLE_BAND_ROWS * o_w * sizeof(kmz_color_32));
+        }
+    }
+
+    if (NULL == buffers->line || NULL == buffers->src || NULL == buffers->h_rows || NULL == buffers->acc || NULL == buffers->rows
+            || (NULL == ctx->pixels && NULL == buffers->out)) {
+        status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+
+    for (size_t y = first; KMZ_PIXEL_OP_OK == status && y < last; ++y) {
+        status = KmzImage__read_row_span(ctx->me, kmz_point(ctx->area.pos.x, ctx->area.pos.y + (ssize_t)y), w, buffers->line);
+        if (KMZ_PIXEL_OP_OK == status) {
+            _kmz_color_premultiply_span(buffers->line, buffers->src, w);
+            _kmz_resample_row(h, buffers->src, buffers->h_rows + (y - first) * stride);
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK == status) {
+        kmz_color_32 * const restrict out = NULL == ctx->pixels ? buffers->out : ctx->pixels + y0 * o_w;
+        for (size_t y = y0; y < y1; ++y) {
+            for (size_t k = 0; k < v->taps; ++k) {
+                const size_t row = v->starts[y] + k;
+                buffers->rows[k] = row < last ? buffers->h_rows + (row - first) * stride : ctx->zero_row;
+            }
+            memset(buffers->acc, 0, stride * sizeof(int32_t));
+            _kmz_kernel_pass(buffers->acc, buffers->rows, v->weights + y * v->taps, v->taps, stride);
+            _kmz_resample_store(buffers->acc, out + (y - y0) * o_w, o_w);
+        }
+
+        if (NULL == ctx->pixels) {
+            pthread_mutex_lock(&ctx->lock);
+            status = KmzImage__write_argb_block(ctx->output, kmz_rectangle(kmz_point(0, (ssize_t)y0), kmz_size(ctx->dimen.w, (uint16_t)(y1 - y0))), out);
+            pthread_mutex_unlock(&ctx->lock);
+        }
+    }
+
+    if (KMZ_PIXEL_OP_OK != status) {
+        KmzPixelOperationStatus expected = KMZ_PIXEL_OP_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, status, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Copies an area with the dimensions of the output image, which every filter passes through unchanged, without rounding translucent colors through
+ * premultiplied channels.
+ */
+static const KmzPixelOperationStatus _kmz_resample_copy(const KmzImage * const me, const KmzRectangle area, KmzImage * const output) {
+    if (me == output && 0 == area.pos.x && 0 == area.pos.y) {
+        return KMZ_PIXEL_OP_OK;
+    }
+
+    kmz_color_32 * const restrict pixels = malloc((size_t)area.size.w * area.size.h * sizeof(kmz_color_32));
+    if (NULL == pixels) {
+        return KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    }
+    KmzPixelOperationStatus status = KmzImage__read_argb_block(me, area, pixels);
+    if (KMZ_PIXEL_OP_OK == status) {
+        status = KmzImage__write_argb_block(output, kmz_rectangle(KmzPoint__ZERO, area.size), pixels);
+    }
+    free(pixels);
+    return status;
+}
+
+const KmzPixelOperationStatus KmzImage__resample(const KmzImage * const me, const KmzRectangle area, const KmzResampleFilter filter,
+        KmzImage * const output, const size_t threads) {
+    if ((unsigned int)filter >= sizeof(_kmz_resample_support) / sizeof(_kmz_resample_support[0])) {
+        return KMZ_PIXEL_OP_ERR_UNKNOWN;
+    }
+
+    const KmzSize dimen = KmzImage__dimen(me), o_dimen = KmzImage__dimen(output);
+    const ssize_t x = kmz_clamp(area.pos.x, 0, dimen.w),
+          y = kmz_clamp(area.pos.y, 0, dimen.h),
+          max_x = kmz_clamp(area.size.w + x, x, dimen.w),
+          max_y = kmz_clamp(area.size.h + y, y, dimen.h);
+
+    const size_t w = (size_t)(max_x - x),
+          h = (size_t)(max_y - y);
+
+    if (!w || !h || !o_dimen.w || !o_dimen.h) {
+        return KMZ_PIXEL_OP_OK;
+    } else if (w == o_dimen.w && h == o_dimen.h) {
+        return _kmz_resample_copy(me, kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)w, (uint16_t)h)), output);
+    }
+
+    const size_t bands = (o_dimen.h + _KMZ_RESAMPLE_BAND_ROWS - 1) / _KMZ_RESAMPLE_BAND_ROWS,
+          workers = _kmz_parallel_workers(threads, bands);
+
+    struct _kmz_resample_t ctx = {
+        .me = me,
+        .output = output,
+        .area = kmz_rectangle(kmz_point(x, y), kmz_size((uint16_t)w, (uint16_t)h)),
+        .dimen = o_dimen,
+        .h = _kmz_resample_table_acquire(w, o_dimen.w, filter),
+        .v = _kmz_resample_table_acquire(h, o_dimen.h, filter),
+        .zero_row = calloc(4 * (size_t)o_dimen.w, sizeof(int16_t)),
+        .workers = calloc(workers, sizeof(struct _kmz_resample_worker_t)),
+        // Every band reads its rows from `me`, so in-place output is written back only once all bands are resampled.
+        .pixels = output == me ? malloc((size_t)o_dimen.w * o_dimen.h * sizeof(kmz_color_32)) : NULL,
+        .status = KMZ_PIXEL_OP_OK,
+    };
+
+    if (NULL == ctx.h || NULL == ctx.v || NULL == ctx.zero_row || NULL == ctx.workers || (output == me && NULL == ctx.pixels)) {
+        ctx.status = KMZ_PIXEL_OP_ERR_OUT_OF_MEMORY;
+    } else {
+        for (size_t i = 0; i < bands; ++i) {
+            const size_t y0 = i * _KMZ_RESAMPLE_BAND_ROWS, y1 = y0 + _KMZ_RESAMPLE_BAND_ROWS < o_dimen.h ? y0 + _KMZ_RESAMPLE_BAND_ROWS : o_dimen.h,
+                  last = ctx.v->starts[y1 - 1] + ctx.v->taps < h ? ctx.v->starts[y1 - 1] + ctx.v->taps : h;
+            ctx.max_rows = last - ctx.v->starts[y0] > ctx.max_rows ? last - ctx.v->starts[y0] : ctx.max_rows;
+        }
+
+        pthread_mutex_init(&ctx.lock, NULL);
+        _kmz_parallel_for(workers, bands, &_KmzImage__resample_band, &ctx);
+        pthread_mutex_destroy(&ctx.lock);
+
+        if (NULL != ctx.pixels && KMZ_PIXEL_OP_OK == ctx.status) {
+            ctx.status = KmzImage__write_argb_block(output, kmz_rectangle(KmzPoint__ZERO, o_dimen), ctx.pixels);
+        }
+    }
+
+    if (NULL != ctx.workers) {
+        for (size_t i = 0; i < workers; ++i) {
+            free(ctx.workers[i].line);
+            free(ctx.workers[i].src);
+            free(ctx.workers[i].h_rows);
+            free(ctx.workers[i].acc);
+            free(ctx.workers[i].rows);
+            free(ctx.workers[i].out);
+        }
+    }
+    _kmz_resample_table_release(ctx.h);
+    _kmz_resample_table_release(ctx.v);
+    free(ctx.zero_row);
+    free(ctx.workers);
+    free(ctx.pixels);
+
+    return ctx.status;
+}
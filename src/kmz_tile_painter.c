@@ -0,0 +1,774 @@
+/*-
+  BSD 3-Clause License
+
+  Copyright (c) 2020, Kempozer
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice, this
+  list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its
+  contributors may be used to endorse or promote products derived from
+  this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#include "kmz_tile_painter.h"
+
+#define _KMZ_TILE_SIZE 64
+#define _KMZ_TILE_STRIDE (_KMZ_TILE_SIZE + 2)
+
+struct _kmz_tile_edge_t {
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+};
+
+struct _kmz_tile_command_t {
+    kmz_color_32 color;
+    KmzPattern * pattern;
+    KmzBool antialias;
+    size_t first;
+    size_t count;
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+};
+
+struct _kmz_tile_bin_t {
+    size_t * commands;
+    size_t count;
+    size_t capacity;
+};
+
+struct _kmz_tile_painter_t {
+    KmzSize dimen;
+    size_t threads;
+    KmzBrush brush;
+    KmzPen pen;
+    struct _kmz_tile_command_t * commands;
+    size_t count;
+    size_t total;
+    size_t capacity;
+    struct _kmz_tile_edge_t * edges;
+    size_t edge_count;
+    size_t edge_capacity;
+    size_t tiles_x;
+    size_t tiles_y;
+    struct _kmz_tile_bin_t * bins;
+};
+
+struct _kmz_tile_painter_argv_t {
+    KmzSize dimen;
+    size_t threads;
+};
+
+struct _kmz_tile_painter_paint_t {
+    const struct _kmz_tile_painter_t * me;
+    KmzImage * image;
+    KmzSize dimen;
+    KmzPoint pos;
+    float ** covers;
+    uint64_t ** masks;
+    kmz_color_32 ** pixels;
+    pthread_mutex_t lock;
+    KmzDrawStatus status;
+};
+
+KmzPainter * const KmzPainter__new_binned(const KmzSize dimen, const size_t threads) {
+    const struct _kmz_tile_painter_argv_t argv = {dimen, threads};
+    return KmzPainter__new(&kmz_tile_painter, &argv);
+}
+
+// region Recording:
+
+/**
+ * Discards every shape that was undone so that a new shape can be recorded in its place.
+ */
+static void _KmzTilePainter__truncate(struct _kmz_tile_painter_t * const restrict me) {
+    if (me->count == me->total) {
+        return;
+    }
+
+    for (size_t i = 0; i < me->tiles_x * me->tiles_y; ++i) {
+        struct _kmz_tile_bin_t * const restrict bin = &me->bins[i];
+        while (bin->count && bin->commands[bin->count - 1] >= me->count) {
+            --bin->count;
+        }
+    }
+    me->edge_count = me->commands[me->count].first;
+    me->total = me->count;
+}
+
+static const KmzDrawStatus _KmzTilePainter__begin(struct _kmz_tile_painter_t * const restrict me, const kmz_color_32 color, KmzPattern * const restrict pattern, const KmzBool antialias) {
+    _KmzTilePainter__truncate(me);
+    if (me->total == me->capacity) {
+        const size_t capacity = me->capacity ? me->capacity * 2 : 64;
+        struct _kmz_tile_command_t * const restrict commands = realloc(me->commands, sizeof(struct _kmz_tile_command_t) * capacity);
+        if (NULL == commands) {
+            return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+        }
+        me->commands = commands;
+        me->capacity = capacity;
+    }
+
+    me->commands[me->total] = (struct _kmz_tile_command_t){color, pattern, antialias, me->edge_count, 0, INFINITY, INFINITY, -INFINITY, -INFINITY};
+    return KMZ_DRAW_OK;
+}
+
+static const KmzDrawStatus _KmzTilePainter__edge(struct _kmz_tile_painter_t * const restrict me, const float x0, const float y0, const float x1, const float y1) {
+    if (y0 == y1 || !isfinite(x0) || !isfinite(y0) || !isfinite(x1) || !isfinite(y1)) {
+        return KMZ_DRAW_OK;
+    } else if (me->edge_count == me->edge_capacity) {
+        const size_t capacity = me->edge_capacity ? me->edge_capacity * 2 : 256;
+        struct _kmz_tile_edge_t * const restrict edges = realloc(me->edges, sizeof(struct _kmz_tile_edge_t) * capacity);
+        if (NULL == edges) {
+            return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+        }
+        me->edges = edges;
+        me->edge_capacity = capacity;
+    }
+
+    struct _kmz_tile_command_t * const restrict command = &me->commands[me->total];
+    me->edges[me->edge_count++] = (struct _kmz_tile_edge_t){x0, y0, x1, y1};
+    ++command->count;
+    command->min_x = fminf(command->min_x, fminf(x0, x1));
+    command->min_y = fminf(command->min_y, fminf(y0, y1));
+    command->max_x = fmaxf(command->max_x, fmaxf(x0, x1));
+    command->max_y = fmaxf(command->max_y, fmaxf(y0, y1));
+    return KMZ_DRAW_OK;
+}
+
+static const KmzDrawStatus _KmzTilePainter__contour(struct _kmz_tile_painter_t * const restrict me, const KmzPointF * const restrict points, const size_t count, const float offset, const KmzBool reverse) {
+    KmzDrawStatus status = KMZ_DRAW_OK;
+    for (size_t i = 0; i < count && KMZ_DRAW_OK == status; ++i) {
+        const KmzPointF a = points[reverse ? count - 1 - i : i], b = points[reverse ? (2 * count - 2 - i) % count : (i + 1) % count];
+        status = _KmzTilePainter__edge(me, a.x + offset, a.y + offset, b.x + offset, b.y + offset);
+    }
+    return status;
+}
+
+/**
+ * Records a closed circle, flattened so that no point of it strays more than a tenth of a pixel from the true circle.
+ */
+static const KmzDrawStatus _KmzTilePainter__circle(struct _kmz_tile_painter_t * const restrict me, const float cx, const float cy, const float radius, const KmzBool reverse) {
+    if (!(radius > 0.f)) {
+        return KMZ_DRAW_OK;
+    }
+
+    const double tolerance = radius > .1f ? 1. - .1 / radius : 0.;
+    const size_t segments = (size_t)fmax(8., fmin(4096., ceil(M_PI / acos(tolerance))));
+    const double step = (reverse ? -2. : 2.) * M_PI / (double)segments;
+    float x = cx + radius, y = cy;
+    KmzDrawStatus status = KMZ_DRAW_OK;
+
+    for (size_t i = 1; i <= segments && KMZ_DRAW_OK == status; ++i) {
+        const float nx = i == segments ? cx + radius : (float)(cx + radius * cos(step * (double)i)),
+                    ny = i == segments ? cy : (float)(cy + radius * sin(step * (double)i));
+        status = _KmzTilePainter__edge(me, x, y, nx, ny);
+        x = nx;
+        y = ny;
+    }
+    return status;
+}
+
+static const KmzDrawStatus _KmzTilePainter__rectangle(struct _kmz_tile_painter_t * const restrict me, const float x0, const float y0, const float x1, const float y1, const KmzBool reverse) {
+    const KmzPointF points[4] = {kmz_pointf(x0, y0), kmz_pointf(x1, y0), kmz_pointf(x1, y1), kmz_pointf(x0, y1)};
+    return _KmzTilePainter__contour(me, points, 4, 0.f, reverse);
+}
+
+static inline const float _KmzTilePainter__pen_width(const struct _kmz_tile_painter_t * const restrict me) {
+    return me->pen.width > 0.f ? me->pen.width : 1.f;
+}
+
+/**
+ * Records a line with the width of the pen as a rectangle around it, or a square if both ends are the same.
+ */
+static const KmzDrawStatus _KmzTilePainter__stroke(struct _kmz_tile_painter_t * const restrict me, const KmzPointF start, const KmzPointF end) {
+    const double dx = (double)end.x - start.x, dy = (double)end.y - start.y, length = sqrt(dx * dx + dy * dy), half = _KmzTilePainter__pen_width(me) / 2.;
+    if (0. == length) {
+        return _KmzTilePainter__rectangle(me, (float)(start.x + .5 - half), (float)(start.y + .5 - half), (float)(start.x + .5 + half), (float)(start.y + .5 + half), KMZ_FALSE);
+    }
+
+    const double nx = -dy / length * half, ny = dx / length * half;
+    const KmzPointF quad[4] = {
+        kmz_pointf((float)(start.x + nx), (float)(start.y + ny)),
+        kmz_pointf((float)(end.x + nx), (float)(end.y + ny)),
+        kmz_pointf((float)(end.x - nx), (float)(end.y - ny)),
+        kmz_pointf((float)(start.x - nx), (float)(start.y - ny)),
+    };
+    return _KmzTilePainter__contour(me, quad, 4, .5f, KMZ_FALSE);
+}
+
+/**
+ * Finishes recording a shape by adding it to the bin of every tile it touches, discarding it if it has no edges or recording failed.
+ */
+static const KmzDrawStatus _KmzTilePainter__end(struct _kmz_tile_painter_t * const restrict me, const KmzDrawStatus status) {
+    const struct _kmz_tile_command_t * const restrict command = &me->commands[me->total];
+    if (KMZ_DRAW_OK != status || 0 == command->count) {
+        me->edge_count = command->first;
+        return status;
+    }
+
+    const size_t index = me->total;
+    if (command->max_x > 0.f && command->max_y > 0.f && command->min_x < me->dimen.w && command->min_y < me->dimen.h) {
+        const size_t tx0 = command->min_x > 0.f ? (size_t)command->min_x / _KMZ_TILE_SIZE : 0,
+                     ty0 = command->min_y > 0.f ? (size_t)command->min_y / _KMZ_TILE_SIZE : 0,
+                     tx1 = command->max_x < me->dimen.w ? (size_t)command->max_x / _KMZ_TILE_SIZE : me->tiles_x - 1,
+                     ty1 = command->max_y < me->dimen.h ? (size_t)command->max_y / _KMZ_TILE_SIZE : me->tiles_y - 1;
+
+        for (size_t ty = ty0; ty <= ty1 && ty < me->tiles_y; ++ty) {
+            for (size_t tx = tx0; tx <= tx1 && tx < me->tiles_x; ++tx) {
+                struct _kmz_tile_bin_t * const restrict bin = &me->bins[ty * me->tiles_x + tx];
+                if (bin->count == bin->capacity) {
+                    const size_t capacity = bin->capacity ? bin->capacity * 2 : 16;
+                    size_t * const restrict commands = realloc(bin->commands, sizeof(size_t) * capacity);
+                    if (NULL == commands) {
+                        // Remove the shape from the bins it was already added to.
+                        me->count = me->total;
+                        me->total = index + 1;
+                        _KmzTilePainter__truncate(me);
+                        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+                    }
+                    bin->commands = commands;
+                    bin->capacity = capacity;
+                }
+                bin->commands[bin->count++] = index;
+            }
+        }
+    }
+
+    me->count = me->total = index + 1;
+    return KMZ_DRAW_OK;
+}
+
+// endregion;
+
+// region Rasterization:
+
+/**
+ * Marks the cells [from, to] of a row as touched, where each row has a mask of two words.
+ */
+static inline void _kmz_tile_mark(uint64_t * const restrict mask, const size_t from, const size_t to) {
+    for (size_t word = from / 64; word <= to / 64; ++word) {
+        const size_t lo = word * 64 > from ? 0 : from - word * 64, hi = to - word * 64 < 63 ? to - word * 64 : 63;
+        mask[word] |= (UINT64_MAX >> (63 - hi)) & (UINT64_MAX << lo);
+    }
+}
+
+/**
+ * Accumulates the signed area covered by a line whose x coordinates lie within [0, {@link _KMZ_TILE_SIZE}] into the rows [top, bottom) of a
+ * tile, marking every cell it changes in `masks`.
+ */
+static void _kmz_tile_accumulate(float * const restrict cover, uint64_t * const restrict masks, const size_t top, const size_t bottom, float x0, float y0, float x1, float y1) {
+    float dir = 1.f;
+    if (y0 > y1) {
+        float tmp = x0;
+        x0 = x1;
+        x1 = tmp;
+        tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+        dir = -1.f;
+    }
+    if (y1 <= top || y0 >= bottom) {
+        return;
+    }
+
+    const float dxdy = (x1 - x0) / (y1 - y0);
+    size_t y = y0 > top ? (size_t)y0 : top;
+    const size_t y_end = y1 < bottom ? (size_t)ceilf(y1) : bottom;
+    float x = x0 + ((float)y > y0 ? ((float)y - y0) * dxdy : 0.f);
+
+    for (; y < y_end; ++y) {
+        float * const restrict row = cover + y * _KMZ_TILE_STRIDE;
+        const float dy = fminf((float)(y + 1), y1) - fmaxf((float)y, y0);
+        const float xnext = fminf(fmaxf(x + dxdy * dy, 0.f), _KMZ_TILE_SIZE);
+        const float d = dy * dir;
+        const float l = x < xnext ? x : xnext, r = x < xnext ? xnext : x;
+        const float l_floor = floorf(l), r_ceil = ceilf(r);
+        const size_t li = (size_t)l_floor, ri = (size_t)r_ceil;
+        _kmz_tile_mark(masks + 2 * y, li, ri <= li + 1 ? li + 1 : ri);
+
+        if (ri <= li + 1) {
+            const float mid = .5f * (x + xnext) - l_floor;
+            row[li] += d - d * mid;
+            row[li + 1] += d * mid;
+        } else {
+            const float s = 1.f / (r - l), lf = l - l_floor, a0 = .5f * s * (1.f - lf) * (1.f - lf), rf = r - r_ceil + 1.f, am = .5f * s * rf * rf;
+            row[li] += d * a0;
+            if (ri == li + 2) {
+                row[li + 1] += d * (1.f - a0 - am);
+            } else {
+                const float a1 = s * (1.5f - lf);
+                row[li + 1] += d * (a1 - a0);
+                for (size_t i = li + 2; i < ri - 1; ++i) {
+                    row[i] += d * s;
+                }
+                row[ri - 1] += d * (1.f - (a1 + (float)(ri - li - 3) * s) - am);
+            }
+            row[ri] += d * am;
+        }
+        x = xnext;
+    }
+}
+
+/**
+ * Accumulates a line in tile coordinates, where the parts of the line outside the left and right of the tile are moved onto its edges so
+ * that they still cover every pixel to their right.
+ */
+static void _kmz_tile_line(float * const restrict cover, uint64_t * const restrict masks, const size_t top, const size_t bottom, const float x0, const float y0, const float x1, const float y1) {
+    static const float bounds[2] = {0.f, _KMZ_TILE_SIZE};
+    for (size_t i = 0; i < 2; ++i) {
+        const float b = bounds[i];
+        if ((x0 < b && x1 > b) || (x0 > b && x1 < b)) {
+            const float ym = y0 + (b - x0) / (x1 - x0) * (y1 - y0);
+            _kmz_tile_line(cover, masks, top, bottom, x0, y0, b, ym);
+            _kmz_tile_line(cover, masks, top, bottom, b, ym, x1, y1);
+            return;
+        }
+    }
+    _kmz_tile_accumulate(cover, masks, top, bottom, fminf(fmaxf(x0, 0.f), _KMZ_TILE_SIZE), y0, fminf(fmaxf(x1, 0.f), _KMZ_TILE_SIZE), y1);
+}
+
+static inline const uint32_t _kmz_tile_coverage(const float area, const KmzBool antialias) {
+    const float coverage = fminf(fabsf(area), 1.f);
+    if (!antialias) {
+        return coverage >= .5f ? 255u : 0u;
+    }
+    return (uint32_t)(coverage * 255.f + .5f);
+}
+
+/**
+ * Blends the color of a shape over the pixels [from, to) of a row of a tile, which all have the same coverage.
+ */
+static inline void _kmz_tile_fill(kmz_color_32 * const restrict out, const size_t from, const size_t to, const struct _kmz_tile_command_t * const restrict command,
+        const uint32_t coverage, const ssize_t x, const ssize_t y) {
+    if (NULL != command->pattern) {
+        for (size_t i = from; i < to; ++i) {
+            out[i] = _kmz_draw_blend(out[i], KmzPattern__color_at(command->pattern, kmz_point(x + (ssize_t)i, y)), coverage);
+        }
+    } else if (255u == coverage && 127u == _kmz_draw_opacity(command->color)) {
+        for (size_t i = from; i < to; ++i) {
+            out[i] = command->color;
+        }
+    } else {
+        for (size_t i = from; i < to; ++i) {
+            out[i] = _kmz_draw_blend(out[i], command->color, coverage);
+        }
+    }
+}
+
+static void _KmzTilePainter__rasterize(void * const restrict arg, const size_t index, const size_t worker) {
+    struct _kmz_tile_painter_paint_t * const restrict ctx = arg;
+    const struct _kmz_tile_painter_t * const restrict me = ctx->me;
+    const struct _kmz_tile_bin_t * const restrict bin = &me->bins[index];
+    if (0 == bin->count || bin->commands[0] >= me->count || __atomic_load_n(&ctx->status, __ATOMIC_RELAXED) != KMZ_DRAW_OK) {
+        return;
+    }
+
+    // The tile in canvas coordinates, clipped to the canvas and then to the image it is painted on.
+    const ssize_t tile_x = (ssize_t)(index % me->tiles_x) * _KMZ_TILE_SIZE, tile_y = (ssize_t)(index / me->tiles_x) * _KMZ_TILE_SIZE;
+    const ssize_t t_w = kmz_clamp(me->dimen.w - tile_x, 0, _KMZ_TILE_SIZE), t_h = kmz_clamp(me->dimen.h - tile_y, 0, _KMZ_TILE_SIZE);
+    const ssize_t l = kmz_clamp(-(ctx->pos.x + tile_x), 0, t_w), t = kmz_clamp(-(ctx->pos.y + tile_y), 0, t_h),
+                  r = kmz_clamp(ctx->dimen.w - (ctx->pos.x + tile_x), l, t_w), b = kmz_clamp(ctx->dimen.h - (ctx->pos.y + tile_y), t, t_h);
+    if (l == r || t == b) {
+        return;
+    }
+
+    // The cells of `cover` and `masks` are cleared as they are read, so they are only ever zeroed once.
+    if (NULL == ctx->covers[worker]) {
+        ctx->covers[worker] = calloc(_KMZ_TILE_STRIDE * _KMZ_TILE_SIZE, sizeof(float));
+        ctx->masks[worker] = calloc(2 * _KMZ_TILE_SIZE, sizeof(uint64_t));
+        ctx->pixels[worker] = malloc(sizeof(kmz_color_32) * _KMZ_TILE_SIZE * _KMZ_TILE_SIZE);
+    }
+    float * const restrict cover = ctx->covers[worker];
+    uint64_t * const restrict masks = ctx->masks[worker];
+    kmz_color_32 * const restrict pixels = ctx->pixels[worker];
+    if (NULL == cover || NULL == masks || NULL == pixels) {
+        KmzDrawStatus expected = KMZ_DRAW_OK;
+        __atomic_compare_exchange_n(&ctx->status, &expected, KMZ_DRAW_ERR_OUT_OF_MEMORY, KMZ_FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        return;
+    }
+
+    const size_t w = (size_t)(r - l);
+    const KmzRectangle area = kmz_rectangle(kmz_point(ctx->pos.x + tile_x + l, ctx->pos.y + tile_y + t), kmz_size((uint16_t)w, (uint16_t)(b - t)));
+    pthread_mutex_lock(&ctx->lock);
+    KmzImage__read_argb_block(ctx->image, area, pixels);
+    pthread_mutex_unlock(&ctx->lock);
+
+    for (size_t c = 0; c < bin->count && bin->commands[c] < me->count; ++c) {
+        const struct _kmz_tile_command_t * const restrict command = &me->commands[bin->commands[c]];
+        const float min_y = command->min_y - (float)tile_y, max_y = command->max_y - (float)tile_y,
+                    min_x = command->min_x - (float)tile_x, max_x = command->max_x - (float)tile_x;
+        const size_t top = (size_t)kmz_clamp(floorf(min_y), t, b), bottom = (size_t)kmz_clamp(ceilf(max_y), t, b);
+        if (top >= bottom || max_x <= (float)l || min_x >= (float)r) {
+            continue;
+        }
+
+        for (size_t e = command->first; e < command->first + command->count; ++e) {
+            const struct _kmz_tile_edge_t edge = me->edges[e];
+            if (fminf(edge.x0, edge.x1) - (float)tile_x >= _KMZ_TILE_SIZE) {
+                continue;
+            }
+            _kmz_tile_line(cover, masks, top, bottom, edge.x0 - (float)tile_x, edge.y0 - (float)tile_y, edge.x1 - (float)tile_x, edge.y1 - (float)tile_y);
+        }
+
+        // Between two touched cells the accumulated area is constant, so each row is blended a run at a time.
+        for (size_t y = top; y < bottom; ++y) {
+            float * const restrict row = cover + y * _KMZ_TILE_STRIDE;
+            uint64_t * const restrict mask = masks + 2 * y;
+            kmz_color_32 * const restrict out = pixels + (y - (size_t)t) * w - (size_t)l;
+            const ssize_t py = tile_y + (ssize_t)y;
+            float area_sum = 0.f;
+            size_t x = (size_t)l;
+
+            for (size_t word = 0; word < 2; ++word) {
+                while (mask[word]) {
+                    const size_t cell = word * 64 + (size_t)__builtin_ctzll(mask[word]);
+                    mask[word] &= mask[word] - 1;
+
+                    uint32_t coverage = _kmz_tile_coverage(area_sum, command->antialias);
+                    if (coverage && cell > x) {
+                        _kmz_tile_fill(out, x, cell < (size_t)r ? cell : (size_t)r, command, coverage, tile_x, py);
+                    }
+                    area_sum += row[cell];
+                    row[cell] = 0.f;
+
+                    coverage = _kmz_tile_coverage(area_sum, command->antialias);
+                    if (coverage && cell >= (size_t)l && cell < (size_t)r) {
+                        _kmz_tile_fill(out, cell, cell + 1, command, coverage, tile_x, py);
+                    }
+                    x = cell + 1 > x ? cell + 1 : x;
+                }
+            }
+
+            const uint32_t coverage = _kmz_tile_coverage(area_sum, command->antialias);
+            if (coverage && x < (size_t)r) {
+                _kmz_tile_fill(out, x, (size_t)r, command, coverage, tile_x, py);
+            }
+        }
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+    KmzImage__write_argb_block(ctx->image, area, pixels);
+    pthread_mutex_unlock(&ctx->lock);
+}
+
+// endregion;
+
+static struct _kmz_tile_painter_t * const _KmzTilePainter__new(void) {
+    struct _kmz_tile_painter_t * const restrict me = malloc(sizeof(struct _kmz_tile_painter_t));
+
+    if (NULL != me) {
+        me->dimen = KmzSize__ZERO;
+        me->threads = 0;
+        me->brush = KmzBrush__TRANSPARENT;
+        me->pen = KmzPen__TRANSPARENT;
+        me->commands = NULL;
+        me->count = me->total = me->capacity = 0;
+        me->edges = NULL;
+        me->edge_count = me->edge_capacity = 0;
+        me->tiles_x = me->tiles_y = 0;
+        me->bins = NULL;
+    }
+
+    return me;
+}
+
+static void _KmzTilePainter__ctor(struct _kmz_tile_painter_t * const restrict me, const struct _kmz_tile_painter_argv_t * const restrict args) {
+    me->threads = args->threads;
+    me->bins = calloc(((size_t)args->dimen.w + _KMZ_TILE_SIZE - 1) / _KMZ_TILE_SIZE * (((size_t)args->dimen.h + _KMZ_TILE_SIZE - 1) / _KMZ_TILE_SIZE), sizeof(struct _kmz_tile_bin_t));
+    if (NULL == me->bins) {
+        // Without bins every shape lies outside the canvas, so nothing is painted.
+        return;
+    }
+
+    me->dimen = args->dimen;
+    me->tiles_x = ((size_t)me->dimen.w + _KMZ_TILE_SIZE - 1) / _KMZ_TILE_SIZE;
+    me->tiles_y = ((size_t)me->dimen.h + _KMZ_TILE_SIZE - 1) / _KMZ_TILE_SIZE;
+}
+
+static void _KmzTilePainter__dtor(struct _kmz_tile_painter_t * const restrict me) {
+    for (size_t i = 0; i < me->tiles_x * me->tiles_y; ++i) {
+        free(me->bins[i].commands);
+    }
+    free(me->bins);
+    free(me->edges);
+    free(me->commands);
+    free(me);
+}
+
+static const KmzBrush _KmzTilePainter__brush(const struct _kmz_tile_painter_t * const restrict me) {
+    return me->brush;
+}
+
+static void _KmzTilePainter__set_brush(struct _kmz_tile_painter_t * const restrict me, const KmzBrush brush) {
+    me->brush = brush;
+}
+
+static const KmzPen _KmzTilePainter__pen(const struct _kmz_tile_painter_t * const restrict me) {
+    return me->pen;
+}
+
+static void _KmzTilePainter__set_pen(struct _kmz_tile_painter_t * const restrict me, const KmzPen pen) {
+    me->pen = pen;
+}
+
+static inline const KmzBool _KmzTilePainter__has_pen(const struct _kmz_tile_painter_t * const restrict me) {
+    return _kmz_draw_opacity(me->pen.color) ? KMZ_TRUE : KMZ_FALSE;
+}
+
+static inline const KmzBool _KmzTilePainter__has_brush(const struct _kmz_tile_painter_t * const restrict me) {
+    return NULL != me->brush.pattern || _kmz_draw_opacity(me->brush.color) ? KMZ_TRUE : KMZ_FALSE;
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_linef(struct _kmz_tile_painter_t * const restrict me, const KmzLineF line) {
+    if (!_KmzTilePainter__has_pen(me)) {
+        return KMZ_DRAW_OK;
+    }
+
+    const KmzDrawStatus status = _KmzTilePainter__begin(me, me->pen.color, NULL, me->pen.antialias);
+    if (KMZ_DRAW_OK != status) {
+        return status;
+    }
+    return _KmzTilePainter__end(me, _KmzTilePainter__stroke(me, line.start, line.end));
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_line(struct _kmz_tile_painter_t * const restrict me, const KmzLine line) {
+    return _KmzTilePainter__draw_linef(me, kmz_linef(kmz_pointf((float)line.start.x, (float)line.start.y), kmz_pointf((float)line.end.x, (float)line.end.y)));
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_pointf(struct _kmz_tile_painter_t * const restrict me, const KmzPointF point) {
+    if (!_KmzTilePainter__has_pen(me)) {
+        return KMZ_DRAW_OK;
+    }
+
+    const KmzDrawStatus status = _KmzTilePainter__begin(me, me->pen.color, NULL, me->pen.antialias);
+    if (KMZ_DRAW_OK != status) {
+        return status;
+    } else if (_KmzTilePainter__pen_width(me) <= 1.f) {
+        return _KmzTilePainter__end(me, _KmzTilePainter__stroke(me, point, point));
+    }
+    return _KmzTilePainter__end(me, _KmzTilePainter__circle(me, point.x + .5f, point.y + .5f, _KmzTilePainter__pen_width(me) / 2.f, KMZ_FALSE));
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_point(struct _kmz_tile_painter_t * const restrict me, const KmzPoint point) {
+    return _KmzTilePainter__draw_pointf(me, kmz_pointf((float)point.x, (float)point.y));
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_polygonf(struct _kmz_tile_painter_t * const restrict me, const KmzPolygonF polygon) {
+    KmzDrawStatus status = KMZ_DRAW_OK;
+    if (0 == polygon.count) {
+        return status;
+    }
+
+    if (polygon.closed && polygon.count >= 3 && _KmzTilePainter__has_brush(me)) {
+        status = _KmzTilePainter__begin(me, me->brush.color, me->brush.pattern, KMZ_TRUE);
+        if (KMZ_DRAW_OK == status) {
+            status = _KmzTilePainter__end(me, _KmzTilePainter__contour(me, polygon.points, polygon.count, 0.f, KMZ_FALSE));
+        }
+    }
+
+    if (KMZ_DRAW_OK == status && _KmzTilePainter__has_pen(me)) {
+        // The whole outline is a single shape, so the corners where its lines overlap are only painted once.
+        status = _KmzTilePainter__begin(me, me->pen.color, NULL, me->pen.antialias);
+        if (KMZ_DRAW_OK != status) {
+            return status;
+        }
+
+        const size_t segments = polygon.closed && polygon.count > 2 ? polygon.count : polygon.count - 1;
+        if (0 == segments) {
+            status = _KmzTilePainter__stroke(me, polygon.points[0], polygon.points[0]);
+        }
+        for (size_t i = 0; i < segments && KMZ_DRAW_OK == status; ++i) {
+            status = _KmzTilePainter__stroke(me, polygon.points[i], polygon.points[(i + 1) % polygon.count]);
+        }
+        status = _KmzTilePainter__end(me, status);
+    }
+    return status;
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_polygon(struct _kmz_tile_painter_t * const restrict me, const KmzPolygon polygon) {
+    KmzPointF * const restrict points = malloc(sizeof(KmzPointF) * (polygon.count ? polygon.count : 1));
+    if (NULL == points) {
+        return KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    }
+    for (size_t i = 0; i < polygon.count; ++i) {
+        points[i] = kmz_pointf((float)polygon.points[i].x, (float)polygon.points[i].y);
+    }
+
+    const KmzDrawStatus status = _KmzTilePainter__draw_polygonf(me, (KmzPolygonF){polygon.closed, polygon.count, points});
+    free(points);
+    return status;
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_rectanglef(struct _kmz_tile_painter_t * const restrict me, const KmzRectangleF rectangle) {
+    const KmzBool has_pen = _KmzTilePainter__has_pen(me);
+    const float x0 = rectangle.pos.x, y0 = rectangle.pos.y, x1 = x0 + rectangle.size.w, y1 = y0 + rectangle.size.h;
+    const float inset = has_pen ? _KmzTilePainter__pen_width(me) : 0.f;
+    const KmzBool hollow = x1 - x0 > 2.f * inset && y1 - y0 > 2.f * inset ? KMZ_TRUE : KMZ_FALSE;
+    KmzDrawStatus status = KMZ_DRAW_OK;
+    if (!(x1 > x0 && y1 > y0)) {
+        return status;
+    }
+
+    if (hollow && _KmzTilePainter__has_brush(me)) {
+        status = _KmzTilePainter__begin(me, me->brush.color, me->brush.pattern, KMZ_TRUE);
+        if (KMZ_DRAW_OK == status) {
+            status = _KmzTilePainter__end(me, _KmzTilePainter__rectangle(me, x0 + inset, y0 + inset, x1 - inset, y1 - inset, KMZ_FALSE));
+        }
+    }
+
+    if (KMZ_DRAW_OK == status && has_pen) {
+        status = _KmzTilePainter__begin(me, me->pen.color, NULL, me->pen.antialias);
+        if (KMZ_DRAW_OK != status) {
+            return status;
+        }
+        status = _KmzTilePainter__rectangle(me, x0, y0, x1, y1, KMZ_FALSE);
+        if (KMZ_DRAW_OK == status && hollow) {
+            status = _KmzTilePainter__rectangle(me, x0 + inset, y0 + inset, x1 - inset, y1 - inset, KMZ_TRUE);
+        }
+        status = _KmzTilePainter__end(me, status);
+    }
+    return status;
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_rectangle(struct _kmz_tile_painter_t * const restrict me, const KmzRectangle rectangle) {
+    return _KmzTilePainter__draw_rectanglef(me, kmz_rectanglef(kmz_pointf((float)rectangle.pos.x, (float)rectangle.pos.y), kmz_sizef(rectangle.size.w, rectangle.size.h)));
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_circlef(struct _kmz_tile_painter_t * const restrict me, const KmzCircleF circle) {
+    const KmzBool has_pen = _KmzTilePainter__has_pen(me);
+    const float cx = circle.center.x + .5f, cy = circle.center.y + .5f, radius = circle.radius + .5f;
+    const float inner = has_pen ? radius - _KmzTilePainter__pen_width(me) : radius;
+    KmzDrawStatus status = KMZ_DRAW_OK;
+    if (!(circle.radius >= 0.f)) {
+        return status;
+    }
+
+    if (inner > 0.f && _KmzTilePainter__has_brush(me)) {
+        status = _KmzTilePainter__begin(me, me->brush.color, me->brush.pattern, KMZ_TRUE);
+        if (KMZ_DRAW_OK == status) {
+            status = _KmzTilePainter__end(me, _KmzTilePainter__circle(me, cx, cy, inner, KMZ_FALSE));
+        }
+    }
+
+    if (KMZ_DRAW_OK == status && has_pen) {
+        status = _KmzTilePainter__begin(me, me->pen.color, NULL, me->pen.antialias);
+        if (KMZ_DRAW_OK != status) {
+            return status;
+        }
+        status = _KmzTilePainter__circle(me, cx, cy, radius, KMZ_FALSE);
+        if (KMZ_DRAW_OK == status && inner > 0.f) {
+            status = _KmzTilePainter__circle(me, cx, cy, inner, KMZ_TRUE);
+        }
+        status = _KmzTilePainter__end(me, status);
+    }
+    return status;
+}
+
+static const KmzDrawStatus _KmzTilePainter__draw_circle(struct _kmz_tile_painter_t * const restrict me, const KmzCircle circle) {
+    return _KmzTilePainter__draw_circlef(me, kmz_circlef(kmz_pointf((float)circle.center.x, (float)circle.center.y), (float)circle.radius));
+}
+
+static const KmzDrawStatus _KmzTilePainter__paint(struct _kmz_tile_painter_t * const restrict me, const KmzPoint pos, KmzImage * const restrict image) {
+    const size_t tiles = me->tiles_x * me->tiles_y;
+    if (0 == me->count || 0 == tiles) {
+        return KMZ_DRAW_OK;
+    }
+
+    const size_t workers = _kmz_parallel_workers(me->threads, tiles);
+    struct _kmz_tile_painter_paint_t ctx = {
+        .me = me,
+        .image = image,
+        .dimen = KmzImage__dimen(image),
+        .pos = pos,
+        .covers = calloc(workers, sizeof(float *)),
+        .masks = calloc(workers, sizeof(uint64_t *)),
+        .pixels = calloc(workers, sizeof(kmz_color_32 *)),
+        .status = KMZ_DRAW_OK,
+    };
+
+    if (NULL == ctx.covers || NULL == ctx.masks || NULL == ctx.pixels) {
+        ctx.status = KMZ_DRAW_ERR_OUT_OF_MEMORY;
+    } else {
+        pthread_mutex_init(&ctx.lock, NULL);
+        _kmz_parallel_for(workers, tiles, &_KmzTilePainter__rasterize, &ctx);
+        pthread_mutex_destroy(&ctx.lock);
+    }
+
+    for (size_t i = 0; i < workers; ++i) {
+        if (NULL != ctx.covers) {
+            free(ctx.covers[i]);
+        }
+        if (NULL != ctx.masks) {
+            free(ctx.masks[i]);
+        }
+        if (NULL != ctx.pixels) {
+            free(ctx.pixels[i]);
+        }
+    }
+    free(ctx.covers);
+    free(ctx.masks);
+    free(ctx.pixels);
+    return ctx.status;
+}
+
+static const KmzBool _KmzTilePainter__undo(struct _kmz_tile_painter_t * const restrict me) {
+    if (0 == me->count) {
+        return KMZ_FALSE;
+    }
+    --me->count;
+    return KMZ_TRUE;
+}
+
+static const KmzBool _KmzTilePainter__redo(struct _kmz_tile_painter_t * const restrict me) {
+    if (me->count == me->total) {
+        return KMZ_FALSE;
+    }
+    ++me->count;
+    return KMZ_TRUE;
+}
+
+const KmzPainterType kmz_tile_painter = {
+    ._new=(void * const (*)(void))&_KmzTilePainter__new,
+    ._ctor=(void (*)(void * const restrict, const void * const restrict))&_KmzTilePainter__ctor,
+    ._dtor=(void (*)(void * const restrict))&_KmzTilePainter__dtor,
+    .brush=(const KmzBrush (*)(void * const restrict))&_KmzTilePainter__brush,
+    .set_brush=(void (*)(void * const restrict, const KmzBrush))&_KmzTilePainter__set_brush,
+    .pen=(const KmzPen (*)(void * const restrict))&_KmzTilePainter__pen,
+    .set_pen=(void (*)(void * const restrict, const KmzPen))&_KmzTilePainter__set_pen,
+    .draw_line=(const KmzDrawStatus (*)(void * const restrict, const KmzLine))&_KmzTilePainter__draw_line,
+    .draw_linef=(const KmzDrawStatus (*)(void * const restrict, const KmzLineF))&_KmzTilePainter__draw_linef,
+    .draw_point=(const KmzDrawStatus (*)(void * const restrict, const KmzPoint))&_KmzTilePainter__draw_point,
+    .draw_pointf=(const KmzDrawStatus (*)(void * const restrict, const KmzPointF))&_KmzTilePainter__draw_pointf,
+    .draw_polygon=(const KmzDrawStatus (*)(void * const restrict, const KmzPolygon))&_KmzTilePainter__draw_polygon,
+    .draw_polygonf=(const KmzDrawStatus (*)(void * const restrict, const KmzPolygonF))&_KmzTilePainter__draw_polygonf,
+    .draw_rectangle=(const KmzDrawStatus (*)(void * const restrict, const KmzRectangle))&_KmzTilePainter__draw_rectangle,
+    .draw_rectanglef=(const KmzDrawStatus (*)(void * const restrict, const KmzRectangleF))&_KmzTilePainter__draw_rectanglef,
+    .draw_circle=(const KmzDrawStatus (*)(void * const restrict, const KmzCircle))&_KmzTilePainter__draw_circle,
+    .draw_circlef=(const KmzDrawStatus (*)(void * const restrict, const KmzCircleF))&_KmzTilePainter__draw_circlef,
+    .paint=(const KmzDrawStatus (*)(void * const restrict, const KmzPoint, KmzImage * const restrict))&_KmzTilePainter__paint,
+    .undo=(const KmzBool (*)(void * const restrict))&_KmzTilePainter__undo,
+    .redo=(const KmzBool (*)(void * const restrict))&_KmzTilePainter__redo
+};
@@ -32,6 +32,43 @@
 
 #include "kmz_utilities.h"
 
+static int _kmz_simd_supported = -1, _kmz_simd_active = -1;
+
+static const KmzSimdLevel _kmz_detect_simd_level(void) {
+#ifdef KMZ_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return KMZ_SIMD_AVX2;
+    } else if (__builtin_cpu_supports("ssse3")) {
+        return KMZ_SIMD_SSSE3;
+    } else if (__builtin_cpu_supports("sse2")) {
+        return KMZ_SIMD_SSE2;
+    }
+#endif
+    return KMZ_SIMD_NONE;
+}
+
 const char * const kmz_version_string(void) {
     return KMZ_VERSION_STRING(KMZ_LIBRARY_NAME, KMZ_VERSION_FULL);
 }
+
+const KmzSimdLevel kmz_simd_level(void) {
+    int level = __atomic_load_n(&_kmz_simd_active, __ATOMIC_RELAXED);
+    if (level < 0) {
+        level = _kmz_detect_simd_level();
+        __atomic_store_n(&_kmz_simd_supported, level, __ATOMIC_RELAXED);
+        __atomic_store_n(&_kmz_simd_active, level, __ATOMIC_RELAXED);
+    }
+    return (KmzSimdLevel)level;
+}
+
+const KmzSimdLevel kmz_set_simd_level(const KmzSimdLevel level) {
+    int supported = __atomic_load_n(&_kmz_simd_supported, __ATOMIC_RELAXED);
+    if (supported < 0) {
+        supported = _kmz_detect_simd_level();
+        __atomic_store_n(&_kmz_simd_supported, supported, __ATOMIC_RELAXED);
+    }
+    const int active = kmz_clamp((int)level, (int)KMZ_SIMD_NONE, supported);
+    __atomic_store_n(&_kmz_simd_active, active, __ATOMIC_RELAXED);
+    return (KmzSimdLevel)active;
+}
@@ -30,12 +30,44 @@
   OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
   */
 
+/**
+ * |Definition                  |Header         |
+ * |kmz_version_string()        |libkempozer.h  |
+ * |kmz_simd_level()            |libkempozer.h  |
+ * |kmz_set_simd_level()        |libkempozer.h  |
+ */
 #ifndef kmz_utilities_h
 #define kmz_utilities_h
 
 #include <assert.h>
 #include <stdlib.h>
 #include "kmz_config.h"
+#include "kmz_shared.h"
 #include "../include/libkempozer.h"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define KMZ_SIMD_X86 1
+#include <immintrin.h>
+#define kmz__target(isa) __attribute__((target(isa)))
+
+kmz__target("sse2") static inline __m128 _kmz_sse2_select(const __m128 mask, const __m128 a, const __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+kmz__target("sse2") static inline __m128i _kmz_sse2_select_si(const __m128i mask, const __m128i a, const __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+kmz__target("sse2") static inline __m128 _kmz_sse2_trunc(const __m128 x) {
+    const __m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.f), x);
+    const __m128 is_integral = _mm_cmpge_ps(magnitude, _mm_set1_ps(8388608.f));
+    return _kmz_sse2_select(is_integral, x, _mm_cvtepi32_ps(_mm_cvttps_epi32(x)));
+}
+
+kmz__target("sse2") static inline __m128 _kmz_sse2_floor(const __m128 x) {
+    const __m128 t = _kmz_sse2_trunc(x);
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.f)));
+}
+#endif
+
 #endif /* kmz_utilities_h */